@@ -38,7 +38,7 @@ RawAudioBuffer load_raw_buffer(const Path& filename) {
 RawAudioBuffer load_wave_file(const Path &filename) {
 	RawAudioBuffer r;
 //	ProgressStatus(_("lade wave"), 0);
-	auto f = os::fs::open(filename, "rb");
+	auto f = os::fs::open(filename, "rbc");
 	r.buffer.resize(f->size());
 	char header[44];
 	f->read_basic(header, 44);
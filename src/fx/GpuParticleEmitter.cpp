@@ -0,0 +1,44 @@
+/*
+ * GpuParticleEmitter.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "GpuParticleEmitter.h"
+#include "../renderer/helper/GpuParticleSystem.h"
+#include "../graphics-impl.h"
+
+extern Texture *tex_white;
+
+const kaba::Class *GpuParticleEmitter::_class = nullptr;
+
+GpuParticleEmitter::GpuParticleEmitter() {
+	max_particles = 65536;
+	spawn_rate = 100;
+	spawn_time_to_live = 2;
+	spawn_vel = vec3(0,0,100);
+	spawn_dvel = 20;
+	spawn_radius = 10;
+	spawn_dradius = 5;
+	spawn_color = White;
+	acceleration = vec3::ZERO;
+	sort = false;
+	texture = tex_white;
+	source = rect::ID;
+}
+
+GpuParticleEmitter::~GpuParticleEmitter() = default;
+
+void GpuParticleEmitter::__init__() {
+	new(this) GpuParticleEmitter;
+}
+
+void GpuParticleEmitter::on_iterate(float dt) {
+	pending_dt += dt;
+	pending_spawn += spawn_rate * dt;
+}
+
+void GpuParticleEmitter::burst(int n) {
+	pending_spawn += (float)n;
+}
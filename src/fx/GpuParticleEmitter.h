@@ -0,0 +1,56 @@
+/*
+ * GpuParticleEmitter.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../graphics-fwd.h"
+#include "../lib/base/base.h"
+#include "../lib/base/pointer.h"
+#include "../lib/math/vec3.h"
+#include "../lib/math/rect.h"
+#include "../lib/image/color.h"
+#include "../y/Component.h"
+
+class GpuParticleSystem;
+
+// simulated and drawn completely on the gpu (compute shaders, indirect draws)
+// the cpu only hands over the elapsed time and how many particles to spawn
+class GpuParticleEmitter : public Component {
+public:
+	GpuParticleEmitter();
+	~GpuParticleEmitter() override;
+	void __init__();
+
+	void on_iterate(float dt) override;
+	// spawn n extra particles in the next simulation step
+	void burst(int n);
+
+	// fixed, once the gpu buffers exist
+	int max_particles;
+
+	float spawn_rate; // per second
+	float spawn_time_to_live;
+	vec3 spawn_vel;
+	float spawn_dvel;
+	float spawn_radius;
+	float spawn_dradius;
+	color spawn_color;
+	vec3 acceleration;
+	// back to front for alpha blending, log²(n) extra passes
+	bool sort;
+
+	Texture* texture;
+	rect source;
+
+	// consumed by the next simulation step
+	float pending_dt = 0;
+	float pending_spawn = 0;
+
+	owned<GpuParticleSystem> system;
+
+	static const kaba::Class *_class;
+};
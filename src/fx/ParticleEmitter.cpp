@@ -31,19 +31,65 @@ void ParticleGroup::__init__() {
 }
 
 
+int ParticleGroup::num_particles() const {
+	return particles.size() + beams.size();
+}
+
+bool ParticleGroup::is_full() const {
+	return max_particles > 0 and num_particles() >= max_particles;
+}
+
+int ParticleGroup::emit_particle_index(const vec3& pos, const color& col, float r, float ttl) {
+	if (is_full())
+		return -1;
+	return particles.add(Particle(pos, col, r, ttl));
+}
+
+int ParticleGroup::emit_beam_index(const vec3& pos, const vec3& length, const color& col, float r, float ttl) {
+	if (is_full())
+		return -1;
+	return beams.add(Particle(pos, col, r, ttl), length);
+}
+
 Particle* ParticleGroup::emit_particle(const vec3& pos, const color& col, float r, float ttl) {
-	for (auto& p: particles)
-		if (!p.enabled) {
-			p = Particle(pos, col, r, ttl);
-			return &p;
-		}
-	particles.add(Particle(pos, col, r, ttl));
-	return &particles.back();
+	flush_emitted();
+	emitted = Beam(pos, vec3::ZERO, col, r, ttl);
+	emitted_index = emit_particle_index(pos, col, r, ttl);
+	emitted_beam = false;
+	return &emitted;
 }
 
 Beam* ParticleGroup::emit_beam(const vec3& pos, const vec3& length, const color& col, float r, float ttl) {
-	beams.add(Beam(pos, length, col, r, ttl));
-	return &beams.back();
+	flush_emitted();
+	emitted = Beam(pos, length, col, r, ttl);
+	emitted_index = emit_beam_index(pos, length, col, r, ttl);
+	emitted_beam = true;
+	return &emitted;
+}
+
+void ParticleGroup::flush_emitted() {
+	if (emitted_index < 0)
+		return;
+	auto& store = emitted_beam ? beams : particles;
+	// the script might have removed particles in between
+	if (emitted_index < store.size()) {
+		if (!emitted.enabled) {
+			emitted.time_to_live = -1;
+			emitted.suicidal = true;
+		}
+		store.set(emitted_index, emitted);
+		if (emitted_beam)
+			store.length[emitted_index] = emitted.length;
+	}
+	emitted_index = -1;
+}
+
+bool class_func_did_override(const kaba::Class *type, const string &fname);
+
+void ParticleGroup::check_hooks() {
+	hook_particle = class_func_did_override(component_type, "on_iterate_particle");
+	hook_beam = class_func_did_override(component_type, "on_iterate_beam");
+	hooks_checked = true;
 }
 
 void ParticleGroup::on_iterate(float dt) {
@@ -51,34 +97,44 @@ void ParticleGroup::on_iterate(float dt) {
 }
 
 void ParticleGroup::iterate_particles(float dt) {
-	for (auto &p: particles) {
-		on_iterate_particle(&p, dt);
-		p.pos += p.vel * dt;
-	}
-	for (auto &b: beams) {
-		on_iterate_beam(&b, dt);
-		b.pos += b.vel * dt;
-	}
-
-	for (int i=0; i<particles.num; i++) {
-		auto& p = particles[i];
-		//p->pos += p->vel * dt;
-		p.time_to_live -= dt;
-		if (p.time_to_live < 0 and p.suicidal) {
-			p.enabled = false;
-			//particles.erase(i);
-			//i --;
+	flush_emitted();
+	if (!hooks_checked)
+		check_hooks();
+
+	on_iterate_particles(dt);
+
+	// legacy per particle hooks work on copies
+	if (hook_particle) {
+		for (int i=0; i<particles.size(); i++) {
+			auto p = particles.get(i);
+			on_iterate_particle(&p, dt);
+			if (!p.enabled) {
+				p.time_to_live = -1;
+				p.suicidal = true;
+			}
+			particles.set(i, p);
 		}
 	}
-	for (int i=0; i<beams.num; i++) {
-		auto& b = beams[i];
-		//p->pos += p->vel * dt;
-		b.time_to_live -= dt;
-		if (b.time_to_live < 0 and b.suicidal) {
-			beams.erase(i);
-			i --;
+	if (hook_beam) {
+		for (int i=0; i<beams.size(); i++) {
+			Beam b;
+			(Particle&)b = beams.get(i);
+			b.length = beams.length[i];
+			on_iterate_beam(&b, dt);
+			if (!b.enabled) {
+				b.time_to_live = -1;
+				b.suicidal = true;
+			}
+			beams.set(i, b);
+			beams.length[i] = b.length;
 		}
 	}
+
+	particles.integrate(dt);
+	beams.integrate(dt);
+
+	particles.remove_expired();
+	beams.remove_expired();
 }
 
 
@@ -103,9 +159,13 @@ void ParticleEmitter::iterate_emitter(float dt) {
 	tt += dt;
 	while (tt >= spawn_dt) {
 		tt -= spawn_dt;
-		auto p = emit_particle(owner->pos, White, spawn_radius, spawn_time_to_live);
-		on_init_particle(p);
-		p->pos += p->vel * tt;
+		if (is_full())
+			continue;
+		Particle p(owner->pos, White, spawn_radius, spawn_time_to_live);
+		on_init_particle(&p);
+		p.pos += p.vel * tt;
+		if (p.enabled)
+			particles.add(p);
 	}
 
 	iterate_particles(dt);
@@ -17,27 +17,56 @@
 #include "../y/Component.h"
 #include "Particle.h"
 #include "Beam.h"
+#include "ParticleStore.h"
 
 class ParticleGroup : public Component {
 public:
 	ParticleGroup();
 	void __init__();
 
+	// added to the store right away, returns a proxy
+	//   changes get written back by the next flush_emitted() (next emit, iteration or draw)
+	//   group is full: a dummy
 	Particle* emit_particle(const vec3& pos, const color& col, float r, float ttl);
 	Beam* emit_beam(const vec3& pos, const vec3& length, const color& col, float r, float ttl);
+	// added to the store right away, returns the index in particles/beams (-1: group is full)
+	//   stays valid until the next iterate_particles() or remove()
+	int emit_particle_index(const vec3& pos, const color& col, float r, float ttl);
+	int emit_beam_index(const vec3& pos, const vec3& length, const color& col, float r, float ttl);
+	void flush_emitted();
+	// per particle hooks are only called when a script overrides them (slow)
 	virtual void on_iterate_particle(Particle *p, float dt) {}
 	virtual void on_iterate_beam(Beam *b, float dt) {}
+	// batched hook, may change particles/beams directly
+	virtual void on_iterate_particles(float dt) {}
 	void on_iterate(float dt) override;
 	void iterate_particles(float dt);
 
+	int num_particles() const;
+	bool is_full() const;
+
 	//shared<Texture> texture;
 	Texture* texture;
 	rect source;
 
-	Array<Particle> particles;
-	Array<Beam> beams;
+	ParticleStore particles;
+	ParticleStore beams{true};
+	// particles + beams, 0: unlimited
+	int max_particles = 0;
 
 	static const kaba::Class *_class;
+
+private:
+	void check_hooks();
+
+	// proxy of the last emit_particle()/emit_beam()
+	Beam emitted;
+	// -1: nothing to write back
+	int emitted_index = -1;
+	bool emitted_beam = false;
+	bool hooks_checked = false;
+	bool hook_particle = false;
+	bool hook_beam = false;
 };
 
 class ParticleEmitter : public ParticleGroup {
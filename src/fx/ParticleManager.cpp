@@ -8,34 +8,118 @@
 
 #include "ParticleManager.h"
 #include "Particle.h"
+#include "Beam.h"
 #include "ParticleEmitter.h"
 #include <y/Entity.h>
-#include <y/ComponentManager.h>
+#include <lib/config.h>
+#ifdef _X_ALLOW_X_
+#include <lib/kaba/syntax/Class.h>
+#include <lib/kaba/syntax/Function.h>
+#endif
+#include <new>
+#include <cstring>
 
+static int instance_size(const kaba::Class *type) {
+#ifdef _X_ALLOW_X_
+	return type->size;
+#else
+	return sizeof(LegacyBeam);
+#endif
+}
+
+static void construct_particle(const kaba::Class *type, LegacyParticle *p) {
+	if (type == LegacyParticle::_class) {
+		new(p) LegacyParticle;
+	} else if (type == LegacyBeam::_class) {
+		new(p) LegacyBeam;
+	} else {
+#ifdef _X_ALLOW_X_
+		// like kaba::Class::create_instance(), but in place
+		memset((void*)p, 0, type->size);
+		if (auto f = type->get_default_constructor()) {
+			typedef void con_func(void *);
+			if (auto ff = (con_func*)f->address)
+				ff(p);
+		}
+#endif
+	}
+	p->component_type = type;
+}
+
+
+ParticleManager::~ParticleManager() {
+	clear();
+}
+
+LegacyParticle *ParticleManager::create_legacy(const kaba::Class *type, const vec3 &pos) {
+	auto p = pool.allocate(instance_size(type));
+	auto owner = new(pool.header(p)) Entity(pos, quaternion::ID);
+	construct_particle(type, p);
+	p->owner = owner;
+	p->on_init();
+	return p;
+}
+
+// no on_delete()
+void ParticleManager::remove(int index) {
+	auto p = legacy_particles[index];
+	p->owner = nullptr;
+	p->__delete__();
+	pool.header(p)->~Entity();
+	pool.remove(index);
+}
 
+ParticleManager::Handle ParticleManager::handle(LegacyParticle *p) const {
+	return pool.handle(p);
+}
+
+LegacyParticle *ParticleManager::get(const Handle &h) const {
+	return pool.get(h);
+}
+
+void ParticleManager::delete_legacy(LegacyParticle *p) {
+	if (iterating) {
+		to_delete.add(handle(p));
+		return;
+	}
+	int index = pool.index(p);
+	if (index < 0)
+		return;
+	p->on_delete();
+	remove(index);
+}
 
-static void iterate_legacy_particles(Array<LegacyParticle*>& particles, float dt) {
-	Array<LegacyParticle*> to_del;
-	foreachi (auto p, particles, i) {
+void ParticleManager::clear() {
+	while (legacy_particles.num > 0)
+		remove(legacy_particles.num - 1);
+	// slots are untyped, they stay for the next world
+	to_delete.clear();
+}
+
+void ParticleManager::iterate(float dt) {
+	iterating = true;
+	int i = 0;
+	while (i < legacy_particles.num) {
+		auto p = legacy_particles[i];
 		p->owner->pos += p->vel * dt;
 		if (p->time_to_live >= 0) {
 			p->time_to_live -= dt;
 			if (p->time_to_live < 0) {
-				//msg_write("PARTICLE SUICIDE  " + p->component_type->name);
-				to_del.add(p);
+				p->on_delete();
+				// the last one moves to i
+				remove(i);
 				continue;
 			}
 		}
 		p->on_iterate(dt);
+		i ++;
 	}
+	iterating = false;
 
-	for (auto p: to_del)
-		p->owner->delete_component(p);
-}
-
-void ParticleManager::iterate(float dt) {
-	auto& list = ComponentManager::get_list_family<LegacyParticle>();
-	iterate_legacy_particles(list, dt);
+	for (auto &h: to_delete)
+		if (auto p = get(h))
+			delete_legacy(p);
+	to_delete.clear();
 }
 
 
@@ -8,11 +8,44 @@
 #pragma once
 
 #include "../lib/base/base.h"
+#include "../lib/math/vec3.h"
+#include "Particle.h"
+#include "SlotPool.h"
+#include <y/Entity.h>
 
+namespace kaba {
+	class Class;
+}
 
+
+// LegacyParticles live in pooled slots, not in the World or the ComponentManager
+//   each slot carries a small proxy Entity, so p.owner.pos keeps working in scripts
 class ParticleManager {
 public:
+	~ParticleManager();
+
+	using Pool = SlotPool<LegacyParticle, Entity>;
+	// weak reference into the pool, invalid once the particle got deleted
+	using Handle = Pool::Handle;
+
+	LegacyParticle* create_legacy(const kaba::Class *type, const vec3 &pos);
+	// deferred while iterating
+	void delete_legacy(LegacyParticle *p);
+	Handle handle(LegacyParticle *p) const;
+	LegacyParticle* get(const Handle &h) const;
+	void clear();
+
 	void iterate(float dt);
+
+	Pool pool;
+	// alive particles, deleting moves the last one into the gap
+	Array<LegacyParticle*> &legacy_particles = pool.alive;
+
+private:
+	void remove(int index);
+
+	bool iterating = false;
+	Array<Handle> to_delete;
 };
 
 
@@ -0,0 +1,123 @@
+/*
+ * ParticleStore.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "ParticleStore.h"
+#include "Particle.h"
+#include "../lib/threads/ThreadPool.h"
+
+// smaller stores are integrated on the calling thread
+static const int INTEGRATE_GRAIN = 16384;
+
+ParticleStore::ParticleStore(bool _with_length) {
+	with_length = _with_length;
+}
+
+void ParticleStore::resize(int n) {
+	// shrinking keeps the allocations
+	pos.resize(n);
+	vel.resize(n);
+	col.resize(n);
+	radius.resize(n);
+	time_to_live.resize(n);
+	suicidal.resize(n);
+	if (with_length)
+		length.resize(n);
+}
+
+void ParticleStore::reserve(int n) {
+	int num = size();
+	resize(max(n, num));
+	resize(num);
+}
+
+void ParticleStore::clear() {
+	resize(0);
+}
+
+int ParticleStore::add(const Particle& p, const vec3& l) {
+	int i = size();
+	resize(i + 1);
+	set(i, p);
+	if (with_length)
+		length[i] = l;
+	return i;
+}
+
+Particle ParticleStore::get(int i) const {
+	Particle p;
+	p.pos = pos[i];
+	p.vel = vel[i];
+	p.col = col[i];
+	p.radius = radius[i];
+	p.time_to_live = time_to_live[i];
+	p.suicidal = suicidal[i];
+	p.enabled = true;
+	return p;
+}
+
+void ParticleStore::set(int i, const Particle& p) {
+	pos[i] = p.pos;
+	vel[i] = p.vel;
+	col[i] = p.col;
+	radius[i] = p.radius;
+	time_to_live[i] = p.time_to_live;
+	suicidal[i] = p.suicidal;
+}
+
+void ParticleStore::move(int from, int to) {
+	pos[to] = pos[from];
+	vel[to] = vel[from];
+	col[to] = col[from];
+	radius[to] = radius[from];
+	time_to_live[to] = time_to_live[from];
+	suicidal[to] = suicidal[from];
+	if (with_length)
+		length[to] = length[from];
+}
+
+void ParticleStore::remove(int i) {
+	int last = size() - 1;
+	if (i < last)
+		move(last, i);
+	resize(last);
+}
+
+void ParticleStore::integrate(float dt) {
+	if (size() == 0)
+		return;
+	// plain loops over floats, so the compiler can vectorize them
+	float *p = &pos[0].x;
+	const float *v = &vel[0].x;
+	float *t = &time_to_live[0];
+	auto f = [p, v, t, dt] (int first, int end) {
+		for (int i=first*3; i<end*3; i++)
+			p[i] += v[i] * dt;
+		for (int i=first; i<end; i++)
+			t[i] -= dt;
+	};
+	if (size() > INTEGRATE_GRAIN)
+		ThreadPool::get()->parallel_for(size(), f, INTEGRATE_GRAIN);
+	else
+		f(0, size());
+}
+
+int ParticleStore::remove_expired() {
+	int n = size();
+	int i = 0;
+	while (i < n) {
+		if (suicidal[i] and time_to_live[i] < 0) {
+			n --;
+			if (i < n)
+				move(n, i);
+		} else {
+			i ++;
+		}
+	}
+	int removed = size() - n;
+	resize(n);
+	return removed;
+}
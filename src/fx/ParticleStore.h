@@ -0,0 +1,48 @@
+/*
+ * ParticleStore.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../lib/base/base.h"
+#include "../lib/math/vec3.h"
+#include "../lib/image/color.h"
+
+class Particle;
+
+// structure of arrays, all entries are alive
+// expired ones get replaced by the last entry (order is not kept)
+// arrays only shrink logically, so their memory is reused as a pool
+class ParticleStore {
+public:
+	explicit ParticleStore(bool with_length = false);
+
+	Array<vec3> pos, vel;
+	Array<color> col;
+	Array<float> radius, time_to_live;
+	Array<bool> suicidal;
+	// beams only
+	Array<vec3> length;
+	bool with_length;
+
+	int size() const { return pos.num; }
+	void reserve(int n);
+	void clear();
+
+	int add(const Particle& p, const vec3& length = vec3::ZERO);
+	Particle get(int i) const;
+	void set(int i, const Particle& p);
+	void remove(int i);
+
+	// pos += vel * dt, time_to_live -= dt
+	void integrate(float dt);
+	// returns the number of removed particles
+	int remove_expired();
+
+private:
+	void resize(int n);
+	void move(int from, int to);
+};
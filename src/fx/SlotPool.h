@@ -0,0 +1,145 @@
+/*
+ * SlotPool.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../lib/base/base.h"
+#include <new>
+
+// objects T (or subclasses, by size) in fixed size slots inside 16 byte aligned chunks
+//   a slot never moves while alive, freed slots get reused, chunks only get freed by the destructor
+//   each slot carries a user header H (e.g. a proxy Entity), constructed/destructed by the user like T
+//   alive objects are listed densely, removing one moves the last one into the gap
+//   handles count generations, so a reused slot does not match old handles
+template<class T, class H>
+class SlotPool {
+public:
+	static constexpr int ALIGNMENT = 16;
+	static constexpr int CHUNK_SLOTS = 256;
+
+	// weak reference, invalid once the object got removed
+	struct Handle {
+		void *slot = nullptr;
+		int generation = 0;
+	};
+
+	SlotPool() = default;
+	SlotPool(const SlotPool&) = delete;
+	~SlotPool() {
+		for (auto c: size_classes) {
+			for (auto p: c->chunks)
+				operator delete(p, std::align_val_t(ALIGNMENT));
+			delete c;
+		}
+	}
+
+	// raw memory for an object of size bytes (>= sizeof(T)), appended to alive
+	T* allocate(int size) {
+		auto c = get_size_class(round_up(HEADER_SIZE + size));
+		if (c->unused.num == 0) {
+			auto chunk = (char*)operator new(c->slot_size * CHUNK_SLOTS, std::align_val_t(ALIGNMENT));
+			c->chunks.add(chunk);
+			for (int i=CHUNK_SLOTS-1; i>=0; i--) {
+				auto s = new(chunk + i * c->slot_size) Slot;
+				s->size_class = c;
+				s->index = -1;
+				s->generation = 0;
+				c->unused.add(s);
+			}
+		}
+		auto s = c->unused.back();
+		c->unused.pop();
+		auto p = object_of(s);
+		s->index = alive.num;
+		alive.add(p);
+		return p;
+	}
+
+	// the object (and header) must be destructed already
+	void remove(int index) {
+		auto p = alive[index];
+		auto last = alive.back();
+		alive[index] = last;
+		slot_of(last)->index = index;
+		alive.pop();
+
+		auto s = slot_of(p);
+		s->index = -1;
+		s->generation ++;
+		s->size_class->unused.add(s);
+	}
+
+	// in alive, -1 once removed
+	int index(const T *p) const {
+		return slot_of(p)->index;
+	}
+
+	H* header(const T *p) const {
+		return reinterpret_cast<H*>(reinterpret_cast<char*>(slot_of(p)) + HEADER_OFFSET);
+	}
+
+	Handle handle(const T *p) const {
+		auto s = slot_of(p);
+		return {s, s->generation};
+	}
+
+	T* get(const Handle &h) const {
+		auto s = reinterpret_cast<Slot*>(h.slot);
+		if (!s or s->index < 0 or s->generation != h.generation)
+			return nullptr;
+		return object_of(s);
+	}
+
+	int num_chunks() const {
+		int n = 0;
+		for (auto c: size_classes)
+			n += c->chunks.num;
+		return n;
+	}
+
+	Array<T*> alive;
+
+private:
+	struct SizeClass;
+	struct Slot {
+		SizeClass *size_class;
+		int index; // in alive, -1 while unused
+		int generation;
+	};
+	struct SizeClass {
+		int slot_size;
+		Array<char*> chunks;
+		Array<Slot*> unused;
+	};
+	Array<SizeClass*> size_classes;
+
+	static constexpr int round_up(int size) {
+		return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	}
+	static_assert(alignof(T) <= ALIGNMENT and alignof(H) <= ALIGNMENT);
+
+	// [Slot][H][T], H and T start at multiples of ALIGNMENT
+	static constexpr int HEADER_OFFSET = round_up(sizeof(Slot));
+	static constexpr int HEADER_SIZE = HEADER_OFFSET + round_up(sizeof(H));
+
+	static Slot *slot_of(const T *p) {
+		return reinterpret_cast<Slot*>(reinterpret_cast<char*>(const_cast<T*>(p)) - HEADER_SIZE);
+	}
+	static T *object_of(Slot *s) {
+		return reinterpret_cast<T*>(reinterpret_cast<char*>(s) + HEADER_SIZE);
+	}
+
+	SizeClass *get_size_class(int slot_size) {
+		for (auto c: size_classes)
+			if (c->slot_size == slot_size)
+				return c;
+		auto c = new SizeClass;
+		c->slot_size = slot_size;
+		size_classes.add(c);
+		return c;
+	}
+};
@@ -0,0 +1,136 @@
+/*
+ * DrawList.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "DrawList.h"
+#include "gui.h"
+#include "Picture.h"
+#include "Text.h"
+#include "../lib/math/mat4.h"
+#include "../lib/math/rect.h"
+#include "../graphics-impl.h"
+#include "../y/EngineData.h"
+
+namespace gui {
+
+Array<DrawVertex> draw_vertices;
+Array<DrawCall> draw_calls;
+int draw_list_version = 0;
+
+static bool equal(const rect &a, const rect &b) {
+	return a.x1 == b.x1 and a.x2 == b.x2 and a.y1 == b.y1 and a.y2 == b.y2;
+}
+
+static bool equal(const color &a, const color &b) {
+	return a.r == b.r and a.g == b.g and a.b == b.b and a.a == b.a;
+}
+
+static bool needs_own_draw_call(Picture *p) {
+	return p->shader or (p->bg_blur > 0);
+}
+
+static mat4 picture_matrix(Picture *p, float r) {
+	if (p->angle == 0)
+		return mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, 0.5f)) * mat4::scale(p->eff_area.width(), p->eff_area.height(), 0);
+	return mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, 0.5f)) * mat4::scale(1/r, 1, 0) * mat4::rotation_z(p->angle) * mat4::scale(p->eff_area.width() * r, p->eff_area.height(), 0);
+}
+
+static void add_quad(Array<DrawVertex> &vertices, const mat4 &m, const color &c, const rect &d, const rect &s) {
+	vec3 p11 = m.transform(vec3(d.x1, d.y1, 0));
+	vec3 p21 = m.transform(vec3(d.x2, d.y1, 0));
+	vec3 p12 = m.transform(vec3(d.x1, d.y2, 0));
+	vec3 p22 = m.transform(vec3(d.x2, d.y2, 0));
+	vertices.add({p11, c, s.x1, s.y1});
+	vertices.add({p21, c, s.x2, s.y1});
+	vertices.add({p22, c, s.x2, s.y2});
+	vertices.add({p11, c, s.x1, s.y1});
+	vertices.add({p22, c, s.x2, s.y2});
+	vertices.add({p12, c, s.x1, s.y2});
+}
+
+// returns true if the geometry changed
+static bool update_picture_geometry(Picture *p, float aspect_ratio) {
+	auto &c = p->draw_cache;
+	int layout_version = 0;
+	if (p->type == Node::Type::TEXT)
+		layout_version = static_cast<Text*>(p)->layout_version;
+	if (c.valid and equal(c.area, p->eff_area) and equal(c.col, p->eff_col) and equal(c.source, p->source) and c.angle == p->angle
+			and c.aspect_ratio == aspect_ratio and c.layout_version == layout_version)
+		return false;
+
+	c.vertices.clear();
+	auto m = picture_matrix(p, aspect_ratio);
+	if (p->type == Node::Type::TEXT) {
+		// glyph quads are already in atlas coordinates
+		for (auto &q: static_cast<Text*>(p)->glyph_quads)
+			add_quad(c.vertices, m, p->eff_col, q.dest, q.source);
+	} else {
+		add_quad(c.vertices, m, p->eff_col, rect::ID, p->source);
+	}
+	c.area = p->eff_area;
+	c.col = p->eff_col;
+	c.source = p->source;
+	c.angle = p->angle;
+	c.aspect_ratio = aspect_ratio;
+	c.layout_version = layout_version;
+	c.valid = true;
+	return true;
+}
+
+void update_draw_list() {
+	bool changed = false;
+	Array<DrawCall> calls;
+	calls.simple_reserve(draw_calls.num);
+	static Array<Picture*> placed;
+	placed.clear();
+	int offset = 0;
+
+	for (auto *n: sorted_nodes) {
+		if (!n->eff_visible)
+			continue;
+		if (n->type != Node::Type::PICTURE and n->type != Node::Type::TEXT)
+			continue;
+		auto *p = static_cast<Picture*>(n);
+
+		if (needs_own_draw_call(p)) {
+			calls.add({p->texture.get(), offset, 0, p});
+			continue;
+		}
+
+		auto &c = p->draw_cache;
+		bool dirty = update_picture_geometry(p, engine.physical_aspect_ratio);
+		if (c.vertices.num == 0)
+			continue;
+
+		// vertices of unchanged nodes are still in place
+		if (dirty or c.offset != offset or c.list_version != draw_list_version)
+			changed = true;
+		if (changed) {
+			draw_vertices.resize(offset + c.vertices.num);
+			memcpy(&draw_vertices[offset], &c.vertices[0], c.vertices.num * sizeof(DrawVertex));
+		}
+		c.offset = offset;
+		placed.add(p);
+
+		if (calls.num > 0 and !calls.back().picture and calls.back().texture == p->texture.get())
+			calls.back().count += c.vertices.num;
+		else
+			calls.add({p->texture.get(), offset, c.vertices.num, nullptr});
+		offset += c.vertices.num;
+	}
+
+	if (draw_vertices.num != offset) {
+		draw_vertices.resize(offset);
+		changed = true;
+	}
+	if (changed)
+		draw_list_version ++;
+	for (auto p: placed)
+		p->draw_cache.list_version = draw_list_version;
+	draw_calls = calls;
+}
+
+}
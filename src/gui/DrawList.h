@@ -0,0 +1,43 @@
+/*
+ * DrawList.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../graphics-fwd.h"
+#include "../lib/base/base.h"
+#include "../lib/math/vec3.h"
+#include "../lib/image/color.h"
+
+namespace gui {
+
+class Picture;
+
+// vertex format "3f,4f,2f", position in [0:1]x[0:1] screen space
+struct DrawVertex {
+	vec3 pos;
+	color col;
+	float u, v;
+};
+
+struct DrawCall {
+	Texture *texture;
+	// consecutive quads sharing a texture are merged into one call
+	int offset, count;
+	// != nullptr: needs a draw of its own (custom shader, background blur)
+	Picture *picture;
+};
+
+// retained list of everything to draw, in z order
+// rebuilt by update(), only dirty nodes regenerate their geometry
+extern Array<DrawVertex> draw_vertices;
+extern Array<DrawCall> draw_calls;
+// increased whenever draw_vertices change
+extern int draw_list_version;
+
+void update_draw_list();
+
+}
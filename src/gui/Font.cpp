@@ -12,6 +12,7 @@
 #include "../lib/image/image.h"
 #include "../lib/os/msg.h"
 #include "../lib/os/filesystem.h"
+#include "../graphics-impl.h"
 
 //#define USE_CAIRO 1
 #if HAS_LIB_FREETYPE2
@@ -43,6 +44,8 @@ FT_Library ft2 = nullptr;
 #endif
 
 const float Font::FONT_SIZE = 30.0f;
+const int Font::ATLAS_SIZE = 1024;
+static const int MAX_CACHED_LAYOUTS = 1024;
 //const float Font::LINE_GAP = 0;//.3f;
 //const float Font::LINE_Y_OFFSET = 1;//0.84f;
 
@@ -355,6 +358,137 @@ float Font::get_height_rel(const string &str) {
 	return (float)get_height(str) / (float)line_height;//FONT_SIZE;
 }
 
+
+void Font::reset_atlas() {
+	if (!atlas_image)
+		atlas_image = new Image;
+	atlas_image->create(ATLAS_SIZE, ATLAS_SIZE, color(0,1,1,1));
+	atlas_image->alpha_used = true;
+	glyphs.clear();
+	layout_cache.clear();
+	pack_x = pack_y = pack_row_height = 0;
+	atlas_generation ++;
+	atlas_dirty = true;
+}
+
+// rasterize on first use
+Font::Glyph Font::get_glyph(int code) {
+	int n = glyphs.find(code);
+	if (n >= 0)
+		return glyphs.by_index(n);
+
+	Glyph g = {rect::EMPTY, 0, 0, 0};
+#ifdef USE_FREETYPE
+	auto ft_face = (FT_Face)face;
+	if (FT_Load_Char(ft_face, code, FT_LOAD_RENDER) == 0) {
+		auto &bm = ft_face->glyph->bitmap;
+		int w = (int)bm.width;
+		int h = (int)bm.rows;
+
+		// shelf packing, 1 pixel gap
+		if (!atlas_image)
+			reset_atlas();
+		if (pack_x + w + 1 > ATLAS_SIZE) {
+			pack_x = 0;
+			pack_y += pack_row_height + 1;
+			pack_row_height = 0;
+		}
+		if (pack_y + h + 1 > ATLAS_SIZE) {
+			msg_write("font atlas full: " + name);
+			reset_atlas();
+		}
+
+		for (int i=0; i<w; i++)
+			for (int j=0; j<h; j++) {
+				float f = (float)bm.buffer[i + j*bm.pitch] / 255.0f;
+				atlas_image->set_pixel(pack_x + i, pack_y + j, color(f, 1,1,1));
+			}
+		g.source = rect((float)pack_x, (float)(pack_x + w), (float)pack_y, (float)(pack_y + h));
+		g.left = ft_face->glyph->bitmap_left;
+		g.top = ft_face->glyph->bitmap_top;
+		g.advance = (int)(ft_face->glyph->advance.x >> 6);
+		pack_x += w + 1;
+		pack_row_height = max(pack_row_height, h);
+		atlas_dirty = true;
+	}
+#endif
+	glyphs.set(code, g);
+	return g;
+}
+
+Font::TextLayout Font::layout(const string &str, Node::Align align) {
+	string key = ((align & Node::Align::RIGHT) ? "r:" : "l:") + str;
+	int n = layout_cache.find(key);
+	if (n >= 0)
+		return layout_cache.by_index(n);
+
+	return _layout(key, str, align, true);
+}
+
+Font::TextLayout Font::_layout(const string &key, const string &str, Node::Align align, bool allow_retry) {
+	int generation = atlas_generation;
+	TextLayout l;
+	auto lines = str.explode("\n");
+
+	// line widths, same metrics as ft_get_text_width_single_line()
+	Array<Array<int>> codes;
+	Array<int> line_width;
+	for (auto &line: lines) {
+		auto utf32 = line.utf8_to_utf32();
+		int x = 0;
+		foreachi (int u, utf32, i) {
+			auto g = get_glyph(u);
+			if (i == utf32.num - 1)
+				x += max(g.advance, g.left + (int)g.source.width());
+			else
+				x += g.advance;
+		}
+		codes.add(utf32);
+		line_width.add(x);
+		l.width = max(l.width, x);
+	}
+	l.height = get_height(str);
+
+	int y = (int)(line_y_offset * (float)line_height + 0.5f);
+	foreachi (auto &utf32, codes, line_no) {
+		int x = 0;
+		if (align & Node::Align::RIGHT)
+			x = l.width - line_width[line_no];
+		for (int u: utf32) {
+			auto g = get_glyph(u);
+			if (g.source.width() > 0 and g.source.height() > 0) {
+				float x0 = (float)(x + g.left);
+				float y0 = (float)(y - g.top);
+				l.quads.add({rect(x0, x0 + g.source.width(), y0, y0 + g.source.height()),
+						rect(g.source.x1 / ATLAS_SIZE, g.source.x2 / ATLAS_SIZE, g.source.y1 / ATLAS_SIZE, g.source.y2 / ATLAS_SIZE)});
+			}
+			x += g.advance;
+		}
+		y += line_height;
+	}
+
+	// atlas was rebuilt in between
+	if (generation != atlas_generation and allow_retry)
+		return _layout(key, str, align, false);
+
+	if (layout_cache.num >= MAX_CACHED_LAYOUTS)
+		layout_cache.clear();
+	layout_cache.set(key, l);
+	return l;
+}
+
+void Font::update_atlas() {
+	if (!atlas_image)
+		reset_atlas();
+	if (!atlas)
+		atlas = new Texture();
+	if (!atlas_dirty)
+		return;
+	atlas->write(*atlas_image);
+	atlas->set_options("magfilter=linear,wrap=clamp");
+	atlas_dirty = false;
+}
+
 }
 
 
@@ -10,6 +10,8 @@
 //#include "../lib/base/base.h"
 //#include "gui.h"
 #include "Node.h"
+#include "../graphics-fwd.h"
+#include "../lib/base/map.h"
 
 class Image;
 
@@ -30,6 +32,38 @@ public:
 	int get_height(const string &str);
 	float get_height_rel(const string &str);
 
+	// glyphs are rasterized once (at FONT_SIZE) into a texture atlas shared by all texts
+	struct Glyph {
+		rect source; // atlas pixels
+		int left, top; // bitmap offset from the pen position
+		int advance;
+	};
+	struct GlyphQuad {
+		rect dest; // pixels, relative to the text's top left corner
+		rect source; // atlas [0:1]
+	};
+	struct TextLayout {
+		Array<GlyphQuad> quads;
+		int width = 0, height = 0;
+	};
+	Glyph get_glyph(int code);
+	TextLayout layout(const string &str, Node::Align align);
+	TextLayout _layout(const string &key, const string &str, Node::Align align, bool allow_retry);
+	void update_atlas();
+
+	static const int ATLAS_SIZE;
+	shared<Texture> atlas;
+	owned<Image> atlas_image;
+	bool atlas_dirty = false;
+	// increased whenever the atlas is full and gets rebuilt
+	int atlas_generation = 0;
+	base::map<int, Glyph> glyphs;
+	int pack_x = 0, pack_y = 0, pack_row_height = 0;
+	void reset_atlas();
+
+	// shaped strings, cleared when growing too large
+	base::map<string, TextLayout> layout_cache;
+
 	static const float FONT_SIZE;
 	//static const float LINE_GAP;
 	//static const float LINE_Y_OFFSET;
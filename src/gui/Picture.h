@@ -9,6 +9,7 @@
 
 #include "../graphics-fwd.h"
 #include "Node.h"
+#include "DrawList.h"
 #include "../lib/any/any.h"
 
 namespace gui {
@@ -30,6 +31,17 @@ public:
 	shared<Shader> shader;
 	shared<Texture> texture;
 	Any shader_data;
+
+	// screen space geometry for the draw list, regenerated when dirty
+	struct DrawCache {
+		Array<DrawVertex> vertices;
+		rect area, source;
+		color col;
+		float angle = 0, aspect_ratio = 0;
+		int layout_version = 0;
+		bool valid = false;
+		int offset = -1, list_version = -1;
+	} draw_cache;
 };
 
 }
@@ -40,25 +40,53 @@ void Text::__delete__() {
 void Text::rebuild() {
 	if (!font)
 		return;
-	Image im;
-	font->render_text(text, align, im);
-	if (im.width == 0 or im.height == 0)
-		im.create(1,1, color(0,0,0,0));
+	auto l = font->layout(text, align);
+	font->update_atlas();
+	texture = font->atlas;
+	atlas_generation = font->atlas_generation;
+	layout_align = align;
 
-	if (texture == nullptr)
-		texture = new Texture();
-
-	texture->write(im);
-	//texture->set_options("magfilter=nearest,wrap=clamp");
-	texture->set_options("magfilter=linear,wrap=clamp");
+	float w = (float)max(l.width, 1);
+	float h = (float)max(l.height, 1);
+	glyph_quads.clear();
+	for (auto &q: l.quads)
+		glyph_quads.add({rect(q.dest.x1 / w, q.dest.x2 / w, q.dest.y1 / h, q.dest.y2 / h), q.source});
+	num_glyphs = l.quads.num;
+	layout_version ++;
 
 	height = font_size * font->get_height_rel(text);
-	width = height * (float)im.width / (float)im.height;
+	width = height * w / h;
 	if (align & Align::NONSQUARE)
 		 width /= engine.physical_aspect_ratio;
 }
 
+// the batched draw list reads glyph_quads directly
+VertexBuffer *Text::update_vertex_buffer() {
+	if (!vertex_buffer)
+		vertex_buffer = new VertexBuffer("3f,3f,2f");
+	if (vertex_buffer_version == layout_version)
+		return vertex_buffer.get();
+	Array<Vertex1> vertices;
+	for (auto &q: glyph_quads) {
+		auto &d = q.dest;
+		auto &s = q.source;
+		vertices.add({{d.x1,d.y1,0}, {0,0,1}, s.x1,s.y1});
+		vertices.add({{d.x2,d.y1,0}, {0,0,1}, s.x2,s.y1});
+		vertices.add({{d.x2,d.y2,0}, {0,0,1}, s.x2,s.y2});
+		vertices.add({{d.x1,d.y1,0}, {0,0,1}, s.x1,s.y1});
+		vertices.add({{d.x2,d.y2,0}, {0,0,1}, s.x2,s.y2});
+		vertices.add({{d.x1,d.y2,0}, {0,0,1}, s.x1,s.y2});
+	}
+	if (vertices.num > 0)
+		vertex_buffer->update(vertices);
+	vertex_buffer_version = layout_version;
+	return vertex_buffer.get();
+}
+
 void Text::set_text(const string &t) {
+	// per frame updates with the same content are free
+	if (t == text and font and atlas_generation == font->atlas_generation and layout_align == align)
+		return;
 	text = t;
 	rebuild();
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "Picture.h"
+#include "Font.h"
 
 namespace gui {
 
@@ -26,6 +27,17 @@ public:
 	string text;
 	float font_size;
 	Font *font;
+
+	// one quad per glyph in [0:1]x[0:1], sampling font->atlas (= texture)
+	Array<Font::GlyphQuad> glyph_quads;
+	int layout_version = 0;
+	// only for drawing with a custom shader, built on demand
+	owned<VertexBuffer> vertex_buffer;
+	int vertex_buffer_version = -1;
+	VertexBuffer *update_vertex_buffer();
+	int num_glyphs = 0;
+	int atlas_generation = -1;
+	Align layout_align = Align::NONE;
 };
 
 }
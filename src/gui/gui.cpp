@@ -8,6 +8,8 @@
 #include "gui.h"
 #include "Node.h"
 #include "Font.h"
+#include "Text.h"
+#include "DrawList.h"
 #include "../meta.h"
 #include "../lib/math/rect.h"
 #include "../lib/math/vec3.h"
@@ -23,6 +25,7 @@ namespace gui {
 Array<Node*> all_nodes;
 Array<Node*> sorted_nodes;
 shared<Node> toplevel;
+static bool tree_changed = true;
 //static int ch_gui_iter = -1;
 
 
@@ -41,6 +44,7 @@ void reset() {
 
 	all_nodes = {};
 	sorted_nodes = {};
+	tree_changed = true;
 }
 
 void add_to_node_list(Node *n) {
@@ -53,19 +57,36 @@ void update_tree() {
 	all_nodes.clear();
 	if (toplevel)
 		add_to_node_list(toplevel.get());
+	tree_changed = true;
 	update();
 }
 
 void update() {
+	// glyph atlas was rebuilt
+	for (auto n: all_nodes)
+		if (n->type == Node::Type::TEXT) {
+			auto t = static_cast<Text*>(n);
+			if (t->font and t->atlas_generation != t->font->atlas_generation)
+				t->rebuild();
+		}
+
 	if (toplevel)
 		toplevel->update_geometry(rect::ID);
 
-	sorted_nodes = all_nodes;
-	//std::sort(sorted_nodes.begin(), sorted_nodes.end(), [](Node *a, Node *b) { return a->eff_z < b->eff_z; });
-	for (int i=0; i<sorted_nodes.num; i++)
-		for (int j=i+1; j<sorted_nodes.num; j++)
-			if (sorted_nodes[i]->eff_z > sorted_nodes[j]->eff_z)
-				sorted_nodes.swap(i, j);
+	// keep the previous order, so the (stable) insertion sort is ~linear when z rarely changes
+	if (tree_changed) {
+		sorted_nodes = all_nodes;
+		tree_changed = false;
+	}
+	for (int i=1; i<sorted_nodes.num; i++) {
+		auto n = sorted_nodes[i];
+		int j = i - 1;
+		for (; j>=0 and sorted_nodes[j]->eff_z > n->eff_z; j--)
+			sorted_nodes[j + 1] = sorted_nodes[j];
+		sorted_nodes[j + 1] = n;
+	}
+
+	update_draw_list();
 
 
 	//for (auto *p: all_nodes) {
@@ -97,8 +118,9 @@ void iterate(float dt) {
 #ifdef _X_ALLOW_X_
 	PerformanceMonitor::begin(ch_gui_iter);
 #endif
-	auto nodes = all_nodes;
 	// tree might change...
+	static Array<Node*> nodes;
+	nodes = all_nodes;
 	for (auto n: nodes) {
 		if (n->visible) {
 #if 0
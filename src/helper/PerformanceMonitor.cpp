@@ -6,10 +6,13 @@
  */
 
 #include "PerformanceMonitor.h"
+#include <mutex>
 
 int PerformanceMonitor::frames = -1;
 bool PerformanceMonitor::just_cleared = true;
 std::chrono::high_resolution_clock::time_point PerformanceMonitor::frame_start;
+std::chrono::high_resolution_clock::time_point PerformanceMonitor::previous_frame_start;
+static std::mutex async_mutex;
 float PerformanceMonitor::temp_frame_time = 0;
 float PerformanceMonitor::avg_frame_time = 0;
 float PerformanceMonitor::frame_dt = 0;
@@ -59,7 +62,26 @@ void PerformanceMonitor::end_gpu(int channel, float t) {
 	current_frame_timing.gpu.add({channel, t});
 }
 
+void PerformanceMonitor::add_async(int channel, std::chrono::high_resolution_clock::time_point begin, std::chrono::high_resolution_clock::time_point end) {
+	std::lock_guard<std::mutex> lock(async_mutex);
+	auto *timing = &current_frame_timing;
+	auto start = frame_start;
+	if (begin < frame_start) {
+		timing = &previous_frame_timing;
+		start = previous_frame_start;
+	}
+	timing->cpu1.add({channel, std::chrono::duration<float, std::chrono::seconds::period>(begin - start).count()});
+	timing->cpu1.add({channel | (int)0x80000000, std::chrono::duration<float, std::chrono::seconds::period>(end - start).count()});
+	channels[channel].dt += std::chrono::duration<float, std::chrono::seconds::period>(end - begin).count();
+	channels[channel].count ++;
+}
+
+void PerformanceMonitor::add_uniform_uploads(int n) {
+	current_frame_timing.uniform_uploads += n;
+}
+
 void PerformanceMonitor::next_frame() {
+	std::lock_guard<std::mutex> lock(async_mutex);
 	auto now = std::chrono::high_resolution_clock::now();
 
 	current_frame_timing.total_time = std::chrono::duration<float, std::chrono::seconds::period>(now - frame_start).count();
@@ -68,6 +90,7 @@ void PerformanceMonitor::next_frame() {
 		frame_dt = std::chrono::duration<float, std::chrono::seconds::period>(now - frame_start).count();
 		temp_frame_time += frame_dt;
 	}
+	previous_frame_start = frame_start;
 	frame_start = now;
 	frames ++;
 	just_cleared = false;
@@ -84,4 +107,6 @@ void PerformanceMonitor::next_frame() {
 	current_frame_timing.cpu0.simple_reserve(256);
 	current_frame_timing.gpu.clear();
 	current_frame_timing.gpu.simple_reserve(256);
+	current_frame_timing.cpu1.clear();
+	current_frame_timing.uniform_uploads = 0;
 }
@@ -43,6 +43,9 @@ struct FrameTimingData {
 	Array<TimingData> cpu0;
 	Array<TimingData> gpu;
 	float total_time;
+	int uniform_uploads = 0;
+	// work running in parallel to the main thread
+	Array<TimingData> cpu1;
 };
 
 class PerformanceMonitor {
@@ -58,13 +61,18 @@ public:
 	static void begin_gpu(int channel, float t);
 	static void end_gpu(int channel, float t);
 
+	// thread safe, assigned to the frame in which it started
+	static void add_async(int channel, std::chrono::high_resolution_clock::time_point begin, std::chrono::high_resolution_clock::time_point end);
+
 	static void next_frame();
+	static void add_uniform_uploads(int n);
 	static void _reset();
 
 
 	static int frames;
 	static bool just_cleared;
 	static std::chrono::high_resolution_clock::time_point frame_start;
+	static std::chrono::high_resolution_clock::time_point previous_frame_start;
 
 	static float temp_frame_time;
 	static float avg_frame_time;
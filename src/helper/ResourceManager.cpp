@@ -3,6 +3,7 @@
 #include <lib/os/file.h>
 #include <lib/os/msg.h>
 #include <lib/nix/nix.h>
+#include <lib/threads/ThreadedWork.h>
 #include <lib/image/image.h>
 #if __has_include(<lib/xhui/xhui.h>)
 	#include <lib/xhui/xhui.h>
@@ -29,6 +30,9 @@ namespace vulkan {
 #endif
 
 
+// binding 5: shadow cascades (MAX_SHADOW_CASCADES), binding 6: unused
+static const string SURFACE_SHADER_BINDINGS = "[[sampler,sampler,sampler,sampler,sampler,sampler*4,.,sampler,buffer,buffer,buffer,buffer]]";
+
 ResourceManager::ResourceManager(Context *_ctx) {
 	ctx = _ctx;
 	material_manager = new MaterialManager(this);
@@ -149,6 +153,13 @@ string ResourceManager::expand_geometry_shader_source(const string &source, cons
 	return source + format("\n<GeometryShader>\n#import geometry-%s\n</GeometryShader>", variant);
 }
 
+string ResourceManager::expand_surface_shader_source(const string &source, const string &render_path, const string &vertex_module, const string &geometry_module) {
+	string r = expand_vertex_shader_source(source, vertex_module);
+	if (geometry_module != "")
+		r = expand_geometry_shader_source(r, geometry_module);
+	return expand_fragment_shader_source(r, render_path);
+}
+
 shared<Shader> ResourceManager::load_surface_shader(const Path& _filename, const string &render_path, const string &vertex_module, const string &geometry_module) {
 	//msg_write("load_surface_shader: " + str(_filename) + "  " + render_path + "  " + vertex_module + "  " + geometry_module);
 	//select_default_vertex_module("vertex-" + variant);
@@ -185,12 +196,9 @@ shared<Shader> ResourceManager::load_surface_shader(const Path& _filename, const
 
 	msg_write("loading shader: " + str(fnx));
 
-	string source = expand_vertex_shader_source(os::fs::read_text(fn), vertex_module);
-	if (geometry_module != "")
-		source = expand_geometry_shader_source(source, geometry_module);
-	source = expand_fragment_shader_source(source, render_path);
+	string source = expand_surface_shader_source(os::fs::read_text(fn), render_path, vertex_module, geometry_module);
 
-	auto shader = __create_shader(source, "[[sampler,sampler,sampler,sampler,sampler,sampler,sampler,sampler,buffer,buffer,buffer,buffer]]");
+	auto shader = __create_shader(source, SURFACE_SHADER_BINDINGS);
 
 	//auto s = Shader::load(fn);
 #ifdef USING_VULKAN
@@ -208,6 +216,9 @@ shared<Shader> ResourceManager::load_surface_shader(const Path& _filename, const
 
 	shaders.add(shader);
 	shader_map.add({fnx, shader});
+
+	if (!shader_cache_dir.is_empty())
+		shader_variants.add({filename, render_path, vertex_module, geometry_module});
 	return shader;
 }
 
@@ -263,6 +274,77 @@ shared<Texture> ResourceManager::load_texture(const Path& filename) {
 	}
 }
 
+void ResourceManager::set_shader_cache_dir(const Path &dir) {
+	shader_cache_dir = dir;
+	shader_variants.clear();
+	if (!dir.is_empty()) {
+		try {
+			os::fs::create_directory(dir);
+		} catch (Exception &e) {
+			msg_error("shader cache disabled: " + e.message());
+			shader_cache_dir = Path::EMPTY;
+		}
+	}
+#ifdef USING_VULKAN
+	vulkan::Shader::cache_directory = shader_cache_dir;
+#else
+	if (ctx)
+		ctx->shader_cache_dir = shader_cache_dir;
+#endif
+	if (!shader_cache_dir.is_empty())
+		shader_variants.load(shader_cache_dir | "variants");
+}
+
+#ifdef USING_VULKAN
+class ShaderPrecompileWork : public ThreadedWork {
+public:
+	Array<string> sources;
+	void on_step(int index, int worker_id) override {
+		try {
+			vulkan::Shader::precompile(sources[index]);
+		} catch (Exception &e) {
+			// reported again, when actually loading
+		}
+	}
+};
+#endif
+
+// compile all known variants before the first frame
+//   vulkan: in parallel, only filling the SPIR-V cache
+//   gl: sequentially (no shared contexts), only variants without a cached program binary,
+//       which are dropped again right after linking
+void ResourceManager::precompile_shader_variants() {
+	if (shader_variants.variants.num == 0)
+		return;
+	msg_write(format("precompiling %d shader variants", shader_variants.variants.num));
+#ifdef USING_VULKAN
+	ShaderPrecompileWork work;
+#endif
+	for (auto &v: shader_variants.variants) {
+		try {
+			Path fn = guess_absolute_path(v.filename, {shader_dir, Application::directory_static | "shader"});
+			if (fn.is_empty())
+				continue;
+			string source = expand_surface_shader_source(os::fs::read_text(fn), v.render_path, v.vertex_module, v.geometry_module);
+#ifdef USING_VULKAN
+			work.sources.add(source);
+#else
+			if (!ctx->has_cached_shader(source))
+				owned<Shader> s(ctx->create_shader(source));
+#endif
+		} catch (Exception &e) {
+			msg_error(e.message());
+		}
+	}
+#ifdef USING_VULKAN
+	// the workers read the global bindings
+	string prev_bindings = vulkan::overwrite_bindings;
+	vulkan::overwrite_bindings = SURFACE_SHADER_BINDINGS;
+	work.run(work.sources.num, 1);
+	vulkan::overwrite_bindings = prev_bindings;
+#endif
+}
+
 void ResourceManager::clear() {
 	shaders.clear();
 	shader_map.clear();
@@ -4,6 +4,7 @@
 #include <lib/base/pointer.h>
 #include <lib/base/map.h>
 #include <lib/os/path.h>
+#include "ShaderVariantCache.h"
 
 
 class string;
@@ -26,6 +27,7 @@ public:
 	string expand_vertex_shader_source(const string &source, const string &variant);
 	string expand_fragment_shader_source(const string &source, const string &render_path);
 	string expand_geometry_shader_source(const string &source, const string &variant);
+	string expand_surface_shader_source(const string &source, const string &render_path, const string &vertex_module, const string &geometry_module);
 	void load_shader_module(const Path& path);
 	xfer<Material> load_material(const Path &filename);
 	xfer<Model> load_model(const Path &filename);
@@ -38,6 +40,13 @@ public:
 	Path default_shader;
 	void clear();
 
+	// compiled shaders (SPIR-V / gl program binaries), keyed by the hash of their expanded source
+	Path shader_cache_dir;
+	void set_shader_cache_dir(const Path &dir);
+	// surface shader variants used in previous runs
+	ShaderVariantCache shader_variants;
+	void precompile_shader_variants();
+
 
 	shared_array<Shader> shaders;
 	Array<Path> shader_modules;
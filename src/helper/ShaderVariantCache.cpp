@@ -0,0 +1,62 @@
+/*
+ * ShaderVariantCache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "ShaderVariantCache.h"
+#include "../lib/os/file.h"
+#include "../lib/os/filesystem.h"
+#include "../lib/os/msg.h"
+#include "../lib/base/pointer.h"
+
+bool ShaderVariant::operator==(const ShaderVariant &o) const {
+	return filename == o.filename and render_path == o.render_path and vertex_module == o.vertex_module and geometry_module == o.geometry_module;
+}
+
+string ShaderVariant::encode() const {
+	return str(filename) + "\t" + render_path + "\t" + vertex_module + "\t" + geometry_module;
+}
+
+base::optional<ShaderVariant> ShaderVariant::decode(const string &line) {
+	auto xx = line.replace("\r", "").explode("\t");
+	if (xx.num != 4 or xx[0].num == 0)
+		return base::None;
+	return ShaderVariant{xx[0], xx[1], xx[2], xx[3]};
+}
+
+void ShaderVariantCache::load(const Path &_filename) {
+	clear();
+	filename = _filename;
+	if (filename.is_empty() or !os::fs::exists(filename))
+		return;
+	try {
+		for (auto &l: os::fs::read_text(filename).explode("\n"))
+			if (auto v = ShaderVariant::decode(l))
+				if (variants.find(*v) < 0)
+					variants.add(*v);
+	} catch (Exception &e) {
+		msg_error(e.message());
+	}
+}
+
+void ShaderVariantCache::clear() {
+	filename = Path::EMPTY;
+	variants.clear();
+}
+
+bool ShaderVariantCache::add(const ShaderVariant &v) {
+	if (variants.find(v) >= 0)
+		return false;
+	variants.add(v);
+	if (filename.is_empty())
+		return true;
+	try {
+		owned<os::fs::FileStream> f(os::fs::open(filename, "at"));
+		f->write(v.encode() + "\n");
+	} catch (Exception &e) {
+		msg_error(e.message());
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+/*
+ * ShaderVariantCache.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#ifndef SRC_HELPER_SHADERVARIANTCACHE_H_
+#define SRC_HELPER_SHADERVARIANTCACHE_H_
+
+#include "../lib/base/base.h"
+#include "../lib/base/optional.h"
+#include "../lib/os/path.h"
+
+// one surface shader, as requested by load_surface_shader()
+struct ShaderVariant {
+	Path filename;
+	string render_path;
+	string vertex_module;
+	string geometry_module;
+
+	bool operator==(const ShaderVariant &o) const;
+
+	// tab separated, since paths might contain ':' (windows)
+	string encode() const;
+	static base::optional<ShaderVariant> decode(const string &line);
+};
+
+// variants used in previous runs, one line each
+//   new variants are appended, the file is never rewritten
+class ShaderVariantCache {
+public:
+	void load(const Path &filename);
+	void clear();
+
+	// true if new
+	bool add(const ShaderVariant &v);
+
+	Path filename;
+	Array<ShaderVariant> variants;
+};
+
+#endif /* SRC_HELPER_SHADERVARIANTCACHE_H_ */
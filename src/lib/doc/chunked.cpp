@@ -234,7 +234,7 @@ void FileChunkBasic::_clamp_name_rec(int length) {
 }
 
 bool ChunkedFileParser::read(const Path &filename, void *p) {
-	auto f = os::fs::open(filename, "rb");
+	auto f = os::fs::open(filename, "rbc");
 	context.f = f;
 	//context.push(Context::Layer(name, 0, f->GetSize()));
 
@@ -251,7 +251,7 @@ bool ChunkedFileParser::read(const Path &filename, void *p) {
 }
 
 bool ChunkedFileParser::write(const Path &filename, void *p) {
-	auto *f = os::fs::open(filename, "wb");
+	auto *f = os::fs::open(filename, "wbc");
 	context.f = f;
 	//context->push(Context::Layer(name, 0, 0));
 
@@ -11,9 +11,6 @@
 
 namespace xml{
 
-int nn = 0;
-const int NMAX = 1000000;
-
 SyntaxError::SyntaxError() : Exception("xml syntax error") {}
 
 
@@ -26,76 +23,79 @@ string decode_text(const string& s) {
 	return s.replace("&quot;", "\"").replace("&apos;", "\'").replace("&gt;", ">").replace("&lt;", "<").replace("&amp;", "&");
 }
 
-void skip_until_char(Stream *f, char c) {
-	while (!f->is_end()) {
-		char cc;
-		f->read(&cc, 1);
-		if (cc == c)
-			return;
+// the parser works in-place on the complete (memory mapped) file contents
+struct Source {
+	const char *p, *end;
+};
+
+// a token, pointing into the source
+struct View {
+	const char *p;
+	int len;
+	bool operator==(const char *s) const {
+		int n = (int)strlen(s);
+		return (len == n) and (memcmp(p, s, n) == 0);
 	}
-	throw EndOfFile();
+	bool operator!=(const char *s) const {
+		return !(*this == s);
+	}
+	string str() const {
+		return string(p, len);
+	}
+};
+
+void skip_until_char(Source &s, char c) {
+	auto q = (const char*)memchr(s.p, c, s.end - s.p);
+	if (!q) {
+		s.p = s.end;
+		throw EndOfFile();
+	}
+	s.p = q + 1;
 }
 
 bool is_whitespace(char c) {
 	return (c == ' ' or c == '\t' or c == '\n' or c == '\r');
 }
 
-char skip_whitespace(Stream *f, bool back = true) {
-	while (!f->is_end()) {
-		char c;
-		f->read(&c, 1);
-		if (is_whitespace(c))
-			continue;
-		if (back)
-			f->seek(-1);
-		return c;
+char next_non_whitespace(Source &s) {
+	while (s.p < s.end) {
+		char c = *(s.p ++);
+		if (!is_whitespace(c))
+			return c;
 	}
 	throw EndOfFile();
 	return ' ';
 }
 
-char next_non_whitespace(Stream *f) {
-	return skip_whitespace(f, false);
-}
-
-string read_next_exp(Stream *f) {
-	string e;
-	char c0 = next_non_whitespace(f);
-	if (c0 == '=')
-		return "=";
-	if (c0 == '>')
-		return ">";
-	if (c0 == '<')
-		return "<";
-	if (c0 == '/')
-		return "/";
-	if (c0 == '?')
-		return "?";
+View read_next_exp(Source &s) {
+	char c0 = next_non_whitespace(s);
+	const char *start = s.p - 1;
+	if ((c0 == '=') or (c0 == '>') or (c0 == '<') or (c0 == '/') or (c0 == '?'))
+		return {start, 1};
 	bool in_string = (c0 == '\"') or (c0 == '\'');
 	if (in_string) {
-		while (!f->is_end()) {
-			char c;
-			f->read(&c, 1);
-			if (c == c0)
-				return e;
-			e.add(c);
-		}
-		throw EndOfFile();
-		return e;
+		auto q = (const char*)memchr(s.p, c0, s.end - s.p);
+		if (!q)
+			throw EndOfFile();
+		View v = {s.p, (int)(q - s.p)};
+		s.p = q + 1;
+		return v;
 	}
 
-	e.add(c0);
-	while (!f->is_end()) {
-		char c;
-		f->read(&c, 1);
-		if (is_whitespace(c) or (c == '=') or (c == '>') or (c == '<')) {
-			f->seek(-1);
-			return e;
-		}
-		e.add(c);
+	while (s.p < s.end) {
+		char c = *s.p;
+		if (is_whitespace(c) or (c == '=') or (c == '>') or (c == '<'))
+			return {start, (int)(s.p - start)};
+		s.p ++;
 	}
 	throw EndOfFile();
-	return e;
+	return {start, 0};
+}
+
+string decode_text(const View &v) {
+	if (!memchr(v.p, '&', v.len))
+		return v.str();
+	return decode_text(v.str());
 }
 
 Element::Element(const string &_tag, const string &_text) {
@@ -144,18 +144,25 @@ string Element::value(const string &key, const string &def) {
 }
 
 void Parser::load(const Path &filename) {
-	auto *f = os::fs::open(filename, "rb");
-
-	while(true) {
-		try{
-			Element e = read_element(f);
-			//msg_write(e.tag);
-			if ((e.tag != "!--") and (e.tag != "!DOCTYPE") and (e.tag != "?xml"))
-				elements.add(e);
-		}catch (EndOfFile &eof) {
-			//msg_write("eof");
-
-			//show();
+	owned<os::fs::FileStream> f(os::fs::open(filename, "rbm"));
+	if (auto m = dynamic_cast<os::fs::MmapStream*>(f.get())) {
+		parse(m->data, m->data_size);
+	} else {
+		bytes data = f->read_complete();
+		parse((const char*)data.data, data.num);
+	}
+}
+
+void Parser::parse(const char *data, int64 size) {
+	Source s = {data, data + size};
+	while (true) {
+		try {
+			Element e = read_element(s);
+			if ((e.tag != "!--") and (e.tag != "!DOCTYPE") and (e.tag != "?xml")) {
+				elements.resize(elements.num + 1);
+				elements.back() = std::move(e);
+			}
+		} catch (EndOfFile &eof) {
 			return;
 		}
 	}
@@ -186,7 +193,7 @@ void Parser::write_element(Stream *f, Element &e, int indent) {
 }
 
 void Parser::save(const Path &filename) {
-	auto *f = os::fs::open(filename, "wb");
+	auto *f = os::fs::open(filename, "wbc");
 	f->write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
 
 	// should be exactly one root!
@@ -213,131 +220,119 @@ void Parser::show_element(Element &e, const string &pre) {
 		show_element(c, pre + "    ");
 }
 
-void skip_recursive(Stream *f) {
+void skip_recursive(Source &s) {
 	int level = 0;
-	while(!f->is_end()) {
-		char c;
-		f->read(&c, 1);
-		if (c == '<') {
+	while (s.p < s.end) {
+		char c = *(s.p ++);
+		if (c == '<')
 			level += 1;
-			//msg_write("<<");
-		} else if (c == '>') {
-			//msg_write(">>");
+		else if (c == '>')
 			level -= 1;
-		}//else
-			//msg_write(string(&c, 1));
 		if (level < 0)
 			return;
 	}
 	throw EndOfFile();
 }
 
-Element Parser::read_element(Stream *f) {
-	//msg_write("<< element");
-	Element e;
-	e = read_tag(f);
-	if (e.single or e.closing) {
-		//msg_write("-----single/cl");
-		//msg_write(">> element");
-		return e;
-	}
-	if (nn > NMAX)
-		return e;
-	//msg_write("content....");
-	while (!f->is_end()) {
-		char c;
-		f->read(&c, 1);
-		if (c == '<') {
-			f->seek(-1);
-			break;
+void skip_comment(Source &s) {
+	for (; s.p + 2 < s.end; s.p ++)
+		if (s.p[0] == '-' and s.p[1] == '-' and s.p[2] == '>') {
+			s.p += 3;
+			return;
 		}
-		e.text.add(c);
-	}
-	e.text = e.text.trim();
-	while (!f->is_end()) {
-		Element ee = read_element(f);
-		if (ee.closing and (ee.tag == e.tag)) {
-			//msg_write(">> element (with closing)");
+	s.p = s.end;
+	throw EndOfFile();
+}
+
+Element Parser::read_element(Source &s) {
+	Element e = read_tag(s);
+	if (e.single or e.closing)
+		return e;
+
+	// text content
+	auto q = (const char*)memchr(s.p, '<', s.end - s.p);
+	if (!q)
+		q = s.end;
+	const char *t0 = s.p, *t1 = q;
+	while (t0 < t1 and is_whitespace(*t0))
+		t0 ++;
+	while (t1 > t0 and is_whitespace(t1[-1]))
+		t1 --;
+	if (t1 > t0)
+		e.text = string(t0, (int)(t1 - t0));
+	s.p = q;
+
+	while (s.p < s.end) {
+		Element ee = read_element(s);
+		if (ee.closing and (ee.tag == e.tag))
 			return e;
+		if (ee.tag != "!--") {
+			// move, don't deep copy the subtree
+			e.elements.resize(e.elements.num + 1);
+			e.elements.back() = std::move(ee);
 		}
-		//msg_write(">>>>  child");
-		if (ee.tag != "!--")
-			e.elements.add(ee);
-		if (nn > NMAX)
-			return e;
 	}
-	//msg_write(">> element");
 	return e;
 }
 
-Element Parser::read_tag(Stream *f) {
-	nn ++;
-	//msg_write("--tag");
+Element Parser::read_tag(Source &s) {
 	Element e;
 	e.single = false;
 	e.closing = false;
-	skip_until_char(f, '<');
-	e.tag = read_next_exp(f);
-	if (e.tag == "?") {
-		e.tag += read_next_exp(f);
+	skip_until_char(s, '<');
+
+	if (s.end - s.p >= 3 and memcmp(s.p, "!--", 3) == 0) {
+		s.p += 3;
+		skip_comment(s);
+		e.tag = "!--";
 		e.single = true;
+		return e;
 	}
-	if (e.tag == "/") {
-		e.closing = true;
-		e.tag = read_next_exp(f);
-	}
-	//msg_write("             tag: " + (e.closing ? string("/") : string("")) + e.tag);
 
-	if (e.tag == "!--") {
+	auto tag = read_next_exp(s);
+	if (tag == "?") {
+		e.tag = "?" + read_next_exp(s).str();
 		e.single = true;
-		return e;
+	} else if (tag == "/") {
+		e.closing = true;
+		e.tag = read_next_exp(s).str();
+	} else {
+		e.tag = tag.str();
 	}
 
 	if ((e.tag == "!ELEMENT") or (e.tag == "!DOCTYPE")) {
-		skip_recursive(f);
+		skip_recursive(s);
 		e.single = true;
 		return e;
 	}
 
-	//msg_write("aaa");
-
 	// attributes
-	while (!f->is_end()) {
-		string s = read_next_exp(f);
-		//msg_write(s);
-		if (s == "?")
+	while (s.p < s.end) {
+		auto v = read_next_exp(s);
+		if (v == "?")
 			continue;
-		if (s == ">") {
-			//msg_write("-end");
+		if (v == ">")
 			return e;
-		}
 
 		// />
-		if (s == "/") {
-			s = read_next_exp(f);
-			if (s != ">")
+		if (v == "/") {
+			if (read_next_exp(s) != ">")
 				throw SyntaxError();
 			e.single = true;
 			return e;
 		}
 
-		//msg_write("attr...");
 		Attribute a;
-		a.key = s;
-		s = read_next_exp(f);
-		if (s != "=")
+		a.key = v.str();
+		if (read_next_exp(s) != "=")
 			throw SyntaxError();
-		a.value = decode_text(read_next_exp(f));
+		a.value = decode_text(read_next_exp(s));
 		e.attributes.add(a);
 	}
 
-	//skip_until_char(f, '>');
 	throw EndOfFile();
 	return e;
 }
 
 
 }
-
-
-
@@ -15,6 +15,8 @@ class Path;
 
 namespace xml{
 
+struct Source;
+
 class SyntaxError : public Exception {
 public:
 	SyntaxError();
@@ -47,9 +49,11 @@ struct Element : Tag {
 class Parser {
 public:
 	void _cdecl load(const Path &filename);
+	// in-place, data must stay valid while parsing
+	void parse(const char *data, int64 size);
 
-	Element read_element(Stream *f);
-	Element read_tag(Stream *f);
+	Element read_element(Source &s);
+	Element read_tag(Source &s);
 
 	void _cdecl save(const Path &filename);
 	void write_element(Stream *f, Element &e, int indent);
@@ -1,10 +1,12 @@
 #include "../kaba.h"
 #include "lib.h"
+#include "../../base/callable.h"
 
 #if __has_include("../../threads/Thread.h")
 	#include "../../threads/Thread.h"
 	#include "../../threads/Mutex.h"
 	#include "../../threads/ThreadedWork.h"
+	#include "../../threads/ThreadPool.h"
 	#define KABA_EXPORT_THREADS
 #endif
 
@@ -20,6 +22,19 @@ namespace kaba {
 	#define thread_p(p)		nullptr
 #endif
 
+#ifdef KABA_EXPORT_THREADS
+	// f is called once per index, chunked automatically
+	void kaba_parallel_for(int n, Callable<void(int)> &f) {
+		ThreadPool::get()->parallel_for(n, [&f] (int first, int end) {
+			for (int i=first; i<end; i++)
+				f(i);
+		});
+	}
+	int kaba_pool_num_workers() {
+		return ThreadPool::get()->num_workers();
+	}
+#endif
+
 
 void SIAddPackageThread(Context *c) {
 	add_package(c, "thread");
@@ -65,6 +80,12 @@ void SIAddPackageThread(Context *c) {
 #endif
 
 
+	auto TypeCallbackInt = add_type_func(TypeVoid, {TypeInt32});
+	add_func("parallel_for", TypeVoid, thread_p(&kaba_parallel_for), Flags::Static);
+		func_add_param("n", TypeInt32);
+		func_add_param("f", TypeCallbackInt);
+	add_func("get_num_workers", TypeInt32, thread_p(&kaba_pool_num_workers), Flags::Static);
+
 	add_func("get_num_cores", TypeInt32, thread_p(&Thread::get_num_cores), Flags::Static);
 	add_func("exit", TypeVoid, thread_p(&Thread::exit), Flags::Static);
 }
@@ -1,4 +1,5 @@
 #include "Box.h"
+#include "mat4.h"
 
 
 vec3 Box::center() const {
@@ -28,3 +29,24 @@ vec3 Box::to_relative(const vec3& p) const {
 }
 
 
+
+bool Box::in_frustum(const mat4& m) const {
+	int outside[6] = {0, 0, 0, 0, 0, 0};
+	for (int i=0; i<8; i++) {
+		vec3 p = vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+		float x = m._00 * p.x + m._01 * p.y + m._02 * p.z + m._03;
+		float y = m._10 * p.x + m._11 * p.y + m._12 * p.z + m._13;
+		float z = m._20 * p.x + m._21 * p.y + m._22 * p.z + m._23;
+		float w = m._30 * p.x + m._31 * p.y + m._32 * p.z + m._33;
+		if (x < -w)	outside[0] ++;
+		if (x > w)	outside[1] ++;
+		if (y < -w)	outside[2] ++;
+		if (y > w)	outside[3] ++;
+		if (z > w)	outside[4] ++;
+		if (w < 0)	outside[5] ++;
+	}
+	for (int k=0; k<6; k++)
+		if (outside[k] == 8)
+			return false;
+	return true;
+}
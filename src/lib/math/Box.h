@@ -2,6 +2,8 @@
 
 #include "vec3.h"
 
+class mat4;
+
 struct Box {
 	vec3 min, max;
 
@@ -10,5 +12,8 @@ struct Box {
 	Box canonical() const;
 	vec3 to_relative(const vec3& p) const;
 	vec3 to_absolute(const vec3& p) const;
+
+	// conservative frustum test (m: clip space from box space), false only if all 8 corners are outside of the same clip plane
+	bool in_frustum(const mat4& m) const;
 };
 
@@ -244,6 +244,15 @@ void query_timestamp(int index) {
 }
 
 
+// queries finish in order, so checking the last one is enough
+bool timestamps_available(int first, int count) {
+	if (count <= 0)
+		return true;
+	GLint available = 0;
+	glGetQueryObjectiv(time_queries[first + count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	return available;
+}
+
 Array<int64> get_timestamps(int first, int count) {
 	Array<int64> result;
 	result.resize(count);
@@ -254,6 +263,22 @@ Array<int64> get_timestamps(int first, int count) {
 
 
 
+Fence::Fence() {
+	sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+Fence::~Fence() {
+	glDeleteSync((GLsync)sync);
+}
+
+bool Fence::is_signaled() const {
+	// timeout 0: don't wait, only flush
+	auto r = glClientWaitSync((GLsync)sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	return (r == GL_ALREADY_SIGNALED) or (r == GL_CONDITION_SATISFIED);
+}
+
+
+
 #define GL_GPU_MEM_INFO_TOTAL_AVAILABLE_MEM_NVX 0x9048
 #define GL_GPU_MEM_INFO_CURRENT_AVAILABLE_MEM_NVX 0x9049
 
@@ -53,6 +53,9 @@ public:
 	string vertex_module_default;
 	Array<ShaderModule> shader_modules;
 
+	// linked programs are stored here (glGetProgramBinary), if not empty
+	Path shader_cache_dir;
+
 	int verbosity = 1;
 	int current_program = 0;
 
@@ -69,9 +72,17 @@ public:
 
 	bool supports_mesh_shaders = false;
 
+	// set_material()
+	owned<UniformBuffer> material_buffer;
+
+	// statistics (reset by the user)
+	int num_uniform_uploads = 0;
+
 
 	xfer<Shader> load_shader(const Path &filename);
 	xfer<Shader> create_shader(const string &source);
+	// a linked program of this source is in shader_cache_dir
+	bool has_cached_shader(const string &source);
 
 	int available_mem() const;
 	int total_mem() const;
@@ -85,8 +96,19 @@ void flush();
 
 void create_query_pool(int size);
 void query_timestamp(int index);
+bool timestamps_available(int first, int count);
 Array<int64> get_timestamps(int first, int count);
 
+// marks the current position in the command stream
+// signaled, once the gpu has processed all commands before it
+class Fence {
+public:
+	Fence();
+	~Fence();
+	bool is_signaled() const;
+	void* sync; // GLsync
+};
+
 enum class FogMode;
 
 // engine properties
@@ -31,6 +31,18 @@ void draw_triangles(VertexBuffer *vb) {
 		glDrawArrays(GL_TRIANGLES, 0, vb->count()); // Starting from vertex 0; 3 vertices total -> 1 triangle
 }
 
+// only non-indexed vertex buffers
+void draw_triangles_range(VertexBuffer *vb, int first, int count) {
+	if (count <= 0)
+		return;
+	// FIXME
+	Context::CURRENT->_current_->set_default_data();
+
+	bind_vertex_buffer(vb);
+
+	glDrawArrays(GL_TRIANGLES, first, count);
+}
+
 void draw_instanced_triangles(VertexBuffer *vb, int count) {
 	if (vb->count() == 0)
 		return;
@@ -42,6 +54,17 @@ void draw_instanced_triangles(VertexBuffer *vb, int count) {
 	glDrawArraysInstanced(GL_TRIANGLES, 0, vb->count(), count); // Starting from vertex 0; 3 vertices total -> 1 triangle
 }
 
+void draw_instanced_triangles_indirect(VertexBuffer *vb, Buffer *args, int offset) {
+	// FIXME
+	Context::CURRENT->_current_->set_default_data();
+
+	bind_vertex_buffer(vb);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, args->buffer);
+	glDrawArraysIndirect(GL_TRIANGLES, (void*)(int_p)offset);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
 
 void draw_lines(VertexBuffer *vb, bool contiguous) {
 	if (vb->count() == 0)
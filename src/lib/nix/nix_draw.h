@@ -15,6 +15,7 @@ namespace nix{
 
 class VertexBuffer;
 class Texture;
+class Buffer;
 
 void _cdecl clear(const color &c);
 void _cdecl clear_color(const color &c);
@@ -22,6 +23,9 @@ void _cdecl clear_z();
 
 void _cdecl draw_triangles(VertexBuffer *vb);
 void _cdecl draw_instanced_triangles(VertexBuffer *vb, int count);
+// instance count etc. read from args (DrawArraysIndirectCommand at offset)
+void _cdecl draw_instanced_triangles_indirect(VertexBuffer *vb, Buffer *args, int offset);
+void _cdecl draw_triangles_range(VertexBuffer *vb, int first, int count);
 void _cdecl draw_lines(VertexBuffer *vb, bool contiguous);
 void _cdecl draw_points(VertexBuffer *vb);
 void draw_mesh_tasks(int offset, int count);
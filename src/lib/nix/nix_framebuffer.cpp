@@ -97,7 +97,9 @@ void FrameBuffer::update_x(const shared_array<Texture> &attachments, int cube_fa
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, target, t->texture, 0);
 		draw_buffers.add(GL_COLOR_ATTACHMENT0 + (unsigned)i);
 	}
-	glDrawBuffers(draw_buffers.num, &draw_buffers[0]);
+	// depth only: glDrawBuffer(GL_NONE) above
+	if (draw_buffers.num > 0)
+		glDrawBuffers(draw_buffers.num, &draw_buffers[0]);
 
 
 	_check();
@@ -18,12 +18,16 @@ Material material;
 
 
 void set_material(const color &albedo, float roughness, float metal, const color &emission) {
-	material.albedo = albedo;
-	material.roughness = roughness;
-	material.metal = metal;
-	//material.specular = (1 - roughness);
-	//material.shininess = 5 / (1.1f - roughness);//shininess;
-	material.emission = emission;
+	Material m = {albedo, emission, roughness, metal, {0, 0}};
+	auto ctx = Context::CURRENT;
+	// only uploading changes
+	if (!ctx->material_buffer.get() or memcmp(&m, &material, sizeof(m)) != 0) {
+		if (!ctx->material_buffer.get())
+			ctx->material_buffer = new UniformBuffer(sizeof(Material));
+		material = m;
+		ctx->material_buffer->update(&material, sizeof(material));
+	}
+	bind_uniform_buffer(BINDING_MATERIAL, ctx->material_buffer.get());
 }
 
 
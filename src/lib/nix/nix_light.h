@@ -17,6 +17,10 @@
 
 namespace nix{
 
+// uniform block "MaterialData" (std140), shared by all shaders
+static constexpr int BINDING_MATERIAL = 2;
+
+// uploads into the context's material buffer and binds it at BINDING_MATERIAL
 void _cdecl set_material(const color &albedo, float roughness, float metal, const color &emission);
 
 
@@ -25,6 +29,7 @@ struct Material {
 	color albedo;
 	color emission;
 	float roughness, metal;
+	float _dummy[2];
 };
 extern Material material;
 
@@ -10,6 +10,7 @@
 #include "nix.h"
 #include "nix_common.h"
 #include "../os/file.h"
+#include "../os/filesystem.h"
 #include "../os/msg.h"
 
 namespace nix {
@@ -134,8 +135,7 @@ string expand_shader_source(Context *ctx, const string &source, ShaderMetaData &
 	return intro + r;
 }
 
-int create_gl_shader(Context* ctx, const string &_source, int type, ShaderMetaData &meta) {
-	string source = expand_shader_source(ctx, _source, meta);
+int create_gl_shader(Context* ctx, const string &source, int type) {
 	if (source.num == 0)
 		return -1;
 	int gl_shader = glCreateShader(type);
@@ -162,6 +162,55 @@ int create_gl_shader(Context* ctx, const string &_source, int type, ShaderMetaDa
 	return gl_shader;
 }
 
+// program binaries are only valid for the exact same driver
+string program_binary_key(Context* ctx, const Array<ShaderSourcePart> &parts) {
+	string key = ctx->gl_renderer + "\n" + ctx->gl_version + "\n";
+	for (auto &p: parts)
+		key += format("<%d>\n", p.type) + p.source;
+	return key.md5();
+}
+
+int load_program_binary(Context* ctx, const Path &filename) {
+	if (!os::fs::exists(filename))
+		return -1;
+	bytes data;
+	try {
+		data = os::fs::read_binary(filename);
+	} catch (...) {
+		return -1;
+	}
+	if (data.num <= 4)
+		return -1;
+	int format = *(int*)&data[0];
+	int prog = create_empty_shader_program();
+	glProgramBinary(prog, format, &data[4], data.num - 4);
+	int status;
+	glGetProgramiv(prog, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		// driver update etc.
+		glDeleteProgram(prog);
+		return -1;
+	}
+	return prog;
+}
+
+void save_program_binary(Context* ctx, int prog, const Path &filename) {
+	int size = 0;
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+	bytes data;
+	data.resize(size + 4);
+	GLenum format = 0;
+	glGetProgramBinary(prog, size, &size, &format, &data[4]);
+	*(int*)&data[0] = (int)format;
+	try {
+		os::fs::write_binary_atomic(filename, data);
+	} catch (Exception &e) {
+		msg_error("can not write shader cache: " + e.message());
+	}
+}
+
 ShaderMetaData parse_meta(string source) {
 	ShaderMetaData m;
 	for (auto &x: source.explode("\n")) {
@@ -178,15 +227,29 @@ ShaderMetaData parse_meta(string source) {
 	return m;
 }
 
+bool Context::has_cached_shader(const string &source) {
+	if (shader_cache_dir.is_empty())
+		return false;
+	Array<ShaderSourcePart> expanded;
+	ShaderMetaData meta;
+	for (auto &p: get_shader_parts(this, source)) {
+		if (p.type == TYPE_MODULE)
+			return false;
+		else if (p.type == TYPE_LAYOUT)
+			meta = parse_meta(p.source);
+		else
+			expanded.add({p.type, expand_shader_source(this, p.source, meta)});
+	}
+	return os::fs::exists(shader_cache_dir | (program_binary_key(this, expanded) + ".glbin"));
+}
+
 void Shader::update(const string &source) {
 	auto parts = get_shader_parts(ctx, source);
 
 	if (parts.num == 0)
 		throw Exception("no shader tags found (<VertexShader>...</VertexShader> or <FragmentShader>...</FragmentShader>)");
 
-	int prog = create_empty_shader_program();
-
-	Array<int> shaders;
+	Array<ShaderSourcePart> expanded;
 	ShaderMetaData meta;
 	for (auto p: parts) {
 		if (p.type == TYPE_MODULE) {
@@ -199,13 +262,36 @@ void Shader::update(const string &source) {
 		} else if (p.type == TYPE_LAYOUT) {
 			meta = parse_meta(p.source);
 		} else {
-			int shader = create_gl_shader(ctx, p.source, p.type, meta);
-			shaders.add(shader);
-			if (shader >= 0)
-				glAttachShader(prog, shader);
+			expanded.add({p.type, expand_shader_source(ctx, p.source, meta)});
 		}
 	}
 
+	Path cache_file;
+	if (!ctx->shader_cache_dir.is_empty()) {
+		cache_file = ctx->shader_cache_dir | (program_binary_key(ctx, expanded) + ".glbin");
+		int prog = load_program_binary(ctx, cache_file);
+		if (prog >= 0) {
+			program = prog;
+			ctx->shader_error = "";
+			_reset_uniform_state();
+			find_locations();
+			return;
+		}
+	}
+
+	int prog = create_empty_shader_program();
+
+	Array<int> shaders;
+	for (auto &p: expanded) {
+		int shader = create_gl_shader(ctx, p.source, p.type);
+		shaders.add(shader);
+		if (shader >= 0)
+			glAttachShader(prog, shader);
+	}
+
+	if (!cache_file.is_empty())
+		glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	int status;
 	glLinkProgram(prog);
 	glGetProgramiv(prog, GL_LINK_STATUS, &status);
@@ -218,11 +304,16 @@ void Shader::update(const string &source) {
 	}
 
 	for (int shader: shaders)
-		glDeleteShader(shader);
+		if (shader >= 0)
+			glDeleteShader(shader);
+
+	if (!cache_file.is_empty())
+		save_program_binary(ctx, prog, cache_file);
 
 	program = prog;
 	ctx->shader_error = "";
 
+	_reset_uniform_state();
 	find_locations();
 }
 xfer<Shader> Shader::create(Context* ctx, const string &source) {
@@ -248,14 +339,16 @@ void Shader::find_locations() {
 		location[LOCATION_TEX + i] = get_location("tex" + i2s(i));
 	location[LOCATION_TEX_CUBE] = get_location("tex_cube");
 
-	location[LOCATION_MATERIAL_ALBEDO] = get_location("material.albedo");
-	location[LOCATION_MATERIAL_ROUGHNESS] = get_location("material.roughness");
-	location[LOCATION_MATERIAL_METAL] = get_location("material.metal");
-	location[LOCATION_MATERIAL_EMISSION] = get_location("material.emission");
+	location[LOCATION_EYE_POS] = get_location("eye_pos");
+	location[LOCATION_NUM_LIGHTS] = get_location("num_lights");
+	location[LOCATION_SHADOW_INDEX] = get_location("shadow_index");
+	location[LOCATION_CUBE_MAP_LEVELS] = get_location("cube_map_levels");
+	location[LOCATION_NUM_SHADOW_CASCADES] = get_location("num_shadow_cascades");
+	location[LOCATION_SHADOW_CASCADE_SCALE] = get_location("shadow_cascade_scale");
 
 	link_uniform_block("Matrix", 0);
 	link_uniform_block("LightData", 1);
-	link_uniform_block("Material", 2);
+	link_uniform_block("MaterialData", BINDING_MATERIAL);
 	link_uniform_block("Fog", 3);
 }
 
@@ -306,7 +399,36 @@ void set_shader(Shader *s) {
 }
 
 int Shader::get_location(const string &name) const {
-	return glGetUniformLocation(program, name.c_str());
+	int i = location_cache.find(name);
+	if (i >= 0)
+		return location_cache.by_index(i);
+	int loc = glGetUniformLocation(program, name.c_str());
+	location_cache.set(name, loc);
+	return loc;
+}
+
+// locations are usually small and dense
+static const int MAX_TRACKED_UNIFORM_LOCATION = 4096;
+
+void Shader::_reset_uniform_state() {
+	location_cache.clear();
+	uniform_state.clear();
+}
+
+bool Shader::_uniform_changed(int location, const void *data, int size) {
+	if (location >= MAX_TRACKED_UNIFORM_LOCATION) {
+		ctx->num_uniform_uploads ++;
+		return true;
+	}
+	if (location >= uniform_state.num)
+		uniform_state.resize(location + 1);
+	auto &u = uniform_state[location];
+	if (u.size == size and memcmp(u.data, data, size) == 0)
+		return false;
+	u.size = size;
+	memcpy(u.data, data, size);
+	ctx->num_uniform_uploads ++;
+	return true;
 }
 
 bool Shader::link_uniform_block(const string &name, int binding) {
@@ -322,6 +444,10 @@ bool Shader::link_uniform_block(const string &name, int binding) {
 void Shader::set_floats_l(int location, const float *data, int num) {
 	if (location < 0)
 		return;
+	if (num != 1 and num != 2 and num != 3 and num != 4 and num != 16)
+		return;
+	if (!_uniform_changed(location, data, num * sizeof(float)))
+		return;
 	//NixSetShader(this);
 	if (num == 1) {
 		glProgramUniform1f(program, location, *data);
@@ -339,24 +465,32 @@ void Shader::set_floats_l(int location, const float *data, int num) {
 void Shader::set_int_l(int location, int i) {
 	if (location < 0)
 		return;
+	if (!_uniform_changed(location, &i, sizeof(i)))
+		return;
 	glProgramUniform1i(program, location, i);
 }
 
 void Shader::set_float_l(int location, float f) {
 	if (location < 0)
 		return;
+	if (!_uniform_changed(location, &f, sizeof(f)))
+		return;
 	glProgramUniform1f(program, location, f);
 }
 
 void Shader::set_color_l(int location, const color &c) {
 	if (location < 0)
 		return;
+	if (!_uniform_changed(location, &c, sizeof(c)))
+		return;
 	glProgramUniform4fv(program, location, 1, (float*)&c);
 }
 
 void Shader::set_matrix_l(int location, const mat4 &m) {
 	if (location < 0)
 		return;
+	if (!_uniform_changed(location, &m, sizeof(m)))
+		return;
 	glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, (float*)&m);
 }
 
@@ -389,10 +523,6 @@ void Shader::set_default_data() {
 		set_int_l(location[LOCATION_TEX + i], i);
 	if (tex_cube_level >= 0)
 		set_int_l(location[LOCATION_TEX_CUBE], tex_cube_level);
-	set_color_l(location[LOCATION_MATERIAL_ALBEDO], material.albedo);
-	set_float_l(location[LOCATION_MATERIAL_ROUGHNESS], material.roughness);
-	set_float_l(location[LOCATION_MATERIAL_METAL], material.metal);
-	set_color_l(location[LOCATION_MATERIAL_EMISSION], material.emission);
 }
 
 void Shader::dispatch(int nx, int ny, int nz) {
@@ -404,6 +534,10 @@ void image_barrier() {
 	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
 }
 
+void buffer_barrier() {
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
 
 void init_shaders(Context *ctx) {
 	ctx->vertex_module_default = "vertex-default-nix";
@@ -450,7 +584,7 @@ R"foodelim(
 struct Matrix { mat4 model, view, project; };
 /*layout(binding = 0)*/ uniform Matrix matrix;
 struct Material { vec4 albedo, emission; float roughness, metal; };
-/*layout(binding = 2)*/ uniform Material material;
+/*layout(binding = 2)*/ layout(std140) uniform MaterialData { Material material; };
 struct Light { mat4 proj; vec4 pos, dir, color; float radius, theta, harshness; };
 uniform int num_lights = 0;
 /*layout(binding = 1)*/ uniform LightData { Light light[32]; };
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "../base/pointer.h"
+#include "../base/map.h"
 #include "../os/path.h"
 
 namespace nix {
@@ -57,16 +58,30 @@ public:
 		LOCATION_MATRIX_P,
 		LOCATION_TEX,
 		LOCATION_TEX_CUBE = LOCATION_TEX + NIX_MAX_TEXTURELEVELS,
-		LOCATION_MATERIAL_ALBEDO,
-		LOCATION_MATERIAL_ROUGHNESS,
-		LOCATION_MATERIAL_METAL,
-		LOCATION_MATERIAL_EMISSION,
+		LOCATION_EYE_POS,
+		LOCATION_NUM_LIGHTS,
+		LOCATION_SHADOW_INDEX,
+		LOCATION_CUBE_MAP_LEVELS,
+		LOCATION_NUM_SHADOW_CASCADES,
+		LOCATION_SHADOW_CASCADE_SCALE,
 		NUM_LOCATIONS
 	};
 
 	int location[NUM_LOCATIONS];
 	Context* ctx;
 
+	// name -> location (avoiding glGetUniformLocation() in the draw loop)
+	mutable base::map<string, int> location_cache;
+
+	// last uploaded value per location, redundant uploads are skipped
+	struct UniformState {
+		int size = -1;
+		float data[16];
+	};
+	Array<UniformState> uniform_state;
+	bool _uniform_changed(int location, const void *data, int size);
+	void _reset_uniform_state();
+
 
 	static xfer<Shader> _cdecl load(Context* ctx, const Path &filename);
 	static xfer<Shader> _cdecl create(Context* ctx, const string &source);
@@ -79,6 +94,8 @@ void init_shaders(Context* ctx);
 void _cdecl set_shader(Shader *s);
 
 void image_barrier();
+// storage buffers written by compute shaders -> shaders, vertex fetch, indirect draws
+void buffer_barrier();
 
 
 };
@@ -301,6 +301,14 @@ void bind_image(int binding, Texture *t, int level, int layer, bool writable) {
 	glBindImageTexture(binding, t->texture, level, GL_FALSE, layer, writable ? GL_READ_WRITE : GL_READ_ONLY, t->internal_format);
 }
 
+void copy_texture(Texture *dest, Texture *source) {
+	glCopyImageSubData(source->texture, GL_TEXTURE_2D, 0, 0, 0, 0, dest->texture, GL_TEXTURE_2D, 0, 0, 0, 0, source->width, source->height, 1);
+}
+
+void copy_texture_to_cube_face(CubeMap *dest, int face, Texture *source) {
+	glCopyImageSubData(source->texture, GL_TEXTURE_2D, 0, 0, 0, 0, dest->texture, GL_TEXTURE_CUBE_MAP, 0, 0, 0, face, source->width, source->height, 1);
+}
+
 void bind_texture(int binding, Texture *t) {
 	//refresh_texture(t);
 	if (!t)
@@ -453,7 +461,8 @@ CubeMap::CubeMap(int size, const string &_format) {
 	glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTextureParameteri(texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTextureStorage2D(texture, 6, internal_format, width, height);
+	levels = min(6, mip_levels(width, height));
+	glTextureStorage2D(texture, levels, internal_format, width, height);
 
 	if (false) {
 		Image im;
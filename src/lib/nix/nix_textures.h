@@ -99,12 +99,18 @@ public:
 
 	void _cdecl write_side(int side, const Image &image);
 	void _cdecl fill_side(int side, Texture *source);
+	// allocated mip levels (content is up to the user)
+	int levels;
 };
 
 
 void bind_textures(const Array<Texture*> &textures);
 void bind_texture(int binding, Texture *t);
 void bind_image(int binding, Texture *t, int level, int layer, bool writable);
+// level 0, same size and format
+void copy_texture(Texture *dest, Texture *source);
+// into one face of a cube map
+void copy_texture_to_cube_face(CubeMap *dest, int face, Texture *source);
 
 extern int tex_cube_level;
 
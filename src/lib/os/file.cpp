@@ -16,7 +16,10 @@
 | last update: 2010.06.01 (c) by MichiSoft TM                                  |
 \*----------------------------------------------------------------------------*/
 #include "file.h"
+#include "filesystem.h"
 #include "date.h"
+#include "msg.h"
+#include <atomic>
 
 
 
@@ -36,12 +39,15 @@
 	#include <windows.h>
 	#include <winbase.h>
 	#include <winnt.h>
+	#include <process.h>
+	#define getpid _getpid
 #endif
 #if defined(OS_LINUX) || defined(OS_MAC)
 	#include <unistd.h>
 	#include <dirent.h>
 	#include <stdarg.h>
 	#include <sys/stat.h>
+	#include <sys/mman.h>
 
 	#define _open	::open
 	#define _read	::read
@@ -63,25 +69,34 @@
 namespace os::fs {
 
 
-FileStream::FileStream(int h, Mode mode) : Stream(mode) {
+const int FileStream::BUFFER_SIZE = 1 << 16;
+
+FileStream::FileStream(int h, Mode mode, bool _buffered) : Stream(mode) {
 	handle = h;
+	buffered = _buffered;
+	if (buffered) {
+		io_buffer.resize(BUFFER_SIZE);
+		handle_pos = _lseek(handle, 0, SEEK_CUR);
+	}
 }
 
 FileStream::~FileStream() {
-	if (handle >= 0)
-		close();
+	// pending writes might fail, but destructors must not throw
+	try {
+		if (handle >= 0)
+			close();
+	} catch (Exception &e) {
+		msg_error(e.message());
+		if (handle >= 0)
+			_close(handle);
+		handle = -1;
+	}
 }
 
 bool FileStream::is_end() const {
-#ifdef OS_WINDOWS
-	return _eof(handle);
-#endif
-#if defined(OS_LINUX) || defined(OS_MAC) || defined(OS_MINGW)
-	int pos = lseek(handle,0,SEEK_CUR);
-	struct stat stat;
-	fstat(handle, &stat);
-	return (pos >= stat.st_size);
-#endif
+	if (buffered and !buffer_writing and buffer_pos < buffer_fill)
+		return false;
+	return pos() >= size();
 }
 
 void set_mode_bin(int handle) {
@@ -96,13 +111,18 @@ void set_mode_text(int handle) {
 #endif
 }
 
+// reading without an explicit backend: binary files of at least this size get mapped
+static const int64 AUTO_MMAP_SIZE = 1 << 20;
+
 // open a file stream
 FileStream *open(const Path &filename, const string &mode) {
 	int handle = -1;
+	bool reading = false;
 
 	if (mode.find("r") >= 0) {
 		// reading
 		handle = _open(filename.c_str(), O_RDONLY);
+		reading = true;
 	} else if (mode.find("w") >= 0) {
 #ifdef OS_WINDOWS
 		handle = _creat(filename.c_str(), _S_IREAD | _S_IWRITE);
@@ -117,6 +137,9 @@ FileStream *open(const Path &filename, const string &mode) {
 #if defined(OS_LINUX) || defined(OS_MAC) || defined(OS_MINGW)
 		handle = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
 #endif
+		// pos() starts at the end
+		if (handle >= 0)
+			_lseek(handle, 0, SEEK_END);
 	} else {
 		throw FileError(format("mode unhandled: '%s'", mode));
 	}
@@ -131,7 +154,36 @@ FileStream *open(const Path &filename, const string &mode) {
 	else
 		set_mode_bin(handle);
 
-	return new FileStream(handle, (mode.find("t") >= 0) ? Stream::Mode::TEXT : Stream::Mode::BINARY);
+	auto stream_mode = (mode.find("t") >= 0) ? Stream::Mode::TEXT : Stream::Mode::BINARY;
+
+	bool mapped = (mode.find("m") >= 0);
+	bool buffered = (mode.find("c") >= 0 or mapped);
+	// reading without a backend letter: large binary files get mapped, others buffered
+	if (reading and !buffered and mode.find("u") < 0) {
+		buffered = true;
+		if (stream_mode == Stream::Mode::BINARY)
+			mapped = (_lseek(handle, 0, SEEK_END) >= AUTO_MMAP_SIZE);
+		_lseek(handle, 0, SEEK_SET);
+	}
+	FileStream *f = nullptr;
+#if defined(OS_LINUX) || defined(OS_MAC)
+	if (reading and mapped) {
+		struct stat st;
+		fstat(handle, &st);
+		void *p = nullptr;
+		if (st.st_size > 0)
+			p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+		if (p != MAP_FAILED) {
+			if (p)
+				madvise(p, st.st_size, MADV_SEQUENTIAL);
+			f = new MmapStream(handle, stream_mode, (const char*)p, st.st_size);
+		}
+	}
+#endif
+	if (!f)
+		f = new FileStream(handle, stream_mode, buffered);
+	f->filename = filename;
+	return f;
 }
 
 
@@ -156,6 +208,25 @@ void write_binary(const Path &filename, const bytes &buf) {
 	delete f;
 }
 
+void write_binary_atomic(const Path &filename, const bytes &buf) {
+	static std::atomic<int> counter = 0;
+	Path temp = filename.str() + format(".%d-%d.tmp", (int)getpid(), (int)(counter ++));
+	try {
+		write_binary(temp, buf);
+#ifdef OS_WINDOWS
+		rename(temp, filename);
+#else
+		// replaces an existing file atomically
+		if (::rename(temp.str().c_str(), filename.str().c_str()) != 0)
+			throw FileError(format("can not rename file '%s' -> '%s'", temp, filename));
+#endif
+	} catch (...) {
+		if (exists(temp))
+			_delete(temp);
+		throw;
+	}
+}
+
 void write_text(const Path &filename, const string &str) {
 	auto f = open(filename, "wt");
 	f->write(str);
@@ -165,26 +236,73 @@ void write_text(const Path &filename, const string &str) {
 
 // close the file
 void FileStream::close() {
-	//flush(handle);
-	if (handle >= 0)
+	if (handle >= 0) {
+		flush();
 		_close(handle);
+	}
 	handle = -1;
 }
 
+// write pending data
+void FileStream::flush() {
+	if (!buffer_writing)
+		return;
+	int done = 0;
+	while (done < buffer_fill) {
+		int r = _write_raw(&io_buffer[done], buffer_fill - done);
+		if (r <= 0)
+			break;
+		done += r;
+	}
+	buffer_writing = false;
+	buffer_fill = 0;
+	buffer_pos = 0;
+}
+
+// move the os handle back to the logical position
+void FileStream::_discard_read_buffer() {
+	if (!buffer_writing and buffer_pos < buffer_fill)
+		handle_pos = _lseek(handle, -(buffer_fill - buffer_pos), SEEK_CUR);
+	buffer_fill = 0;
+	buffer_pos = 0;
+}
+
 // jump to an position in the file or to a position relative to the current
 void FileStream::set_pos(int pos) {
+	if (buffered) {
+		flush();
+		// still inside the read buffer?
+		int64 buffer_start = handle_pos - buffer_fill;
+		if (pos >= buffer_start and pos <= handle_pos) {
+			buffer_pos = (int)(pos - buffer_start);
+			return;
+		}
+		buffer_fill = 0;
+		buffer_pos = 0;
+		handle_pos = _lseek(handle, pos, SEEK_SET);
+		return;
+	}
 	_lseek(handle, pos, SEEK_SET);
 }
 
 void FileStream::seek(int delta) {
+	if (buffered) {
+		set_pos(pos() + delta);
+		return;
+	}
 	_lseek(handle, delta, SEEK_CUR);
 }
 
 // retrieve the size of the opened(!) file
 int64 FileStream::size() const {
-	struct stat s;
-	fstat(handle, &s);
-	return s.st_size;
+	if (size_cache < 0) {
+		struct stat s;
+		fstat(handle, &s);
+		size_cache = s.st_size;
+	}
+	if (buffered and buffer_writing)
+		return max(size_cache, handle_pos + buffer_fill);
+	return size_cache;
 }
 
 Date FileStream::ctime() {
@@ -207,25 +325,135 @@ Date FileStream::atime() {
 
 // where is the current reading position in the file?
 int FileStream::pos() const {
+	if (buffered) {
+		if (buffer_writing)
+			return (int)(handle_pos + buffer_fill);
+		return (int)(handle_pos - buffer_fill + buffer_pos);
+	}
 	return _lseek(handle, 0, SEEK_CUR);
 }
 
-// read a part of the file into the buffer
-int FileStream::read_basic(void *buffer, int size) {
+int FileStream::_read_raw(void *buffer, int size) {
 	int r = _read(handle, buffer, size);
 	if (r < 0)
 		throw FileError(format("failed reading file '%s'", filename));
+	handle_pos += r;
 	return r;
 }
 
+int FileStream::_write_raw(const void *buffer, int size) {
+	int r = _write(handle, buffer, size);
+	size_cache = -1;
+	if (r < 0)
+		throw FileError(format("failed writing file '%s'", filename));
+	// might be appending
+	handle_pos = _lseek(handle, 0, SEEK_CUR);
+	return r;
+}
+
+// read a part of the file into the buffer
+int FileStream::read_basic(void *buffer, int size) {
+	if (!buffered)
+		return _read_raw(buffer, size);
+	if (buffer_writing)
+		flush();
+
+	auto dest = (char*)buffer;
+	int done = 0;
+	while (done < size) {
+		int available = buffer_fill - buffer_pos;
+		if (available > 0) {
+			int n = min(available, size - done);
+			memcpy(dest + done, &io_buffer[buffer_pos], n);
+			buffer_pos += n;
+			done += n;
+		} else if (size - done >= BUFFER_SIZE) {
+			// large reads bypass the buffer
+			buffer_fill = buffer_pos = 0;
+			int r = _read_raw(dest + done, size - done);
+			if (r <= 0)
+				break;
+			done += r;
+		} else {
+			buffer_pos = 0;
+			buffer_fill = _read_raw(&io_buffer[0], BUFFER_SIZE);
+			if (buffer_fill <= 0) {
+				buffer_fill = 0;
+				break;
+			}
+		}
+	}
+	return done;
+}
+
 // insert the buffer into the file
 int FileStream::write_basic(const void *buffer, int size) {
 	if (size == 0)
 		return 0;
-	int r = _write(handle,buffer,size);
-	if (r < 0)
-		throw FileError(format("failed writing file '%s'", filename));
-	return r;
+	if (!buffered)
+		return _write_raw(buffer, size);
+
+	if (!buffer_writing) {
+		_discard_read_buffer();
+		buffer_writing = true;
+	}
+	if (buffer_fill + size > BUFFER_SIZE) {
+		flush();
+		buffer_writing = true;
+	}
+	if (size >= BUFFER_SIZE)
+		return _write_raw(buffer, size);
+	memcpy(&io_buffer[buffer_fill], buffer, size);
+	buffer_fill += size;
+	return size;
+}
+
+
+
+// takes over the mapping done by open(), so a failed mmap() can still fall back to reading
+MmapStream::MmapStream(int h, Mode mode, const char *_data, int64 size) : FileStream(h, mode, false) {
+	data = _data;
+	data_size = size;
+}
+
+MmapStream::~MmapStream() {
+#if defined(OS_LINUX) || defined(OS_MAC)
+	if (data)
+		munmap((void*)data, data_size);
+#endif
+}
+
+void MmapStream::set_pos(int pos) {
+	data_pos = max((int64)0, min((int64)pos, data_size));
+}
+
+void MmapStream::seek(int delta) {
+	set_pos((int)(data_pos + delta));
+}
+
+int64 MmapStream::size() const {
+	return data_size;
+}
+
+int MmapStream::pos() const {
+	return (int)data_pos;
+}
+
+bool MmapStream::is_end() const {
+	return data_pos >= data_size;
+}
+
+int MmapStream::read_basic(void *buffer, int size) {
+	int n = (int)min((int64)size, data_size - data_pos);
+	if (n <= 0)
+		return 0;
+	memcpy(buffer, data + data_pos, n);
+	data_pos += n;
+	return n;
+}
+
+int MmapStream::write_basic(const void *, int) {
+	throw FileError(format("memory mapped file '%s' is read-only", filename));
 }
 
 }
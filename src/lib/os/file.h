@@ -39,8 +39,8 @@ public:
 
 class FileStream : public Stream {
 public:
-	FileStream(int handle, Mode mode);
-	~FileStream();
+	FileStream(int handle, Mode mode, bool buffered = false);
+	~FileStream() override;
 
 	// meta
 	void set_pos(int pos) override;
@@ -53,6 +53,7 @@ public:
 
 	bool is_end() const override;
 	void close();
+	void flush();
 
 	int read_basic(void *buffer, int size) override;
 	int write_basic(const void *buffer, int size) override;
@@ -60,13 +61,55 @@ public:
 //private:
 	Path filename;
 	int handle = -1;
+
+	// read-ahead/write-behind, so small reads/writes don't each become a syscall
+	static const int BUFFER_SIZE;
+	bool buffered;
+	bytes io_buffer;
+	int buffer_pos = 0; // next byte to read
+	int buffer_fill = 0; // valid bytes (reading) or pending bytes (writing)
+	bool buffer_writing = false;
+	int64 handle_pos = 0; // position of the os file handle
+	// file size on disk, -1 after our own writes
+	//   (changes by other processes are not seen while reading)
+	mutable int64 size_cache = -1;
+	void _discard_read_buffer();
+	int _read_raw(void *buffer, int size);
+	int _write_raw(const void *buffer, int size);
+};
+
+// read-only, the whole file mapped into memory
+class MmapStream : public FileStream {
+public:
+	MmapStream(int handle, Mode mode, const char *data, int64 size);
+	~MmapStream() override;
+
+	void set_pos(int pos) override;
+	void seek(int delta) override;
+	int64 size() const override;
+	int pos() const override;
+	bool is_end() const override;
+
+	int read_basic(void *buffer, int size) override;
+	int write_basic(const void *buffer, int size) override;
+
+	const char *data = nullptr;
+	int64 data_size = 0;
+	int64 data_pos = 0;
 };
 
+// mode: "r"/"w"/"a" + "b"/"t"
+//   optional backend: "u" unbuffered, "c" buffered, "m" memory mapped (reading)
+//   default: writing unbuffered, reading buffered or mapped (binary, >= 1 mb)
+//   if mapping fails, the file is read buffered instead
 extern FileStream *open(const Path &filename, const string &mode);
 
 extern bytes read_binary(const Path &filename);
 extern string read_text(const Path &filename);
 extern void write_binary(const Path &filename, const bytes &data);
+// via a temporary file and rename(), so readers never see a partial file
+//   (crashes, concurrent writers of the same file)
+extern void write_binary_atomic(const Path &filename, const bytes &data);
 extern void write_text(const Path &filename, const string &str);
 
 }
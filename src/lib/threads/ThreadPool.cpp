@@ -0,0 +1,251 @@
+#include "ThreadPool.h"
+#include "Thread.h"
+#include "../os/msg.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+
+class Task {
+public:
+	std::function<void()> func;
+	// unfinished dependencies (+1 while submitting)
+	std::atomic<int> pending{1};
+	std::atomic<bool> done{false};
+	std::mutex mutex;
+	Array<TaskRef> successors;
+};
+
+struct Worker {
+	std::mutex mutex;
+	// owner works at the back, thieves take from the front
+	std::deque<TaskRef> queue;
+	std::thread thread;
+};
+
+struct ThreadPoolInternal {
+	Array<Worker*> workers;
+
+	// tasks submitted from outside the pool
+	std::mutex inject_mutex;
+	std::deque<TaskRef> inject;
+
+	std::atomic<int> queued{0};
+	std::atomic<int> waiters{0};
+	bool quit = false;
+	std::mutex sleep_mutex;
+	std::condition_variable wake;     // workers
+	std::condition_variable finished; // threads in wait()
+};
+
+static thread_local ThreadPoolInternal *current_pool = nullptr;
+static thread_local int current_index = -1;
+
+
+static void schedule(ThreadPoolInternal *p, const TaskRef &t) {
+	if (current_pool == p) {
+		auto w = p->workers[current_index];
+		std::lock_guard<std::mutex> lock(w->mutex);
+		w->queue.push_back(t);
+	} else {
+		std::lock_guard<std::mutex> lock(p->inject_mutex);
+		p->inject.push_back(t);
+	}
+	p->queued ++;
+
+	std::lock_guard<std::mutex> lock(p->sleep_mutex);
+	p->wake.notify_one();
+	if (p->waiters > 0)
+		p->finished.notify_all();
+}
+
+static TaskRef find_task(ThreadPoolInternal *p, int index) {
+	TaskRef t;
+	if (index >= 0) {
+		auto w = p->workers[index];
+		std::lock_guard<std::mutex> lock(w->mutex);
+		if (w->queue.size() > 0) {
+			t = std::move(w->queue.back());
+			w->queue.pop_back();
+		}
+	}
+	if (!t) {
+		std::lock_guard<std::mutex> lock(p->inject_mutex);
+		if (p->inject.size() > 0) {
+			t = std::move(p->inject.front());
+			p->inject.pop_front();
+		}
+	}
+	// steal, starting at the neighbour to spread contention
+	for (int i=1; !t and i<=p->workers.num; i++) {
+		auto w = p->workers[(max(index, 0) + i) % p->workers.num];
+		std::lock_guard<std::mutex> lock(w->mutex);
+		if (w->queue.size() > 0) {
+			t = std::move(w->queue.front());
+			w->queue.pop_front();
+		}
+	}
+	if (t)
+		p->queued --;
+	return t;
+}
+
+static void execute(ThreadPoolInternal *p, const TaskRef &t) {
+	// exceptions must not leave the worker (std::terminate), the task counts as done anyway
+	try {
+		t->func();
+	} catch (Exception &e) {
+		msg_error("task: " + e.message());
+	} catch (std::exception &e) {
+		msg_error(string("task: ") + e.what());
+	} catch (...) {
+		msg_error("task: unknown exception");
+	}
+	t->func = nullptr;
+
+	Array<TaskRef> successors;
+	{
+		std::lock_guard<std::mutex> lock(t->mutex);
+		t->done = true;
+		successors.exchange(t->successors);
+	}
+	for (auto &s: successors)
+		if (-- s->pending == 0)
+			schedule(p, s);
+
+	if (p->waiters > 0) {
+		std::lock_guard<std::mutex> lock(p->sleep_mutex);
+		p->finished.notify_all();
+	}
+}
+
+static void worker_main(ThreadPoolInternal *p, int index) {
+	current_pool = p;
+	current_index = index;
+	while (true) {
+		if (auto t = find_task(p, index)) {
+			execute(p, t);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(p->sleep_mutex);
+		p->wake.wait(lock, [p] { return p->quit or p->queued > 0; });
+		if (p->quit)
+			return;
+	}
+}
+
+
+ThreadPool::ThreadPool(int num_workers) {
+	internal = new ThreadPoolInternal;
+	for (int i=0; i<max(num_workers, 1); i++)
+		internal->workers.add(new Worker);
+	for (int i=0; i<internal->workers.num; i++)
+		internal->workers[i]->thread = std::thread(worker_main, internal, i);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(internal->sleep_mutex);
+		internal->quit = true;
+		internal->wake.notify_all();
+	}
+	for (auto w: internal->workers) {
+		w->thread.join();
+		delete w;
+	}
+	delete internal;
+}
+
+ThreadPool *ThreadPool::get() {
+	// the calling thread helps while waiting, so one core less
+	static ThreadPool pool(Thread::get_num_cores() - 1);
+	return &pool;
+}
+
+int ThreadPool::num_workers() const {
+	return internal->workers.num;
+}
+
+int ThreadPool::current_worker() const {
+	if (current_pool == internal)
+		return current_index;
+	return -1;
+}
+
+TaskRef ThreadPool::submit(std::function<void()> f) {
+	return submit(std::move(f), {});
+}
+
+TaskRef ThreadPool::submit(std::function<void()> f, const Array<TaskRef> &dependencies) {
+	auto t = std::make_shared<Task>();
+	t->func = std::move(f);
+	for (auto &d: dependencies) {
+		std::lock_guard<std::mutex> lock(d->mutex);
+		if (!d->done) {
+			t->pending ++;
+			d->successors.add(t);
+		}
+	}
+	if (-- t->pending == 0)
+		schedule(internal, t);
+	return t;
+}
+
+bool ThreadPool::is_done(const TaskRef &task) const {
+	return task->done;
+}
+
+void ThreadPool::wait(const TaskRef &task) {
+	int index = current_worker();
+	while (!task->done) {
+		if (auto t = find_task(internal, index)) {
+			execute(internal, t);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(internal->sleep_mutex);
+		internal->waiters ++;
+		internal->finished.wait(lock, [this, &task] { return task->done or internal->queued > 0; });
+		internal->waiters --;
+	}
+}
+
+bool ThreadPool::wait_for(const TaskRef &task, int milliseconds) {
+	std::unique_lock<std::mutex> lock(internal->sleep_mutex);
+	internal->waiters ++;
+	bool done = internal->finished.wait_for(lock, std::chrono::milliseconds(milliseconds), [&task] { return (bool)task->done; });
+	internal->waiters --;
+	return done;
+}
+
+void ThreadPool::wait_all(const Array<TaskRef> &tasks) {
+	for (auto &t: tasks)
+		wait(t);
+}
+
+void ThreadPool::parallel_for(int n, const std::function<void(int, int)> &f, int grain_size) {
+	if (n <= 0)
+		return;
+	if (grain_size <= 0)
+		// a few chunks per thread, for balancing
+		grain_size = max(n / ((num_workers() + 1) * 4), 1);
+	if (n <= grain_size) {
+		f(0, n);
+		return;
+	}
+
+	int num_chunks = (n + grain_size - 1) / grain_size;
+	Array<TaskRef> tasks;
+	tasks.simple_reserve(num_chunks - 1);
+	for (int c=1; c<num_chunks; c++) {
+		int first = c * grain_size;
+		int end = min(first + grain_size, n);
+		tasks.add(submit([&f, first, end] { f(first, end); }));
+	}
+	f(0, grain_size);
+	wait_all(tasks);
+}
@@ -0,0 +1,49 @@
+/*----------------------------------------------------------------------------*\
+| Threads (persistent pool)                                                    |
+| -> one set of worker threads for the whole program                           |
+| -> per worker deques, idle workers steal from the others                     |
+| -> waiting threads help executing tasks, then sleep (never spin)             |
+|                                                                              |
+| last update: 2026.10.19 (c) by MichiSoft TM                                  |
+\*----------------------------------------------------------------------------*/
+#pragma once
+
+#include "../base/base.h"
+#include <functional>
+#include <memory>
+
+class Task;
+using TaskRef = std::shared_ptr<Task>;
+struct ThreadPoolInternal;
+
+class ThreadPool {
+public:
+	explicit ThreadPool(int num_workers);
+	~ThreadPool();
+
+	// shared by the engine, created on first use
+	static ThreadPool *get();
+
+	int num_workers() const;
+	// index of the calling worker of this pool or -1
+	int current_worker() const;
+
+	// f runs after all dependencies have finished
+	TaskRef submit(std::function<void()> f);
+	TaskRef submit(std::function<void()> f, const Array<TaskRef> &dependencies);
+
+	// blocks until finished, executing other tasks in the meantime
+	void wait(const TaskRef &task);
+	void wait_all(const Array<TaskRef> &tasks);
+	// sleeps without helping, false on timeout
+	bool wait_for(const TaskRef &task, int milliseconds);
+	bool is_done(const TaskRef &task) const;
+
+	// calls f(first, end) for chunks of [0, n)
+	// grain_size <= 0: choose one from n and the number of workers
+	void parallel_for(int n, const std::function<void(int, int)> &f, int grain_size = 0);
+
+private:
+	ThreadPoolInternal *internal;
+};
+
@@ -1,5 +1,6 @@
 /*----------------------------------------------------------------------------*\
 | Threads (work scheduler)                                                     |
+| -> runs on the shared ThreadPool                                             |
 |                                                                              |
 | last update: 2011.02.19 (c) by MichiSoft TM                                  |
 \*----------------------------------------------------------------------------*/
@@ -7,6 +8,8 @@
 
 #include "Mutex.h"
 #include "Thread.h"
+#include <atomic>
+#include <mutex>
 
 #define MAX_THREADS			32
 
@@ -14,15 +17,19 @@ class ThreadedWork : public VirtualBase {
 public:
 	ThreadedWork();
 	virtual ~ThreadedWork();
+	// worker_id: the pool worker, or ThreadPool::get()->num_workers() for threads outside the pool
+	//   (e.g. the caller of run() helping after an abort, never more than one at a time)
+	//   so per worker state needs num_workers() + 1 entries
 	virtual void _cdecl on_step(int index, int worker_id) {}
 	virtual bool _cdecl on_status() { return true; }
 	bool _cdecl run(int total_size, int partition_size);
 
 	int total_size, partition_size;
-	Array<Thread*> thread;
 
-	int work_given;
-	Mutex *mx_list;
+	std::atomic<int> work_done;
+	std::atomic<bool> aborted;
+	// serializes steps outside of the pool's workers
+	std::mutex helper_mutex;
 
 	int _cdecl get_total();
 	int _cdecl get_done();
@@ -30,5 +37,3 @@ public:
 	void _cdecl __init__();
 	virtual void _cdecl __delete__();
 };
-
-
@@ -25,7 +25,6 @@ Array<UniformBuffer*> ubo_wrappers;
 Buffer::Buffer(Device *_device) {
 	device = _device;
 	buffer = VK_NULL_HANDLE;
-	memory = VK_NULL_HANDLE;
 	size = 0;
 }
 
@@ -47,24 +46,17 @@ void Buffer::create(VkDeviceSize _size, VkBufferUsageFlags usage, VkMemoryProper
 	VkMemoryRequirements mem_requirements;
 	vkGetBufferMemoryRequirements(device->device, buffer, &mem_requirements);
 
-	VkMemoryAllocateInfo alloc_info = {};
-	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	alloc_info.allocationSize = mem_requirements.size;
-	alloc_info.memoryTypeIndex = device->find_memory_type(mem_requirements, properties);
+	allocation = device->allocator->allocate(mem_requirements, properties, true);
 
-	if (vkAllocateMemory(device->device, &alloc_info, nullptr, &memory) != VK_SUCCESS)
-		throw Exception("failed to allocate buffer memory!");
-
-	vkBindBufferMemory(device->device, buffer, memory, 0);
+	vkBindBufferMemory(device->device, buffer, allocation.memory, allocation.offset);
 }
 
 void Buffer::destroy() {
 	if (buffer)
 		vkDestroyBuffer(device->device, buffer, nullptr);
 	buffer = nullptr;
-	if (memory)
-		vkFreeMemory(device->device, memory, nullptr);
-	memory = nullptr;
+	if (allocation.block)
+		device->allocator->free(allocation);
 	size = 0;
 }
 
@@ -72,16 +64,17 @@ void *Buffer::map() {
 	return map_part(0, size);
 }
 
+// host visible blocks are mapped persistently
+//   non-coherent memory gets invalidated/flushed as a whole
 void *Buffer::map_part(VkDeviceSize _offset, VkDeviceSize _size) {
-	void *p;
-	if (_size < 8) // for size=0 unmap() might complain
-		_size = 8;
-	vkMapMemory(device->device, memory, _offset, _size, 0, &p);
-	return p;
+	if (!allocation.mapped)
+		throw Exception("buffer memory is not host visible");
+	allocation.invalidate();
+	return (char*)allocation.mapped + _offset;
 }
 
 void Buffer::unmap() {
-	vkUnmapMemory(device->device, memory);
+	allocation.flush();
 }
 
 void Buffer::update_part(const void *source, int offset, int update_size) {
@@ -145,7 +138,7 @@ StorageBuffer::StorageBuffer(int _size) : Buffer(default_device) {
 	size = _size;
 	VkDeviceSize buffer_size = size;
 
-	auto usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_RAY_TRACING_BIT_NV | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+	auto usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_RAY_TRACING_BIT_NV | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 	create(buffer_size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 }
 
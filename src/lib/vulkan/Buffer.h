@@ -10,6 +10,7 @@
 
 #include "../base/base.h"
 #include <vulkan/vulkan.h>
+#include "MemoryAllocator.h"
 
 namespace vulkan {
 
@@ -32,7 +33,8 @@ namespace vulkan {
 		int64 get_device_address() const;
 
 		VkBuffer buffer;
-		VkDeviceMemory memory;
+		// sub-allocated, see MemoryAllocator
+		Allocation allocation;
 		VkDeviceSize size;
 		Device *device;
 	};
@@ -58,16 +58,14 @@ CommandBuffer *begin_single_time_commands() {
 	return cb;
 }
 
+// blocks until done (fence, not the whole queue)
 void end_single_time_commands(CommandBuffer *cb) { //VkCommandBuffer command_buffer) {
 	vkEndCommandBuffer(cb->buffer);
 
-	VkSubmitInfo info = {};
-	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	info.commandBufferCount = 1;
-	info.pCommandBuffers = &cb->buffer;
-
-	vkQueueSubmit(default_device->graphics_queue.queue, 1, &info, VK_NULL_HANDLE);
-	default_device->graphics_queue.wait_idle();
+	// pending uploads first
+	Fence fence(default_device);
+	default_device->graphics_queue.submit(cb, {}, {}, &fence);
+	fence.wait();
 
 	//vkFreeCommandBuffers(default_device->device, command_pool, 1, &cb->command_buffer);
 	delete cb;
@@ -136,6 +134,15 @@ void CommandBuffer::draw(VertexBuffer *vb) {
 	draw_instanced(vb, 1);
 }
 
+// only non-indexed vertex buffers
+void CommandBuffer::draw_range(VertexBuffer *vb, int first, int count) {
+	if (count <= 0)
+		return;
+	VkDeviceSize offsets[] = {0};
+	vkCmdBindVertexBuffers(buffer, 0, 1, &vb->vertex_buffer.buffer, offsets);
+	vkCmdDraw(buffer, count, 1, first, 0);
+}
+
 void CommandBuffer::draw_instanced(VertexBuffer *vb, int num_instances) {
 	if (vb->output_count == 0)
 		return;
@@ -150,6 +157,12 @@ void CommandBuffer::draw_instanced(VertexBuffer *vb, int num_instances) {
 	}
 }
 
+void CommandBuffer::draw_instanced_indirect(VertexBuffer *vb, Buffer *args, int offset) {
+	VkDeviceSize offsets[] = {0};
+	vkCmdBindVertexBuffers(buffer, 0, 1, &vb->vertex_buffer.buffer, offsets);
+	vkCmdDrawIndirect(buffer, args->buffer, offset, 1, sizeof(VkDrawIndirectCommand));
+}
+
 void CommandBuffer::begin() {
 	VkCommandBufferBeginInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -311,6 +324,18 @@ void CommandBuffer::image_barrier(const Texture *t, AccessFlags src_access, Acce
 			&barrier);
 }
 
+void CommandBuffer::memory_barrier(AccessFlags src_access, AccessFlags dst_access) {
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = (VkAccessFlags)src_access;
+	barrier.dstAccessMask = (VkAccessFlags)dst_access;
+
+	vkCmdPipelineBarrier(buffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
 void CommandBuffer::copy_image(const Texture *source, const Texture *dest, const Array<int> &extend) {
 	VkImageCopy region;
 	region.srcSubresource = {source->image.aspect(), 0, 0, 1};
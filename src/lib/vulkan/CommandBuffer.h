@@ -22,6 +22,7 @@ namespace vulkan{
 
 	class BasePipeline;
 	class VertexBuffer;
+	class Buffer;
 	class RenderPass;
 	class DescriptorSet;
 	class FrameBuffer;
@@ -35,8 +36,12 @@ namespace vulkan{
 		SHADER_READ_BIT = VK_ACCESS_SHADER_READ_BIT,
 		SHADER_WRITE_BIT = VK_ACCESS_SHADER_WRITE_BIT,
 		TRANSFER_READ_BIT = VK_ACCESS_TRANSFER_READ_BIT,
-		TRANSFER_WRITE_BIT = VK_ACCESS_TRANSFER_WRITE_BIT
+		TRANSFER_WRITE_BIT = VK_ACCESS_TRANSFER_WRITE_BIT,
+		INDIRECT_COMMAND_READ_BIT = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
 	};
+	inline AccessFlags operator|(AccessFlags a, AccessFlags b) {
+		return (AccessFlags)((int)a | (int)b);
+	}
 
 	enum class ImageLayout {
 		UNDEFINED = VK_IMAGE_LAYOUT_UNDEFINED,
@@ -91,6 +96,9 @@ namespace vulkan{
 		void clear(const rect& area, const Array<color> &col, base::optional<float> z);
 		void draw(VertexBuffer *vb);
 		void draw_instanced(VertexBuffer *vb, int num_instances);
+		void draw_range(VertexBuffer *vb, int first, int count);
+		// VkDrawIndirectCommand read from args at offset
+		void draw_instanced_indirect(VertexBuffer *vb, Buffer *args, int offset);
 
 		void set_bind_point(PipelineBindPoint bind_point);
 
@@ -102,6 +110,7 @@ namespace vulkan{
 
 		void barrier(const Array<Texture*> &t, int mode);
 		void image_barrier(const Texture *t, AccessFlags src_access, AccessFlags dst_access, ImageLayout old_layout, ImageLayout new_layout);
+		void memory_barrier(AccessFlags src_access, AccessFlags dst_access);
 		void copy_image(const Texture *source, const Texture *dest, const Array<int> &extend);
 
 		void timestamp(int id);
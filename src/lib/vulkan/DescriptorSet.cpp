@@ -72,10 +72,10 @@ VkDescriptorType descriptor_type(const string &s) {
 
 	DescriptorSet *DescriptorPool::create_set(const string &s) {
 		Array<VkDescriptorType> types;
-		Array<int> binding_no;
-		DescriptorSet::digest_bindings(s, types, binding_no);
+		Array<int> binding_no, counts;
+		DescriptorSet::digest_bindings(s, types, binding_no, counts);
 
-		auto layout = DescriptorSet::create_layout(types, binding_no);
+		auto layout = DescriptorSet::create_layout(types, binding_no, counts);
 		return create_set_from_layout(layout);
 	}
 
@@ -119,10 +119,21 @@ VkDescriptorType descriptor_type(const string &s) {
 	}
 
 	void DescriptorSet::set_texture(int binding, Texture *t) {
-		auto &i = get_for_binding(images, binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		i.info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		i.info.imageView = t->view;
-		i.info.sampler = t->sampler;
+		set_texture_element(binding, 0, t);
+	}
+
+	void DescriptorSet::set_texture_element(int binding, int element, Texture *t) {
+		ImageData *i = nullptr;
+		for (auto &x: images)
+			if (x.binding == binding and x.element == element)
+				i = &x;
+		if (!i) {
+			images.add({{}, binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, element});
+			i = &images.back();
+		}
+		i->info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		i->info.imageView = t->view;
+		i->info.sampler = t->sampler;
 	}
 
 	void DescriptorSet::set_storage_image(int binding, Texture *t) {
@@ -133,12 +144,12 @@ VkDescriptorType descriptor_type(const string &s) {
 		i.info.sampler = VK_NULL_HANDLE; //t->sampler;
 	}
 
-	void DescriptorSet::set_uniform_buffer_with_offset(int binding, Buffer *u, int offset) {
+	void DescriptorSet::set_uniform_buffer_with_offset(int binding, Buffer *u, int offset, int range) {
 		auto type = /*u->is_dynamic() ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC :*/ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		auto &i = get_for_binding(buffers, binding, type);
 		i.info.buffer = u->buffer;
 		i.info.offset = offset;
-		i.info.range = u->size;
+		i.info.range = (range >= 0) ? range : u->size;
 	}
 
 	void DescriptorSet::set_storage_buffer(int binding, Buffer *u) {
@@ -182,7 +193,7 @@ VkDescriptorType descriptor_type(const string &s) {
 			w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 			w.dstSet = descriptor_set;
 			w.dstBinding = i.binding;
-			w.dstArrayElement = 0;
+			w.dstArrayElement = i.element;
 			w.descriptorType = i.type;
 			w.descriptorCount = 1;
 			w.pImageInfo = &i.info;
@@ -203,13 +214,13 @@ VkDescriptorType descriptor_type(const string &s) {
 		vkUpdateDescriptorSets(default_device->device, static_cast<uint32_t>(wds.num), &wds[0], 0, nullptr);
 	}
 
-	VkDescriptorSetLayout DescriptorSet::create_layout(const Array<VkDescriptorType> &types, const Array<int> &binding_no) {
+	VkDescriptorSetLayout DescriptorSet::create_layout(const Array<VkDescriptorType> &types, const Array<int> &binding_no, const Array<int> &counts) {
 		//std::cout << "create dset layout, " << num_ubos << " ubos, " << num_samplers << " samplers\n";
 		Array<VkDescriptorSetLayoutBinding> bindings;
 		for (int i=0; i<types.num;i++) {
 			VkDescriptorSetLayoutBinding lb = {};
 			lb.descriptorType = types[i];
-			lb.descriptorCount = 1;
+			lb.descriptorCount = counts[i];
 			lb.binding = binding_no[i];
 			lb.pImmutableSamplers = nullptr;
 			if (types[i] == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
@@ -251,16 +262,17 @@ VkDescriptorType descriptor_type(const string &s) {
 				break;
 			string bb = bindings.sub(i1+1, i2);
 			Array<VkDescriptorType> types;
-			Array<int> binding_no;
-			digest_bindings(bb, types, binding_no);
-			rr.add(DescriptorSet::create_layout(types, binding_no));
+			Array<int> binding_no, counts;
+			digest_bindings(bb, types, binding_no, counts);
+			rr.add(DescriptorSet::create_layout(types, binding_no, counts));
 
 			i0 = i2 + 1;
 		}
 		return rr;
 	}
 
-	void DescriptorSet::digest_bindings(const string &bindings, Array<VkDescriptorType> &types, Array<int> &binding_no) {
+	// "type" or "type*n" (array of n descriptors), "" or "." skips a binding
+	void DescriptorSet::digest_bindings(const string &bindings, Array<VkDescriptorType> &types, Array<int> &binding_no, Array<int> &counts) {
 		auto x = bindings.explode(",");
 		//int num_samplers = 0;
 		int cur_binding = 0;
@@ -268,7 +280,9 @@ VkDescriptorType descriptor_type(const string &s) {
 			if (y == "" or y == ".") {
 				cur_binding ++;
 			} else {
-				types.add(descriptor_type(y));
+				auto z = y.explode("*");
+				types.add(descriptor_type(z[0]));
+				counts.add((z.num >= 2) ? max(z[1]._int(), 1) : 1);
 				binding_no.add(cur_binding ++);
 			}
 		}
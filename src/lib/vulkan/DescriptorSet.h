@@ -45,9 +45,12 @@ namespace vulkan{
 		~DescriptorSet();
 
 		void set_uniform_buffer(int binding, Buffer *b);
-		void set_uniform_buffer_with_offset(int binding, Buffer *b, int offset);
+		// range < 0: whole buffer
+		void set_uniform_buffer_with_offset(int binding, Buffer *b, int offset, int range = -1);
 		void set_storage_buffer(int binding, Buffer *b);
 		void set_texture(int binding, Texture *t);
+		// element of a sampler array binding ("sampler*n")
+		void set_texture_element(int binding, int element, Texture *t);
 		void set_storage_image(int binding, Texture *t);
 		void set_acceleration_structure(int binding, AccelerationStructure *a);
 
@@ -64,6 +67,7 @@ namespace vulkan{
 			VkDescriptorImageInfo info;
 			int binding;
 			VkDescriptorType type;
+			int element = 0;
 		};
 		struct AccelerationData {
 			VkWriteDescriptorSetAccelerationStructureNV info;
@@ -76,8 +80,8 @@ namespace vulkan{
 		int num_dynamic_ubos;
 
 		static Array<VkDescriptorSetLayout> parse_bindings(const string &bindings);
-		static void digest_bindings(const string &bindings, Array<VkDescriptorType> &types, Array<int> &binding_no);
-		static VkDescriptorSetLayout create_layout(const Array<VkDescriptorType> &types, const Array<int> &bindings);
+		static void digest_bindings(const string &bindings, Array<VkDescriptorType> &types, Array<int> &binding_no, Array<int> &counts);
+		static VkDescriptorSetLayout create_layout(const Array<VkDescriptorType> &types, const Array<int> &bindings, const Array<int> &counts);
 		static void destroy_layout(VkDescriptorSetLayout layout);
 	};
 };
@@ -13,6 +13,8 @@
 #include "Queue.h"
 #include "helper.h"
 #include "common.h"
+#include "MemoryAllocator.h"
+#include "Uploader.h"
 
 #include "../base/set.h"
 #include "../os/msg.h"
@@ -107,8 +109,14 @@ Device::Device() {
 }
 
 Device::~Device() {
+	if (frame_allocator)
+		delete frame_allocator;
+	if (uploader)
+		delete uploader;
 	if (command_pool)
 		delete command_pool;
+	if (allocator)
+		delete allocator;
 	if (surface)
 		vkDestroySurfaceKHR(instance->instance, surface, nullptr);
 	if (device)
@@ -219,6 +227,10 @@ void Device::create_logical_device(VkSurfaceKHR surface, Requirements req) {
 		device_features.geometryShader = VK_TRUE;
 	if (req & Requirements::ANISOTROPY)
 		device_features.samplerAnisotropy = VK_TRUE;
+	// loop indices into sampler arrays (shadow cascades)
+	VkPhysicalDeviceFeatures supported_features;
+	vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+	device_features.shaderSampledImageArrayDynamicIndexing = supported_features.shaderSampledImageArrayDynamicIndexing;
 
 	VkDeviceCreateInfo create_info = {};
 	create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -325,6 +337,15 @@ Array<int> Device::get_timestamps(int first, int count) {
 	return tt;
 }
 
+// does not block - false, if any of the results is not ready yet
+bool Device::get_timestamps_if_available(int first, int count, Array<int>& result) {
+	result.resize(count);
+	if (count == 0)
+		return true;
+	auto r = vkGetQueryPoolResults(device, query_pool, first, count, sizeof(result[0]) * result.num, &result[0], 4, 0);
+	return r == VK_SUCCESS;
+}
+
 
 int Device::make_aligned(int size) {
 	if (physical_device_properties.limits.minUniformBufferOffsetAlignment == 0)
@@ -367,6 +388,9 @@ xfer<Device> Device::create_simple(Instance *instance, VkSurfaceKHR surface, con
 	device->create_logical_device(surface, req);
 
 	device->command_pool = new CommandPool(device);
+	device->allocator = new MemoryAllocator(device);
+	device->uploader = new Uploader(device, 32 << 20);
+	device->frame_allocator = new LinearAllocator(device, 4 << 20, 2, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 	if (sa_contains(op, "rtx"))
 		device->get_rtx_properties();
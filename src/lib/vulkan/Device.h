@@ -17,6 +17,9 @@ namespace vulkan {
 
 	class Instance;
 	class CommandPool;
+	class MemoryAllocator;
+	class LinearAllocator;
+	class Uploader;
 	enum class Requirements;
 
 
@@ -44,6 +47,10 @@ public:
 	Queue compute_queue;
 
 	CommandPool *command_pool = nullptr;
+	MemoryAllocator *allocator = nullptr;
+	Uploader *uploader = nullptr;
+	// transient uniform data, next_frame() once per frame
+	LinearAllocator *frame_allocator = nullptr;
 
 	string physical_name() const;
 
@@ -70,6 +77,7 @@ public:
 	void create_query_pool(int count);
 	void reset_query_pool(int first, int count);
 	Array<int> get_timestamps(int first, int count);
+	bool get_timestamps_if_available(int first, int count, Array<int>& result);
 };
 
 extern Device *default_device;
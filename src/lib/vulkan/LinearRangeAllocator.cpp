@@ -0,0 +1,35 @@
+/*
+ * LinearRangeAllocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "LinearRangeAllocator.h"
+#include "RangeAllocator.h"
+
+namespace vulkan {
+
+LinearRangeAllocator::LinearRangeAllocator(int64 _frame_size, int _num_frames) {
+	frame_size = _frame_size;
+	num_frames = _num_frames;
+	frame = 0;
+	used = 0;
+	peak = 0;
+}
+
+void LinearRangeAllocator::next_frame() {
+	frame = (frame + 1) % num_frames;
+	used = 0;
+}
+
+int64 LinearRangeAllocator::allocate(int64 size, int64 alignment) {
+	int64 offset = align_up(used, alignment);
+	if (offset + size > frame_size)
+		return -1;
+	used = offset + size;
+	peak = max(peak, used);
+	return offset + frame_size * frame;
+}
+
+}
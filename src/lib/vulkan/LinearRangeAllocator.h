@@ -0,0 +1,35 @@
+/*
+ * LinearRangeAllocator.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../base/base.h"
+
+namespace vulkan {
+
+	// bump sub-allocation of [0, frame_size * num_frames), used by LinearAllocator
+	//   one region per frame in flight, reset when the frame comes around again
+	//   only offsets, no vulkan calls (testable without a device)
+	class LinearRangeAllocator {
+	public:
+		LinearRangeAllocator(int64 frame_size, int num_frames);
+
+		// switch to the next region, everything allocated in it num_frames ago is dropped
+		void next_frame();
+		// offset into the whole range, -1 if this frame's region is full
+		int64 allocate(int64 size, int64 alignment);
+
+		int64 frame_size;
+		int num_frames;
+		int frame;
+		// in the current region
+		int64 used;
+		// largest used of any frame so far (for statistics)
+		int64 peak;
+	};
+
+}
@@ -0,0 +1,235 @@
+/*
+ * MemoryAllocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#if HAS_LIB_VULKAN
+
+#include "MemoryAllocator.h"
+#include "Device.h"
+#include "Buffer.h"
+#include "../os/msg.h"
+
+namespace vulkan {
+
+static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 << 20;
+
+static string mb_str(VkDeviceSize size) {
+	return format("%.1f MB", (float)size / (float)(1 << 20));
+}
+
+
+void Allocation::flush() const {
+	if (!non_coherent)
+		return;
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = memory;
+	range.offset = offset;
+	range.size = size;
+	vkFlushMappedMemoryRanges(block->device->device, 1, &range);
+}
+
+void Allocation::invalidate() const {
+	if (!non_coherent)
+		return;
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = memory;
+	range.offset = offset;
+	range.size = size;
+	vkInvalidateMappedMemoryRanges(block->device->device, 1, &range);
+}
+
+
+MemoryBlock::MemoryBlock(Device *_device, uint32_t _memory_type, VkDeviceSize _size, bool _linear, bool _dedicated, VkMemoryPropertyFlags flags) : ranges(_size) {
+	device = _device;
+	memory_type = _memory_type;
+	linear = _linear;
+	dedicated = _dedicated;
+	mapped = nullptr;
+	memory = VK_NULL_HANDLE;
+	bool host_visible = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	non_coherent = host_visible and !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = _size;
+	alloc_info.memoryTypeIndex = memory_type;
+
+	if (vkAllocateMemory(device->device, &alloc_info, nullptr, &memory) != VK_SUCCESS)
+		throw Exception(format("failed to allocate memory block (%s)", mb_str(_size)));
+
+	if (host_visible)
+		vkMapMemory(device->device, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+}
+
+MemoryBlock::~MemoryBlock() {
+	if (mapped)
+		vkUnmapMemory(device->device, memory);
+	if (memory)
+		vkFreeMemory(device->device, memory, nullptr);
+}
+
+bool MemoryBlock::allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation &a) {
+	int64 offset = ranges.allocate(size, alignment);
+	if (offset < 0)
+		return false;
+	a.block = this;
+	a.memory = memory;
+	a.offset = offset;
+	a.size = size;
+	a.mapped = mapped ? ((char*)mapped + offset) : nullptr;
+	a.non_coherent = non_coherent;
+	return true;
+}
+
+void MemoryBlock::free(const Allocation &a) {
+	ranges.free(a.offset, a.size);
+}
+
+int MemoryBlock::kind() const {
+	return (int)memory_type * 4 + (linear ? 2 : 0) + (dedicated ? 1 : 0);
+}
+
+
+
+MemoryAllocator::MemoryAllocator(Device *_device) {
+	device = _device;
+	block_size = DEFAULT_BLOCK_SIZE;
+	num_allocate_calls = 0;
+	non_coherent_atom_size = max(device->physical_device_properties.limits.nonCoherentAtomSize, (VkDeviceSize)1);
+	vkGetPhysicalDeviceMemoryProperties(device->physical_device, &memory_properties);
+
+	// small heaps (e.g. 256MB host visible device local) get smaller blocks
+	for (uint32_t i=0; i<memory_properties.memoryHeapCount; i++)
+		block_size = min(block_size, memory_properties.memoryHeaps[i].size / 8);
+	block_size = align_up(block_size, non_coherent_atom_size);
+}
+
+MemoryAllocator::~MemoryAllocator() {
+	for (auto b: blocks)
+		delete b;
+}
+
+Allocation MemoryAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t type = device->find_memory_type(requirements, properties);
+	auto flags = memory_properties.memoryTypes[type].propertyFlags;
+	VkDeviceSize size = requirements.size;
+	VkDeviceSize alignment = requirements.alignment;
+	// flushed ranges must be aligned to whole atoms
+	if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) and !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+		size = align_up(size, non_coherent_atom_size);
+		alignment = max(alignment, non_coherent_atom_size);
+	}
+	Allocation a;
+
+	// large ones don't share
+	if (size > block_size / 2) {
+		auto b = new MemoryBlock(device, type, size, linear, true, flags);
+		blocks.add(b);
+		num_allocate_calls ++;
+		b->allocate(size, alignment, a);
+		return a;
+	}
+
+	for (auto b: blocks)
+		if (b->memory_type == type and b->linear == linear and !b->dedicated)
+			if (b->allocate(size, alignment, a))
+				return a;
+
+	auto b = new MemoryBlock(device, type, block_size, linear, false, flags);
+	blocks.add(b);
+	num_allocate_calls ++;
+	if (!b->allocate(size, alignment, a))
+		throw Exception("failed to sub-allocate memory");
+	return a;
+}
+
+void MemoryAllocator::free(Allocation &a) {
+	if (!a.block)
+		return;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto b = a.block;
+	b->free(a);
+	if (b->dedicated) {
+		int i = blocks.find(b);
+		if (i >= 0)
+			blocks.erase(i);
+		delete b;
+	} else if (b->is_empty()) {
+		// normal blocks are kept for reuse, but only one empty block per kind
+		_trim(1);
+	}
+	a = Allocation();
+}
+
+void MemoryAllocator::trim() {
+	std::lock_guard<std::mutex> lock(mutex);
+	_trim(0);
+}
+
+void MemoryAllocator::_trim(int keep_empty) {
+	auto r = empty_blocks_to_release(blocks, keep_empty);
+	for (int i=r.num-1; i>=0; i--) {
+		delete blocks[r[i]];
+		blocks.erase(r[i]);
+	}
+}
+
+Array<MemoryBlock*> MemoryAllocator::defragmentation_candidates(float max_usage) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Array<MemoryBlock*> r;
+	for (auto b: blocks)
+		if (!b->dedicated and b->ranges.is_sparse(max_usage))
+			r.add(b);
+	return r;
+}
+
+RangeStats MemoryAllocator::stats() {
+	std::lock_guard<std::mutex> lock(mutex);
+	RangeStats s;
+	for (auto b: blocks)
+		s.add(b->ranges, b->dedicated);
+	return s;
+}
+
+void MemoryAllocator::dump_stats() {
+	msg_write("vulkan memory: " + stats().str() + format(", %d vkAllocateMemory() calls", num_allocate_calls));
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto b: blocks)
+		msg_write(format("  type %d  %s  %s/%s  allocations: %d  free ranges: %d  largest free: %s",
+				b->memory_type, b->dedicated ? "dedicated" : (b->linear ? "linear" : "optimal"),
+				mb_str(b->ranges.used), mb_str(b->ranges.size), b->ranges.num_allocations, b->ranges.free_ranges.num, mb_str(b->ranges.largest_free_range())));
+}
+
+
+
+LinearAllocator::LinearAllocator(Device *device, VkDeviceSize size_per_frame, int num_frames, VkBufferUsageFlags usage) : ranges(size_per_frame, num_frames) {
+	buffer = new Buffer(device);
+	buffer->create(size_per_frame * num_frames, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+LinearAllocator::~LinearAllocator() {
+	delete buffer;
+}
+
+void LinearAllocator::next_frame() {
+	ranges.next_frame();
+}
+
+int64 LinearAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment, void **p) {
+	int64 offset = ranges.allocate(size, alignment);
+	if (offset >= 0 and p)
+		*p = (char*)buffer->allocation.mapped + offset;
+	return offset;
+}
+
+}
+
+#endif
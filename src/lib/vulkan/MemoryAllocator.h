@@ -0,0 +1,115 @@
+/*
+ * MemoryAllocator.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#if HAS_LIB_VULKAN
+
+#include "../base/base.h"
+#include "RangeAllocator.h"
+#include "LinearRangeAllocator.h"
+#include <vulkan/vulkan.h>
+#include <mutex>
+
+namespace vulkan {
+
+	class Device;
+	class Buffer;
+	class MemoryBlock;
+
+	struct Allocation {
+		MemoryBlock *block = nullptr;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		// host visible memory stays mapped
+		void *mapped = nullptr;
+		// host visible, but without HOST_COHERENT: needs flush()/invalidate()
+		//   offset and size are multiples of nonCoherentAtomSize then
+		bool non_coherent = false;
+
+		void flush() const;
+		void invalidate() const;
+	};
+
+	// one vkAllocateMemory(), sub-allocated first fit
+	class MemoryBlock {
+	public:
+		MemoryBlock(Device *device, uint32_t memory_type, VkDeviceSize size, bool linear, bool dedicated, VkMemoryPropertyFlags flags);
+		~MemoryBlock();
+
+		bool allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation &a);
+		void free(const Allocation &a);
+
+		bool is_empty() const { return ranges.is_empty(); }
+		// blocks of the same kind can replace each other
+		int kind() const;
+
+		Device *device;
+		VkDeviceMemory memory;
+		uint32_t memory_type;
+		// buffers and linear images never share a block with optimal images (bufferImageGranularity)
+		bool linear;
+		bool dedicated;
+		bool non_coherent;
+		void *mapped;
+		RangeAllocator ranges;
+	};
+
+	// blocks per memory type, large resources get their own dedicated block
+	class MemoryAllocator {
+	public:
+		explicit MemoryAllocator(Device *device);
+		~MemoryAllocator();
+
+		Allocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear);
+		// empty blocks get released by free(), except for one spare per kind
+		void free(Allocation &a);
+
+		// releases all empty blocks
+		void trim();
+
+		// defragmentation hook:
+		//   owners of resources in these blocks should recreate them, then call trim()
+		//   (filled less than max_usage, not dedicated)
+		Array<MemoryBlock*> defragmentation_candidates(float max_usage);
+
+		RangeStats stats();
+		void dump_stats();
+
+		Device *device;
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		VkDeviceSize block_size;
+		VkDeviceSize non_coherent_atom_size;
+		Array<MemoryBlock*> blocks;
+		// for statistics
+		int num_allocate_calls;
+
+	private:
+		void _trim(int keep_empty);
+		std::mutex mutex;
+	};
+
+	// bump allocator for transient per frame data (host visible, coherent)
+	//   one region per frame in flight, reused once the frame comes around again
+	class LinearAllocator {
+	public:
+		LinearAllocator(Device *device, VkDeviceSize size_per_frame, int num_frames, VkBufferUsageFlags usage);
+		~LinearAllocator();
+
+		// call once per frame, when the gpu is done with the region num_frames ago
+		void next_frame();
+		// offset into buffer, -1 if this frame's region is full
+		int64 allocate(VkDeviceSize size, VkDeviceSize alignment, void **p);
+
+		Buffer *buffer;
+		LinearRangeAllocator ranges;
+	};
+
+}
+
+#endif
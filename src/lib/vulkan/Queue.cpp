@@ -13,6 +13,8 @@
 #include "vulkan.h"
 #include "helper.h"
 #include "common.h"
+#include "Device.h"
+#include "Uploader.h"
 #include "../base/set.h"
 #include "../base/iter.h"
 
@@ -26,10 +28,20 @@ bool Queue::submit(CommandBuffer *cb, const Array<Semaphore*> &wait_sem, const A
 
 	auto wait_semaphores = extract_semaphores(wait_sem);
 	auto signal_semaphores = extract_semaphores(signal_sem);
-	VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+	Array<VkPipelineStageFlags> wait_stages;
+	for (int i=0; i<wait_semaphores.num; i++)
+		wait_stages.add(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+	// pending uploads get submitted before
+	if (default_device and default_device->uploader)
+		if (auto s = default_device->uploader->flush(this)) {
+			wait_semaphores.add(s->semaphore);
+			wait_stages.add(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+
 	submit_info.waitSemaphoreCount = wait_semaphores.num;
 	submit_info.pWaitSemaphores = &wait_semaphores[0];
-	submit_info.pWaitDstStageMask = wait_stages;
+	submit_info.pWaitDstStageMask = &wait_stages[0];
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers = &cb->buffer;
 	submit_info.signalSemaphoreCount = signal_semaphores.num;
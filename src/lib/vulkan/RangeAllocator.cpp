@@ -0,0 +1,99 @@
+/*
+ * RangeAllocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "RangeAllocator.h"
+
+namespace vulkan {
+
+int64 align_up(int64 x, int64 alignment) {
+	if (alignment <= 1)
+		return x;
+	return (x + alignment - 1) / alignment * alignment;
+}
+
+RangeAllocator::RangeAllocator(int64 _size) {
+	size = _size;
+	used = 0;
+	num_allocations = 0;
+	free_ranges.add({0, size});
+}
+
+int64 RangeAllocator::allocate(int64 _size, int64 alignment) {
+	foreachi (auto &r, free_ranges, i) {
+		int64 offset = align_up(r.offset, alignment);
+		int64 padding = offset - r.offset;
+		if (padding + _size > r.size)
+			continue;
+
+		Range before = {r.offset, padding};
+		Range after = {offset + _size, r.size - padding - _size};
+		free_ranges.erase(i);
+		if (after.size > 0)
+			free_ranges.insert(after, i);
+		if (before.size > 0)
+			free_ranges.insert(before, i);
+
+		used += _size;
+		num_allocations ++;
+		return offset;
+	}
+	return -1;
+}
+
+void RangeAllocator::free(int64 offset, int64 _size) {
+	int i = 0;
+	while (i < free_ranges.num and free_ranges[i].offset < offset)
+		i ++;
+	free_ranges.insert({offset, _size}, i);
+
+	// merge with next
+	if (i + 1 < free_ranges.num and free_ranges[i].offset + free_ranges[i].size == free_ranges[i + 1].offset) {
+		free_ranges[i].size += free_ranges[i + 1].size;
+		free_ranges.erase(i + 1);
+	}
+	// merge with previous
+	if (i > 0 and free_ranges[i - 1].offset + free_ranges[i - 1].size == free_ranges[i].offset) {
+		free_ranges[i - 1].size += free_ranges[i].size;
+		free_ranges.erase(i);
+	}
+
+	used -= _size;
+	num_allocations --;
+}
+
+int64 RangeAllocator::largest_free_range() const {
+	int64 m = 0;
+	for (auto &r: free_ranges)
+		m = max(m, r.size);
+	return m;
+}
+
+bool RangeAllocator::is_sparse(float max_usage) const {
+	return !is_empty() and (float)used < (float)size * max_usage;
+}
+
+
+void RangeStats::add(const RangeAllocator &r, bool dedicated) {
+	num_blocks ++;
+	if (dedicated)
+		num_dedicated ++;
+	num_allocations += r.num_allocations;
+	allocated += r.size;
+	used += r.used;
+	largest_free_range = max(largest_free_range, r.largest_free_range());
+}
+
+static string mb_str(int64 size) {
+	return format("%.1f MB", (float)size / (float)(1 << 20));
+}
+
+string RangeStats::str() const {
+	return format("%d allocations in %d blocks (%d dedicated), %s used of %s, largest free range %s",
+			num_allocations, num_blocks, num_dedicated, mb_str(used), mb_str(allocated), mb_str(largest_free_range));
+}
+
+}
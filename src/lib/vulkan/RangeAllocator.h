@@ -0,0 +1,69 @@
+/*
+ * RangeAllocator.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../base/base.h"
+
+namespace vulkan {
+
+	// first fit sub-allocation of [0, size), used by MemoryBlock
+	//   only offsets, no vulkan calls (testable without a device)
+	class RangeAllocator {
+	public:
+		explicit RangeAllocator(int64 size);
+
+		// offset, -1 if no free range fits
+		int64 allocate(int64 size, int64 alignment);
+		void free(int64 offset, int64 size);
+
+		int64 largest_free_range() const;
+		bool is_empty() const { return num_allocations == 0; }
+		// filled less than max_usage (but not empty): worth moving the content elsewhere
+		bool is_sparse(float max_usage) const;
+
+		int64 size, used;
+		int num_allocations;
+
+		struct Range {
+			int64 offset, size;
+		};
+		// sorted by offset, neighbours get merged
+		Array<Range> free_ranges;
+	};
+
+	int64 align_up(int64 x, int64 alignment);
+
+	// summed over several blocks
+	struct RangeStats {
+		int num_blocks = 0, num_dedicated = 0, num_allocations = 0;
+		int64 allocated = 0, used = 0;
+		int64 largest_free_range = 0;
+
+		void add(const RangeAllocator &r, bool dedicated);
+		string str() const;
+	};
+
+	// indices of empty blocks to release, keeping up to keep_empty empty blocks per kind for reuse
+	//   B: ->ranges (RangeAllocator), ->kind() (blocks of the same kind can replace each other)
+	template<class B>
+	Array<int> empty_blocks_to_release(const Array<B*> &blocks, int keep_empty) {
+		Array<int> r;
+		for (int i=0; i<blocks.num; i++) {
+			if (!blocks[i]->ranges.is_empty())
+				continue;
+			int kept = 0;
+			for (int j=0; j<i; j++)
+				if (blocks[j]->ranges.is_empty() and blocks[j]->kind() == blocks[i]->kind() and r.find(j) < 0)
+					kept ++;
+			if (kept >= keep_empty)
+				r.add(i);
+		}
+		return r;
+	}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * RingAllocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "RingAllocator.h"
+#include "RangeAllocator.h"
+
+namespace vulkan {
+
+RingAllocator::RingAllocator(int64 _size) {
+	size = _size;
+	head = tail = used = 0;
+}
+
+int64 RingAllocator::allocate(int64 _size, int64 alignment, int64 &bytes) {
+	if (used == 0)
+		head = tail = 0;
+
+	int64 o = align_up(head, alignment);
+	int64 offset;
+	if (head > tail or (head == tail and used == 0)) {
+		// free: [head, size) and [0, tail)
+		if (o + _size <= size) {
+			offset = o;
+		} else if (_size <= tail) {
+			// wrap around, the rest of the ring is wasted until released
+			o = size;
+			offset = 0;
+		} else {
+			return -1;
+		}
+	} else {
+		// free: [head, tail)
+		if (o + _size > tail)
+			return -1;
+		offset = o;
+	}
+
+	bytes = (o - head) + _size;
+	used += bytes;
+	head = offset + _size;
+	return offset;
+}
+
+void RingAllocator::release(int64 bytes) {
+	tail = (tail + bytes) % size;
+	used -= bytes;
+}
+
+}
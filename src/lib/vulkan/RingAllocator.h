@@ -0,0 +1,31 @@
+/*
+ * RingAllocator.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include "../base/base.h"
+
+namespace vulkan {
+
+	// fifo sub-allocation of [0, size), used by the Uploader's staging ring
+	//   released in the order of allocation (oldest first)
+	//   only offsets, no vulkan calls (testable without a device)
+	class RingAllocator {
+	public:
+		explicit RingAllocator(int64 size);
+
+		// offset, -1 if it doesn't fit right now
+		//   bytes: what to release() later, including alignment and wrap-around waste
+		int64 allocate(int64 size, int64 alignment, int64 &bytes);
+		void release(int64 bytes);
+
+		int64 size;
+		// data lives in [tail, tail + used) (mod size)
+		int64 head, tail, used;
+	};
+
+}
@@ -17,6 +17,7 @@
 
 #if HAS_LIB_SHADERC
 #include "shaderc/shaderc.h"
+#include <mutex>
 #endif
 
 string with_line_numbers(const string& s) {
@@ -50,6 +51,7 @@ static shaderc_compiler_t shaderc = nullptr;
 	}
 
 	Path Shader::directory;
+	Path Shader::cache_directory;
 
 
 	string overwrite_bindings;
@@ -224,32 +226,76 @@ static shaderc_compiler_t shaderc = nullptr;
 		return shaderc_glsl_vertex_shader;
 	}
 
-	VkShaderModule create_vk_shader(const string &_source, VkShaderStageFlagBits type, ShaderMetaData &meta) {
-		string source = expand_shader_source(_source, meta);
-		if (source.num == 0)
-			return nullptr;
-		static shaderc_compile_options_t options;
-		if (!shaderc) {
+	static shaderc_compile_options_t shaderc_options;
+	static std::once_flag shaderc_init_flag;
+
+	void init_shaderc() {
+		std::call_once(shaderc_init_flag, [] {
 			shaderc = shaderc_compiler_initialize();
-			options = shaderc_compile_options_initialize();
-			shaderc_compile_options_add_macro_definition(options, "vulkan", 6, "1", 1);
+			shaderc_options = shaderc_compile_options_initialize();
+			shaderc_compile_options_add_macro_definition(shaderc_options, "vulkan", 6, "1", 1);
+		});
+	}
+
+	// whole words, starting with the magic number (header: 5 words)
+	static bool is_valid_spirv(const bytes &code) {
+		if (code.num < 20 or (code.num % 4) != 0)
+			return false;
+		return *(const unsigned int*)&code[0] == 0x07230203;
+	}
+
+	// thread safe (shaderc compilers can be shared)
+	bytes compile_spirv(const string &source, VkShaderStageFlagBits type) {
+		Path cache_file;
+		if (!Shader::cache_directory.is_empty()) {
+			cache_file = Shader::cache_directory | ((format("<%d>\n", (int)type) + source).md5() + ".spv");
+			if (os::fs::exists(cache_file)) {
+				try {
+					auto code = os::fs::read_binary(cache_file);
+					if (is_valid_spirv(code))
+						return code;
+					msg_error("broken shader cache file, recompiling: " + cache_file.str());
+				} catch (...) {
+				}
+			}
 		}
-		//msg_write(">>>----------------------------------------------------------------------------------- xxxx");
-		//msg_write(source);
 
+		init_shaderc();
 		auto result = shaderc_compile_into_spv(shaderc,
 				(const char*)&source[0], source.num,
-				vk_to_shaderc(type), "dummy", "main", options);
+				vk_to_shaderc(type), "dummy", "main", shaderc_options);
 
-		if (shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success) {
-			bytes code = bytes(shaderc_result_get_bytes(result), shaderc_result_get_length(result));
-			shaderc_result_release(result);
-			return create_shader_module(code);
-		} else {
-			shader_error = shaderc_result_get_error_message(result);
+		if (shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success) {
+			string error = shaderc_result_get_error_message(result);
 			shaderc_result_release(result);
+			throw Exception("while compiling shader: " + error);
+		}
+		bytes code = bytes(shaderc_result_get_bytes(result), shaderc_result_get_length(result));
+		shaderc_result_release(result);
+
+		if (!cache_file.is_empty()) {
+			try {
+				os::fs::write_binary_atomic(cache_file, code);
+			} catch (Exception &e) {
+				msg_error("can not write shader cache: " + e.message());
+			}
+		}
+		return code;
+	}
+
+	VkShaderModule create_vk_shader(const string &_source, VkShaderStageFlagBits type, ShaderMetaData &meta) {
+		string source = expand_shader_source(_source, meta);
+		if (source.num == 0)
+			return nullptr;
+		//msg_write(">>>----------------------------------------------------------------------------------- xxxx");
+		//msg_write(source);
+
+		try {
+			return create_shader_module(compile_spirv(source, type));
+		} catch (Exception &e) {
+			shader_error = e.message();
 			msg_error(shader_error);
-			throw Exception("while compiling shader: " + shader_error);
+			throw;
 		}
 		return nullptr;
 	}
@@ -315,12 +361,32 @@ static shaderc_compiler_t shaderc = nullptr;
 		s->descr_layouts = DescriptorSet::parse_bindings(meta.bindings);
 		return s;
 	}
+
+	void Shader::precompile(const string &source) {
+		auto parts = get_shader_parts(source);
+
+		ShaderMetaData meta;
+		for (auto p: parts) {
+			if ((int)p.type == TYPE_MODULE) {
+				return;
+			} else if ((int)p.type == TYPE_LAYOUT) {
+				meta = parse_meta(p.source);
+			} else {
+				string expanded = expand_shader_source(p.source, meta);
+				if (expanded.num > 0)
+					compile_spirv(expanded, p.type);
+			}
+		}
+	}
 #else
 
 	xfer<Shader> Shader::create(const string &source) {
 		throw Exception("Shader.crete() requires this program to be compiled with shaderc support!");
 		return nullptr;
 	}
+
+	void Shader::precompile(const string &source) {
+	}
 #endif
 
 
@@ -29,8 +29,12 @@ namespace vulkan{
 		VkShaderModule get_module(VkShaderStageFlagBits stage) const;
 
 		static Path directory;
+		// compiled SPIR-V is stored here, if not empty
+		static Path cache_directory;
 		static xfer<Shader> load(const Path &filename);
 		static xfer<Shader> create(const string &source);
+		// only fills the cache, can be called from several threads
+		static void precompile(const string &source);
 	};
 
 };
@@ -10,6 +10,7 @@
 #include "CommandBuffer.h"
 #include "Buffer.h"
 #include "Device.h"
+#include "Uploader.h"
 #include "../image/image.h"
 #include "../os/msg.h"
 
@@ -207,6 +208,19 @@ void Texture::writex(const void *data, int nx, int ny, int nz, const string &for
 	_create_sampler();
 }
 
+void Texture::write_float(const DynamicArray &data) {
+	int size = width * height * depth * format_size(image.format);
+	if (data.num * data.element_size != size) {
+		msg_error(format("Texture.write_float: array of size %d b given, but %d b expected", data.num * data.element_size, size));
+		return;
+	}
+
+	image.transition_layout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_levels, 0, 1);
+	auto s = default_device->uploader->stage(data.data, size);
+	copy_buffer_to_image(s.buffer, s.offset, image.image, width, height, depth, 0, 0);
+	image.transition_layout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mip_levels, 0, 1);
+}
+
 void Texture::_create_image(const void *image_data, VkImageType type, VkFormat format, int num_layers, VkSampleCountFlagBits samples, bool allow_mip, bool allow_storage, bool cube) {
 	int layer_size = width * height * depth * format_size(format);
 	//VkDeviceSize image_size = layer_size * num_layers;
@@ -232,12 +246,9 @@ void Texture::_create_image(const void *image_data, VkImageType type, VkFormat f
 
 
 	if (image_data) {
-		Buffer staging(default_device);
-		staging.create(layer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
 		for (int k=0; k<num_layers; k++) {
-			staging.update_part((char*)image_data + k * layer_size, 0, layer_size);
-			copy_buffer_to_image(staging.buffer, image.image, width, height, depth, 0, k);
+			auto s = default_device->uploader->stage((char*)image_data + k * layer_size, layer_size);
+			copy_buffer_to_image(s.buffer, s.offset, image.image, width, height, depth, 0, k);
 		}
 	}
 
@@ -367,11 +378,8 @@ void CubeMap::write_side(int side, const Image &_image) {
 	int layer_size = width * height * 4;
 
 
-	Buffer staging(default_device);
-	staging.create(layer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	staging.update_part(&_image.data[0], 0, layer_size);
-	copy_buffer_to_image(staging.buffer, image.image, width, height, depth, 0, side);
+	auto s = default_device->uploader->stage(&_image.data[0], layer_size);
+	copy_buffer_to_image(s.buffer, s.offset, image.image, width, height, depth, 0, side);
 
 
 	/*if (allow_mip)
@@ -34,6 +34,8 @@ namespace vulkan {
 		void _load(const Path &filename);
 		void write(const Image &image);
 		void writex(const void *image, int nx, int ny, int nz, const string &format);
+		// in place, same size and format
+		void write_float(const DynamicArray &data);
 		void read(void* data);
 
 
@@ -0,0 +1,179 @@
+/*
+ * Uploader.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#if HAS_LIB_VULKAN
+
+#include "Uploader.h"
+#include "Buffer.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "Queue.h"
+#include "Semaphore.h"
+#include <string.h>
+
+namespace vulkan {
+
+struct Uploader::Batch {
+	CommandBuffer *cb;
+	Fence *fence;
+	Semaphore *semaphore;
+	// ring bytes (including alignment and wrap-around waste)
+	VkDeviceSize ring_bytes;
+	// staging data too large for the ring
+	Array<Buffer*> temporaries;
+};
+
+static void global_barrier(CommandBuffer *cb, VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) {
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = src_access;
+	barrier.dstAccessMask = dst_access;
+	vkCmdPipelineBarrier(cb->buffer, src_stage, dst_stage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+
+Uploader::Uploader(Device *_device, VkDeviceSize ring_size) : ring_allocator(ring_size) {
+	device = _device;
+	num_batches_submitted = 0;
+	ring = new Buffer(device);
+	ring->create(ring_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+Uploader::~Uploader() {
+	wait();
+	for (auto b: unused) {
+		delete b->cb;
+		delete b->fence;
+		delete b->semaphore;
+		delete b;
+	}
+	delete ring;
+}
+
+CommandBuffer *Uploader::command_buffer() {
+	if (!current) {
+		if (unused.num > 0) {
+			current = unused.pop();
+		} else {
+			current = new Batch;
+			current->cb = device->command_pool->create_command_buffer();
+			current->fence = new Fence(device);
+			current->semaphore = new Semaphore(device);
+		}
+		current->ring_bytes = 0;
+		current->cb->begin();
+		// earlier submissions (previous frames) might still read what we overwrite
+		global_barrier(current->cb, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
+	return current->cb;
+}
+
+Uploader::Staging Uploader::stage(const void *data, VkDeviceSize size, VkDeviceSize alignment) {
+	command_buffer();
+
+	if ((int64)size > ring_allocator.size / 2) {
+		auto b = new Buffer(device);
+		b->create(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		b->update_part(data, 0, size);
+		current->temporaries.add(b);
+		return {b->buffer, 0};
+	}
+
+	int64 offset, bytes;
+	while ((offset = ring_allocator.allocate(size, alignment, bytes)) < 0) {
+		if (in_flight.num == 0) {
+			// the current batch fills the ring by itself
+			submit(current, false);
+			in_flight.add(current);
+			current = nullptr;
+			command_buffer();
+		}
+		retire(true);
+	}
+
+	current->ring_bytes += bytes;
+	memcpy((char*)ring->allocation.mapped + offset, data, size);
+	return {ring->buffer, (VkDeviceSize)offset};
+}
+
+void Uploader::upload_buffer(VkBuffer dest, VkDeviceSize dest_offset, const void *data, VkDeviceSize size) {
+	auto s = stage(data, size);
+	auto cb = command_buffer();
+
+	// several updates of the same buffer in one batch
+	global_barrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	VkBufferCopy region = {};
+	region.srcOffset = s.offset;
+	region.dstOffset = dest_offset;
+	region.size = size;
+	vkCmdCopyBuffer(cb->buffer, s.buffer, dest, 1, &region);
+}
+
+void Uploader::submit(Batch *b, bool with_semaphore) {
+	// make everything visible to the following submissions
+	global_barrier(b->cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+	b->cb->end();
+
+	VkSubmitInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	info.commandBufferCount = 1;
+	info.pCommandBuffers = &b->cb->buffer;
+	if (with_semaphore) {
+		info.signalSemaphoreCount = 1;
+		info.pSignalSemaphores = &b->semaphore->semaphore;
+	}
+
+	b->fence->reset();
+	if (vkQueueSubmit(device->graphics_queue.queue, 1, &info, b->fence->fence) != VK_SUCCESS)
+		throw Exception("failed to submit upload batch");
+	num_batches_submitted ++;
+}
+
+Semaphore *Uploader::flush(const Queue *queue) {
+	if (!current)
+		return nullptr;
+	bool other_queue = queue and (queue->queue != device->graphics_queue.queue);
+	auto b = current;
+	submit(b, other_queue);
+	in_flight.add(b);
+	current = nullptr;
+	retire(false);
+	return other_queue ? b->semaphore : nullptr;
+}
+
+void Uploader::retire(bool wait_for_oldest) {
+	while (in_flight.num > 0) {
+		auto b = in_flight[0];
+		if (wait_for_oldest) {
+			b->fence->wait();
+			wait_for_oldest = false;
+		} else if (vkGetFenceStatus(device->device, b->fence->fence) != VK_SUCCESS) {
+			break;
+		}
+
+		ring_allocator.release(b->ring_bytes);
+		for (auto t: b->temporaries)
+			delete t;
+		b->temporaries.clear();
+		in_flight.erase(0);
+		unused.add(b);
+	}
+}
+
+void Uploader::wait() {
+	flush(nullptr);
+	while (in_flight.num > 0)
+		retire(true);
+}
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Uploader.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#if HAS_LIB_VULKAN
+
+#include "../base/base.h"
+#include "RingAllocator.h"
+#include <vulkan/vulkan.h>
+
+namespace vulkan {
+
+	class Device;
+	class Buffer;
+	class CommandBuffer;
+	class Fence;
+	class Semaphore;
+	class Queue;
+
+	// uploads (and layout transitions, mipmaps) get recorded into one batch command buffer
+	//   submitted once before the next Queue::submit(), or when the staging ring runs full
+	//   completion is tracked with a fence per batch, nothing idles the queue
+	class Uploader {
+	public:
+		Uploader(Device *device, VkDeviceSize ring_size);
+		~Uploader();
+
+		// current batch, recording
+		CommandBuffer *command_buffer();
+
+		// copied into the persistent staging ring, valid until the batch completed
+		struct Staging {
+			VkBuffer buffer;
+			VkDeviceSize offset;
+		};
+		Staging stage(const void *data, VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		void upload_buffer(VkBuffer dest, VkDeviceSize dest_offset, const void *data, VkDeviceSize size);
+
+		// submits the current batch (if any) to the graphics queue
+		//   returns a semaphore to wait for, if the caller submits to a different queue
+		Semaphore *flush(const Queue *queue);
+		// flush, then block until all batches completed
+		void wait();
+
+		int num_batches_submitted;
+
+	private:
+		struct Batch;
+		Batch *current = nullptr;
+		Array<Batch*> in_flight;
+		Array<Batch*> unused;
+
+		void submit(Batch *b, bool with_semaphore);
+		// releases ring space of completed batches (oldest first)
+		void retire(bool wait_for_oldest);
+
+		Device *device;
+		Buffer *ring;
+		RingAllocator ring_allocator;
+	};
+
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include <vulkan/vulkan.h>
 
 #include "helper.h"
+#include "Device.h"
+#include "Uploader.h"
 #include "../os/msg.h"
 
 namespace vulkan{
@@ -112,12 +114,6 @@ void VertexBuffer::_create_buffer(Buffer &buf, const DynamicArray &array) {
 
 	VkDeviceSize buffer_size = array.num * array.element_size;
 
-	// -> staging
-	Buffer staging(vertex_buffer.device);
-	staging.create(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	staging.update_part(array.data, 0, buffer_size);
-
-
 	// gpu
 	if (buffer_size > buf.size) {
 		buf.destroy();
@@ -126,7 +122,8 @@ void VertexBuffer::_create_buffer(Buffer &buf, const DynamicArray &array) {
 		buf.create(buffer_size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 	}
 
-	copy_buffer(staging.buffer, buf.buffer, buffer_size);
+	// via the staging ring, executed before the next frame
+	buf.device->uploader->upload_buffer(buf.buffer, 0, array.data, buffer_size);
 }
 
 void VertexBuffer::_create_index_buffer_i16(const Array<uint16_t> &indices) {
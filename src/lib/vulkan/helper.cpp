@@ -4,6 +4,7 @@
 #include "helper.h"
 #include "CommandBuffer.h"
 #include "Device.h"
+#include "Uploader.h"
 #include <vector>
 
 namespace vulkan{
@@ -13,10 +14,9 @@ namespace vulkan{
 void ImageAndMemory::_destroy() {
 	if (image)
 		vkDestroyImage(default_device->device, image, nullptr);
-	if (memory)
-		vkFreeMemory(default_device->device, memory, nullptr);
+	if (allocation.block)
+		default_device->allocator->free(allocation);
 	image = nullptr;
-	memory = nullptr;
 }
 
 void ImageAndMemory::create(VkImageType type, uint32_t width, uint32_t height, uint32_t depth, uint32_t mip_levels, uint32_t num_layers, VkSampleCountFlagBits samples, VkFormat _format, VkImageUsageFlags usage, bool cube) {
@@ -48,16 +48,10 @@ void ImageAndMemory::create(VkImageType type, uint32_t width, uint32_t height, u
 
 	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-	VkMemoryAllocateInfo alloc_info = {};
-	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	alloc_info.allocationSize = mem_requirements.size;
-	alloc_info.memoryTypeIndex = default_device->find_memory_type(mem_requirements, properties);
+	// optimal tiling, never next to buffers
+	allocation = default_device->allocator->allocate(mem_requirements, properties, false);
 
-	if (vkAllocateMemory(default_device->device, &alloc_info, nullptr, &memory) != VK_SUCCESS) {
-		throw Exception("failed to allocate image memory!");
-	}
-
-	vkBindImageMemory(default_device->device, image, memory, 0);
+	vkBindImageMemory(default_device->device, image, allocation.memory, allocation.offset);
 }
 
 void ImageAndMemory::generate_mipmaps(uint32_t width, uint32_t height, uint32_t mip_levels, uint32_t layer0, uint32_t num_layers, VkImageLayout new_layout) {
@@ -69,7 +63,7 @@ void ImageAndMemory::generate_mipmaps(uint32_t width, uint32_t height, uint32_t
 		throw Exception("texture image format does not support linear blitting!");
 	}
 
-	auto command_buffer = begin_single_time_commands();
+	auto command_buffer = default_device->uploader->command_buffer();
 
 	VkImageMemoryBarrier barrier = {};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -143,8 +137,6 @@ void ImageAndMemory::generate_mipmaps(uint32_t width, uint32_t height, uint32_t
 		0, nullptr,
 		0, nullptr,
 		1, &barrier);
-
-	end_single_time_commands(command_buffer);
 }
 
 bool format_is_depth_buffer(VkFormat f) {
@@ -165,13 +157,11 @@ VkImageAspectFlagBits ImageAndMemory::aspect() const {
 }
 
 void copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size) {
-	auto command_buffer = begin_single_time_commands();
+	auto command_buffer = default_device->uploader->command_buffer();
 
 	VkBufferCopy copy_region = {};
 	copy_region.size = size;
 	vkCmdCopyBuffer(command_buffer->buffer, src_buffer, dst_buffer, 1, &copy_region);
-
-	end_single_time_commands(command_buffer);
 }
 
 VkImageView ImageAndMemory::create_view(VkImageAspectFlags aspect, VkImageViewType type, uint32_t mip_levels, uint32_t layer0, uint32_t num_layers) const {
@@ -193,11 +183,11 @@ VkImageView ImageAndMemory::create_view(VkImageAspectFlags aspect, VkImageViewTy
 	return image_view;
 }
 
-void copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t depth, uint32_t level, uint32_t layer) {
-	auto command_buffer = begin_single_time_commands();
+void copy_buffer_to_image(VkBuffer buffer, VkDeviceSize offset, VkImage image, uint32_t width, uint32_t height, uint32_t depth, uint32_t level, uint32_t layer) {
+	auto command_buffer = default_device->uploader->command_buffer();
 
 	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
+	region.bufferOffset = offset;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -208,8 +198,6 @@ void copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32
 	region.imageExtent = {width, height, depth};
 
 	vkCmdCopyBufferToImage(command_buffer->buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	end_single_time_commands(command_buffer);
 }
 
 void copy_image_to_buffer(VkImage image, uint32_t width, uint32_t height, uint32_t depth, uint32_t level, uint32_t layer, VkBuffer buffer) {
@@ -243,7 +231,7 @@ VkImageAspectFlags image_aspect(const ImageAndMemory &i, VkImageLayout new_layou
 }
 
 void ImageAndMemory::transition_layout(VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels, uint32_t layer0, uint32_t num_layers) const {
-	auto command_buffer = begin_single_time_commands();
+	auto command_buffer = default_device->uploader->command_buffer();
 
 	VkImageMemoryBarrier barrier = {};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -306,8 +294,6 @@ void ImageAndMemory::transition_layout(VkImageLayout old_layout, VkImageLayout n
 		0, nullptr,
 		1, &barrier
 	);
-
-	end_single_time_commands(command_buffer);
 }
 
 
@@ -4,6 +4,7 @@
 
 #include "../base/base.h"
 #include <vulkan/vulkan.h>
+#include "MemoryAllocator.h"
 
 namespace vulkan{
 
@@ -11,7 +12,7 @@ namespace vulkan{
 
 	struct ImageAndMemory {
 		VkImage image = nullptr;
-		VkDeviceMemory memory = nullptr;
+		Allocation allocation;
 		VkFormat format = VK_FORMAT_UNDEFINED;
 
 		void create(VkImageType type, uint32_t width, uint32_t height, uint32_t depth, uint32_t mip_levels, uint32_t num_layers, VkSampleCountFlagBits samples, VkFormat format, VkImageUsageFlags usage, bool cube);
@@ -30,8 +31,10 @@ namespace vulkan{
 	};
 
 	//void create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory);
+	// recorded into the current upload batch (see Uploader)
 	void copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size);
-	void copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t depth, uint32_t level, uint32_t layer);
+	void copy_buffer_to_image(VkBuffer buffer, VkDeviceSize offset, VkImage image, uint32_t width, uint32_t height, uint32_t depth, uint32_t level, uint32_t layer);
+	// blocking
 	void copy_image_to_buffer(VkImage image, uint32_t width, uint32_t height, uint32_t depth, uint32_t level, uint32_t layer, VkBuffer buffer);
 };
 
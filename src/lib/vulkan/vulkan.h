@@ -15,6 +15,8 @@
 #include "Queue.h"
 #include "DescriptorSet.h"
 #include "Buffer.h"
+#include "MemoryAllocator.h"
+#include "Uploader.h"
 #include "VertexBuffer.h"
 #include "Texture.h"
 #include "Shader.h"
@@ -114,6 +114,15 @@ public:
 		engine.version = app_version;
 		if (config.get_str("error.missing-files", "ignore") == "ignore")
 			engine.ignore_missing_files = true;
+		engine.pipelined = config.get_bool("engine.pipelined", false);
+		float tick_rate = config.get_float("engine.tick-rate", 0);
+		if (tick_rate > 0) {
+			engine.fixed_dt = 1.0f / tick_rate;
+			engine.max_ticks_per_frame = config.get_int("engine.max-ticks-per-frame", 5);
+			if (engine.pipelined)
+				msg_error("engine.pipelined is not supported with fixed ticks");
+			engine.pipelined = false;
+		}
 
 
 
@@ -126,10 +135,13 @@ public:
 			config.game_dir | "Scripts",
 			config.game_dir | "Materials",
 			config.game_dir | "Fonts");
+		engine.cache_dir = config.get_str("cache.dir", str(hui::Application::directory | "cache"));
 
 		auto context = api_init(window);
 		auto resource_manager = new ResourceManager(context);
 		engine.set_context(context, resource_manager);
+		if (config.get_bool("renderer.shader-cache.enabled", true))
+			resource_manager->set_shader_cache_dir(config.get_str("renderer.shader-cache.dir", str(hui::Application::directory | "shader-cache")));
 
 		create_base_renderer(window);
 
@@ -165,6 +177,7 @@ public:
 
 		for (auto& cam: ComponentManager::get_list_family<Camera>())
 			create_and_attach_render_path(cam);
+		engine.resource_manager->precompile_shader_variants();
 		for (auto &s: world.scripts)
 			ControllerManager::add_controller(s.filename, s.variables);
 		for (auto &s: config.additional_scripts)
@@ -229,9 +242,9 @@ public:
 
 	void main_loop() {
 		while (!glfwWindowShouldClose(window) and !engine.end_requested) {
-			gpu_flush();
 			PerformanceMonitor::next_frame();
 			reset_gpu_timestamp_queries();
+			engine.frame ++;
 #ifdef USING_OPENGL
 			gpu_timestamp({}, -1);
 #endif
@@ -239,10 +252,15 @@ public:
 			engine.elapsed = engine.time_scale * min(engine.elapsed_rt, 1.0f / config.min_framerate);
 
 			input::iterate();
+			// scripts may touch bodies from here on
+			world.wait_physics_step();
 			ControllerManager::handle_input();
 
 			iterate();
+			if (engine.pipelined)
+				world.start_physics_step(engine.elapsed);
 			draw_frame();
+			world.invalidate_transforms();
 
 			if (input::get_key(hui::KEY_CONTROL) and input::get_key(hui::KEY_Q))
 				break;
@@ -251,12 +269,16 @@ public:
 				load_world(world.next_filename);
 				world.next_filename = "";
 			}
-			auto tt = gpu_read_timestamps();
-			for (int i=0; i<tt.num; i++)
-				PerformanceMonitor::current_frame_timing.gpu.add({gpu_timestamp_queries[i], tt[i]});
+			for (const auto& t: gpu_read_timestamps())
+				PerformanceMonitor::current_frame_timing.gpu.add({t.channel, t.offset});
+#ifdef USING_OPENGL
+			PerformanceMonitor::add_uniform_uploads(engine.context->num_uniform_uploads);
+			engine.context->num_uniform_uploads = 0;
+#endif
 
 		}
 
+		world.wait_physics_step();
 		gpu_flush();
 	}
 
@@ -288,13 +310,37 @@ public:
 		glfwTerminate();
 	}
 
+	float tick_time_accumulated = 0;
+
+	// physics and on_iterate_fixed() in steps of fixed_dt, everything else runs per frame
+	void iterate_ticks() {
+		tick_time_accumulated += engine.elapsed;
+		int n = 0;
+		while (tick_time_accumulated >= engine.fixed_dt and n < engine.max_ticks_per_frame) {
+			engine.tick ++;
+			world.store_previous_transforms();
+			world.iterate(engine.fixed_dt);
+			ControllerManager::handle_iterate_fixed(engine.fixed_dt);
+			ComponentManager::iterate_fixed(engine.fixed_dt);
+			tick_time_accumulated -= engine.fixed_dt;
+			n ++;
+		}
+		// too far behind (frame spike): drop the time instead of catching up
+		if (tick_time_accumulated >= engine.fixed_dt)
+			tick_time_accumulated = fmodf(tick_time_accumulated, engine.fixed_dt);
+		engine.tick_alpha = tick_time_accumulated / engine.fixed_dt;
+	}
+
 	void iterate() {
 		PerformanceMonitor::begin(ch_iter);
 		ControllerManager::handle_iterate_pre(engine.elapsed);
 
 		network_manager.iterate();
 
-		world.iterate(engine.elapsed);
+		if (engine.fixed_dt > 0)
+			iterate_ticks();
+		else
+			world.iterate(engine.elapsed);
 		audio::iterate(engine.elapsed);
 		DeletionQueue::delete_all();
 
@@ -353,6 +399,8 @@ public:
 			return;
 		const auto params = engine.window_renderer->create_params(engine.physical_aspect_ratio);
 		ControllerManager::handle_draw_pre();
+		// after draw_pre, scripts like to move cameras and attached models there
+		world.update_transforms();
 		timer_render.peek();
 		for (auto t: engine.render_tasks)
 			if (t->_priority < 1000 and t->active)
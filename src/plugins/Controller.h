@@ -33,6 +33,7 @@ public:
 
 	virtual void _cdecl on_render_inject() {}
 	virtual void _cdecl on_render_inject2() {}
+	virtual void _cdecl on_iterate_fixed(float dt) {}
 
 	const kaba::Class *_class;
 	int ch_iterate = -1;
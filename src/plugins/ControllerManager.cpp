@@ -59,6 +59,11 @@ void ControllerManager::handle_iterate(float dt) {
 	PerformanceMonitor::end(ch_controller);
 }
 
+void ControllerManager::handle_iterate_fixed(float dt) {
+	for (auto *c: controllers)
+		c->on_iterate_fixed(dt);
+}
+
 void ControllerManager::handle_iterate_pre(float dt) {
 	PerformanceMonitor::begin(ch_con_iter_pre);
 	for (auto *c: controllers)
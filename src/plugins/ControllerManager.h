@@ -25,6 +25,7 @@ public:
 
 	static void handle_iterate_pre(float dt);
 	static void handle_iterate(float dt);
+	static void handle_iterate_fixed(float dt);
 	static void handle_input();
 	static void handle_draw_pre();
 	static void handle_render_inject();
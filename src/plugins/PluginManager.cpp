@@ -16,6 +16,8 @@
 #include "../fx/Particle.h"
 #include "../fx/Beam.h"
 #include "../fx/ParticleEmitter.h"
+#include "../fx/ParticleManager.h"
+#include "../fx/GpuParticleEmitter.h"
 #include "../gui/gui.h"
 #include "../gui/Node.h"
 #include "../gui/Picture.h"
@@ -117,17 +119,26 @@ Model* _attach_model(World *w, Entity& e, const Path &filename) {
 }
 
 LegacyParticle* _world_add_legacy_particle(World* w, const kaba::Class* type, const vec3& pos, float radius, const color& c, shared<Texture>& tex, float ttl) {
-	auto e = w->create_entity(pos, quaternion::ID);
-	auto p = reinterpret_cast<LegacyParticle*>(e->_add_component_untyped_(type, ""));
-	//auto p = reinterpret_cast<LegacyParticle*>(PluginManager::create_instance(type, ""));
+	// pooled, no entity in the world
+	auto p = w->particle_manager->create_legacy(type, pos);
 	p->radius = radius;
 	p->col = c;
 	p->texture = tex;
 	p->time_to_live = ttl;
-	//w->add_legacy_particle(p);
 	return p;
 }
 
+void _legacy_particle_delete(LegacyParticle* p) {
+	world.particle_manager->delete_legacy(p);
+}
+
+// legacy particles are not registered in the ComponentManager
+ComponentManager::List& _get_component_family_list(const kaba::Class* type_family) {
+	if (type_family == LegacyParticle::_class)
+		return (ComponentManager::List&)world.particle_manager->legacy_particles;
+	return ComponentManager::_get_list_family(type_family);
+}
+
 void framebuffer_init(FrameBuffer *fb, const shared_array<Texture> &tex) {
 #ifdef USING_VULKAN
 	kaba::kaba_raise_exception(new kaba::KabaException("not implemented: FrameBuffer.__init__() for vulkan"));
@@ -320,9 +331,11 @@ CubeMap* render_path_get_cubemap(RenderPath &r) {
 }
 
 Array<Texture*> render_path_get_shadow_map(RenderPath &r) {
+	Array<Texture*> maps;
 	if (r.shadow_renderer)
-		return {r.shadow_renderer->cascades[0].depth_buffer, r.shadow_renderer->cascades[1].depth_buffer};
-	return {};
+		for (int i=0; i<r.shadow_renderer->num_cascades; i++)
+			maps.add(r.shadow_renderer->cascades[i].depth_buffer);
+	return maps;
 }
 
 //shared_array<Texture> render_path_get_gbuffer(RenderPath &r) {
@@ -379,6 +392,7 @@ void PluginManager::export_kaba() {
 	ext->link_virtual("Component.on_delete", &Component::on_delete, &component);
 	ext->link_virtual("Component.on_iterate", &Component::on_iterate, &component);
 	ext->link_virtual("Component.on_collide", &Component::on_collide, &component);
+	ext->link_virtual("Component.on_iterate_fixed", &Component::on_iterate_fixed, &component);
 	ext->link_class_func("Component.set_variables", &Component::set_variables);
 
 	Camera _cam;
@@ -410,6 +424,8 @@ void PluginManager::export_kaba() {
 	ext->declare_class_element("CubeMapSource.cube_map", &CubeMapSource::cube_map);
 	ext->declare_class_element("CubeMapSource.resolution", &CubeMapSource::resolution);
 	ext->declare_class_element("CubeMapSource.update_rate", &CubeMapSource::update_rate);
+	ext->declare_class_element("CubeMapSource.prefilter", &CubeMapSource::prefilter);
+	ext->link_class_func("CubeMapSource.invalidate", &CubeMapSource::invalidate);
 
 
 	ext->declare_class_size("Model.Mesh", sizeof(Mesh));
@@ -506,6 +522,7 @@ void PluginManager::export_kaba() {
 	ext->declare_class_element("Terrain.texture_scale", &Terrain::texture_scale);
 	ext->link_class_func("Terrain.update", &Terrain::update);
 	ext->link_class_func("Terrain.get_height", &Terrain::gimme_height);
+	ext->link_class_func("Terrain.get_heights", &Terrain::gimme_heights);
 
 	ext->declare_class_size("CollisionData", sizeof(CollisionData));
 	ext->declare_class_element("CollisionData.entity", &CollisionData::entity);
@@ -576,6 +593,7 @@ void PluginManager::export_kaba() {
 	ext->link_virtual("Controller.on_delete", &Controller::on_delete, &con);
 	ext->link_virtual("Controller.on_iterate", &Controller::on_iterate, &con);
 	ext->link_virtual("Controller.on_iterate_pre", &Controller::on_iterate_pre, &con);
+	ext->link_virtual("Controller.on_iterate_fixed", &Controller::on_iterate_fixed, &con);
 	ext->link_virtual("Controller.on_draw_pre", &Controller::on_draw_pre, &con);
 	ext->link_virtual("Controller.on_input", &Controller::on_input, &con);
 	ext->link_virtual("Controller.on_key", &Controller::on_key, &con);
@@ -621,7 +639,7 @@ void PluginManager::export_kaba() {
 
 
 	ext->link("__get_component_list", (void*)&ComponentManager::_get_list);
-	ext->link("__get_component_family_list", (void*)&ComponentManager::_get_list_family);
+	ext->link("__get_component_family_list", (void*)&_get_component_family_list);
 	ext->link("__get_component_list2", (void*)&ComponentManager::_get_list2);
 
 	ext->declare_class_size("Particle", sizeof(Particle));
@@ -636,6 +654,17 @@ void PluginManager::export_kaba() {
 	ext->declare_class_size("Beam", sizeof(Beam));
 	ext->declare_class_element("Beam.length", &Beam::length);
 
+	ext->declare_class_size("ParticleStore", sizeof(ParticleStore));
+	ext->declare_class_element("ParticleStore.pos", &ParticleStore::pos);
+	ext->declare_class_element("ParticleStore.vel", &ParticleStore::vel);
+	ext->declare_class_element("ParticleStore.color", &ParticleStore::col);
+	ext->declare_class_element("ParticleStore.radius", &ParticleStore::radius);
+	ext->declare_class_element("ParticleStore.time_to_live", &ParticleStore::time_to_live);
+	ext->declare_class_element("ParticleStore.suicidal", &ParticleStore::suicidal);
+	ext->declare_class_element("ParticleStore.length", &ParticleStore::length);
+	ext->link_class_func("ParticleStore.size", &ParticleStore::size);
+	ext->link_class_func("ParticleStore.remove", &ParticleStore::remove);
+
 
 	{
 		LegacyParticle particle;
@@ -651,7 +680,7 @@ void PluginManager::export_kaba() {
 		ext->link_virtual("LegacyParticle.__delete__", &LegacyParticle::__delete__, &particle);
 		//ext->link_virtual("LegacyParticle.on_iterate", &Particle::on_iterate, &particle);
 		//ext->link_class_func("LegacyParticle.__del_override__", &global_delete);
-		ext->link_class_func("LegacyParticle.__del_override__", &DeletionQueue::add);
+		ext->link_class_func("LegacyParticle.__del_override__", &_legacy_particle_delete);
 	}
 
 	ext->declare_class_size("LegacyBeam", sizeof(LegacyBeam));
@@ -662,14 +691,20 @@ void PluginManager::export_kaba() {
 	ParticleGroup group;
 	ext->declare_class_size("ParticleGroup", sizeof(ParticleGroup));
 	ext->declare_class_element("ParticleGroup.source", &ParticleGroup::source);
+	ext->declare_class_element("ParticleGroup.particles", &ParticleGroup::particles);
+	ext->declare_class_element("ParticleGroup.beams", &ParticleGroup::beams);
+	ext->declare_class_element("ParticleGroup.max_particles", &ParticleGroup::max_particles);
 	ext->link_class_func("ParticleGroup.__init__", &ParticleGroup::__init__);
 	ext->link_class_func("ParticleGroup.emit", &ParticleGroup::emit_particle);
 	ext->link_class_func("ParticleGroup.emit_beam", &ParticleGroup::emit_beam);
+	ext->link_class_func("ParticleGroup.emit_index", &ParticleGroup::emit_particle_index);
+	ext->link_class_func("ParticleGroup.emit_beam_index", &ParticleGroup::emit_beam_index);
 	ext->link_class_func("ParticleGroup.iterate_particles", &ParticleGroup::iterate_particles);
 	ext->link_virtual("ParticleGroup.__delete__", &ParticleGroup::__delete__, &group);
 	ext->link_virtual("ParticleGroup.on_iterate", &ParticleGroup::on_iterate, &group);
 	ext->link_virtual("ParticleGroup.on_iterate_particle", &ParticleGroup::on_iterate_particle, &group);
 	ext->link_virtual("ParticleGroup.on_iterate_beam", &ParticleGroup::on_iterate_beam, &group);
+	ext->link_virtual("ParticleGroup.on_iterate_particles", &ParticleGroup::on_iterate_particles, &group);
 	//ext->link_class_func("ParticleGroup.__del_override__", &DeletionQueue::add);
 	}
 
@@ -689,6 +724,27 @@ void PluginManager::export_kaba() {
 	//ext->link_class_func("ParticleEmitter.__del_override__", &DeletionQueue::add);
 	}
 
+	{
+	GpuParticleEmitter emitter;
+	ext->declare_class_size("GpuParticleEmitter", sizeof(GpuParticleEmitter));
+	ext->declare_class_element("GpuParticleEmitter.max_particles", &GpuParticleEmitter::max_particles);
+	ext->declare_class_element("GpuParticleEmitter.spawn_rate", &GpuParticleEmitter::spawn_rate);
+	ext->declare_class_element("GpuParticleEmitter.spawn_time_to_live", &GpuParticleEmitter::spawn_time_to_live);
+	ext->declare_class_element("GpuParticleEmitter.spawn_vel", &GpuParticleEmitter::spawn_vel);
+	ext->declare_class_element("GpuParticleEmitter.spawn_dvel", &GpuParticleEmitter::spawn_dvel);
+	ext->declare_class_element("GpuParticleEmitter.spawn_radius", &GpuParticleEmitter::spawn_radius);
+	ext->declare_class_element("GpuParticleEmitter.spawn_dradius", &GpuParticleEmitter::spawn_dradius);
+	ext->declare_class_element("GpuParticleEmitter.spawn_color", &GpuParticleEmitter::spawn_color);
+	ext->declare_class_element("GpuParticleEmitter.acceleration", &GpuParticleEmitter::acceleration);
+	ext->declare_class_element("GpuParticleEmitter.sort", &GpuParticleEmitter::sort);
+	ext->declare_class_element("GpuParticleEmitter.texture", &GpuParticleEmitter::texture);
+	ext->declare_class_element("GpuParticleEmitter.source", &GpuParticleEmitter::source);
+	ext->link_class_func("GpuParticleEmitter.__init__", &GpuParticleEmitter::__init__);
+	ext->link_class_func("GpuParticleEmitter.burst", &GpuParticleEmitter::burst);
+	ext->link_virtual("GpuParticleEmitter.__delete__", &GpuParticleEmitter::__delete__, &emitter);
+	ext->link_virtual("GpuParticleEmitter.on_iterate", &GpuParticleEmitter::on_iterate, &emitter);
+	}
+
 	ext->declare_class_size("SoundSource", sizeof(audio::SoundSource));
 	ext->declare_class_element("SoundSource.loop", &audio::SoundSource::loop);
 	ext->declare_class_element("SoundSource.suicidal", &audio::SoundSource::suicidal);
@@ -834,6 +890,8 @@ void PluginManager::export_kaba() {
 	ext->declare_class_element("PerformanceMonitor.FrameTimingData.cpu0", &FrameTimingData::cpu0);
 	ext->declare_class_element("PerformanceMonitor.FrameTimingData.gpu", &FrameTimingData::gpu);
 	ext->declare_class_element("PerformanceMonitor.FrameTimingData.total_time", &FrameTimingData::total_time);
+	ext->declare_class_element("PerformanceMonitor.FrameTimingData.uniform_uploads", &FrameTimingData::uniform_uploads);
+	ext->declare_class_element("PerformanceMonitor.FrameTimingData.cpu1", &FrameTimingData::cpu1);
 
 	ext->declare_class_size("PerformanceMonitor", sizeof(PerformanceMonitor));
 	ext->link("PerformanceMonitor.get_name", (void*)&PerformanceMonitor::get_name);
@@ -862,6 +920,8 @@ void PluginManager::export_kaba() {
 	ext->declare_class_element("EngineData.elapsed", &EngineData::elapsed);
 	ext->declare_class_element("EngineData.elapsed_rt", &EngineData::elapsed_rt);
 	ext->declare_class_element("EngineData.time_scale", &EngineData::time_scale);
+	ext->declare_class_element("EngineData.fixed_dt", &EngineData::fixed_dt);
+	ext->declare_class_element("EngineData.tick_alpha", &EngineData::tick_alpha);
 	ext->declare_class_element("EngineData.fps_min", &EngineData::fps_min);
 	ext->declare_class_element("EngineData.fps_max", &EngineData::fps_max);
 	ext->declare_class_element("EngineData.resolution_scale", &EngineData::resolution_scale_x);
@@ -1057,6 +1117,7 @@ void PluginManager::export_kaba() {
 	ext->link("rt_setup", (void*)&rt_setup);
 	ext->link("rt_update_frame", (void*)&rt_update_frame);
 	ext->link("rt_vtrace", (void*)&vtrace);
+	ext->link("rt_benchmark", (void*)&rt_benchmark);
 
 	ext->link("attach_light_parallel", (void*)&attach_light_parallel);
 	ext->link("attach_light_point", (void*)&attach_light_point);
@@ -1108,6 +1169,7 @@ void PluginManager::import_kaba() {
 	import_component_class<ParticleEmitter>(m_fx, "ParticleEmitter");
 	import_component_class<LegacyParticle>(m_fx, "LegacyParticle");
 	import_component_class<LegacyBeam>(m_fx, "LegacyBeam");
+	import_component_class<GpuParticleEmitter>(m_fx, "GpuParticleEmitter");
 
 	auto m_audio = kaba::default_context->load_module("y/audio.kaba");
 	import_component_class<audio::SoundSource>(m_audio, "SoundSource");
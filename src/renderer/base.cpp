@@ -17,9 +17,34 @@
 Texture *tex_white = nullptr;
 Texture *tex_black = nullptr;
 
-static const int MAX_TIMESTAMP_QUERIES = 4096;
+static const int MAX_TIMESTAMP_QUERIES = 4096; // per frame
+// queries are read back this many frames later, so we never wait for the gpu
+static const int TIMESTAMP_FRAMES = 3;
 
-Array<int> gpu_timestamp_queries;
+// channels of the queries issued in each frame of the ring
+// frame f uses the query indices [f * MAX_TIMESTAMP_QUERIES, ...)
+static Array<int> gpu_timestamp_queries[TIMESTAMP_FRAMES];
+static int gpu_timestamp_frame = 0;
+
+// the oldest frame in the ring, next to be overwritten
+static int gpu_timestamp_read_frame() {
+	return (gpu_timestamp_frame + 1) % TIMESTAMP_FRAMES;
+}
+
+static int gpu_timestamp_next_query() {
+	auto& q = gpu_timestamp_queries[gpu_timestamp_frame];
+	if (q.num >= MAX_TIMESTAMP_QUERIES)
+		return -1;
+	return gpu_timestamp_frame * MAX_TIMESTAMP_QUERIES + q.num;
+}
+
+void gpu_timestamp_begin(const RenderParams& params, int channel) {
+	gpu_timestamp(params, channel);
+}
+
+void gpu_timestamp_end(const RenderParams& params, int channel) {
+	gpu_timestamp(params, channel | (int)0x80000000);
+}
 
 #ifdef USING_VULKAN
 
@@ -29,7 +54,7 @@ vulkan::Device *device = nullptr;
 vulkan::Surface surface;
 
 Context* _create_context() {
-	device->create_query_pool(MAX_TIMESTAMP_QUERIES);
+	device->create_query_pool(MAX_TIMESTAMP_QUERIES * TIMESTAMP_FRAMES);
 	pool = new vulkan::DescriptorPool("buffer:65536,sampler:65536", 65536);
 
 	tex_white = new Texture();
@@ -90,6 +115,8 @@ void api_end() {
 	gpu_flush();
 	PipelineManager::clear();
 	engine.resource_manager->clear();
+	if (config.get_bool("renderer.memory-stats", false))
+		device->allocator->dump_stats();
 	delete pool;
 	delete device;
 	delete instance;
@@ -97,32 +124,35 @@ void api_end() {
 
 
 void reset_gpu_timestamp_queries() {
-	gpu_timestamp_queries.clear();
-	gpu_timestamp_queries.simple_reserve(256);
-	device->reset_query_pool(0, MAX_TIMESTAMP_QUERIES);
+	// results of this slot not read until now are dropped
+	gpu_timestamp_frame = (gpu_timestamp_frame + 1) % TIMESTAMP_FRAMES;
+	auto& q = gpu_timestamp_queries[gpu_timestamp_frame];
+	q.clear();
+	q.simple_reserve(256);
+	device->reset_query_pool(gpu_timestamp_frame * MAX_TIMESTAMP_QUERIES, MAX_TIMESTAMP_QUERIES);
 }
 
 void gpu_timestamp(const RenderParams& params, int channel) {
-	if (gpu_timestamp_queries.num >= MAX_TIMESTAMP_QUERIES)
+	int index = gpu_timestamp_next_query();
+	if (index < 0)
 		return;
-	params.command_buffer->timestamp(gpu_timestamp_queries.num);
-	gpu_timestamp_queries.add(channel);
-}
-
-void gpu_timestamp_begin(const RenderParams& params, int channel) {
-	gpu_timestamp(params, channel);
-}
-
-void gpu_timestamp_end(const RenderParams& params, int channel) {
-	gpu_timestamp(params, channel | (int)0x80000000);
-}
-
-Array<float> gpu_read_timestamps() {
-	auto tt = device->get_timestamps(0, gpu_timestamp_queries.num);
-	Array<float> result;
-	result.resize(gpu_timestamp_queries.num);
-	for (int i=0; i<gpu_timestamp_queries.num; i++)
-		result[i] = (float)(tt[i] - tt[0]) * device->physical_device_properties.limits.timestampPeriod * 1e-9f;
+	params.command_buffer->timestamp(index);
+	gpu_timestamp_queries[gpu_timestamp_frame].add(channel);
+}
+
+Array<GpuTimestamp> gpu_read_timestamps() {
+	int f = gpu_timestamp_read_frame();
+	auto& q = gpu_timestamp_queries[f];
+	Array<GpuTimestamp> result;
+	if (q.num == 0)
+		return result;
+	Array<int> tt;
+	if (!device->get_timestamps_if_available(f * MAX_TIMESTAMP_QUERIES, q.num, tt))
+		return result;
+	result.resize(q.num);
+	for (int i=0; i<q.num; i++)
+		result[i] = {q[i], (float)(tt[i] - tt[0]) * device->physical_device_properties.limits.timestampPeriod * 1e-9f};
+	q.clear();
 	return result;
 }
 
@@ -148,7 +178,7 @@ Context* api_init(GLFWwindow* window) {
 		msg_write(format("VRAM: %d mb  of  %d mb available", gl->available_mem() / 1024, gl->total_mem() / 1024));
 	}
 
-	nix::create_query_pool(MAX_TIMESTAMP_QUERIES);
+	nix::create_query_pool(MAX_TIMESTAMP_QUERIES * TIMESTAMP_FRAMES);
 
 	tex_white = new nix::Texture(16, 16, "rgba:i8");
 	tex_black = new nix::Texture(16, 16, "rgba:i8");
@@ -159,31 +189,34 @@ Context* api_init(GLFWwindow* window) {
 }
 
 void reset_gpu_timestamp_queries() {
-	gpu_timestamp_queries.clear();
-	gpu_timestamp_queries.simple_reserve(256);
+	// results of this slot not read until now are dropped
+	gpu_timestamp_frame = (gpu_timestamp_frame + 1) % TIMESTAMP_FRAMES;
+	auto& q = gpu_timestamp_queries[gpu_timestamp_frame];
+	q.clear();
+	q.simple_reserve(256);
 }
 
 void gpu_timestamp(const RenderParams&, int channel) {
-	if (gpu_timestamp_queries.num >= MAX_TIMESTAMP_QUERIES)
+	int index = gpu_timestamp_next_query();
+	if (index < 0)
 		return;
-	nix::query_timestamp(gpu_timestamp_queries.num);
-	gpu_timestamp_queries.add(channel);
-}
-
-void gpu_timestamp_begin(const RenderParams& params, int channel) {
-	gpu_timestamp(params, channel);
-}
-
-void gpu_timestamp_end(const RenderParams& params, int channel) {
-	gpu_timestamp(params, channel | (int)0x80000000);
-}
-
-Array<float> gpu_read_timestamps() {
-	auto tt = nix::get_timestamps(0, gpu_timestamp_queries.num);
-	Array<float> result;
+	nix::query_timestamp(index);
+	gpu_timestamp_queries[gpu_timestamp_frame].add(channel);
+}
+
+Array<GpuTimestamp> gpu_read_timestamps() {
+	int f = gpu_timestamp_read_frame();
+	auto& q = gpu_timestamp_queries[f];
+	Array<GpuTimestamp> result;
+	if (q.num == 0)
+		return result;
+	if (!nix::timestamps_available(f * MAX_TIMESTAMP_QUERIES, q.num))
+		return result;
+	auto tt = nix::get_timestamps(f * MAX_TIMESTAMP_QUERIES, q.num);
 	result.resize(tt.num);
 	for (int i=0; i<tt.num; i++)
-		result[i] = (float)(tt[i] - tt[0]) * 1e-9f;
+		result[i] = {q[i], (float)(tt[i] - tt[0]) * 1e-9f};
+	q.clear();
 	return result;
 }
 
@@ -28,8 +28,13 @@ void reset_gpu_timestamp_queries();
 void gpu_timestamp(const RenderParams& params, int channel);
 void gpu_timestamp_begin(const RenderParams& params, int channel);
 void gpu_timestamp_end(const RenderParams& params, int channel);
-Array<float> gpu_read_timestamps();
-extern Array<int> gpu_timestamp_queries;
+
+struct GpuTimestamp {
+	int channel;
+	float offset;
+};
+// results of the oldest frame still in flight (a few frames behind), empty if not available yet
+Array<GpuTimestamp> gpu_read_timestamps();
 
 #ifdef USING_VULKAN
 extern vulkan::DescriptorPool *pool;
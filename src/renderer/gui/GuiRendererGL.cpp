@@ -12,6 +12,8 @@
 #include <lib/os/msg.h>
 #include "../../gui/gui.h"
 #include "../../gui/Picture.h"
+#include "../../gui/Text.h"
+#include "../../gui/DrawList.h"
 #include "../../helper/PerformanceMonitor.h"
 #include "../../helper/ResourceManager.h"
 #include <y/EngineData.h>
@@ -24,6 +26,9 @@ GuiRendererGL::GuiRendererGL() : Renderer("gui") {
 
 	vb = new VertexBuffer("3f,3f,2f");
 	vb->create_quad(rect::ID);
+
+	shader_batch = resource_manager->load_shader("forward/2d-batch.shader");
+	vb_batch = new VertexBuffer("3f,4f,2f");
 }
 
 void GuiRendererGL::draw(const RenderParams& params) {
@@ -41,29 +46,20 @@ void GuiRendererGL::draw_gui(const RenderParams& params, FrameBuffer *source) {
 	nix::set_alpha(nix::Alpha::SOURCE_ALPHA, nix::Alpha::SOURCE_INV_ALPHA);
 	nix::set_z(false, false);
 
-	for (auto *n: gui::sorted_nodes) {
-		if (!n->eff_visible)
+	if (vb_batch_version != gui::draw_list_version) {
+		vb_batch->update(gui::draw_vertices);
+		vb_batch_version = gui::draw_list_version;
+	}
+
+	for (auto &c: gui::draw_calls) {
+		if (c.picture) {
+			draw_picture(c.picture);
 			continue;
-		if (n->type == gui::Node::Type::PICTURE or n->type == gui::Node::Type::TEXT) {
-			auto *p = (gui::Picture*)n;
-			auto s = shader.get();
-			if (p->shader) {
-				s = p->shader.get();
-				apply_shader_data(s, p->shader_data);
-			}
-			nix::set_shader(s);
-			s->set_float("blur", p->bg_blur);
-			s->set_color("color", p->eff_col);
-			nix::bind_textures({p->texture.get()});// , source->color_attachments[0].get()});
-			if (p->angle == 0) {
-				nix::set_model_matrix(mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, /*0.999f - p->eff_z/1000*/ 0.5f)) * mat4::scale(p->eff_area.width(), p->eff_area.height(), 0));
-			} else {
-				float r = engine.physical_aspect_ratio;
-				nix::set_model_matrix(mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, /*0.999f - p->eff_z/1000*/ 0.5f)) * mat4::scale(1/r, 1, 0) * mat4::rotation_z(p->angle) * mat4::scale(p->eff_area.width() * r, p->eff_area.height(), 0));
-			}
-			vb->create_quad(rect::ID, p->source);
-			nix::draw_triangles(vb.get());
 		}
+		nix::set_shader(shader_batch.get());
+		nix::set_model_matrix(mat4::ID);
+		nix::bind_textures({c.texture});
+		nix::draw_triangles_range(vb_batch.get(), c.offset, c.count);
 	}
 	nix::set_z(true, true);
 	nix::set_cull(nix::CullMode::BACK);
@@ -75,4 +71,32 @@ void GuiRendererGL::draw_gui(const RenderParams& params, FrameBuffer *source) {
 }
 
 
+// unbatched (custom shader, blur...)
+void GuiRendererGL::draw_picture(gui::Picture *p) {
+	auto s = shader.get();
+	if (p->shader) {
+		s = p->shader.get();
+		apply_shader_data(s, p->shader_data);
+	}
+	nix::set_shader(s);
+	s->set_float("blur", p->bg_blur);
+	s->set_color("color", p->eff_col);
+	nix::bind_textures({p->texture.get()});// , source->color_attachments[0].get()});
+	if (p->angle == 0) {
+		nix::set_model_matrix(mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, /*0.999f - p->eff_z/1000*/ 0.5f)) * mat4::scale(p->eff_area.width(), p->eff_area.height(), 0));
+	} else {
+		float r = engine.physical_aspect_ratio;
+		nix::set_model_matrix(mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, /*0.999f - p->eff_z/1000*/ 0.5f)) * mat4::scale(1/r, 1, 0) * mat4::rotation_z(p->angle) * mat4::scale(p->eff_area.width() * r, p->eff_area.height(), 0));
+	}
+	if (p->type == gui::Node::Type::TEXT) {
+		// glyph quads, already in atlas coordinates
+		auto t = (gui::Text*)p;
+		if (t->num_glyphs > 0)
+			nix::draw_triangles(t->update_vertex_buffer());
+	} else {
+		vb->create_quad(rect::ID, p->source);
+		nix::draw_triangles(vb.get());
+	}
+}
+
 #endif
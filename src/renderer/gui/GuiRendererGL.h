@@ -10,6 +10,10 @@
 #include "../Renderer.h"
 #ifdef USING_OPENGL
 
+namespace gui {
+	class Picture;
+}
+
 class GuiRendererGL : public Renderer {
 public:
 	GuiRendererGL();
@@ -20,6 +24,13 @@ public:
 
 	shared<Shader> shader;
 	owned<VertexBuffer> vb;
+
+	// all batched quads of gui::draw_vertices
+	shared<Shader> shader_batch;
+	owned<VertexBuffer> vb_batch;
+	int vb_batch_version = -1;
+
+	void draw_picture(gui::Picture *p);
 };
 
 #endif
@@ -12,6 +12,8 @@
 #include "../../graphics-impl.h"
 #include "../../gui/gui.h"
 #include "../../gui/Picture.h"
+#include "../../gui/Text.h"
+#include "../../gui/DrawList.h"
 #include "../../helper/PerformanceMonitor.h"
 #include "../../helper/ResourceManager.h"
 #include <lib/math/mat4.h>
@@ -33,6 +35,9 @@ GuiRendererVulkan::GuiRendererVulkan() : Renderer("ui") {
 
 	vb = new VertexBuffer("3f,3f,2f");
 	vb->create_quad(rect::ID);
+
+	shader_batch = resource_manager->load_shader("vulkan/2d-batch.shader");
+	vb_batch = new VertexBuffer("3f,4f,2f");
 }
 
 void GuiRendererVulkan::draw(const RenderParams& params) {
@@ -53,19 +58,20 @@ void GuiRendererVulkan::prepare_gui(FrameBuffer *source, const RenderParams& par
 	u.gamma = 2.2f;
 	u.exposure = 1.0f;
 
-	int index = 0;
-
-	for (auto *n: gui::sorted_nodes) {
-		if (!n->eff_visible)
-			continue;
-		if (n->type == gui::Node::Type::PICTURE or n->type == gui::Node::Type::TEXT) {
-			auto *p = (gui::Picture*)n;
+	if (vb_batch_version != gui::draw_list_version) {
+		if (gui::draw_vertices.num > 0)
+			vb_batch->update(gui::draw_vertices);
+		vb_batch_version = gui::draw_list_version;
+	}
 
-			if (index >= ubo.num) {
-				dset.add(pool->create_set("buffer,sampler"));
-				ubo.add(new UniformBuffer(sizeof(UBOGUI)));
-			}
+	// one descriptor set per draw call
+	foreachi (auto &c, gui::draw_calls, index) {
+		if (index >= ubo.num) {
+			dset.add(pool->create_set("buffer,sampler"));
+			ubo.add(new UniformBuffer(sizeof(UBOGUI)));
+		}
 
+		if (auto p = c.picture) {
 			if (p->angle == 0) {
 				u.m = mat4::translation(vec3(p->eff_area.x1, p->eff_area.y1, /*0.999f - p->eff_z/1000*/ 0.5f)) * mat4::scale(p->eff_area.width(), p->eff_area.height(), 0);
 			} else {
@@ -76,40 +82,52 @@ void GuiRendererVulkan::prepare_gui(FrameBuffer *source, const RenderParams& par
 			u.blur = p->bg_blur;
 			u.col = p->eff_col;
 			u.source = p->source;
-			ubo[index]->update(&u);
-
-			dset[index]->set_uniform_buffer(0, ubo[index]);
-			dset[index]->set_texture(1, p->texture.get());
-//			dset[index]->set_texture(2, source->...);
-			dset[index]->update();
-			index ++;
+			if (p->type == gui::Node::Type::TEXT) {
+				u.source = rect::ID; // glyph quads are already in atlas coordinates
+				static_cast<gui::Text*>(p)->update_vertex_buffer();
+			}
+		} else {
+			// batched quads are in screen space, with color
+			u.m = mat4::ID;
+			u.blur = 0;
+			u.col = White;
+			u.source = rect::ID;
 		}
+		ubo[index]->update(&u);
+
+		dset[index]->set_uniform_buffer(0, ubo[index]);
+		dset[index]->set_texture(1, c.texture);
+//		dset[index]->set_texture(2, source->...);
+		dset[index]->update();
 	}
 }
 
 void GuiRendererVulkan::draw_gui(CommandBuffer *cb, RenderPass *render_pass) {
 	if (!pipeline)
 		pipeline = PipelineManager::get_gui(shader.get(), render_pass, "3f,3f,2f");
+	if (!pipeline_batch)
+		pipeline_batch = PipelineManager::get_gui(shader_batch.get(), render_pass, "3f,4f,2f");
 
-	cb->bind_pipeline(pipeline);
-
-	int index = 0;
-	for (auto *n: gui::sorted_nodes) {
-		if (!n->eff_visible)
-			continue;
-		if (n->type == gui::Node::Type::PICTURE or n->type == gui::Node::Type::TEXT) {
-			auto *p = (gui::Picture*)n;
-			if (p->shader) {
-				auto pl = PipelineManager::get_gui(p->shader.get(), render_pass, "3f,3f,2f");
-				cb->bind_pipeline(pl);
-			}
-
-			cb->bind_descriptor_set(0, dset[index]);
-			cb->draw(vb.get());
+	foreachi (auto &c, gui::draw_calls, index) {
+		cb->bind_descriptor_set(0, dset[index]);
 
+		if (auto p = c.picture) {
+			// unbatched (custom shader, blur...)
 			if (p->shader)
+				cb->bind_pipeline(PipelineManager::get_gui(p->shader.get(), render_pass, "3f,3f,2f"));
+			else
 				cb->bind_pipeline(pipeline);
-			index ++;
+
+			if (p->type == gui::Node::Type::TEXT) {
+				auto t = (gui::Text*)p;
+				if (t->num_glyphs > 0)
+					cb->draw(t->vertex_buffer.get());
+			} else {
+				cb->draw(vb.get());
+			}
+		} else {
+			cb->bind_pipeline(pipeline_batch);
+			cb->draw_range(vb_batch.get(), c.offset, c.count);
 		}
 	}
 }
@@ -21,6 +21,13 @@ public:
 	Array<DescriptorSet*> dset;
 	Array<UniformBuffer*> ubo;
 	owned<VertexBuffer> vb;
+
+	// all batched quads of gui::draw_vertices
+	shared<Shader> shader_batch;
+	GraphicsPipeline* pipeline_batch = nullptr;
+	owned<VertexBuffer> vb_batch;
+	int vb_batch_version = -1;
+
 	void prepare_gui(FrameBuffer *source, const RenderParams& params);
 	void draw_gui(CommandBuffer *cb, RenderPass *render_pass);
 };
@@ -110,7 +110,7 @@ Any vec3_to_any(const vec3& v) {
 BindingData::BindingData(Shader* shader) {
 #ifdef USING_VULKAN
 	if (shader) {
-		pool = new vulkan::DescriptorPool("sampler:8,buffer:8,storage-buffer:8,image:8", 1);
+		pool = new vulkan::DescriptorPool("sampler:16,buffer:8,storage-buffer:8,image:8", 1);
 		dset = pool->create_set_from_layout(shader->descr_layouts[0]);
 	}
 #endif
@@ -118,9 +118,21 @@ BindingData::BindingData(Shader* shader) {
 
 
 
+#ifdef USING_OPENGL
+// re-binding an index replaces the old binding
+static void set_binding(Array<Binding>& bindings, const Binding& b) {
+	for (auto& bb: bindings)
+		if (bb.index == b.index and bb.type == b.type) {
+			bb.p = b.p;
+			return;
+		}
+	bindings.add(b);
+}
+#endif
+
 void BindingData::bind_texture(int index, Texture *texture) {
 #ifdef USING_OPENGL
-	bindings.add({index, Binding::Type::Texture, texture});
+	set_binding(bindings, {index, Binding::Type::Texture, texture});
 #endif
 #ifdef USING_VULKAN
 	dset->set_texture(index, texture);
@@ -133,9 +145,20 @@ void BindingData::bind_textures(int index0, const Array<Texture*>& textures) {
 		bind_texture(index0 + i, t);
 }
 
+void BindingData::bind_texture_array(int index, const Array<Texture*>& textures) {
+#ifdef USING_OPENGL
+	bind_textures(index, textures);
+#endif
+#ifdef USING_VULKAN
+	for (auto&& [i, t]: enumerate(textures))
+		dset->set_texture_element(index, i, t);
+	dset->update();
+#endif
+}
+
 void BindingData::bind_image(int index, ImageTexture *texture) {
 #ifdef USING_OPENGL
-	bindings.add({index, Binding::Type::Image, texture});
+	set_binding(bindings, {index, Binding::Type::Image, texture});
 #endif
 #ifdef USING_VULKAN
 	dset->set_storage_image(index, texture);
@@ -145,7 +168,7 @@ void BindingData::bind_image(int index, ImageTexture *texture) {
 
 void BindingData::bind_uniform_buffer(int index, Buffer *buffer) {
 #ifdef USING_OPENGL
-	bindings.add({index, Binding::Type::UniformBuffer, buffer});
+	set_binding(bindings, {index, Binding::Type::UniformBuffer, buffer});
 #endif
 #ifdef USING_VULKAN
 	dset->set_uniform_buffer(index, buffer);
@@ -155,7 +178,7 @@ void BindingData::bind_uniform_buffer(int index, Buffer *buffer) {
 
 void BindingData::bind_storage_buffer(int index, Buffer *buffer) {
 #ifdef USING_OPENGL
-	bindings.add({index, Binding::Type::StorageBuffer, buffer});
+	set_binding(bindings, {index, Binding::Type::StorageBuffer, buffer});
 #endif
 #ifdef USING_VULKAN
 	dset->set_storage_buffer(index, buffer);
@@ -31,6 +31,8 @@ struct BindingData {
 
 	void bind_texture(int index, Texture* texture);
 	void bind_textures(int index0, const Array<Texture*>& textures);
+	// elements of a sampler array (consecutive units in OpenGL)
+	void bind_texture_array(int index, const Array<Texture*>& textures);
 	void bind_image(int index, ImageTexture* image);
 	void bind_uniform_buffer(int index, Buffer* buffer);
 	void bind_storage_buffer(int index, Buffer* buffer);
@@ -54,6 +56,9 @@ struct BindingData {
 	void bind_textures(int index0, const Array<Texture*>& textures) { \
 		bindings.bind_textures(index0, textures); \
 	} \
+	void bind_texture_array(int index, const Array<Texture*>& textures) { \
+		bindings.bind_texture_array(index, textures); \
+	} \
 	void bind_image(int index, ImageTexture* image) { \
 		bindings.bind_image(index, image); \
 	} \
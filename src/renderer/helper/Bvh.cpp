@@ -0,0 +1,604 @@
+//
+// Created by michi on 10/19/26.
+//
+
+#include "Bvh.h"
+#include <lib/threads/ThreadPool.h>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+// subtrees with more primitives get built as separate tasks
+const int PARALLEL_THRESHOLD = 4096;
+
+Box empty_box() {
+	return {vec3(1e30f, 1e30f, 1e30f), vec3(-1e30f, -1e30f, -1e30f)};
+}
+
+void grow(Box &b, const Box &o) {
+	b.min._min(o.min);
+	b.max._max(o.max);
+}
+
+float half_area(const Box &b) {
+	vec3 d = b.max - b.min;
+	if (d.x < 0 or d.y < 0 or d.z < 0)
+		return 0;
+	return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+float axis(const vec3 &v, int k) {
+	return (&v.x)[k];
+}
+
+struct BvhBuilder {
+	const Array<Box> &boxes;
+	Array<vec3> centers;
+	Bvh &bvh;
+	int max_leaf_size;
+	int max_depth;
+	std::atomic<int> num_nodes;
+	std::atomic<int> depth_reached;
+
+	BvhBuilder(const Array<Box> &_boxes, Bvh &_bvh, int _max_leaf_size, int _max_depth) : boxes(_boxes), bvh(_bvh) {
+		max_leaf_size = _max_leaf_size;
+		max_depth = _max_depth;
+		num_nodes = 1;
+		depth_reached = 0;
+		centers.resize(boxes.num);
+		for (int i=0; i<boxes.num; i++)
+			centers[i] = boxes[i].center();
+	}
+
+	// index of the bin along axis k
+	static int bin(float c, float c0, float scale) {
+		return std::clamp((int)((c - c0) * scale), 0, Bvh::NUM_BINS - 1);
+	}
+
+	void build_node(int n, int first, int count, int depth) {
+		int d = depth_reached;
+		while (depth > d and !depth_reached.compare_exchange_weak(d, depth)) {}
+
+		Box bounds = empty_box();
+		Box cbounds = empty_box();
+		for (int i=first; i<first+count; i++) {
+			int p = bvh.index[i];
+			grow(bounds, boxes[p]);
+			grow(cbounds, {centers[p], centers[p]});
+		}
+		auto &node = bvh.nodes[n];
+		node.min = bounds.min;
+		node.max = bounds.max;
+		node.first = first;
+		node.count = count;
+		if (count <= max_leaf_size or depth >= max_depth)
+			return;
+
+		// levels below, if all splits were at the median
+		int levels = 0;
+		while (((int64)max_leaf_size << levels) < count)
+			levels ++;
+		bool balanced = (depth + levels >= max_depth - 1);
+
+		// binned SAH, all axes
+		int best_axis = -1, best_bin = 0;
+		float best_cost = 1e30f;
+		for (int k=0; k<3 and !balanced; k++) {
+			float c0 = axis(cbounds.min, k);
+			float extent = axis(cbounds.max, k) - c0;
+			if (extent <= 0)
+				continue;
+			float scale = (float)Bvh::NUM_BINS / extent;
+
+			Box bin_box[Bvh::NUM_BINS];
+			int bin_count[Bvh::NUM_BINS] = {};
+			for (auto &b: bin_box)
+				b = empty_box();
+			for (int i=first; i<first+count; i++) {
+				int p = bvh.index[i];
+				int b = bin(axis(centers[p], k), c0, scale);
+				bin_count[b] ++;
+				grow(bin_box[b], boxes[p]);
+			}
+
+			// sweep from the right, then from the left
+			float right_cost[Bvh::NUM_BINS];
+			Box acc = empty_box();
+			int acc_count = 0;
+			for (int b=Bvh::NUM_BINS-1; b>0; b--) {
+				grow(acc, bin_box[b]);
+				acc_count += bin_count[b];
+				right_cost[b] = half_area(acc) * (float)acc_count;
+			}
+			acc = empty_box();
+			acc_count = 0;
+			for (int b=0; b<Bvh::NUM_BINS-1; b++) {
+				grow(acc, bin_box[b]);
+				acc_count += bin_count[b];
+				float cost = half_area(acc) * (float)acc_count + right_cost[b + 1];
+				if (acc_count > 0 and acc_count < count and cost < best_cost) {
+					best_cost = cost;
+					best_axis = k;
+					best_bin = b;
+				}
+			}
+		}
+
+		int mid = first + count / 2;
+		if (balanced) {
+			// median along the largest extent
+			int k = 0;
+			for (int kk=1; kk<3; kk++)
+				if (axis(cbounds.max, kk) - axis(cbounds.min, kk) > axis(cbounds.max, k) - axis(cbounds.min, k))
+					k = kk;
+			std::nth_element(&bvh.index[first], &bvh.index[mid], &bvh.index[first] + count, [this, k] (int a, int b) {
+				return axis(centers[a], k) < axis(centers[b], k);
+			});
+		} else if (best_axis >= 0) {
+			float c0 = axis(cbounds.min, best_axis);
+			float scale = (float)Bvh::NUM_BINS / (axis(cbounds.max, best_axis) - c0);
+			auto it = std::partition(&bvh.index[first], &bvh.index[first] + count, [this, best_axis, best_bin, c0, scale] (int p) {
+				return bin(axis(centers[p], best_axis), c0, scale) <= best_bin;
+			});
+			mid = (int)(it - &bvh.index[0]);
+		}
+		// (otherwise all centers coincide, any split will do)
+
+		int c = num_nodes.fetch_add(2);
+		node.first = c;
+		node.count = 0;
+
+		int child_first[2] = {first, mid};
+		int child_count[2] = {mid - first, first + count - mid};
+		if (count > PARALLEL_THRESHOLD) {
+			ThreadPool::get()->parallel_for(2, [this, c, &child_first, &child_count, depth] (int i0, int i1) {
+				for (int i=i0; i<i1; i++)
+					build_node(c + i, child_first[i], child_count[i], depth + 1);
+			}, 1);
+		} else {
+			build_node(c, child_first[0], child_count[0], depth + 1);
+			build_node(c + 1, child_first[1], child_count[1], depth + 1);
+		}
+	}
+};
+
+}
+
+void Bvh::build(const Array<Box> &boxes, int max_leaf_size, int max_depth) {
+	clear();
+	if (boxes.num == 0)
+		return;
+	index.resize(boxes.num);
+	for (int i=0; i<boxes.num; i++)
+		index[i] = i;
+	// binary tree, at least one primitive per leaf
+	nodes.resize(boxes.num * 2 - 1);
+
+	BvhBuilder builder(boxes, *this, ::max(max_leaf_size, 1), ::min(max_depth, MAX_DEPTH));
+	builder.build_node(0, 0, boxes.num, 0);
+	nodes.resize(builder.num_nodes);
+	depth = builder.depth_reached;
+}
+
+void Bvh::refit(const Array<Box> &boxes) {
+	// children are stored after their parents
+	for (int n=nodes.num-1; n>=0; n--) {
+		auto &node = nodes[n];
+		Box b = empty_box();
+		if (node.count > 0) {
+			for (int i=node.first; i<node.first+node.count; i++)
+				grow(b, boxes[index[i]]);
+		} else {
+			grow(b, {nodes[node.first].min, nodes[node.first].max});
+			grow(b, {nodes[node.first + 1].min, nodes[node.first + 1].max});
+		}
+		node.min = b.min;
+		node.max = b.max;
+	}
+}
+
+void Bvh::clear() {
+	nodes.clear();
+	index.clear();
+	depth = 0;
+}
+
+Box Bvh::bounds() const {
+	if (nodes.num == 0)
+		return {v_0, v_0};
+	return {nodes[0].min, nodes[0].max};
+}
+
+// sum of inner node areas, relative to the root
+static float bvh_cost(const Bvh &bvh) {
+	float root = half_area(bvh.bounds());
+	if (root <= 0)
+		return 0;
+	float sum = 0;
+	for (auto &n: bvh.nodes)
+		sum += half_area({n.min, n.max});
+	return sum / root;
+}
+
+
+static Array<Box> triangle_boxes(const Array<vec3> &vertex, const Array<int> &triangle_index) {
+	int num_triangles = triangle_index.num / 3;
+	Array<Box> boxes;
+	boxes.resize(num_triangles);
+	for (int i=0; i<num_triangles; i++) {
+		const vec3 &a = vertex[triangle_index[i*3]];
+		Box b = {a, a};
+		grow(b, {vertex[triangle_index[i*3+1]], vertex[triangle_index[i*3+1]]});
+		grow(b, {vertex[triangle_index[i*3+2]], vertex[triangle_index[i*3+2]]});
+		boxes[i] = b;
+	}
+	return boxes;
+}
+
+// triangles in bvh order
+static void fill_triangles(Array<BvhTriangle> &triangles, const Bvh &bvh, const Array<vec3> &vertex, const Array<int> &triangle_index, const Array<vec3> &normal) {
+	triangles.resize(bvh.index.num);
+	for (int k=0; k<triangles.num; k++) {
+		int i = bvh.index[k];
+		auto &t = triangles[k];
+		t.a = vertex[triangle_index[i*3]];
+		t.b = vertex[triangle_index[i*3+1]];
+		t.c = vertex[triangle_index[i*3+2]];
+		if (normal.num >= triangle_index.num)
+			t.n = (normal[i*3] + normal[i*3+1] + normal[i*3+2]).normalized();
+		else
+			t.n = vec3::cross(t.b - t.a, t.c - t.a).normalized();
+		t._a = t._b = t._c = 0;
+		t.index = i;
+	}
+}
+
+void BvhMesh::build(const Array<vec3> &vertex, const Array<int> &triangle_index, const Array<vec3> &normal) {
+	bvh.build(triangle_boxes(vertex, triangle_index), 4);
+	fill_triangles(triangles, bvh, vertex, triangle_index, normal);
+}
+
+void BvhMesh::refit(const Array<vec3> &vertex, const Array<int> &triangle_index, const Array<vec3> &normal) {
+	if (bvh.index.num != triangle_index.num / 3) {
+		build(vertex, triangle_index, normal);
+		return;
+	}
+	bvh.refit(triangle_boxes(vertex, triangle_index));
+	fill_triangles(triangles, bvh, vertex, triangle_index, normal);
+}
+
+
+BvhScene::BvhScene() {
+	meshes_changed = false;
+	num_nodes = 0;
+	num_triangles = 0;
+	top_valid = false;
+}
+
+BvhScene::~BvhScene() {
+	for (auto m: meshes)
+		delete m;
+}
+
+void BvhScene::begin() {
+	for (auto m: meshes)
+		m->used = false;
+	instances.clear();
+}
+
+void BvhScene::add_instance(const void *key, int sub, int version, const mat4 &matrix, const std::function<void(BvhMesh&)> &builder) {
+	int index = -1;
+	for (int i=0; i<meshes.num; i++)
+		if (meshes[i]->key == key and meshes[i]->sub == sub) {
+			index = i;
+			break;
+		}
+	if (index < 0) {
+		auto m = new Mesh;
+		m->key = key;
+		m->sub = sub;
+		m->version = version - 1;
+		m->node_offset = m->triangle_offset = 0;
+		index = meshes.num;
+		meshes.add(m);
+	}
+	auto m = meshes[index];
+	if (m->version != version) {
+		m->version = version;
+		m->builder = builder;
+	}
+	m->used = true;
+	instances.add({index, matrix, matrix.inverse(), {v_0, v_0}});
+}
+
+void BvhScene::end() {
+	// drop unused meshes
+	Array<int> remap;
+	remap.resize(meshes.num);
+	Array<Mesh*> kept;
+	for (int i=0; i<meshes.num; i++) {
+		if (meshes[i]->used) {
+			remap[i] = kept.num;
+			kept.add(meshes[i]);
+		} else {
+			delete meshes[i];
+			meshes_changed = true;
+		}
+	}
+	meshes = kept;
+	for (auto &inst: instances)
+		inst.mesh = remap[inst.mesh];
+
+	// build new/outdated meshes
+	Array<Mesh*> pending;
+	for (auto m: meshes)
+		if (m->builder)
+			pending.add(m);
+	if (pending.num > 0) {
+		ThreadPool::get()->parallel_for(pending.num, [&pending] (int first, int end) {
+			for (int i=first; i<end; i++)
+				pending[i]->builder(pending[i]->data);
+		}, 1);
+		for (auto m: pending)
+			m->builder = nullptr;
+		meshes_changed = true;
+	}
+
+	if (meshes_changed) {
+		num_nodes = num_triangles = 0;
+		for (auto m: meshes) {
+			m->node_offset = num_nodes;
+			m->triangle_offset = num_triangles;
+			num_nodes += m->data.bvh.nodes.num;
+			num_triangles += m->data.triangles.num;
+		}
+	}
+
+	// instance boxes (world space)
+	Array<Box> boxes;
+	boxes.resize(instances.num);
+	for (int i=0; i<instances.num; i++) {
+		auto &inst = instances[i];
+		Box b = meshes[inst.mesh]->data.bvh.bounds();
+		Box w = {inst.matrix * b.min, inst.matrix * b.min};
+		for (int k=1; k<8; k++) {
+			vec3 p = vec3((k & 1) ? b.max.x : b.min.x, (k & 2) ? b.max.y : b.min.y, (k & 4) ? b.max.z : b.min.z);
+			grow(w, {inst.matrix * p, inst.matrix * p});
+		}
+		inst.box = w;
+		boxes[i] = w;
+	}
+
+	// refit while the instances stay the same, rebuild when the quality degrades too much
+	if (top_valid and top.index.num == instances.num) {
+		top.refit(boxes);
+		if (bvh_cost(top) > 2 * top_cost)
+			top_valid = false;
+	} else {
+		top_valid = false;
+	}
+	if (!top_valid) {
+		top.build(boxes, 1);
+		top_cost = bvh_cost(top);
+		top_valid = true;
+	}
+}
+
+void BvhScene::flatten_top(Array<BvhNode> &nodes) const {
+	nodes = top.nodes;
+	for (auto &n: nodes)
+		if (n.count > 0)
+			n.first = top.index[n.first];
+}
+
+void BvhScene::flatten_meshes(Array<BvhNode> &nodes, Array<BvhTriangle> &triangles) const {
+	nodes.resize(num_nodes);
+	triangles.resize(num_triangles);
+	for (auto m: meshes) {
+		for (int i=0; i<m->data.bvh.nodes.num; i++)
+			nodes[m->node_offset + i] = m->data.bvh.nodes[i];
+		for (int i=0; i<m->data.triangles.num; i++)
+			triangles[m->triangle_offset + i] = m->data.triangles[i];
+	}
+}
+
+
+namespace {
+
+const int P = BvhScene::PACKET_SIZE;
+
+// structure of arrays, so the loops over the rays vectorize
+struct RayPacket {
+	int n;
+	float ox[P], oy[P], oz[P];
+	float dx[P], dy[P], dz[P];
+	float ix[P], iy[P], iz[P];
+	// closest hit so far
+	float t[P], f[P], g[P];
+	int triangle[P], instance[P];
+
+	void set(int i, const vec3 &o, const vec3 &d) {
+		ox[i] = o.x;	oy[i] = o.y;	oz[i] = o.z;
+		dx[i] = d.x;	dy[i] = d.y;	dz[i] = d.z;
+		ix[i] = 1.0f / ((d.x != 0) ? d.x : 1e-20f);
+		iy[i] = 1.0f / ((d.y != 0) ? d.y : 1e-20f);
+		iz[i] = 1.0f / ((d.z != 0) ? d.z : 1e-20f);
+	}
+};
+
+// slab test, true if any ray hits the box before its current t
+bool packet_hits_box(const RayPacket &r, const vec3 &bmin, const vec3 &bmax) {
+	int hits = 0;
+	for (int i=0; i<r.n; i++) {
+		float tx0 = (bmin.x - r.ox[i]) * r.ix[i], tx1 = (bmax.x - r.ox[i]) * r.ix[i];
+		float ty0 = (bmin.y - r.oy[i]) * r.iy[i], ty1 = (bmax.y - r.oy[i]) * r.iy[i];
+		float tz0 = (bmin.z - r.oz[i]) * r.iz[i], tz1 = (bmax.z - r.oz[i]) * r.iz[i];
+		float t_near = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+		float t_far = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), r.t[i]));
+		hits += (t_near <= t_far) ? 1 : 0;
+	}
+	return hits > 0;
+}
+
+// Moeller-Trumbore, both sides
+void packet_hit_triangle(RayPacket &r, const BvhTriangle &tr, int triangle, int instance) {
+	vec3 e1 = tr.b - tr.a;
+	vec3 e2 = tr.c - tr.a;
+	for (int i=0; i<r.n; i++) {
+		// q = dir x e2
+		float qx = r.dy[i] * e2.z - r.dz[i] * e2.y;
+		float qy = r.dz[i] * e2.x - r.dx[i] * e2.z;
+		float qz = r.dx[i] * e2.y - r.dy[i] * e2.x;
+		float det = e1.x * qx + e1.y * qy + e1.z * qz;
+		float inv_det = 1.0f / ((det != 0) ? det : 1e-30f);
+		float sx = r.ox[i] - tr.a.x, sy = r.oy[i] - tr.a.y, sz = r.oz[i] - tr.a.z;
+		float f = (sx * qx + sy * qy + sz * qz) * inv_det;
+		// w = s x e1
+		float wx = sy * e1.z - sz * e1.y;
+		float wy = sz * e1.x - sx * e1.z;
+		float wz = sx * e1.y - sy * e1.x;
+		float g = (r.dx[i] * wx + r.dy[i] * wy + r.dz[i] * wz) * inv_det;
+		float t = (e2.x * wx + e2.y * wy + e2.z * wz) * inv_det;
+		bool hit = (det != 0) and (f >= 0) and (g >= 0) and (f + g <= 1) and (t > 0) and (t < r.t[i]);
+		r.t[i] = hit ? t : r.t[i];
+		r.f[i] = hit ? f : r.f[i];
+		r.g[i] = hit ? g : r.g[i];
+		r.triangle[i] = hit ? triangle : r.triangle[i];
+		r.instance[i] = hit ? instance : r.instance[i];
+	}
+}
+
+// popping a node and pushing its children: at most one entry per level + 1
+const int STACK_SIZE = Bvh::MAX_DEPTH + 1;
+
+// r in object space of the instance
+void packet_trace_mesh(RayPacket &r, const BvhMesh &mesh, int instance) {
+	const auto &nodes = mesh.bvh.nodes;
+	if (nodes.num == 0)
+		return;
+	// packet direction, decides which child gets visited first
+	vec3 d = v_0;
+	for (int i=0; i<r.n; i++)
+		d += vec3(r.dx[i], r.dy[i], r.dz[i]);
+
+	int stack[STACK_SIZE];
+	int sp = 0;
+	stack[sp ++] = 0;
+	while (sp > 0) {
+		auto &node = nodes[stack[-- sp]];
+		if (!packet_hits_box(r, node.min, node.max))
+			continue;
+		if (node.count > 0) {
+			for (int k=node.first; k<node.first+node.count; k++)
+				packet_hit_triangle(r, mesh.triangles[k], k, instance);
+		} else {
+			auto &l = nodes[node.first];
+			auto &rr = nodes[node.first + 1];
+			bool left_first = ((l.min + l.max - rr.min - rr.max) * d <= 0);
+			stack[sp ++] = node.first + (left_first ? 1 : 0);
+			stack[sp ++] = node.first + (left_first ? 0 : 1);
+		}
+	}
+}
+
+}
+
+void BvhScene::trace_packet(const vec3 *p0, const vec3 *dir, int n, float t_max, BvhHit *hits) const {
+	RayPacket r;
+	r.n = n;
+	for (int i=0; i<n; i++) {
+		r.set(i, p0[i], dir[i]);
+		r.t[i] = t_max;
+		r.f[i] = r.g[i] = 0;
+		r.triangle[i] = r.instance[i] = -1;
+	}
+
+	if (top.nodes.num > 0) {
+		int stack[STACK_SIZE];
+		int sp = 0;
+		stack[sp ++] = 0;
+		while (sp > 0) {
+			auto &node = top.nodes[stack[-- sp]];
+			if (!packet_hits_box(r, node.min, node.max))
+				continue;
+			if (node.count > 0) {
+				for (int k=node.first; k<node.first+node.count; k++) {
+					int inst = top.index[k];
+					auto &ii = instances[inst];
+					// same t in object space (dir not normalized there)
+					RayPacket ro = r;
+					for (int i=0; i<n; i++)
+						ro.set(i, ii.inverse * p0[i], ii.inverse.transform_normal(dir[i]));
+					packet_trace_mesh(ro, meshes[ii.mesh]->data, inst);
+					for (int i=0; i<n; i++) {
+						r.t[i] = ro.t[i];
+						r.f[i] = ro.f[i];
+						r.g[i] = ro.g[i];
+						r.triangle[i] = ro.triangle[i];
+						r.instance[i] = ro.instance[i];
+					}
+				}
+			} else {
+				stack[sp ++] = node.first + 1;
+				stack[sp ++] = node.first;
+			}
+		}
+	}
+
+	for (int i=0; i<n; i++) {
+		auto &h = hits[i];
+		h.instance = r.instance[i];
+		if (h.instance < 0) {
+			h.index = -1;
+			h.t = r.t[i];
+			h.f = h.g = 0;
+			h.p = h.n = v_0;
+			continue;
+		}
+		auto &ii = instances[h.instance];
+		auto &tr = meshes[ii.mesh]->data.triangles[r.triangle[i]];
+		h.index = tr.index;
+		h.t = r.t[i];
+		h.f = r.f[i];
+		h.g = r.g[i];
+		h.p = p0[i] + dir[i] * h.t;
+		// inverse transpose
+		h.n = ii.inverse.transpose().transform_normal(tr.n).normalized();
+		if (h.n * dir[i] > 0)
+			h.n = -h.n;
+	}
+}
+
+// similar directions, close origins (relative to the scene)
+//   otherwise the packet visits the union of all the rays' nodes, slower than single rays
+static bool is_coherent(const vec3 *p0, const vec3 *dir, int n, float scene_size) {
+	vec3 d0 = dir[0].normalized();
+	float max_dist = scene_size * 0.02f;
+	for (int i=1; i<n; i++) {
+		if (dir[i] * d0 < 0.95f * dir[i].length())
+			return false;
+		if ((p0[i] - p0[0]).length_sqr() > max_dist * max_dist)
+			return false;
+	}
+	return true;
+}
+
+void BvhScene::trace(const Array<vec3> &p0, const Array<vec3> &dir, float t_max, Array<BvhHit> &hits) const {
+	hits.resize(p0.num);
+	Box b = top.bounds();
+	float scene_size = (b.max - b.min).length();
+	int num_packets = (p0.num + PACKET_SIZE - 1) / PACKET_SIZE;
+	ThreadPool::get()->parallel_for(num_packets, [this, &p0, &dir, t_max, &hits, scene_size] (int first, int end) {
+		for (int k=first; k<end; k++) {
+			int i0 = k * PACKET_SIZE;
+			int n = ::min(PACKET_SIZE, p0.num - i0);
+			if (is_coherent(&p0[i0], &dir[i0], n, scene_size)) {
+				trace_packet(&p0[i0], &dir[i0], n, t_max, &hits[i0]);
+			} else {
+				for (int i=i0; i<i0+n; i++)
+					trace_packet(&p0[i], &dir[i], 1, t_max, &hits[i]);
+			}
+		}
+	});
+}
@@ -0,0 +1,141 @@
+//
+// Created by michi on 10/19/26.
+//
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <lib/base/base.h>
+#include <lib/math/vec3.h>
+#include <lib/math/mat4.h>
+#include <lib/math/Box.h>
+#include <functional>
+
+// same layout in the compute shaders (module-bvh.shader)
+struct BvhNode {
+	vec3 min;
+	// inner node: left child (right = first + 1), leaf: first primitive
+	int first;
+	vec3 max;
+	// number of primitives, 0 for inner nodes
+	int count;
+};
+
+struct BvhTriangle {
+	vec3 a;
+	float _a;
+	vec3 b;
+	float _b;
+	vec3 c;
+	float _c;
+	vec3 n;
+	// original triangle index
+	int index;
+};
+
+struct BvhHit {
+	vec3 p, n;
+	// barycentric
+	float f, g;
+	// in units of dir
+	float t;
+	// original triangle index, -1 for misses
+	int index;
+	int instance;
+};
+
+// bounding volume hierarchy over boxes, stored flat
+//   built top-down with binned SAH, large subtrees get built in parallel on the ThreadPool
+//   children are always stored after their parent
+//   depth is limited (close to the limit subtrees get split at the median), so fixed traversal stacks can't overflow
+class Bvh {
+public:
+	static const int NUM_BINS = 16;
+	// root = 0, a traversal stack needs MAX_DEPTH + 1 entries
+	static const int MAX_DEPTH = 62;
+
+	// max_depth: clamped to MAX_DEPTH
+	void build(const Array<Box> &boxes, int max_leaf_size, int max_depth = MAX_DEPTH);
+	// same primitives (and topology), new boxes
+	void refit(const Array<Box> &boxes);
+	void clear();
+
+	Box bounds() const;
+
+	Array<BvhNode> nodes;
+	// primitive order, leaves reference ranges in here
+	Array<int> index;
+	int depth = 0;
+};
+
+// one Bvh over triangles, triangles in bvh order
+struct BvhMesh {
+	// vertex: positions, triangle_index: 3 per triangle, normal: 3 per triangle (optional)
+	void build(const Array<vec3> &vertex, const Array<int> &triangle_index, const Array<vec3> &normal);
+	// same triangles, moved vertices (keeps the topology of the tree)
+	void refit(const Array<vec3> &vertex, const Array<int> &triangle_index, const Array<vec3> &normal);
+
+	Bvh bvh;
+	Array<BvhTriangle> triangles;
+};
+
+// two levels: one BvhMesh per (cached) mesh, one Bvh over the instances
+//   per frame: begin(), add_instance()..., end()
+class BvhScene {
+public:
+	BvhScene();
+	~BvhScene();
+
+	struct Mesh {
+		const void *key;
+		int sub;
+		int version;
+		BvhMesh data;
+		// in the flat arrays
+		int node_offset, triangle_offset;
+		bool used;
+		std::function<void(BvhMesh&)> builder;
+	};
+
+	struct Instance {
+		int mesh;
+		mat4 matrix, inverse;
+		Box box;
+	};
+
+	void begin();
+	// key, sub, version identify the geometry, builder gets called (on a worker) if it is unknown or outdated
+	void add_instance(const void *key, int sub, int version, const mat4 &matrix, const std::function<void(BvhMesh&)> &builder);
+	// builds new meshes (in parallel), then refits or rebuilds the top level
+	void end();
+
+	Array<Mesh*> meshes;
+	Array<Instance> instances;
+	Bvh top;
+
+	// meshes changed, the flat arrays need to be uploaded again (reset by the user)
+	bool meshes_changed;
+	int num_nodes, num_triangles;
+
+	// gpu layout:
+	//   nodes: top level (leaves reference instances directly), then all meshes (relative to node_offset)
+	//   triangles: all meshes (relative to triangle_offset)
+	void flatten_top(Array<BvhNode> &nodes) const;
+	void flatten_meshes(Array<BvhNode> &nodes, Array<BvhTriangle> &triangles) const;
+
+	// cpu queries:
+	//   rays get traced in packets, every node gets tested against all rays of a packet at once
+	//   (flat loops over the rays), so coherent rays share their node visits
+	static const int PACKET_SIZE = 16;
+	// closest hits (both sides, n facing the ray), n <= PACKET_SIZE
+	void trace_packet(const vec3 *p0, const vec3 *dir, int n, float t_max, BvhHit *hits) const;
+	// any number of rays, packets in parallel
+	void trace(const Array<vec3> &p0, const Array<vec3> &dir, float t_max, Array<BvhHit> &hits) const;
+
+private:
+	bool top_valid;
+	// relative inner node area after the last full build
+	float top_cost;
+};
+
+#endif //BVH_H
@@ -1,4 +1,6 @@
 #include "CubeMapSource.h"
+#include "../world/geometry/GeometryRenderer.h"
+#include "../target/TextureRenderer.h"
 #include <Config.h>
 #include <graphics-impl.h>
 
@@ -10,7 +12,30 @@ CubeMapSource::CubeMapSource() {
 	resolution = config.get_int("cubemap.resolution", 128);
 	update_rate = config.get_int("cubemap.update_rate", 9);
 	counter = 0;
+	prefilter = config.get_bool("cubemap.prefilter", false);
+	levels = 1;
+	next_face = 0;
+	valid = false;
+	priority = 0;
 }
 
 CubeMapSource::~CubeMapSource() = default;
 
+CubeMapSource::Face::Face() = default;
+CubeMapSource::Face::~Face() = default;
+
+// unfinished cycles always continue
+bool CubeMapSource::is_due() const {
+	if (next_face > 0 or !valid)
+		return true;
+	if (update_rate <= 0)
+		return false;
+	return counter >= update_rate;
+}
+
+void CubeMapSource::invalidate() {
+	valid = false;
+	for (auto& f: faces)
+		f.static_valid = false;
+}
+
@@ -4,7 +4,10 @@
 #include <y/Component.h>
 #include <graphics-fwd.h>
 #include <lib/base/pointer.h>
-#include "../world/geometry/RenderViewData.h"
+#include <lib/math/vec3.h>
+
+class GeometryRenderer;
+class TextureRenderer;
 
 class CubeMapSource : public Component {
 public:
@@ -18,11 +21,38 @@ public:
 #ifdef USING_VULKAN
 	owned<vulkan::RenderPass> render_pass;
 #endif
-	RenderViewData rvd[6];
 	int resolution;
+	// update_rate <= 0: rendered once, kept until invalidate()
 	int update_rate;
 	int counter;
 
+	// per face, see RenderPath::render_into_cubemap_face()
+	//   like the ShadowRenderer's cascades, static geometry (GeometryRenderer::is_static()) gets cached
+	//   in a static layer (OpenGL) and each update only draws the dynamic geometry on top of a copy
+	struct Face {
+		Face();
+		~Face();
+		owned<GeometryRenderer> geo_renderer;
+		owned<GeometryRenderer> static_geo_renderer;
+		owned<TextureRenderer> static_renderer;
+		bool static_valid = false;
+		int64 static_signature = 0;
+		vec3 static_pos;
+		float static_min_depth = 0;
+	} faces[6];
+	// ggx prefiltered mip chain after each complete cycle, sampled by roughness
+	//   OpenGL only: Vulkan cube maps have no mip levels, the flag is ignored there
+	bool prefilter;
+	// mip levels with valid content (1 without prefiltering)
+	int levels;
+
+	// scheduling, see RenderPath::render_cubemaps()
+	int next_face;
+	bool valid;
+	float priority;
+	bool is_due() const;
+	void invalidate();
+
 	static const kaba::Class *_class;
 };
 
@@ -0,0 +1,211 @@
+//
+// Created by michi on 10/19/26.
+//
+
+#include "GpuParticleSystem.h"
+#include "../world/geometry/GeometryRenderer.h"
+#include "../world/geometry/RenderViewData.h"
+#include "../base.h"
+#include "../../fx/GpuParticleEmitter.h"
+#include "../../graphics-impl.h"
+#include "../../helper/PerformanceMonitor.h"
+#include "../../helper/ResourceManager.h"
+#include "../../y/EngineData.h"
+#include "../../y/Entity.h"
+#ifdef USING_VULKAN
+	#include "PipelineManager.h"
+#endif
+
+// must match compute/particles.shader
+enum class Stage {
+	EMIT,
+	SIMULATE,
+	FINALIZE,
+	SORT_PAD,
+	SORT
+};
+
+struct GpuParticle {
+	vec3 pos;
+	float time_to_live;
+	vec3 vel;
+	float radius;
+	color col;
+};
+
+struct GpuParticleCounters {
+	// DrawArraysIndirectCommand
+	unsigned int vertex_count, instance_count, first_vertex, first_instance;
+	int alive_count[2];
+	int dead_count;
+	int _padding;
+};
+
+static constexpr int GROUP_SIZE = 256;
+
+static Any vec4_to_any(const vec3& v, float w) {
+	Any a = vec3_to_any(v);
+	a.list_set(3, w);
+	return a;
+}
+
+static void upload(ShaderStorageBuffer* buf, const void* data, int size) {
+#ifdef USING_VULKAN
+	buf->update_part(data, 0, size);
+#else
+	buf->update(data, size);
+#endif
+}
+
+GpuParticleSystem::GpuParticleSystem(GpuParticleEmitter* _emitter) :
+	ComputeTask("gpu-particles", engine.resource_manager->load_shader("compute/particles.shader"), 1, 1, 1),
+	shader_draw(engine.resource_manager->load_shader("fx-gpu.shader")),
+	draw_bindings(shader_draw.get())
+{
+	emitter = _emitter;
+	capacity = max(emitter->max_particles, 1);
+	half_size = 1;
+	while (half_size < capacity)
+		half_size *= 2;
+
+	particle_buffer = new ShaderStorageBuffer(capacity * sizeof(GpuParticle));
+	alive_buffer = new ShaderStorageBuffer(half_size * 2 * sizeof(int));
+	dead_buffer = new ShaderStorageBuffer(capacity * sizeof(int));
+	counter_buffer = new ShaderStorageBuffer(sizeof(GpuParticleCounters));
+
+	// all dead
+	Array<int> dead;
+	dead.resize(capacity);
+	for (int i=0; i<capacity; i++)
+		dead[i] = i;
+	upload(dead_buffer.get(), &dead[0], capacity * sizeof(int));
+	GpuParticleCounters counters = {6, 0, 0, 0, {0, 0}, capacity, 0};
+	upload(counter_buffer.get(), &counters, sizeof(counters));
+
+	bind_storage_buffer(0, particle_buffer.get());
+	bind_storage_buffer(1, alive_buffer.get());
+	bind_storage_buffer(2, dead_buffer.get());
+	bind_storage_buffer(3, counter_buffer.get());
+
+	draw_bindings.bind_storage_buffer(0, particle_buffer.get());
+	draw_bindings.bind_storage_buffer(1, alive_buffer.get());
+
+	// corners in [-1,1], uv in [0,1]
+	vb_quad = new VertexBuffer("3f,4f,2f");
+	Array<VertexFx> v = {{{-1, 1,0}, White, 0,0},
+	                     {{ 1, 1,0}, White, 1,0},
+	                     {{ 1,-1,0}, White, 1,1},
+	                     {{-1, 1,0}, White, 0,0},
+	                     {{ 1,-1,0}, White, 1,1},
+	                     {{-1,-1,0}, White, 0,1}};
+	vb_quad->update(v);
+
+	cam_pos = vec3::ZERO;
+	cam_dir = vec3::EZ;
+}
+
+GpuParticleSystem::~GpuParticleSystem() = default;
+
+void GpuParticleSystem::dispatch(const RenderParams& params, int stage, int num_threads) {
+	bindings.shader_data.dict_set("stage:96", stage);
+	bindings.shader_data.dict_set("current:104", current);
+#ifdef USING_OPENGL
+	bindings.apply(shader.get(), params);
+	shader->dispatch((num_threads + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+	nix::buffer_barrier();
+#endif
+#ifdef USING_VULKAN
+	auto cb = params.command_buffer;
+	bindings.apply(shader.get(), params);
+	cb->dispatch((num_threads + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+	cb->memory_barrier(vulkan::AccessFlags::SHADER_WRITE_BIT, vulkan::AccessFlags::SHADER_READ_BIT | vulkan::AccessFlags::SHADER_WRITE_BIT | vulkan::AccessFlags::INDIRECT_COMMAND_READ_BIT);
+#endif
+}
+
+void GpuParticleSystem::render(const RenderParams& params) {
+	float dt = emitter->pending_dt;
+	if (dt <= 0)
+		return;
+	int num_emit = min((int)emitter->pending_spawn, capacity);
+	emitter->pending_dt = 0;
+	emitter->pending_spawn -= (float)(int)emitter->pending_spawn;
+
+	PerformanceMonitor::begin(channel);
+	gpu_timestamp_begin(params, channel);
+
+	auto& data = bindings.shader_data;
+	data.dict_set("emit_pos:0", vec4_to_any(emitter->owner->pos, emitter->spawn_time_to_live));
+	data.dict_set("emit_vel:16", vec4_to_any(emitter->owner->ang * emitter->spawn_vel, emitter->spawn_dvel));
+	Any col = Any::EmptyList;
+	for (int i=0; i<4; i++)
+		col.list_set(i, (&emitter->spawn_color.r)[i]);
+	data.dict_set("emit_color:32", col);
+	data.dict_set("acceleration:48", vec4_to_any(emitter->acceleration, dt));
+	data.dict_set("cam_pos:64", vec4_to_any(cam_pos, emitter->spawn_radius));
+	data.dict_set("cam_dir:80", vec4_to_any(cam_dir, emitter->spawn_dradius));
+	data.dict_set("num:100", num_emit);
+	data.dict_set("capacity:108", half_size);
+	data.dict_set("seed:112", seed ++);
+	data.dict_set("sort_j:116", 0);
+
+#ifdef USING_VULKAN
+	auto cb = params.command_buffer;
+	cb->set_bind_point(vulkan::PipelineBindPoint::COMPUTE);
+	cb->bind_pipeline(pipeline.get());
+#endif
+
+	if (num_emit > 0)
+		dispatch(params, (int)Stage::EMIT, num_emit);
+	dispatch(params, (int)Stage::SIMULATE, capacity);
+	dispatch(params, (int)Stage::FINALIZE, 1);
+	current = 1 - current;
+
+	if (emitter->sort) {
+		// bitonic sort of the whole (padded) half
+		dispatch(params, (int)Stage::SORT_PAD, half_size);
+		for (int k=2; k<=half_size; k*=2)
+			for (int j=k/2; j>0; j/=2) {
+				data.dict_set("num:100", k);
+				data.dict_set("sort_j:116", j);
+				dispatch(params, (int)Stage::SORT, half_size);
+			}
+	}
+
+#ifdef USING_VULKAN
+	cb->set_bind_point(vulkan::PipelineBindPoint::GRAPHICS);
+#endif
+
+	gpu_timestamp_end(params, channel);
+	PerformanceMonitor::end(channel);
+}
+
+void GpuParticleSystem::draw(const RenderParams& params, RenderViewData& rvd) {
+	auto& data = draw_bindings.shader_data;
+	data.dict_set("view:0", mat4_to_any(rvd.ubo.v));
+	data.dict_set("project:64", mat4_to_any(rvd.ubo.p));
+	auto& s = emitter->source;
+	Any source = Any::EmptyList;
+	source.list_set(0, s.x1);
+	source.list_set(1, s.x2);
+	source.list_set(2, s.y1);
+	source.list_set(3, s.y2);
+	data.dict_set("source:128", source);
+	data.dict_set("alive_offset:144", current * half_size);
+	draw_bindings.bind_texture(2, emitter->texture);
+
+#ifdef USING_OPENGL
+	nix::set_shader(shader_draw.get());
+	nix::bind_texture(0, emitter->texture);
+	draw_bindings.apply(shader_draw.get(), params);
+	nix::set_model_matrix(mat4::ID);
+	nix::draw_instanced_triangles_indirect(vb_quad.get(), counter_buffer.get(), 0);
+#endif
+#ifdef USING_VULKAN
+	auto cb = params.command_buffer;
+	auto p = PipelineManager::get_alpha(shader_draw.get(), params.render_pass, PrimitiveTopology::TRIANGLES, vb_quad.get(),
+			Alpha::SOURCE_ALPHA, Alpha::SOURCE_INV_ALPHA, CullMode::NONE, true, false);
+	cb->bind_pipeline(p);
+	draw_bindings.apply(shader_draw.get(), params);
+	cb->draw_instanced_indirect(vb_quad.get(), counter_buffer.get(), 0);
+#endif
+}
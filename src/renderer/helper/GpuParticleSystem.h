@@ -0,0 +1,55 @@
+//
+// Created by michi on 10/19/26.
+//
+
+#ifndef GPUPARTICLESYSTEM_H
+#define GPUPARTICLESYSTEM_H
+
+#include "ComputeTask.h"
+#include <lib/math/vec3.h>
+#include <lib/math/mat4.h>
+
+class GpuParticleEmitter;
+class RenderViewData;
+
+// gpu state of one GpuParticleEmitter
+// render() runs emit -> simulate (+compaction) -> finalize -> (sort), all in compute shaders
+// draw() uses the instance count written by finalize (indirect), so the cpu never
+// learns how many particles are alive
+class GpuParticleSystem : public ComputeTask {
+public:
+	explicit GpuParticleSystem(GpuParticleEmitter* emitter);
+	~GpuParticleSystem() override;
+
+	// (vulkan: outside of render passes)
+	void render(const RenderParams& params) override;
+	// (vulkan: inside a render pass)
+	void draw(const RenderParams& params, RenderViewData& rvd);
+
+	GpuParticleEmitter* emitter;
+	vec3 cam_pos, cam_dir;
+	// engine.frame of the last render()
+	int frame = -1;
+
+	// max particles, each half of the alive list is rounded up to a power of 2 (sorting)
+	int capacity;
+	int half_size;
+	// half of the alive list holding the particles of the last step
+	int current = 0;
+	int seed = 0;
+
+	owned<ShaderStorageBuffer> particle_buffer;
+	owned<ShaderStorageBuffer> alive_buffer;
+	owned<ShaderStorageBuffer> dead_buffer;
+	// indirect draw command + counters
+	owned<ShaderStorageBuffer> counter_buffer;
+
+	shared<Shader> shader_draw;
+	BindingData draw_bindings;
+	owned<VertexBuffer> vb_quad;
+
+private:
+	void dispatch(const RenderParams& params, int stage, int num_threads);
+};
+
+#endif //GPUPARTICLESYSTEM_H
@@ -16,27 +16,59 @@ constexpr int NSAMPLES = 2560;
 LightMeter::LightMeter(ResourceManager* resource_manager, Texture* tex)
 	: ComputeTask("expo", resource_manager->load_shader("compute/brightness.shader"), NSAMPLES, 1, 1)
 {
-	params = new UniformBuffer(8);
-	buf = new ShaderStorageBuffer(NBINS*4);
+	for (auto& s: slots)
+		s.buf = new ShaderStorageBuffer(NBINS*4);
+	buf = slots[current_slot].buf.get();
 	texture = tex;
 	bind_texture(0, tex);
 	bind_storage_buffer(1, buf);
-	bind_uniform_buffer(2, params);
 	brightness = 1;
+	histogram.resize(NBINS);
+	memset(&histogram[0], 0, NBINS * sizeof(int));
+}
+
+LightMeter::~LightMeter() = default;
+
+bool LightMeter::is_slot_ready(int index) const {
+#ifdef USING_OPENGL
+	return slots[index].fence->is_signaled();
+#else
+	// the window renderer waits for each frame to finish
+	return true;
+#endif
+}
+
+void LightMeter::render(const RenderParams& params) {
+	if (!slot_ready_for_dispatch)
+		return;
+	ComputeTask::render(params);
+	auto& s = slots[current_slot];
+	s.in_flight = true;
+#ifdef USING_OPENGL
+	s.fence = new nix::Fence();
+#endif
+	slot_ready_for_dispatch = false;
 }
 
+// collect the oldest histogram (without waiting) and prepare its slot for this frame
 void LightMeter::read() {
 	PerformanceMonitor::begin(ch_prepare);
 
-	// TODO barriers...
-	gpu_flush();
-	if (histogram.num == NBINS) {
+	int next = (current_slot + 1) % NUM_SLOTS;
+	auto& s = slots[next];
+	if (s.in_flight) {
+		if (!is_slot_ready(next)) {
+			// gpu too far behind, skip measuring this frame
+			slot_ready_for_dispatch = false;
+			PerformanceMonitor::end(ch_prepare);
+			return;
+		}
 #ifdef USING_VULKAN
-		void* p = buf->map();
+		void* p = s.buf->map();
 		memcpy(&histogram[0], p, NBINS*sizeof(int));
-		buf->unmap();
+		s.buf->unmap();
 #else
-		buf->read(&histogram[0], NBINS*sizeof(int));
+		s.buf->read(&histogram[0], NBINS*sizeof(int));
 #endif
 		//msg_write(str(histogram));
 
@@ -51,27 +83,24 @@ void LightMeter::read() {
 			}
 		}
 		brightness = pow(2.0f, ((float)ii / (float)NBINS) * 20.0f - 10.0f);
+		s.in_flight = false;
 	}
 
-	histogram.resize(NBINS);
-	memset(&histogram[0], 0, NBINS * sizeof(int));
+	Array<int> zero;
+	zero.resize(NBINS);
+	memset(&zero[0], 0, NBINS * sizeof(int));
 #ifdef USING_VULKAN
-	buf->update(&histogram[0]);
+	s.buf->update(&zero[0]);
 #else
-	buf->update(&histogram[0], NBINS * sizeof(int));
+	s.buf->update(&zero[0], NBINS * sizeof(int));
 #endif
+	current_slot = next;
+	buf = s.buf.get();
+	bind_storage_buffer(1, buf);
+	slot_ready_for_dispatch = true;
 	PerformanceMonitor::end(ch_prepare);
 }
 
-void LightMeter::setup() {
-	int pp[2] = {texture->width, texture->height};
-#ifdef USING_VULKAN
-	params->update(&pp);
-#else
-	params->update(&pp, sizeof(pp));
-#endif
-}
-
 void LightMeter::adjust_camera(Camera *cam) {
 	float exposure = clamp((float)pow(1.0f / brightness, 0.8f), cam->auto_exposure_min, cam->auto_exposure_max);
 	if (exposure > cam->exposure)
@@ -10,18 +10,37 @@
 
 class ComputeTask;
 class Camera;
+#ifdef USING_OPENGL
+namespace nix {
+	class Fence;
+}
+#endif
 
 class LightMeter : public ComputeTask {
 public:
 	LightMeter(ResourceManager* resource_manager, Texture* tex);
-	UniformBuffer* params;
-	ShaderStorageBuffer* buf;
+	~LightMeter() override;
+	ShaderStorageBuffer* buf; // current slot
 	Array<int> histogram;
 	float brightness;
 	Texture* texture;
 	void read();
-	void setup();
 	void adjust_camera(Camera* cam);
+	void render(const RenderParams& params) override;
+
+	// readback ring: histograms are read a few frames after being measured
+	static constexpr int NUM_SLOTS = 3;
+	struct Slot {
+		owned<ShaderStorageBuffer> buf;
+		bool in_flight = false;
+#ifdef USING_OPENGL
+		owned<nix::Fence> fence;
+#endif
+	};
+	Slot slots[NUM_SLOTS];
+	int current_slot = 0;
+	bool slot_ready_for_dispatch = false;
+	bool is_slot_ready(int index) const;
 };
 
 
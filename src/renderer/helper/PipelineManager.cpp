@@ -74,7 +74,7 @@ GraphicsPipeline *get_gui(Shader *s, RenderPass *rp, const string &format) {
 	if (ob_pipelines_gui.contains(s))
 		return ob_pipelines_gui[s];
 	msg_write("NEW PIPELINE GUI");
-	auto p = new GraphicsPipeline(s, rp, 0, "triangles", "3f,3f,2f");
+	auto p = new GraphicsPipeline(s, rp, 0, "triangles", format);
 	p->set_blend(Alpha::SOURCE_ALPHA, Alpha::SOURCE_INV_ALPHA);
 	p->set_z(false, false);
 	p->rebuild();
@@ -26,22 +26,199 @@
 #include "../../y/EngineData.h"
 #include "../../Config.h"
 #include "../../graphics-impl.h"
+#include <lib/os/time.h>
+#include <lib/math/random.h>
+
+static const int MAX_RT_MESHES = 512;
+
+// squares [x0,x1) x [z0,z1) of the full resolution grid
+struct TerrainBvhBlock {
+	int x0, x1, z0, z1;
+	int version;
+};
+
+// TERRAIN_BVH_BLOCK x TERRAIN_BVH_BLOCK chunks per bvh, edits only refit the blocks they touch
+static const int TERRAIN_BVH_BLOCK = 4;
+
+static Array<TerrainBvhBlock> terrain_bvh_blocks(Terrain *t) {
+	if (t->chunks.num == 0)
+		return {{0, t->num_x, 0, t->num_z, t->version}};
+	Array<TerrainBvhBlock> blocks;
+	const int size = TERRAIN_CHUNK_SIZE * TERRAIN_BVH_BLOCK;
+	for (int bx=0; bx<t->num_chunks_x; bx+=TERRAIN_BVH_BLOCK)
+		for (int bz=0; bz<t->num_chunks_z; bz+=TERRAIN_BVH_BLOCK) {
+			TerrainBvhBlock b;
+			b.x0 = bx * TERRAIN_CHUNK_SIZE;
+			b.z0 = bz * TERRAIN_CHUNK_SIZE;
+			b.x1 = min(b.x0 + size, t->num_x);
+			b.z1 = min(b.z0 + size, t->num_z);
+			// chunk versions only grow
+			b.version = 0;
+			for (int cx=bx; cx<min(bx + TERRAIN_BVH_BLOCK, t->num_chunks_x); cx++)
+				for (int cz=bz; cz<min(bz + TERRAIN_BVH_BLOCK, t->num_chunks_z); cz++)
+					b.version += t->chunk(cx, cz).version;
+			blocks.add(b);
+		}
+	return blocks;
+}
+
+// (acd), (adb) like Terrain
+static Array<int> terrain_triangle_index(Terrain *t, const TerrainBvhBlock &b) {
+	Array<int> index;
+	int nz = t->num_z + 1;
+	for (int i=b.x0; i<b.x1; i++)
+		for (int j=b.z0; j<b.z1; j++) {
+			int a = i * nz + j;
+			int b = a + nz;
+			int c = a + 1;
+			int d = b + 1;
+			index.add(a);	index.add(c);	index.add(d);
+			index.add(a);	index.add(d);	index.add(b);
+		}
+	return index;
+}
+
+RayTracingData::RayTracingData() {
+	mode = Mode::CPU;
+	vtrace_on_cpu = true;
+}
+
+void RayTracingData::update_bvh() {
+	auto& models = ComponentManager::get_list_family<Model>();
+	auto& terrains = ComponentManager::get_list_family<Terrain>();
+
+	bvh.begin();
+	for (auto m: models) {
+		m->update_matrix();
+		for (int i=0; i<m->material.num; i++) {
+			if (bvh.instances.num >= MAX_RT_MESHES)
+				break;
+			// meshes are shared between models, so are their bvhs (rebuilt when update_vb() changes the generation)
+			auto mesh = m->mesh[0].get();
+			bvh.add_instance(mesh, i, mesh->generation, m->_matrix, [mesh, i] (BvhMesh &b) {
+				b.build(mesh->vertex, mesh->sub[i].triangle_index, mesh->sub[i].normal);
+			});
+		}
+	}
+	for (auto *t: terrains) {
+		auto blocks = terrain_bvh_blocks(t);
+		for (int i=0; i<blocks.num; i++) {
+			if (bvh.instances.num >= MAX_RT_MESHES)
+				break;
+			// height edits keep the triangles, refitting is enough
+			auto block = blocks[i];
+			bvh.add_instance(t, i, block.version, mat4::translation(t->owner->pos), [t, block] (BvhMesh &b) {
+				b.refit(t->vertex, terrain_triangle_index(t, block), {});
+			});
+		}
+	}
+	bvh.end();
+}
+
+Array<RayReply> RayTracingData::trace_cpu(const Array<RayRequest>& requests) const {
+	// p1 is the direction, like in raytracing.shader
+	Array<vec3> p0, dir;
+	p0.resize(requests.num);
+	dir.resize(requests.num);
+	for (int i=0; i<requests.num; i++) {
+		p0[i] = requests[i].p0;
+		dir[i] = requests[i].p1;
+	}
+
+	Array<BvhHit> hits;
+	bvh.trace(p0, dir, 1000000.0f, hits);
+
+	Array<RayReply> replies;
+	replies.resize(requests.num);
+	for (int i=0; i<requests.num; i++) {
+		auto &h = hits[i];
+		RayReply r = {};
+		if (h.index >= 0) {
+			r.p = h.p;
+			r.n = h.n;
+			r.f = h.f;
+			r.g = h.g;
+			r.t = h.t;
+			r.index = h.index;
+			r.mesh = h.instance;
+		} else {
+			r.index = r.mesh = r._a = r._b = -1;
+		}
+		replies[i] = r;
+	}
+	return replies;
+}
+
+float rt_benchmark(SceneView& scene_view, int num_rays) {
+	auto rtd = scene_view.ray_tracing_data;
+	if (!rtd) {
+		msg_error("rt_benchmark: rt_setup() missing");
+		return 0;
+	}
+	rtd->update_bvh();
+
+	vec3 pos = v_0;
+	quaternion ang = quaternion::ID;
+	if (scene_view.cam) {
+		pos = scene_view.cam->owner->pos;
+		ang = scene_view.cam->owner->ang;
+	}
+
+	// incoherent: random directions
+	Random r;
+	Array<RayRequest> requests;
+	requests.resize(num_rays);
+	for (auto &q: requests) {
+		q.p0 = pos;
+		q.p1 = r.dir();
+	}
+	os::Timer timer;
+	auto replies = rtd->trace_cpu(requests);
+	float dt_random = timer.get();
+
+	// coherent: a grid through the camera's view
+	int w = max((int)sqrt((float)num_rays), 1);
+	for (int i=0; i<num_rays; i++) {
+		requests[i].p0 = pos;
+		requests[i].p1 = ang * vec3((float)(i % w) / (float)w - 0.5f, 0.5f - (float)(i / w) / (float)w, 1).normalized();
+	}
+	timer.reset();
+	replies = rtd->trace_cpu(requests);
+	float dt_view = timer.get();
+
+	int num_hits = 0;
+	for (auto &rr: replies)
+		if (rr.index >= 0)
+			num_hits ++;
+	float rate = (float)num_rays / max(dt_random, 1e-9f);
+	msg_write(format("cpu rays: %d instances, %d rays   random: %.2f Mrays/s   view: %.2f Mrays/s (%d hits)",
+			rtd->bvh.instances.num, num_rays, rate / 1e6f, (float)num_rays / max(dt_view, 1e-9f) / 1e6f, num_hits));
+	return rate;
+}
+
 #ifdef USING_VULKAN
 
-static const int MAX_RT_TRIAS = 65536;
-static const int MAX_RT_MESHES = 1024;
 static const int MAX_RT_REQUESTS = 4096*16;
+// the top level bvh lives in front of the mesh bvhs
+static const int MAX_RT_TOP_NODES = MAX_RT_MESHES * 2;
 
 void rt_setup(SceneView& scene_view) {
-	scene_view.ray_tracing_data = new RayTracingData(engine.window_renderer->device);
+	if (engine.window_renderer)
+		scene_view.ray_tracing_data = new RayTracingData(engine.window_renderer->device);
+	else
+		scene_view.ray_tracing_data = new RayTracingData();
 }
 
 void rt_update_frame(SceneView& scene_view) {
-	scene_view.ray_tracing_data->update_frame();
+	if (scene_view.ray_tracing_data->mode == RayTracingData::Mode::CPU)
+		scene_view.ray_tracing_data->update_bvh();
+	else
+		scene_view.ray_tracing_data->update_frame();
 }
 
-RayTracingData::RayTracingData(vulkan::Device *device) {
+RayTracingData::RayTracingData(vulkan::Device *_device) {
 	auto resource_manager = engine.resource_manager;
+	device = _device;
 
 	/*if (device->has_rtx() and config.allow_rtx)
 		mode = Mode::RTX;
@@ -49,7 +226,8 @@ RayTracingData::RayTracingData(vulkan::Device *device) {
 	if (device->has_compute())
 		mode = Mode::COMPUTE;
 	else
-		throw Exception("no compute shader support");
+		mode = Mode::CPU;
+	vtrace_on_cpu = (mode == Mode::CPU) or (config.get_str("raytracing.vtrace", "gpu") == "cpu");
 
 	buffer_meshes = new UniformBuffer(sizeof(MeshDescription) * MAX_RT_MESHES);
 	buffer_requests = new UniformBuffer(sizeof(RayRequest) * MAX_RT_REQUESTS);
@@ -74,15 +252,22 @@ RayTracingData::RayTracingData(vulkan::Device *device) {
 	} else if (mode == Mode::COMPUTE) {
 		//msg_error("COMPUTE!!!");
 
-		compute.pool = new vulkan::DescriptorPool("image:1,storage-buffer:1,buffer:8,sampler:1", 1);
+		buffer_bvh_nodes = new vulkan::StorageBuffer(sizeof(BvhNode) * MAX_RT_TOP_NODES * 2);
+		buffer_bvh_triangles = new vulkan::StorageBuffer(sizeof(BvhTriangle) * 1024);
+		buffer_bvh_instances = new vulkan::StorageBuffer(sizeof(mat4) * MAX_RT_MESHES);
 
+		compute.pool = new vulkan::DescriptorPool("image:1,storage-buffer:4,buffer:8,sampler:1", 1);
+
+		resource_manager->load_shader_module("compute/module-bvh.shader");
 		auto shader = resource_manager->load_shader("compute/raytracing.shader");
 		compute.pipeline = new vulkan::ComputePipeline(shader.get());
-		compute.dset = compute.pool->create_set("buffer,buffer,storage-buffer");
+		compute.dset = compute.pool->create_set("buffer,buffer,storage-buffer,storage-buffer,storage-buffer,storage-buffer");
 		compute.dset->set_uniform_buffer(0, buffer_requests.get());
 		compute.dset->set_uniform_buffer(1, buffer_meshes.get());
 		compute.dset->set_storage_buffer(2, buffer_reply.get());
+		bind_bvh(compute.dset);
 		compute.dset->update();
+		compute.bvh_buffer_version = bvh_buffer_version;
 
 		compute.command_buffer = device->command_pool->create_command_buffer();
 		compute.fence = new Fence(device);
@@ -96,14 +281,19 @@ void RayTracingData::update_frame() {
 	auto& terrains = ComponentManager::get_list_family<Terrain>();
 
 
+	if (mode == Mode::COMPUTE or vtrace_on_cpu)
+		update_bvh();
+
 	Array<MeshDescription> meshes;
 
 	for (auto m: models) {
 		m->update_matrix();
 		for (int i=0; i<m->material.num; i++) {
+			if (meshes.num >= MAX_RT_MESHES)
+				break;
 			auto material = m->material[i];
 
-			MeshDescription md;
+			MeshDescription md = {};
 			md.matrix = m->_matrix;
 			md.num_triangles = m->mesh[0]->sub[i].triangle_index.num / 3;
 			md.albedo = material->albedo.with_alpha(material->roughness);
@@ -116,16 +306,45 @@ void RayTracingData::update_frame() {
 	for (auto *t: terrains) {
 		auto o = t->owner;
 
-		MeshDescription md;
-		md.matrix = mat4::translation(o->pos);
-		md.albedo = t->material->albedo.with_alpha(t->material->roughness);
-		md.emission = t->material->emission.with_alpha(t->material->metal);
-		md.num_triangles = t->vertex_buffer->output_count / 3;
-		md.address_vertices = t->vertex_buffer->vertex_buffer.get_device_address();
-		meshes.add(md);
+		if (mode == Mode::COMPUTE) {
+			// one bvh per block of the full resolution grid (same order as in update_bvh())
+			for (auto &b: terrain_bvh_blocks(t)) {
+				if (meshes.num >= MAX_RT_MESHES)
+					break;
+				MeshDescription md = {};
+				md.matrix = mat4::translation(o->pos);
+				md.albedo = t->material->albedo.with_alpha(t->material->roughness);
+				md.emission = t->material->emission.with_alpha(t->material->metal);
+				md.num_triangles = (b.x1 - b.x0) * (b.z1 - b.z0) * 2;
+				meshes.add(md);
+			}
+			continue;
+		}
+
+		// one mesh per chunk
+		for (auto &c: t->chunks) {
+			if (!c.vertex_buffer)
+				continue;
+			MeshDescription md;
+			md.matrix = mat4::translation(o->pos);
+			md.albedo = t->material->albedo.with_alpha(t->material->roughness);
+			md.emission = t->material->emission.with_alpha(t->material->metal);
+			md.num_triangles = c.vertex_buffer->output_count / 3;
+			md.address_vertices = c.vertex_buffer->vertex_buffer.get_device_address();
+			meshes.add(md);
+		}
 	}
 
 
+	if (mode == Mode::COMPUTE) {
+		for (int i=0; i<meshes.num; i++) {
+			auto mesh = bvh.meshes[bvh.instances[i].mesh];
+			meshes[i].bvh_root = MAX_RT_TOP_NODES + mesh->node_offset;
+			meshes[i].bvh_triangles = mesh->triangle_offset;
+		}
+		update_bvh_buffers();
+	}
+
 	buffer_meshes->update_array(meshes, 0);
 
 	num_meshes = meshes.num;
@@ -141,11 +360,13 @@ void RayTracingData::update_frame() {
 			for (auto m: models) {
 				m->update_matrix();
 				for (int i=0; i<m->material.num; i++)
-					matrices.add(m->owner->get_matrix().transpose());
+					matrices.add(m->owner->get_matrix_cached().transpose());
 			}
 			for (auto *t: terrains) {
 				auto o = t->owner;
-				matrices.add(mat4::translation(o->pos).transpose());
+				for (auto &c: t->chunks)
+					if (c.vertex_buffer)
+						matrices.add(mat4::translation(o->pos).transpose());
 			}
 			rtx.tlas->update_top(rtx.blas, matrices);
 
@@ -167,26 +388,77 @@ void RayTracingData::update_frame() {
 					auto vb = m->mesh[0]->sub[i].vertex_buffer;
 					make_indexed(vb);
 					rtx.blas.add(vulkan::AccelerationStructure::create_bottom(device, vb));
-					matrices.add(m->owner->get_matrix().transpose());
+					matrices.add(m->owner->get_matrix_cached().transpose());
 				}
 			}
 
 			for (auto *t: terrains) {
 				auto o = t->owner;
-				make_indexed(t->vertex_buffer.get());
-				rtx.blas.add(vulkan::AccelerationStructure::create_bottom(device, t->vertex_buffer.get()));
-				matrices.add(mat4::translation(o->pos).transpose());
+				for (auto &c: t->chunks) {
+					if (!c.vertex_buffer)
+						continue;
+					make_indexed(c.vertex_buffer);
+					rtx.blas.add(vulkan::AccelerationStructure::create_bottom(device, c.vertex_buffer));
+					matrices.add(mat4::translation(o->pos).transpose());
+				}
 			}
 
 			rtx.tlas = vulkan::AccelerationStructure::create_top(device, rtx.blas, matrices);
 		}
 
-	} else if (mode == Mode::COMPUTE) {
 	}
 }
 
+void RayTracingData::update_bvh_buffers() {
+	// grow (with some headroom), the old buffers might still be in use
+	auto reserve = [this] (owned<ShaderStorageBuffer> &buf, int size) {
+		if (buf and (int)buf->size >= size)
+			return;
+		device->wait_idle();
+		buf = new vulkan::StorageBuffer(size + size / 2);
+		bvh_buffer_version ++;
+	};
+
+	if (bvh.meshes_changed) {
+		Array<BvhNode> nodes;
+		Array<BvhTriangle> triangles;
+		bvh.flatten_meshes(nodes, triangles);
+		reserve(buffer_bvh_nodes, sizeof(BvhNode) * (MAX_RT_TOP_NODES + nodes.num));
+		reserve(buffer_bvh_triangles, sizeof(BvhTriangle) * ::max(triangles.num, 1));
+		if (nodes.num > 0)
+			buffer_bvh_nodes->update_array(nodes, sizeof(BvhNode) * MAX_RT_TOP_NODES);
+		if (triangles.num > 0)
+			buffer_bvh_triangles->update_array(triangles);
+		bvh.meshes_changed = false;
+	}
+
+	Array<BvhNode> top;
+	bvh.flatten_top(top);
+	Array<mat4> inverse;
+	for (auto &inst: bvh.instances)
+		inverse.add(inst.inverse);
+	if (top.num > 0)
+		buffer_bvh_nodes->update_array(top);
+	if (inverse.num > 0)
+		buffer_bvh_instances->update_array(inverse);
+
+	if (compute.bvh_buffer_version != bvh_buffer_version) {
+		bind_bvh(compute.dset);
+		compute.dset->update();
+		compute.bvh_buffer_version = bvh_buffer_version;
+	}
+}
+
+void RayTracingData::bind_bvh(DescriptorSet *dset) const {
+	dset->set_storage_buffer(3, buffer_bvh_nodes.get());
+	dset->set_storage_buffer(4, buffer_bvh_triangles.get());
+	dset->set_storage_buffer(5, buffer_bvh_instances.get());
+}
+
 //Array<base::optional<RayHitInfo>>
 Array<RayReply> vtrace(SceneView& scene_view, const Array<RayRequest>& requests) {
+	if (scene_view.ray_tracing_data->vtrace_on_cpu)
+		return scene_view.ray_tracing_data->trace_cpu(requests);
 	if (requests.num > MAX_RT_REQUESTS) {
 		msg_error("too many rt requests");
 		return {};
@@ -201,6 +473,7 @@ Array<RayReply> vtrace(SceneView& scene_view, const Array<RayRequest>& requests)
 	cb->set_bind_point(vulkan::PipelineBindPoint::COMPUTE);
 	cb->bind_pipeline(scene_view.ray_tracing_data->compute.pipeline);
 	cb->bind_descriptor_set(0, scene_view.ray_tracing_data->compute.dset);
+	cb->push_constant(0, sizeof(int), &scene_view.ray_tracing_data->num_meshes);
 	int n = 1 + (requests.num - 1) / 256;
 	cb->dispatch(n,1,1);
 	cb->end();
@@ -221,15 +494,17 @@ Array<RayReply> vtrace(SceneView& scene_view, const Array<RayRequest>& requests)
 }
 #else
 
+// ray queries only
 void rt_setup(SceneView& scene_view) {
-	msg_error("raytracing only supported on vulkan!");
+	scene_view.ray_tracing_data = new RayTracingData();
 }
 
 void rt_update_frame(SceneView& scene_view) {
+	scene_view.ray_tracing_data->update_bvh();
 }
 
 Array<RayReply> vtrace(SceneView& scene_view, const Array<RayRequest>& requests) {
-	return {};
+	return scene_view.ray_tracing_data->trace_cpu(requests);
 }
 #endif
 
@@ -13,9 +13,12 @@
 #include <lib/math/mat4.h>
 #include <lib/image/color.h>
 #include "../../graphics-fwd.h"
+#include "Bvh.h"
 
 class Model;
 struct SceneView;
+struct RayRequest;
+struct RayReply;
 
 
 struct RayTracingData {
@@ -25,12 +28,32 @@ struct RayTracingData {
 	owned<UniformBuffer> buffer_requests;
 	owned<ShaderStorageBuffer> buffer_reply;
 
+	// cpu built bvhs, for trace_cpu() and (flattened) for module-bvh.shader in COMPUTE mode
+	BvhScene bvh;
+	owned<ShaderStorageBuffer> buffer_bvh_nodes;
+	owned<ShaderStorageBuffer> buffer_bvh_triangles;
+	owned<ShaderStorageBuffer> buffer_bvh_instances;
+	// incremented when the bvh buffers get recreated (descriptor sets need an update)
+	int bvh_buffer_version = 0;
+
 	enum class Mode {
 		NONE,
 		COMPUTE,
-		RTX
+		RTX,
+		// no gpu resources, only ray queries
+		CPU
 	} mode = Mode::NONE;
 
+	// CPU mode
+	RayTracingData();
+
+	// collects models and terrains into bvh (same order as the MeshDescriptions)
+	void update_bvh();
+	// same results as the compute shader, multi-threaded
+	Array<RayReply> trace_cpu(const Array<RayRequest>& requests) const;
+	// vtrace() uses trace_cpu() (always in CPU mode, or config raytracing.vtrace=cpu)
+	bool vtrace_on_cpu = false;
+
 	struct MeshDescription {
 		mat4 matrix;
 		color albedo;
@@ -38,14 +61,20 @@ struct RayTracingData {
 		int64 address_vertices;
 		int64 address_indices;
 		int num_triangles;
-		int _a, _b, _c;
+		// COMPUTE mode: first node/triangle of the mesh's bvh
+		int bvh_root, bvh_triangles;
+		int _c;
 	};
 
 #ifdef USING_VULKAN
 	explicit RayTracingData(vulkan::Device *_device);
 
 	void update_frame();
+	// bindings 3, 4, 5
+	void bind_bvh(DescriptorSet *dset) const;
+	void update_bvh_buffers();
 
+	vulkan::Device *device;
 
 
 	struct ComputeModeData {
@@ -54,6 +83,7 @@ struct RayTracingData {
 		ComputePipeline *pipeline;
 		CommandBuffer* command_buffer;
 		vulkan::Fence* fence;
+		int bvh_buffer_version;
 	} compute;
 
 	struct RtxModeData {
@@ -96,5 +126,8 @@ void rt_update_frame(SceneView& scene_view);
 //Array<base::optional<RayHitInfo>>
 Array<RayReply> vtrace(SceneView& scene_view, const Array<RayRequest>& requests);
 
+// cpu queries, random and camera rays, prints and returns rays per second
+float rt_benchmark(SceneView& scene_view, int num_rays);
+
 
 #endif //RAYTRACING_H
@@ -24,6 +24,7 @@
 #include "../../helper/ResourceManager.h"
 #include <graphics-impl.h>
 #include <world/Camera.h>
+#include <world/Light.h>
 #include <world/Model.h>
 #include <world/World.h>
 #include <y/EngineData.h>
@@ -31,6 +32,7 @@
 #include <y/ComponentManager.h>
 #include <Config.h>
 #include <lib/os/msg.h>
+#include <lib/base/sort.h>
 
 
 HDRResolver *create_hdr_resolver(Camera *cam, Texture* tex, DepthBuffer* depth) {
@@ -68,6 +70,7 @@ RenderPath::RenderPath(RenderPathType _type, Camera* _cam) : Renderer("path") {
 	resource_manager->load_shader_module("module-vertex-lines.shader");
 	resource_manager->load_shader_module("module-vertex-points.shader");
 	resource_manager->load_shader_module("module-vertex-fx.shader");
+	resource_manager->load_shader_module("module-vertex-heightfield.shader");
 	resource_manager->load_shader_module("module-geometry-lines.shader");
 	resource_manager->load_shader_module("module-geometry-points.shader");
 
@@ -77,6 +80,11 @@ RenderPath::RenderPath(RenderPathType _type, Camera* _cam) : Renderer("path") {
 	cube_map_source = new CubeMapSource;
 	cube_map_source->owner = e;
 	cube_map_source->cube_map = new CubeMap(cube_map_source->resolution, "rgba:i8");
+	cube_map_faces_per_frame = config.get_int("cubemap.faces_per_frame", 1);
+	cube_map_cache_static = config.get_bool("cubemap.cache_static", true);
+#ifndef USING_OPENGL
+	cube_map_cache_static = false;
+#endif
 
 	scene_view.cube_map = cube_map_source->cube_map;
 }
@@ -89,8 +97,10 @@ void RenderPath::prepare_basics() {
 
 void RenderPath::create_shadow_renderer() {
 	shadow_renderer = new ShadowRenderer(scene_view.cam);
-	scene_view.shadow_maps.add(shadow_renderer->cascades[0].depth_buffer);
-	scene_view.shadow_maps.add(shadow_renderer->cascades[1].depth_buffer);
+	for (int i=0; i<shadow_renderer->num_cascades; i++) {
+		scene_view.shadow_maps.add(shadow_renderer->cascades[i].depth_buffer);
+		scene_view.shadow_cascade_scale[i] = shadow_renderer->cascades[i].scale;
+	}
 	add_child(shadow_renderer.get());
 }
 
@@ -105,7 +115,7 @@ void RenderPath::create_shadow_renderer() {
 
 
 
-void RenderPath::render_into_cubemap(CubeMapSource& source) {
+static bool create_cube_map_targets(CubeMapSource& source) {
 	if (!source.depth_buffer)
 		source.depth_buffer = new DepthBuffer(source.resolution, source.resolution, "ds:u24i8");
 	if (!source.cube_map)
@@ -122,7 +132,7 @@ void RenderPath::render_into_cubemap(CubeMapSource& source) {
 				source.frame_buffer[i]->update_x(source.render_pass.get(), {source.cube_map.get(), source.depth_buffer.get()}, i);
 			} catch(Exception &e) {
 				msg_error(e.message());
-				return;
+				return false;
 			}
 #else
 			source.frame_buffer[i] = new FrameBuffer();
@@ -130,34 +140,121 @@ void RenderPath::render_into_cubemap(CubeMapSource& source) {
 				source.frame_buffer[i]->update_x({source.cube_map.get(), source.depth_buffer.get()}, i);
 			} catch(Exception &e) {
 				msg_error(e.message());
-				return;
+				return false;
 			}
 #endif
 		}
-	Entity o(source.owner->pos, quaternion::ID);
+	return true;
+}
+
+static quaternion cube_map_face_orientation(int face) {
+	if (face == 0)
+		return quaternion::rotation(vec3(0,pi/2,0));
+	if (face == 1)
+		return quaternion::rotation(vec3(0,-pi/2,0));
+	if (face == 2)
+		return quaternion::rotation(vec3(-pi/2,pi,pi));
+	if (face == 3)
+		return quaternion::rotation(vec3(pi/2,pi,pi));
+	if (face == 5)
+		return quaternion::rotation(vec3(0,pi,0));
+	return quaternion::ID;
+}
+
+static void create_cube_map_face_renderers(CubeMapSource& source, int face, SceneView& scene_view, RenderPathType type, bool cache_static) {
+	using Flags = GeometryRenderer::Flags;
+	auto& f = source.faces[face];
+	f.geo_renderer = new GeometryRenderer(type, scene_view);
+	if (!cache_static) {
+		f.geo_renderer->flags = Flags::ALLOW_OPAQUE | Flags::ALLOW_TRANSPARENT | Flags::ALLOW_SKYBOXES | Flags::ALLOW_CLEAR_COLOR;
+		return;
+	}
+	f.geo_renderer->flags = Flags::ALLOW_OPAQUE | Flags::ALLOW_TRANSPARENT | Flags::DYNAMIC_ONLY;
+
+	f.static_geo_renderer = new GeometryRenderer(type, scene_view);
+	f.static_geo_renderer->flags = Flags::ALLOW_OPAQUE | Flags::ALLOW_TRANSPARENT | Flags::ALLOW_SKYBOXES | Flags::ALLOW_CLEAR_COLOR | Flags::STATIC_ONLY;
+	// same formats as the cube map and its depth buffer, for copying
+	shared tex = new Texture(source.resolution, source.resolution, "rgba:i8");
+	shared<Texture> depth = new DepthBuffer(source.resolution, source.resolution, "ds:u24i8");
+	f.static_renderer = new TextureRenderer(format("cube%d", face), {tex, depth});
+	f.static_renderer->add_child(f.static_geo_renderer.get());
+}
+
+void RenderPath::render_into_cubemap_face(const RenderParams& params, CubeMapSource& source, int face) {
+	if (!create_cube_map_targets(source))
+		return;
+	Entity o(source.owner->pos, cube_map_face_orientation(face));
 	Camera cam;
 	cam.min_depth = source.min_depth;
 	cam.owner = &o;
 	cam.fov = pi/2;
-	for (int i=0; i<6; i++) {
-		if (i == 0)
-			o.ang = quaternion::rotation(vec3(0,pi/2,0));
-		if (i == 1)
-			o.ang = quaternion::rotation(vec3(0,-pi/2,0));
-		if (i == 2)
-			o.ang = quaternion::rotation(vec3(-pi/2,pi,pi));
-		if (i == 3)
-			o.ang = quaternion::rotation(vec3(pi/2,pi,pi));
-		if (i == 4)
-			o.ang = quaternion::rotation(vec3(0,0,0));
-		if (i == 5)
-			o.ang = quaternion::rotation(vec3(0,pi,0));
-		//prepare_lights(&cam);
-		render_into_texture(source.frame_buffer[i].get(), &cam, source.rvd[i]);
+	cam.update_matrices(1.0f);
+
+	cube_map_scene_view.cam = &cam;
+	cube_map_scene_view.lights = scene_view.lights;
+	cube_map_scene_view.shadow_index = -1;
+
+	auto& f = source.faces[face];
+	if (!f.geo_renderer)
+		create_cube_map_face_renderers(source, face, cube_map_scene_view, type, cube_map_cache_static);
+	for (auto r: {f.geo_renderer.get(), f.static_geo_renderer.get()})
+		if (r) {
+			r->cur_rvd.set_projection_matrix(cam.m_projection);
+			r->cur_rvd.set_view_matrix(cam.m_view);
+			r->cur_rvd.update_lights();
+		}
+
+	auto fb = source.frame_buffer[face].get();
+	auto p = params.with_target(fb);
+	p.desired_aspect_ratio = 1.0f;
+
+#ifdef USING_OPENGL
+	if (f.static_renderer) {
+		if (!f.static_valid or f.static_signature != cube_map_static_signature or f.static_pos != source.owner->pos or f.static_min_depth != source.min_depth) {
+			auto static_params = params.with_target(f.static_renderer->frame_buffer.get());
+			static_params.desired_aspect_ratio = 1.0f;
+			f.static_geo_renderer->prepare(static_params);
+			f.static_renderer->render(static_params);
+			f.static_valid = true;
+			f.static_signature = cube_map_static_signature;
+			f.static_pos = source.owner->pos;
+			f.static_min_depth = source.min_depth;
+		}
+		// dynamic geometry on top of the cached layer
+		auto static_fb = f.static_renderer->frame_buffer.get();
+		nix::copy_texture_to_cube_face(source.cube_map.get(), face, static_fb->color_attachments[0].get());
+		nix::copy_texture(source.depth_buffer.get(), static_fb->depth_buffer.get());
 	}
+
+	f.geo_renderer->prepare(p);
+	nix::bind_frame_buffer(fb);
+	nix::set_viewport(fb->area());
+	f.geo_renderer->draw(p);
+#else
+	f.geo_renderer->prepare(p);
+	p.render_pass = source.render_pass.get();
+	auto cb = params.command_buffer;
+	cb->begin_render_pass(source.render_pass.get(), fb);
+	cb->set_viewport(fb->area());
+	cb->set_bind_point(vulkan::PipelineBindPoint::GRAPHICS);
+	f.geo_renderer->draw(p);
+	cb->end_render_pass();
+#endif
+
+	// the lights are shared with the main view
+	for (auto l: scene_view.lights)
+		l->update(scene_view.cam, global_shadow_box_size, true);
+	cube_map_scene_view.cam = nullptr;
 	cam.owner = nullptr;
 }
 
+void RenderPath::render_into_cubemap(const RenderParams& params, CubeMapSource& source) {
+	if (cube_map_cache_static)
+		cube_map_static_signature = ShadowRenderer::get_static_signature();
+	for (int i=0; i<6; i++)
+		render_into_cubemap_face(params, source, i);
+}
+
 
 void RenderPath::suggest_cube_map_pos() {
 	if (!cube_map_source)
@@ -184,21 +281,101 @@ void RenderPath::suggest_cube_map_pos() {
 		}
 }
 
+// probes the camera can see (or is inside of) first, then by distance
+//   waiting probes slowly gain priority, so far away ones still get their turn
+float RenderPath::cube_map_priority(const CubeMapSource& source, float aspect_ratio) const {
+	float radius = max(source.min_depth, 1.0f);
+	vec3 d = source.owner->pos - scene_view.cam->owner->pos;
+	float dist = d.length();
+	float p = radius / (radius + dist);
+
+	// fov is vertical, the cone around the frustum reaches its corners
+	float half_angle = atan(tan(scene_view.cam->fov / 2) * sqrt(1 + aspect_ratio * aspect_ratio));
+	vec3 dir = scene_view.cam->owner->ang * vec3::EZ;
+	bool visible = (dist < radius) or (vec3::dot(d, dir) > dist * cos(half_angle) - radius);
+	if (!visible)
+		p *= 0.25f;
+
+	float waiting = (float)max(source.counter - source.update_rate, 0);
+	return p * (1.0f + waiting * 0.1f);
+}
+
 void RenderPath::render_cubemaps(const RenderParams &params) {
 	suggest_cube_map_pos();
-	auto cube_map_sources = ComponentManager::get_list<CubeMapSource>();
-	cube_map_sources.add(cube_map_source);
-	for (auto& source: cube_map_sources) {
-		if (source->update_rate <= 0)
-			continue;
+
+	cube_map_queue.clear();
+	auto add = [this, &params] (CubeMapSource* source) {
 		source->counter ++;
-		if (source->counter >= source->update_rate) {
-			render_into_cubemap(*source);
-			source->counter = 0;
+		if (!source->is_due())
+			return;
+		source->priority = cube_map_priority(*source, params.desired_aspect_ratio);
+		// finish started cycles first, no mixed cube maps for longer than necessary
+		if (source->next_face > 0)
+			source->priority += 1000.0f;
+		cube_map_queue.add(source);
+	};
+	for (auto source: ComponentManager::get_list<CubeMapSource>())
+		add(source);
+	add(cube_map_source);
+	base::inplace_sort(cube_map_queue, [] (CubeMapSource* a, CubeMapSource* b) { return a->priority >= b->priority; });
+
+	if (cube_map_cache_static and cube_map_queue.num > 0)
+		cube_map_static_signature = ShadowRenderer::get_static_signature();
+
+	int budget = cube_map_faces_per_frame;
+	for (auto source: cube_map_queue) {
+		while (budget > 0) {
+			if (source->next_face == 0)
+				source->counter = 0;
+			render_into_cubemap_face(params, *source, source->next_face);
+			budget --;
+			source->next_face ++;
+			if (source->next_face >= 6) {
+				source->next_face = 0;
+				source->valid = true;
+				if (source->prefilter)
+					prefilter_cube_map(*source);
+				break;
+			}
 		}
+		if (budget <= 0)
+			break;
 	}
+	scene_view.cube_map_levels = cube_map_source->levels;
 }
 
+#ifdef USING_OPENGL
+// level k from level 0 with roughness k / (levels - 1), matching the lod in the lighting module
+void RenderPath::prefilter_cube_map(CubeMapSource& source) {
+	auto cube = source.cube_map.get();
+	if (!cube or cube->levels < 2)
+		return;
+	if (!cube_map_prefilter_shader)
+		cube_map_prefilter_shader = resource_manager->load_shader("compute/cubemap-prefilter.shader");
+	auto s = cube_map_prefilter_shader.get();
+
+	cube->set_options("minfilter=trilinear");
+	nix::bind_texture(0, cube);
+	for (int level=1; level<cube->levels; level++) {
+		int size = max(cube->width >> level, 1);
+		s->set_int("size", size);
+		s->set_float("roughness", (float)level / (float)(cube->levels - 1));
+		for (int face=0; face<6; face++) {
+			s->set_int("face", face);
+			nix::bind_image(1, cube, level, face, true);
+			s->dispatch((size + 7) / 8, (size + 7) / 8, 1);
+		}
+	}
+	nix::image_barrier();
+	source.levels = cube->levels;
+}
+#else
+// vulkan cube maps have no mip levels, nothing to prefilter into
+void RenderPath::prefilter_cube_map(CubeMapSource& source) {
+	source.levels = 1;
+}
+#endif
+
 
 
 class RenderPathComplex : public RenderPath {
@@ -278,7 +455,6 @@ public:
 			light_meter->active = hdr_resolver->cam and hdr_resolver->cam->auto_exposure;
 			if (light_meter->active) {
 				light_meter->read();
-				light_meter->setup();
 				light_meter->adjust_camera(hdr_resolver->cam);
 			}
 		}
@@ -53,13 +53,29 @@ public:
 	void create_shadow_renderer();
 
 	virtual void render_into_texture(FrameBuffer *fb, Camera *cam, RenderViewData &rvd) {};
-	void render_into_cubemap(CubeMapSource& source);
+	void render_into_cubemap(const RenderParams& params, CubeMapSource& source);
+	void render_into_cubemap_face(const RenderParams& params, CubeMapSource& source, int face);
 
 	void prepare_basics();
 	void render_cubemaps(const RenderParams& params);
 
 	CubeMapSource* cube_map_source = nullptr;
 	void suggest_cube_map_pos();
+
+	// time sliced probe updates: at most this many faces per frame, most important probes first
+	int cube_map_faces_per_frame = 1;
+	Array<CubeMapSource*> cube_map_queue;
+	float cube_map_priority(const CubeMapSource& source, float aspect_ratio) const;
+
+	// what the probes see: the main view's lights, without shadows and cube map
+	SceneView cube_map_scene_view;
+	// static geometry per face (OpenGL), see CubeMapSource::Face
+	bool cube_map_cache_static = false;
+	int64 cube_map_static_signature = 0;
+
+	// ggx prefiltered mip levels (OpenGL)
+	void prefilter_cube_map(CubeMapSource& source);
+	shared<Shader> cube_map_prefilter_shader;
 };
 
 WorldRenderer *create_world_renderer(SceneView& scene_view, RenderPathType type);
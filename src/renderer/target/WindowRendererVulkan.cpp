@@ -71,6 +71,7 @@ bool SurfaceRendererVulkan::start_frame() {
 	auto f = wait_for_frame_fences[image_index];
 	f->wait();
 	f->reset();
+	device->frame_allocator->next_frame();
 
 	command_buffers[image_index]->begin();
 
@@ -159,16 +159,27 @@ void WorldRendererDeferred::render_out_from_gbuffer(FrameBuffer *source, const R
 		data.dict_set("eye_pos", vec3_to_any(scene_view.cam->owner->pos)); // NAH
 	data.dict_set("num_lights", scene_view.lights.num);
 	data.dict_set("shadow_index", scene_view.shadow_index);
+	data.dict_set("cube_map_levels", scene_view.cube_map_levels);
+	data.dict_set("num_shadow_cascades", scene_view.shadow_maps.num);
+	Any scales = Any::EmptyList;
+	for (int i=0; i<MAX_SHADOW_CASCADES; i++)
+		scales.list_set(i, scene_view.shadow_cascade_scale[i]);
+	data.dict_set("shadow_cascade_scale", scales);
 	data.dict_set("ambient_occlusion_radius", config.ambient_occlusion_radius);
 	out_renderer->bind_uniform_buffer(13, ssao_sample_buffer);
 
 	auto& rvd = geo_renderer->cur_rvd;
 	out_renderer->bind_uniform_buffer(1, rvd.ubo_light.get());
 	auto tex = weak(gbuffer_textures);
-	tex.add(scene_view.shadow_maps[0]);
-	tex.add(scene_view.shadow_maps[1]);
 	for (int i=0; i<tex.num; i++)
 		out_renderer->bind_texture(i, tex[i]);
+	if (scene_view.shadow_maps.num > 0) {
+		// every element needs a texture, repeat the outermost cascade
+		Array<Texture*> shadow_maps;
+		for (int i=0; i<MAX_SHADOW_CASCADES; i++)
+			shadow_maps.add(scene_view.shadow_maps[min(i, scene_view.shadow_maps.num - 1)]);
+		out_renderer->bind_texture_array(BINDING_SHADOW, shadow_maps);
+	}
 
 	float resolution_scale_x = 1.0f;
 	data.dict_set("resolution_scale:0", vec2_to_any(vec2(resolution_scale_x, resolution_scale_x)));
@@ -64,15 +64,17 @@ WorldRendererVulkanRayTracing::WorldRendererVulkanRayTracing(vulkan::Device *_de
 	} else if (mode == Mode::COMPUTE) {
 		msg_error("COMPUTE!!!");
 
-		compute.pool = new vulkan::DescriptorPool("image:1,storage-buffer:1,buffer:8,sampler:1", 1);
+		compute.pool = new vulkan::DescriptorPool("image:1,storage-buffer:3,buffer:8,sampler:1", 1);
 
 		auto shader = resource_manager->load_shader("compute/pathtracing.shader");
 		compute.pipeline = new vulkan::ComputePipeline(shader.get());
-		compute.dset = compute.pool->create_set("image,buffer,buffer");
+		compute.dset = compute.pool->create_set("image,buffer,buffer,storage-buffer,storage-buffer,storage-buffer");
 		compute.dset->set_storage_image(0, offscreen_image);
 		compute.dset->set_uniform_buffer(1, scene_view.ray_tracing_data->buffer_meshes.get());
 		compute.dset->set_uniform_buffer(2, rvd.ubo_light.get());
+		scene_view.ray_tracing_data->bind_bvh(compute.dset);
 		compute.dset->update();
+		compute.bvh_buffer_version = scene_view.ray_tracing_data->bvh_buffer_version;
 	}
 
 
@@ -118,6 +120,13 @@ void WorldRendererVulkanRayTracing::prepare(const RenderParams& params) {
 		
 	} else if (mode == Mode::COMPUTE) {
 
+		// bvh buffers got recreated
+		if (compute.bvh_buffer_version != scene_view.ray_tracing_data->bvh_buffer_version) {
+			scene_view.ray_tracing_data->bind_bvh(compute.dset);
+			compute.dset->update();
+			compute.bvh_buffer_version = scene_view.ray_tracing_data->bvh_buffer_version;
+		}
+
 		pc.num_trias = 0;
 		pc.num_meshes = scene_view.ray_tracing_data->num_meshes;
 		pc.num_lights = scene_view.lights.num;
@@ -62,6 +62,7 @@ public:
 		vulkan::DescriptorPool *pool;
 		vulkan::DescriptorSet *dset;
 		vulkan::ComputePipeline *pipeline;
+		int bvh_buffer_version;
 	} compute;
 
 	struct RtxModeData {
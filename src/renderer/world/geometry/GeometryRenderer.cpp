@@ -12,6 +12,14 @@
 #include "../../../helper/PerformanceMonitor.h"
 #include "../../../helper/ResourceManager.h"
 #include "../../../world/Camera.h"
+#include "../../../world/Model.h"
+#include "../../../world/components/Animator.h"
+#include "../../../world/components/SolidBody.h"
+#include "../../../fx/GpuParticleEmitter.h"
+#include "../../../y/ComponentManager.h"
+#include "../../../y/Entity.h"
+#include "../../../y/EngineData.h"
+#include "../../helper/GpuParticleSystem.h"
 
 GeometryRenderer::GeometryRenderer(RenderPathType _type, SceneView &_scene_view) :
 		Renderer("geo"),
@@ -57,10 +65,36 @@ void GeometryRenderer::prepare(const RenderParams& params) {
 	PerformanceMonitor::begin(ch_prepare);
 
 	prepare_instanced_matrices();
+	if ((int)(flags & Flags::ALLOW_TRANSPARENT) and !is_shadow_pass())
+		prepare_gpu_particles(params);
 
 	PerformanceMonitor::end(ch_prepare);
 }
 
+// each emitter is simulated (and sorted) once per frame, by the first renderer getting here
+//   cube map faces etc. see the order of the main camera
+void GeometryRenderer::prepare_gpu_particles(const RenderParams& params) {
+	auto cam = cam_main ? cam_main : scene_view.cam;
+	auto& emitters = ComponentManager::get_list_family<GpuParticleEmitter>();
+	for (auto e: emitters) {
+		if (!e->system)
+			e->system = new GpuParticleSystem(e);
+		if (e->system->frame == engine.frame)
+			continue;
+		e->system->frame = engine.frame;
+		e->system->cam_pos = cam->owner->pos;
+		e->system->cam_dir = cam->owner->ang * vec3::EZ;
+		e->system->render(params);
+	}
+}
+
+void GeometryRenderer::draw_gpu_particles(const RenderParams& params, RenderViewData &rvd) {
+	auto& emitters = ComponentManager::get_list_family<GpuParticleEmitter>();
+	for (auto e: emitters)
+		if (e->system)
+			e->system->draw(params, rvd);
+}
+
 
 void GeometryRenderer::set(Flags _flags) {
 	flags = _flags;
@@ -70,6 +104,24 @@ bool GeometryRenderer::is_shadow_pass() const {
 	return (int)(flags & Flags::SHADOW_PASS);
 }
 
+bool GeometryRenderer::allows_static() const {
+	return !(int)(flags & Flags::DYNAMIC_ONLY);
+}
+
+bool GeometryRenderer::allows_dynamic() const {
+	return !(int)(flags & Flags::STATIC_ONLY);
+}
+
+bool GeometryRenderer::is_static(Model* m) {
+	if (!m->owner)
+		return false;
+	if (m->owner->get_component<Animator>())
+		return false;
+	if (auto sb = m->owner->get_component<SolidBody>())
+		return !sb->active;
+	return true;
+}
+
 void GeometryRenderer::draw(const RenderParams& params) {
 	bool flip_y = params.target_is_window;
 
@@ -109,8 +161,7 @@ void GeometryRenderer::draw(const RenderParams& params) {
 			nix::set_z(true, true);
 			nix::set_view_matrix(scene_view.cam->view_matrix());
 			nix::bind_uniform_buffer(1, cur_rvd.ubo_light.get());
-			nix::bind_texture(3, scene_view.shadow_maps[0]);
-			nix::bind_texture(4, scene_view.shadow_maps[1]);
+			bind_shadow_maps(scene_view);
 			nix::bind_texture(5, scene_view.cube_map.get());
 		}
 #endif
@@ -126,8 +177,7 @@ void GeometryRenderer::draw(const RenderParams& params) {
 		//nix::set_z(true, true);
 
 		nix::bind_uniform_buffer(1, cur_rvd.ubo_light.get());
-		nix::bind_texture(3, scene_view.shadow_maps[0]);
-		nix::bind_texture(4, scene_view.shadow_maps[1]);
+		bind_shadow_maps(scene_view);
 		nix::bind_texture(5, scene_view.cube_map.get());
 #endif
 		draw_objects_transparent(params, cur_rvd);
@@ -18,6 +18,7 @@
 class Camera;
 class PerformanceMonitor;
 class Material;
+class Model;
 class UBOLight;
 struct SceneView;
 class RenderViewData;
@@ -60,12 +61,20 @@ public:
 		ALLOW_SKYBOXES = 4,
 		ALLOW_CLEAR_COLOR = 8,
 		SHADOW_PASS = 1024,
+		// only static/dynamic geometry (shadow caching, see is_static())
+		STATIC_ONLY = 2048,
+		DYNAMIC_ONLY = 4096,
 	} flags;
 
 	GeometryRenderer(RenderPathType type, SceneView &scene_view);
 
 	void set(Flags flags);
 	bool is_shadow_pass() const;
+	bool allows_static() const;
+	bool allows_dynamic() const;
+
+	// not animated and not moved by physics (scripts might still move it)
+	static bool is_static(Model* m);
 
 	RenderViewData cur_rvd;
 
@@ -92,6 +101,9 @@ public:
 	static void set_material(const SceneView& scene_view, ShaderCache& cache, const Material& m, RenderPathType type, const string& vertex_module, const string& geometry_module);
 	static void set_material_x(const SceneView& scene_view, const Material& m, Shader* shader);
 
+#ifdef USING_OPENGL
+	static void bind_shadow_maps(const SceneView& scene_view);
+#endif
 #ifdef USING_VULKAN
 	static GraphicsPipeline *get_pipeline(Shader *s, RenderPass *rp, const Material::RenderPassData &pass, PrimitiveTopology top, VertexBuffer *vb);
 #endif
@@ -101,6 +113,8 @@ private:
 	void clear(const RenderParams& params, RenderViewData &rvd);
 	void draw_skyboxes(const RenderParams& params, RenderViewData &rvd);
 	void draw_particles(const RenderParams& params, RenderViewData &rvd);
+	void prepare_gpu_particles(const RenderParams& params);
+	void draw_gpu_particles(const RenderParams& params, RenderViewData &rvd);
 	void draw_terrains(const RenderParams& params, RenderViewData &rvd);
 	void draw_objects_opaque(const RenderParams& params, RenderViewData &rvd);
 	void draw_objects_transparent(const RenderParams& params, RenderViewData &rvd);
@@ -27,6 +27,7 @@
 #include "../../../world/Material.h"
 #include "../../../world/Model.h"
 #include "../../../world/Terrain.h"
+#include "../../../world/TerrainHeightfield.h"
 #include "../../../world/World.h"
 #include "../../../world/Light.h"
 #include "../../../world/ModelManager.h"
@@ -40,6 +41,7 @@
 #include <lib/nix/nix.h>
 #include <lib/image/image.h>
 #include <lib/math/vec3.h>
+#include <lib/math/Box.h>
 #include <lib/math/complex.h>
 #include <lib/math/rect.h>
 #include <lib/os/msg.h>
@@ -49,16 +51,25 @@ void GeometryRenderer::set_material(const SceneView& scene_view, ShaderCache& ca
 	set_material_x(scene_view, m, cache.get_shader(t));
 }
 
+void GeometryRenderer::bind_shadow_maps(const SceneView& scene_view) {
+	for (int i=0; i<scene_view.shadow_maps.num; i++)
+		nix::bind_texture(BINDING_SHADOW + i, scene_view.shadow_maps[i]);
+}
+
 void GeometryRenderer::set_material_x(const SceneView& scene_view, const Material& m, Shader* s) {
 	nix::set_shader(s);
 	if (using_view_space)
-		s->set_floats("eye_pos", &scene_view.cam->owner->pos.x, 3); // NAH....
+		s->set_floats_l(s->location[nix::Shader::LOCATION_EYE_POS], &scene_view.cam->owner->pos.x, 3); // NAH....
 	else
-		s->set_floats("eye_pos", &vec3::ZERO.x, 3);
-	s->set_int("num_lights", scene_view.lights.num);
-	s->set_int("shadow_index", scene_view.shadow_index);
+		s->set_floats_l(s->location[nix::Shader::LOCATION_EYE_POS], &vec3::ZERO.x, 3);
+	s->set_int_l(s->location[nix::Shader::LOCATION_NUM_LIGHTS], scene_view.lights.num);
+	s->set_int_l(s->location[nix::Shader::LOCATION_SHADOW_INDEX], scene_view.shadow_index);
+	s->set_int_l(s->location[nix::Shader::LOCATION_CUBE_MAP_LEVELS], scene_view.cube_map_levels);
+	s->set_int_l(s->location[nix::Shader::LOCATION_NUM_SHADOW_CASCADES], scene_view.shadow_maps.num);
+	s->set_floats_l(s->location[nix::Shader::LOCATION_SHADOW_CASCADE_SCALE], scene_view.shadow_cascade_scale, MAX_SHADOW_CASCADES);
 	for (auto &u: m.uniforms)
 		s->set_floats(u.name, u.p, u.size/4);
+	nix::bind_uniform_buffer(BINDING_MATERIAL, m.update_ubo());
 
 	if (m.pass0.mode == TransparencyMode::FUNCTIONS)
 		nix::set_alpha(m.pass0.source, m.pass0.destination);
@@ -71,9 +82,6 @@ void GeometryRenderer::set_material_x(const SceneView& scene_view, const Materia
 
 	nix::bind_textures(weak(m.textures));
 	nix::bind_texture(7, scene_view.cube_map.get());
-
-
-	nix::set_material(m.albedo, m.roughness, m.metal, m.emission);
 }
 
 
@@ -143,7 +151,7 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 
 	// legacy particles
 	base::map<Texture*, Array<LegacyParticle*>> legacy_groups;
-	auto& legacy_particles = ComponentManager::get_list_family<LegacyParticle>();
+	auto& legacy_particles = world.particle_manager->legacy_particles;
 	for (auto p: legacy_particles) {
 		int i = legacy_groups.find(p->texture.get());
 		if (i >= 0) {
@@ -181,18 +189,16 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 
 	auto& particle_groups = ComponentManager::get_list_family<ParticleGroup>();
 	for (auto g: particle_groups) {
+		g->flush_emitted();
 		nix::bind_texture(0, g->texture);
-		int count = 0;
-		for (auto& p: g->particles)
-			count += int(p.enabled);
+		auto& ps = g->particles;
 
 		nix::set_shader(shader_fx_points.get());
 		shader_fx_points->set_floats("source_uv", &g->source.x1, 4);
 		Array<VertexPoint> v;
-		v.__reserve(count);
-		for (auto& p: g->particles)
-			if (p.enabled)
-				v.add({p.pos, p.radius*2, p.col});
+		v.resize(ps.size());
+		for (int i=0; i<ps.size(); i++)
+			v[i] = {ps.pos[i], ps.radius[i]*2, ps.col[i]};
 		vb_fx_points->update(v);
 		nix::set_model_matrix(mat4::ID);
 		nix::draw_points(vb_fx_points.get());
@@ -208,14 +214,15 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 
 		Array<VertexFx> v;
 
-		for (auto& b: g->beams)
-			if (b.enabled)
-				add_beam_vertices(v, b.pos, b.length, b.radius, b.col, source);
+		auto& bs = g->beams;
+		for (int i=0; i<bs.size(); i++)
+			add_beam_vertices(v, bs.pos[i], bs.length[i], bs.radius[i], bs.col[i], source);
 
 		vb_fx->update(v);
 		nix::draw_triangles(vb_fx.get());
 	}
 
+	draw_gpu_particles(params, rvd);
 
 	nix::set_z(true, true);
 	nix::disable_alpha();
@@ -252,6 +259,8 @@ void GeometryRenderer::draw_skyboxes(const RenderParams& params, RenderViewData
 }
 
 void GeometryRenderer::draw_terrains(const RenderParams& params, RenderViewData &rvd) {
+	if (!allows_static())
+		return;
 	PerformanceMonitor::begin(ch_terrains);
 	gpu_timestamp_begin(params, ch_terrains);
 	auto& terrains = ComponentManager::get_list_family<Terrain>();
@@ -271,16 +280,38 @@ void GeometryRenderer::draw_terrains(const RenderParams& params, RenderViewData
 			shader->set_floats("pattern1", &t->texture_scale[1].x, 3);
 		}
 
-		auto vb = t->vertex_buffer.get();
+		if (auto hf = t->heightfield.get()) {
+			auto& rd = rvd.start(params, mat4::translation(o->pos), shader, *material, 0, PrimitiveTopology::TRIANGLES, hf->grid.get());
+			rd.apply(params);
+			nix::bind_texture(BINDING_HEIGHT_MAP, hf->height_texture.get());
+			nix::bind_uniform_buffer(BINDING_TERRAIN_NODES, hf->ubo.get());
+			nix::draw_instanced_triangles(hf->grid.get(), hf->num_nodes);
+			continue;
+		}
+
+		// (all chunks share the vertex format)
+		VertexBuffer *vb = nullptr;
+		for (auto &c: t->chunks)
+			if (c.vertex_buffer and !vb)
+				vb = c.vertex_buffer;
+		if (!vb)
+			continue;
 		auto& rd = rvd.start(params, mat4::translation(o->pos), shader, *material, 0, PrimitiveTopology::TRIANGLES, vb);
 		rd.apply(params);
-		nix::draw_triangles(vb);
+
+		// chunks outside the view frustum are skipped
+		auto m = rvd.ubo.p * rvd.ubo.v * mat4::translation(o->pos);
+		for (auto &c: t->chunks)
+			if (c.vertex_buffer and t->chunk_visible(c, m))
+				nix::draw_triangles(c.vertex_buffer);
 	}
 	gpu_timestamp_end(params, ch_terrains);
 	PerformanceMonitor::end(ch_terrains);
 }
 
 void GeometryRenderer::draw_objects_instanced(const RenderParams& params, RenderViewData &rvd) {
+	if (!allows_static())
+		return;
 	PerformanceMonitor::begin(ch_models);
 	gpu_timestamp_begin(params, ch_models);
 	auto& list = ComponentManager::get_list_family<MultiInstance>();
@@ -311,11 +342,18 @@ void GeometryRenderer::draw_objects_opaque(const RenderParams& params, RenderVie
 	PerformanceMonitor::begin(ch_models);
 	gpu_timestamp_begin(params, ch_models);
 	auto& list = ComponentManager::get_list_family<Model>();
+	// shadow casters: light space culling (animated models might leave their box)
+	auto m_cull = rvd.ubo.p * rvd.ubo.v;
 	for (auto *m: list) {
+		if (!(is_static(m) ? allows_static() : allows_dynamic()))
+			continue;
 		m->update_matrix();
+		auto ani = m->owner->get_component<Animator>();
+		if (is_shadow_pass() and !ani and !Box{m->prop.min, m->prop.max}.in_frustum(m_cull * m->_matrix))
+			continue;
 		nix::set_model_matrix(m->_matrix);
 
-		if (auto ani = m->owner->get_component<Animator>()) {
+		if (ani) {
 			ani->buf->update_array(ani->dmatrix);
 			nix::bind_uniform_buffer(7, ani->buf);
 		}
@@ -406,6 +444,9 @@ void GeometryRenderer::draw_objects_transparent(const RenderParams& params, Rend
 }
 
 void GeometryRenderer::draw_user_meshes(const RenderParams& params, RenderViewData &rvd, bool transparent) {
+	// (always dynamic)
+	if (!allows_dynamic())
+		return;
 	PerformanceMonitor::begin(ch_user);
 	gpu_timestamp_begin(params, ch_user);
 	auto& meshes = ComponentManager::get_list_family<UserMesh>();
@@ -416,7 +457,7 @@ void GeometryRenderer::draw_user_meshes(const RenderParams& params, RenderViewDa
 		if (!material->cast_shadow and is_shadow_pass())
 			continue;
 		auto o = m->owner;
-		nix::set_model_matrix(o->get_matrix());
+		nix::set_model_matrix(o->get_matrix_cached());
 
 		auto shader = cur_rvd.get_shader(material, 0, m->vertex_shader_module, m->geometry_shader_module);
 		if (is_shadow_pass())
@@ -457,8 +498,7 @@ void GeometryRenderer::draw_opaque(const RenderParams& params, RenderViewData &r
 		nix::set_z(true, true);
 		nix::set_view_matrix(scene_view.cam->view_matrix());
 		nix::bind_uniform_buffer(1, rvd.ubo_light.get());
-		nix::bind_texture(3, scene_view.shadow_maps[0]);
-		nix::bind_texture(4, scene_view.shadow_maps[1]);
+		bind_shadow_maps(scene_view);
 		nix::bind_texture(5, scene_view.cube_map.get());
 	}
 
@@ -474,8 +514,7 @@ void GeometryRenderer::draw_transparent(const RenderParams& params, RenderViewDa
 	//nix::set_z(true, true);
 
 	nix::bind_uniform_buffer(1, rvd.ubo_light.get());
-	nix::bind_texture(3, scene_view.shadow_maps[0]);
-	nix::bind_texture(4, scene_view.shadow_maps[1]);
+	bind_shadow_maps(scene_view);
 	nix::bind_texture(5, scene_view.cube_map.get());
 
 	draw_objects_transparent(params, rvd);
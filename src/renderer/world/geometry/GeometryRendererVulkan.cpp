@@ -22,6 +22,7 @@
 #include "../../../world/Material.h"
 #include "../../../world/Model.h"
 #include "../../../world/Terrain.h"
+#include "../../../world/TerrainHeightfield.h"
 #include "../../../world/World.h"
 #include "../../../world/ModelManager.h"
 #include "../../../world/components/Animator.h"
@@ -33,6 +34,7 @@
 #include <lib/base/sort.h>
 #include <lib/image/image.h>
 #include <lib/math/vec3.h>
+#include <lib/math/Box.h>
 
 
 
@@ -83,7 +85,7 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 
 	base::map<Texture*, Array<LegacyParticle*>> legacy_groups;
 
-	auto& legacy_particles = ComponentManager::get_list_family<LegacyParticle>();
+	auto& legacy_particles = world.particle_manager->legacy_particles;
 	for (auto p: legacy_particles) {
 		int i = legacy_groups.find(p->texture.get());
 		if (i >= 0) {
@@ -144,18 +146,21 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 	// new particles
 	auto& particle_groups = ComponentManager::get_list_family<ParticleGroup>();
 	for (auto g: particle_groups) {
+		g->flush_emitted();
 		auto source = g->source;
+		auto& ps = g->particles;
 		Array<VertexFx> v;
-		for (auto& p: g->particles)
-			if (p.enabled) {
-				auto m = mat4::translation(p.pos) * r * mat4::scale(p.radius, p.radius, p.radius);
-				v.add({m * vec3(-1, 1,0), p.col, source.x1, source.y1});
-				v.add({m * vec3( 1, 1,0), p.col, source.x2, source.y1});
-				v.add({m * vec3( 1,-1,0), p.col, source.x2, source.y2});
-				v.add({m * vec3(-1, 1,0), p.col, source.x1, source.y1});
-				v.add({m * vec3( 1,-1,0), p.col, source.x2, source.y2});
-				v.add({m * vec3(-1,-1,0), p.col, source.x1, source.y2});
-			}
+		v.__reserve(ps.size() * 6);
+		for (int i=0; i<ps.size(); i++) {
+			auto m = mat4::translation(ps.pos[i]) * r * mat4::scale(ps.radius[i], ps.radius[i], ps.radius[i]);
+			auto& c = ps.col[i];
+			v.add({m * vec3(-1, 1,0), c, source.x1, source.y1});
+			v.add({m * vec3( 1, 1,0), c, source.x2, source.y1});
+			v.add({m * vec3( 1,-1,0), c, source.x2, source.y2});
+			v.add({m * vec3(-1, 1,0), c, source.x1, source.y1});
+			v.add({m * vec3( 1,-1,0), c, source.x2, source.y2});
+			v.add({m * vec3(-1,-1,0), c, source.x1, source.y2});
+		}
 		auto vb = get_vb();
 		vb->update(v);
 
@@ -166,35 +171,38 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 
 	// beams
 	for (auto g: particle_groups) {
-		if (g->beams.num == 0)
+		auto& bs = g->beams;
+		if (bs.size() == 0)
 			continue;
 
 		auto source = g->source;
 		Array<VertexFx> v;
-		for (auto& p: g->beams) {
-			if (!p.enabled)
-				continue;
+		v.__reserve(bs.size() * 6);
+		for (int i=0; i<bs.size(); i++) {
+			auto& pos = bs.pos[i];
+			auto& length = bs.length[i];
+			auto& c = bs.col[i];
 			// TODO geometry shader!
-			auto pa = cam->project(p.pos);
-			auto pb = cam->project(p.pos + p.length);
+			auto pa = cam->project(pos);
+			auto pb = cam->project(pos + length);
 			auto pe = vec3::cross(pb - pa, vec3::EZ).normalized();
 			auto uae = cam->unproject(pa + pe * 0.1f);
 			auto ube = cam->unproject(pb + pe * 0.1f);
-			auto _e1 = (p.pos - uae).normalized() * p.radius;
-			auto _e2 = (p.pos + p.length - ube).normalized() * p.radius;
+			auto _e1 = (pos - uae).normalized() * bs.radius[i];
+			auto _e2 = (pos + length - ube).normalized() * bs.radius[i];
 			//vec3 e1 = -vec3::cross(cam->ang * vec3::EZ, p.length).normalized() * p.radius/2;
 
-			vec3 p00 = p.pos - _e1;
-			vec3 p01 = p.pos - _e2 + p.length;
-			vec3 p10 = p.pos + _e1;
-			vec3 p11 = p.pos + _e2 + p.length;
-
-			v.add({p00, p.col, source.x1, source.y1});
-			v.add({p01, p.col, source.x2, source.y1});
-			v.add({p11, p.col, source.x2, source.y2});
-			v.add({p00, p.col, source.x1, source.y1});
-			v.add({p11, p.col, source.x2, source.y2});
-			v.add({p10, p.col, source.x1, source.y2});
+			vec3 p00 = pos - _e1;
+			vec3 p01 = pos - _e2 + length;
+			vec3 p10 = pos + _e1;
+			vec3 p11 = pos + _e2 + length;
+
+			v.add({p00, c, source.x1, source.y1});
+			v.add({p01, c, source.x2, source.y1});
+			v.add({p11, c, source.x2, source.y2});
+			v.add({p00, c, source.x1, source.y1});
+			v.add({p11, c, source.x2, source.y2});
+			v.add({p10, c, source.x1, source.y2});
 		}
 		auto vb = get_vb();
 		vb->update(v);
@@ -202,6 +210,8 @@ void GeometryRenderer::draw_particles(const RenderParams& params, RenderViewData
 		cb->draw(vb);
 	}
 
+	draw_gpu_particles(params, rvd);
+
 	gpu_timestamp_end(params, ch_fx);
 	PerformanceMonitor::end(ch_fx);
 }
@@ -254,6 +264,8 @@ void GeometryRenderer::draw_skyboxes(const RenderParams& params, RenderViewData
 }
 
 void GeometryRenderer::draw_terrains(const RenderParams& params, RenderViewData &rvd) {
+	if (!allows_static())
+		return;
 	auto cb = params.command_buffer;
 	PerformanceMonitor::begin(ch_terrains);
 	gpu_timestamp_begin(params, ch_terrains);
@@ -264,25 +276,49 @@ void GeometryRenderer::draw_terrains(const RenderParams& params, RenderViewData
 
 		auto material = t->material.get();
 		if (is_shadow_pass() and !material->cast_shadow)
-			return;
+			continue;
 		auto shader = cur_rvd.get_shader(material, 0, t->vertex_shader_module, "");
 		if (is_shadow_pass())
 			material = cur_rvd.material_shadow;
 
-		auto& rd = rvd.start(params, mat4::translation(o->pos), shader, *material, 0, PrimitiveTopology::TRIANGLES, t->vertex_buffer.get());
+		// (all chunks share the vertex format)
+		auto hf = t->heightfield.get();
+		VertexBuffer *vb = hf ? hf->grid.get() : nullptr;
+		for (auto &c: t->chunks)
+			if (c.vertex_buffer and !vb)
+				vb = c.vertex_buffer;
+		if (!vb)
+			continue;
+		auto& rd = rvd.start(params, mat4::translation(o->pos), shader, *material, 0, PrimitiveTopology::TRIANGLES, vb);
+		if (hf) {
+			rd.dset->set_texture(BINDING_HEIGHT_MAP, hf->height_texture.get());
+			rd.dset->set_uniform_buffer(BINDING_TERRAIN_NODES, hf->ubo.get());
+		}
 
 		if (!is_shadow_pass()) {
 			cb->push_constant(0, 4, &t->texture_scale[0].x);
 			cb->push_constant(4, 4, &t->texture_scale[1].x);
 		}
 		rd.apply(params);
-		cb->draw(t->vertex_buffer.get());
+
+		if (hf) {
+			cb->draw_instanced(vb, hf->num_nodes);
+			continue;
+		}
+
+		// chunks outside the view frustum are skipped
+		auto m = rvd.ubo.p * rvd.ubo.v * mat4::translation(o->pos);
+		for (auto &c: t->chunks)
+			if (c.vertex_buffer and t->chunk_visible(c, m))
+				cb->draw(c.vertex_buffer);
 	}
 	gpu_timestamp_end(params, ch_terrains);
 	PerformanceMonitor::end(ch_terrains);
 }
 
 void GeometryRenderer::draw_objects_instanced(const RenderParams& params, RenderViewData &rvd) {
+	if (!allows_static())
+		return;
 	auto cb = params.command_buffer;
 	PerformanceMonitor::begin(ch_models);
 	gpu_timestamp_begin(params, ch_models);
@@ -322,9 +358,16 @@ void GeometryRenderer::draw_objects_opaque(const RenderParams& params, RenderVie
 	gpu_timestamp_begin(params, ch_models);
 
 	auto& list = ComponentManager::get_list_family<Model>();
+	// shadow casters: light space culling (animated models might leave their box)
+	auto m_cull = rvd.ubo.p * rvd.ubo.v;
 
 	for (auto m: list) {
+		if (!(is_static(m) ? allows_static() : allows_dynamic()))
+			continue;
 		auto ani = m->owner ? m->owner->get_component<Animator>() : nullptr;
+		m->update_matrix();
+		if (is_shadow_pass() and !ani and !Box{m->prop.min, m->prop.max}.in_frustum(m_cull * m->_matrix))
+			continue;
 		for (int i=0; i<m->material.num; i++) {
 			auto material = m->material[i];
 			if (material->is_transparent())
@@ -336,7 +379,6 @@ void GeometryRenderer::draw_objects_opaque(const RenderParams& params, RenderVie
 			if (is_shadow_pass())
 				material = cur_rvd.material_shadow;
 
-			m->update_matrix();
 			auto vb = m->mesh[0]->sub[i].vertex_buffer;
 			auto& rd = rvd.start(params, m->_matrix, shader, *material, 0, PrimitiveTopology::TRIANGLES, vb);
 
@@ -412,6 +454,9 @@ void GeometryRenderer::draw_objects_transparent(const RenderParams& params, Rend
 }
 
 void GeometryRenderer::draw_user_meshes(const RenderParams& params, RenderViewData &rvd, bool transparent) {
+	// (always dynamic)
+	if (!allows_dynamic())
+		return;
 	auto cb = params.command_buffer;
 	PerformanceMonitor::begin(ch_user);
 	gpu_timestamp_begin(params, ch_user);
@@ -430,7 +475,7 @@ void GeometryRenderer::draw_user_meshes(const RenderParams& params, RenderViewDa
 
 		auto vb = m->vertex_buffer.get();
 		auto shader = cur_rvd.get_shader(material, 0, m->vertex_shader_module, m->geometry_shader_module);
-		auto& rd = rvd.start(params, m->owner->get_matrix(), shader, *material, 0, m->topology, vb);
+		auto& rd = rvd.start(params, m->owner->get_matrix_cached(), shader, *material, 0, m->topology, vb);
 
 		rd.apply(params);
 		cb->draw(m->vertex_buffer.get());
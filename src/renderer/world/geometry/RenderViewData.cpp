@@ -41,6 +41,9 @@ void RenderViewData::update_lights() {
 	//ubo_light->update_part(&lights[0], 0, lights.num * sizeof(lights[0]));
 	ubo.num_lights = scene_view->lights.num;
 	ubo.shadow_index = scene_view->shadow_index;
+	ubo.num_shadow_cascades = scene_view->shadow_maps.num;
+	for (int i=0; i<MAX_SHADOW_CASCADES; i++)
+		ubo.shadow_cascade_scale[i] = scene_view->shadow_cascade_scale[i];
 }
 
 void RenderViewData::prepare_scene(SceneView *_scene_view) {
@@ -77,13 +80,17 @@ RenderData& RenderViewData::start(const RenderParams& params, const mat4& matrix
 
 	nix::set_shader(shader);
 	if (GeometryRenderer::using_view_space)
-		shader->set_floats("eye_pos", &scene_view->cam->owner->pos.x, 3); // NAH....
+		shader->set_floats_l(shader->location[nix::Shader::LOCATION_EYE_POS], &scene_view->cam->owner->pos.x, 3); // NAH....
 	else
-		shader->set_floats("eye_pos", &vec3::ZERO.x, 3);
-	shader->set_int("num_lights", scene_view->lights.num);
-	shader->set_int("shadow_index", scene_view->shadow_index);
+		shader->set_floats_l(shader->location[nix::Shader::LOCATION_EYE_POS], &vec3::ZERO.x, 3);
+	shader->set_int_l(shader->location[nix::Shader::LOCATION_NUM_LIGHTS], scene_view->lights.num);
+	shader->set_int_l(shader->location[nix::Shader::LOCATION_SHADOW_INDEX], scene_view->shadow_index);
+	shader->set_int_l(shader->location[nix::Shader::LOCATION_CUBE_MAP_LEVELS], scene_view->cube_map_levels);
+	shader->set_int_l(shader->location[nix::Shader::LOCATION_NUM_SHADOW_CASCADES], scene_view->shadow_maps.num);
+	shader->set_floats_l(shader->location[nix::Shader::LOCATION_SHADOW_CASCADE_SCALE], scene_view->shadow_cascade_scale, MAX_SHADOW_CASCADES);
 	for (auto &u: material.uniforms)
 		shader->set_floats(u.name, u.p, u.size/4);
+	nix::bind_uniform_buffer(BINDING_MATERIAL, material.update_ubo());
 
 	auto& pass = material.pass(pass_no);
 	if (pass.mode == TransparencyMode::FUNCTIONS)
@@ -98,9 +105,6 @@ RenderData& RenderViewData::start(const RenderParams& params, const mat4& matrix
 	nix::bind_textures(weak(material.textures));
 	nix::bind_texture(7, scene_view->cube_map.get());
 
-
-	nix::set_material(material.albedo, material.roughness, material.metal, material.emission);
-
 	return rd;
 }
 #endif
@@ -110,8 +114,11 @@ RenderData& RenderViewData::start(const RenderParams& params, const mat4& matrix
 void RenderViewData::begin_draw() {
 	index = 0;
 	ubo.num_surfels = 0;
-	if (scene_view)
+	ubo.cube_map_levels = 1;
+	if (scene_view) {
 		ubo.num_surfels = scene_view->num_surfels;
+		ubo.cube_map_levels = scene_view->cube_map_levels;
+	}
 }
 
 RenderData& RenderViewData::start(
@@ -119,9 +126,7 @@ RenderData& RenderViewData::start(
 		Shader* shader, const Material& material, int pass_no,
 		PrimitiveTopology top, VertexBuffer *vb) {
 	if (index >= rda.num) {
-		rda.add({new UniformBuffer(sizeof(UBO)),
-		         pool->create_set(shader)});
-		rda[index].dset->set_uniform_buffer(BINDING_PARAMS, rda[index].ubo);
+		rda.add({nullptr, pool->create_set(shader)});
 		rda[index].dset->set_uniform_buffer(BINDING_LIGHT, ubo_light.get());
 	}
 
@@ -130,7 +135,21 @@ RenderData& RenderViewData::start(
 	ubo.emission = material.emission;
 	ubo.metal = material.metal;
 	ubo.roughness = material.roughness;
-	rda[index].ubo->update_part(&ubo, 0, sizeof(UBO));
+
+	// transient, from the per frame region
+	void *p_ubo;
+	auto fa = device->frame_allocator;
+	int64 offset = fa->allocate(sizeof(UBO), device->physical_device_properties.limits.minUniformBufferOffsetAlignment, &p_ubo);
+	if (offset >= 0) {
+		memcpy(p_ubo, &ubo, sizeof(UBO));
+		rda[index].dset->set_uniform_buffer_with_offset(BINDING_PARAMS, fa->buffer, (int)offset, sizeof(UBO));
+	} else {
+		// region full
+		if (!rda[index].ubo)
+			rda[index].ubo = new UniformBuffer(sizeof(UBO));
+		rda[index].ubo->update_part(&ubo, 0, sizeof(UBO));
+		rda[index].dset->set_uniform_buffer(BINDING_PARAMS, rda[index].ubo);
+	}
 
 	auto p = GeometryRenderer::get_pipeline(shader, params.render_pass, material.pass(pass_no), top, vb);
 
@@ -149,10 +168,10 @@ void RenderData::set_textures(const SceneView& scene_view, const Array<Texture*>
 	foreachi (auto t, tex, i)
 						if (t)
 							dset->set_texture(BINDING_TEX0 + i, t);
-	if (scene_view.shadow_maps.num >= 1)
-		dset->set_texture(BINDING_SHADOW0, scene_view.shadow_maps[0]);
-	if (scene_view.shadow_maps.num >= 2)
-		dset->set_texture(BINDING_SHADOW1, scene_view.shadow_maps[1]);
+	// unused elements repeat the outermost cascade, every element needs a valid descriptor
+	if (scene_view.shadow_maps.num > 0)
+		for (int i=0; i<MAX_SHADOW_CASCADES; i++)
+			dset->set_texture_element(BINDING_SHADOW, i, scene_view.shadow_maps[min(i, scene_view.shadow_maps.num - 1)]);
 	if (scene_view.cube_map)
 		dset->set_texture(BINDING_CUBE, scene_view.cube_map.get());
 }
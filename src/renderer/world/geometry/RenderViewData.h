@@ -25,13 +25,25 @@ static constexpr int MAX_INSTANCES = 1<<11;
 #ifdef USING_VULKAN
 
 static constexpr int BINDING_TEX0 = 0;
-static constexpr int BINDING_SHADOW0 = 5;
-static constexpr int BINDING_SHADOW1 = 6;
+// sampler array, MAX_SHADOW_CASCADES elements
+static constexpr int BINDING_SHADOW = 5;
 static constexpr int BINDING_CUBE = 7;
 static constexpr int BINDING_PARAMS = 8;
 static constexpr int BINDING_LIGHT = 9;
 static constexpr int BINDING_INSTANCE_MATRICES = 10;
 static constexpr int BINDING_BONE_MATRICES = 11;
+// vertex-heightfield
+static constexpr int BINDING_HEIGHT_MAP = 4;
+static constexpr int BINDING_TERRAIN_NODES = 10;
+
+#else
+
+static constexpr int BINDING_MATERIAL = 2; // nix::BINDING_MATERIAL
+// texture units of the shadow sampler array, after the material's
+static constexpr int BINDING_SHADOW = 8;
+// vertex-heightfield (texture unit and uniform block)
+static constexpr int BINDING_HEIGHT_MAP = 6;
+static constexpr int BINDING_TERRAIN_NODES = 6;
 
 #endif
 
@@ -45,11 +57,15 @@ struct UBO {
 	int num_lights;
 	int shadow_index;
 	int num_surfels;
-	int dummy2[2];
+	int cube_map_levels;
+	int num_shadow_cascades;
+	int dummy2[3];
+	float shadow_cascade_scale[4]; // vec4, MAX_SHADOW_CASCADES
 };
 
 struct RenderData {
 #ifdef USING_VULKAN
+	// only if the device's frame_allocator runs full
 	UniformBuffer* ubo;
 	DescriptorSet* dset;
 #endif
@@ -13,14 +13,20 @@
 class Light;
 class Camera;
 struct UBOLight;
-struct XTerrainVBUpdater;
-class TerrainUpdateThread;
 struct RayTracingData;
 
+// size of the shadow sampler array in the lighting shaders
+static constexpr int MAX_SHADOW_CASCADES = 4;
+
 struct SceneView {
 	Camera *cam; // the "owning" camera - might use a different perspective for rendering (e.g. cubemap)
+	// one per cascade, innermost first
 	Array<DepthBuffer*> shadow_maps;
+	// cascade i covers 1/scale of the light's shadow projection
+	float shadow_cascade_scale[MAX_SHADOW_CASCADES] = {1, 1, 1, 1};
 	shared<CubeMap> cube_map;
+	// mip levels of cube_map with valid (prefiltered) content, lod = roughness * (levels - 1)
+	int cube_map_levels = 1;
 	int shadow_index = -1;
 	Array<Light*> lights;
 	owned<UniformBuffer> surfel_buffer;
@@ -33,9 +39,6 @@ struct SceneView {
 
 
 	void check_terrains(const vec3& cam_pos);
-
-	//TerrainUpdateThread* terrain_update_thread = nullptr;
-	Array<XTerrainVBUpdater*> updater;
 };
 
 
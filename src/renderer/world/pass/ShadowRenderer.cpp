@@ -17,6 +17,11 @@
 #include "../../../helper/PerformanceMonitor.h"
 #include <world/Material.h>
 #include <world/Camera.h>
+#include <world/Model.h>
+#include <world/Terrain.h>
+#include <world/components/MultiInstance.h>
+#include <y/ComponentManager.h>
+#include <y/Entity.h>
 #include "../../../Config.h"
 
 
@@ -35,7 +40,16 @@ ShadowRenderer::ShadowRenderer(Camera* cam) :
 	scene_view.cam = cam;
 	scene_view.shadow_index = -1;
 
-	for (int i=0; i<NUM_CASCADES; i++) {
+	cache_static = config.get_bool("shadow.cache_static", true);
+#ifndef USING_OPENGL
+	cache_static = false;
+#endif
+	static_signature = 0;
+	int far_update_interval = max(config.get_int("shadow.far_update_interval", 4), 1);
+	num_cascades = clamp(config.get_int("shadow.cascades", 2), 1, MAX_CASCADES);
+	float cascade_ratio = max(config.get_float("shadow.cascade_ratio", 4.0f), 1.0f);
+
+	for (int i=0; i<num_cascades; i++) {
 		auto& c = cascades[i];
 		c.geo_renderer = new GeometryRenderer(RenderPathType::Forward, scene_view);
 		c.geo_renderer->flags = GeometryRenderer::Flags::SHADOW_PASS;
@@ -44,13 +58,29 @@ ShadowRenderer::ShadowRenderer(Camera* cam) :
 		shared tex = new Texture(shadow_resolution, shadow_resolution, "rgba:i8");
 		c.depth_buffer = new DepthBuffer(shadow_resolution, shadow_resolution, "d:f32");
 		c.texture_renderer = new TextureRenderer(format("cas%d", i), {tex, c.depth_buffer}, {"autoclear"});
-		c.scale = (i == 0) ? 4.0f : 1.0f;
+		c.scale = pow(cascade_ratio, (float)(num_cascades - 1 - i));
 		c.texture_renderer->add_child(c.geo_renderer.get());
+		// the outer cascades cover more area with less detail, their moving casters can lag a bit
+		c.update_interval = (i == 0) ? 1 : far_update_interval;
+
+		if (cache_static) {
+			c.geo_renderer->flags = GeometryRenderer::Flags::SHADOW_PASS | GeometryRenderer::Flags::DYNAMIC_ONLY;
+			c.texture_renderer->clear_z = false;
+
+			c.static_geo_renderer = new GeometryRenderer(RenderPathType::Forward, scene_view);
+			c.static_geo_renderer->flags = GeometryRenderer::Flags::SHADOW_PASS | GeometryRenderer::Flags::STATIC_ONLY;
+			c.static_geo_renderer->cur_rvd.material_shadow = material.get();
+
+			// depth only
+			c.static_depth_buffer = new DepthBuffer(shadow_resolution, shadow_resolution, "d:f32");
+			c.static_renderer = new TextureRenderer(format("cas%ds", i), {c.static_depth_buffer}, {"autoclear"});
+			c.static_renderer->add_child(c.static_geo_renderer.get());
+		}
 	}
 }
 
 void ShadowRenderer::set_projection(const mat4& proj) {
-	for (int i=0; i<NUM_CASCADES; i++) {
+	for (int i=0; i<num_cascades; i++) {
 		auto& c = cascades[i];
 
 #ifdef USING_OPENGL
@@ -58,27 +88,95 @@ void ShadowRenderer::set_projection(const mat4& proj) {
 #else
 		auto m = mat4::scale(c.scale, -c.scale, 1);
 #endif
-		c.geo_renderer->cur_rvd.set_projection_matrix(m * proj);
+		c.projection = m * proj;
+		c.geo_renderer->cur_rvd.set_projection_matrix(c.projection);
+		if (c.static_geo_renderer)
+			c.static_geo_renderer->cur_rvd.set_projection_matrix(c.projection);
+	}
+}
+
+static bool same_matrix(const mat4& a, const mat4& b) {
+	for (int i=0; i<16; i++)
+		if (a.e[i] != b.e[i])
+			return false;
+	return true;
+}
+
+// fnv-1a
+static void hash_add(unsigned long long& h, const void* data, int size) {
+	auto p = (const unsigned char*)data;
+	for (int i=0; i<size; i++) {
+		h ^= p[i];
+		h *= 1099511628211ull;
+	}
+}
+
+int64 ShadowRenderer::get_static_signature() {
+	unsigned long long h = 14695981039346656037ull;
+	for (auto m: ComponentManager::get_list_family<Model>())
+		if (GeometryRenderer::is_static(m)) {
+			m->update_matrix();
+			hash_add(h, &m, sizeof(m));
+			hash_add(h, &m->_matrix, sizeof(mat4));
+		}
+	for (auto t: ComponentManager::get_list_family<Terrain>()) {
+		hash_add(h, &t, sizeof(t));
+		hash_add(h, &t->version, sizeof(int));
+		hash_add(h, &t->owner->pos, sizeof(vec3));
+	}
+	for (auto mi: ComponentManager::get_list_family<MultiInstance>()) {
+		hash_add(h, &mi, sizeof(mi));
+		if (mi->matrices.num > 0)
+			hash_add(h, &mi->matrices[0], mi->matrices.num * sizeof(mat4));
 	}
+	return (int64)h;
 }
 
 void ShadowRenderer::render(const RenderParams& params) {
 	PerformanceMonitor::begin(ch_prepare);
 	gpu_timestamp_begin(params, ch_prepare);
 
-	render_cascade(params, cascades[0]);
-	render_cascade(params, cascades[1]);
+	if (cache_static)
+		static_signature = get_static_signature();
+
+	for (int i=0; i<num_cascades; i++) {
+		auto& c = cascades[i];
+		c.counter ++;
+		// the lighting uses the current projection, so a moved cascade can not wait
+		bool moved = !c.valid or !same_matrix(c.projection, c.rendered_projection);
+		if (!moved and c.counter < c.update_interval)
+			continue;
+		render_cascade(params, c, moved);
+	}
 
 	gpu_timestamp_end(params, ch_prepare);
 	PerformanceMonitor::end(ch_prepare);
 }
 
-void ShadowRenderer::render_cascade(const RenderParams& _params, Cascade& c) {
+void ShadowRenderer::render_cascade(const RenderParams& _params, Cascade& c, bool force) {
 	auto params = _params.with_target(c.texture_renderer->frame_buffer.get());
 	params.desired_aspect_ratio = 1.0f;
 
+#ifdef USING_OPENGL
+	if (cache_static) {
+		if (force or !c.static_valid or c.static_signature != static_signature) {
+			auto static_params = _params.with_target(c.static_renderer->frame_buffer.get());
+			static_params.desired_aspect_ratio = 1.0f;
+			c.static_geo_renderer->prepare(static_params);
+			c.static_renderer->render(static_params);
+			c.static_valid = true;
+			c.static_signature = static_signature;
+		}
+		// dynamic casters on top of the cached depth
+		nix::copy_texture(c.depth_buffer, c.static_depth_buffer);
+	}
+#endif
 
-	// all opaque meshes
+	// all opaque meshes (or only the dynamic ones)
 	c.geo_renderer->prepare(params);
 	c.texture_renderer->render(params);
+
+	c.rendered_projection = c.projection;
+	c.valid = true;
+	c.counter = 0;
 }
@@ -23,7 +23,9 @@ class ShadowRenderer : public RenderTask {
 public:
 	ShadowRenderer(Camera* cam);
 
-	static constexpr int NUM_CASCADES = 2;
+	// "shadow.cascades", each one covers 1/"shadow.cascade_ratio" of the next outer one
+	static constexpr int MAX_CASCADES = MAX_SHADOW_CASCADES;
+	int num_cascades;
 
 	void prepare(const RenderParams& params) override {};
 	void draw(const RenderParams& params) override {}
@@ -40,9 +42,27 @@ public:
 		owned<TextureRenderer> texture_renderer;
 		float scale = 1.0f;
 	    owned<GeometryRenderer> geo_renderer;
-	} cascades[NUM_CASCADES];
 
+		// a changed projection always gets rendered, otherwise (dynamic casters) only every update_interval frames
+		int update_interval = 1;
+		int counter = 0;
+		mat4 projection, rendered_projection;
+		bool valid = false;
 
-    void render_cascade(const RenderParams& params, Cascade& c);
+		// static casters only, copied into depth_buffer before drawing the dynamic ones
+		DepthBuffer* static_depth_buffer = nullptr;
+		owned<TextureRenderer> static_renderer;
+		owned<GeometryRenderer> static_geo_renderer;
+		bool static_valid = false;
+		int64 static_signature = 0;
+	} cascades[MAX_CASCADES];
+
+	// static caster depth cached per cascade (OpenGL only)
+	bool cache_static;
+	// of the static casters, changes when they get added, removed, moved or edited
+	int64 static_signature;
+	static int64 get_static_signature();
+
+    void render_cascade(const RenderParams& params, Cascade& c, bool force);
 };
 
@@ -0,0 +1,201 @@
+/*
+ * HeightPyramid.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: michi
+ */
+
+#include "HeightPyramid.h"
+#include <lib/math/math.h>
+#include <cmath>
+
+float height_grid_square(const float *height, int num_z, int i, int j, float u, float v, float &sx, float &sz) {
+	float ha = height[i * (num_z + 1) + j];
+	float hb = height[(i + 1) * (num_z + 1) + j];
+	float hc = height[i * (num_z + 1) + j + 1];
+	float hd = height[(i + 1) * (num_z + 1) + j + 1];
+	bool upper = (u < v);
+	sx = upper ? (hd - hc) : (hb - ha);
+	sz = upper ? (hc - ha) : (hd - hb);
+	return ha + sx * u + sz * v;
+}
+
+void HeightPyramid::update(const Array<float> &_height, int _num_x, int _num_z, const vec3 &_pattern, int x1, int x2, int z1, int z2) {
+	height = &_height[0];
+	pattern = _pattern;
+	if (_num_x <= 0 or _num_z <= 0)
+		return;
+
+	// (re)create
+	if (levels.num == 0 or _num_x != num_x or _num_z != num_z) {
+		num_x = _num_x;
+		num_z = _num_z;
+		levels.clear();
+		int nx = num_x, nz = num_z;
+		while (true) {
+			Level l;
+			l.nx = nx;
+			l.nz = nz;
+			l.min.resize(nx * nz);
+			l.max.resize(nx * nz);
+			levels.add(l);
+			if (nx == 1 and nz == 1)
+				break;
+			nx = (nx + 1) / 2;
+			nz = (nz + 1) / 2;
+		}
+		x1 = z1 = 0;
+		x2 = num_x;
+		z2 = num_z;
+	}
+
+	// squares touching the changed vertices
+	int cx1 = max(x1 - 1, 0), cx2 = min(x2, num_x - 1);
+	int cz1 = max(z1 - 1, 0), cz2 = min(z2, num_z - 1);
+	auto &l0 = levels[0];
+	int w = num_z + 1;
+	for (int i=cx1; i<=cx2; i++)
+		for (int j=cz1; j<=cz2; j++) {
+			float ha = height[i * w + j];
+			float hb = height[(i + 1) * w + j];
+			float hc = height[i * w + j + 1];
+			float hd = height[(i + 1) * w + j + 1];
+			l0.min[i * l0.nz + j] = min(min(ha, hb), min(hc, hd));
+			l0.max[i * l0.nz + j] = max(max(ha, hb), max(hc, hd));
+		}
+
+	for (int k=1; k<levels.num; k++) {
+		auto &lc = levels[k - 1];
+		auto &l = levels[k];
+		cx1 /= 2;
+		cx2 /= 2;
+		cz1 /= 2;
+		cz2 /= 2;
+		for (int i=cx1; i<=cx2; i++)
+			for (int j=cz1; j<=cz2; j++) {
+				float h0 = lc.min[(i*2) * lc.nz + j*2];
+				float h1 = lc.max[(i*2) * lc.nz + j*2];
+				for (int ii=i*2; ii<min(i*2+2, lc.nx); ii++)
+					for (int jj=j*2; jj<min(j*2+2, lc.nz); jj++) {
+						h0 = min(h0, lc.min[ii * lc.nz + jj]);
+						h1 = max(h1, lc.max[ii * lc.nz + jj]);
+					}
+				l.min[i * l.nz + j] = h0;
+				l.max[i * l.nz + j] = h1;
+			}
+	}
+}
+
+// segment p + d * s, crossing the surface of square (i,j) in [s0, s1]?
+bool HeightPyramid::trace_square(const vec3 &p, const vec3 &d, int i, int j, float s0, float s1, float &s_hit) const {
+	auto uv = [this, &p, &d, i, j] (float s, float &u, float &v) {
+		u = (p.x + d.x * s) / pattern.x - (float)i;
+		v = (p.z + d.z * s) / pattern.z - (float)j;
+	};
+	// height above the triangle containing (u,v) at s_ref
+	auto above = [this, &p, &d, &uv, i, j] (float s, float s_ref) {
+		float u, v, ur, vr, sx, sz;
+		uv(s, u, v);
+		uv(s_ref, ur, vr);
+		float h = height_grid_square(height, num_z, i, j, ur, vr, sx, sz);
+		return p.y + d.y * s - (h + sx * (u - ur) + sz * (v - vr));
+	};
+
+	// split at the diagonal u = v
+	float u0, v0, u1, v1;
+	uv(s0, u0, v0);
+	uv(s1, u1, v1);
+	float g0 = u0 - v0, g1 = u1 - v1;
+	float s_split[3] = {s0, s1, s1};
+	int n = 2;
+	if ((g0 < 0) != (g1 < 0) and g0 != g1) {
+		s_split[1] = s0 + (s1 - s0) * g0 / (g0 - g1);
+		n = 3;
+	}
+
+	for (int k=0; k<n-1; k++) {
+		float a = s_split[k], b = s_split[k + 1];
+		float m = (a + b) * 0.5f;
+		float fa = above(a, m);
+		float fb = above(b, m);
+		if ((fa >= 0 and fb <= 0) or (fa <= 0 and fb >= 0)) {
+			s_hit = (fa == fb) ? a : (a + (b - a) * fa / (fa - fb));
+			return true;
+		}
+	}
+	return false;
+}
+
+bool HeightPyramid::trace(const vec3 &p, const vec3 &d, float &s_hit, int &i, int &j) const {
+	if (levels.num == 0)
+		return false;
+
+	// clip to the grid (xz)
+	float s0 = 0, s1 = 1;
+	float lo[2] = {0, 0};
+	float hi[2] = {pattern.x * (float)num_x, pattern.z * (float)num_z};
+	float pp[2] = {p.x, p.z};
+	float dd[2] = {d.x, d.z};
+	for (int k=0; k<2; k++) {
+		if (dd[k] == 0) {
+			if (pp[k] < lo[k] or pp[k] > hi[k])
+				return false;
+			continue;
+		}
+		float a = (lo[k] - pp[k]) / dd[k];
+		float b = (hi[k] - pp[k]) / dd[k];
+		s0 = max(s0, min(a, b));
+		s1 = min(s1, max(a, b));
+	}
+	if (s0 > s1)
+		return false;
+
+	int top = levels.num - 1;
+	int level = top;
+	float s = s0;
+	while (s < s1) {
+		auto &l = levels[level];
+		float size_x = pattern.x * (float)(1 << level);
+		float size_z = pattern.z * (float)(1 << level);
+
+		// cell we are entering at s
+		vec3 q = p + d * s;
+		int ci = (d.x < 0) ? (int)ceil(q.x / size_x) - 1 : (int)floor(q.x / size_x);
+		int cj = (d.z < 0) ? (int)ceil(q.z / size_z) - 1 : (int)floor(q.z / size_z);
+		ci = clamp(ci, 0, l.nx - 1);
+		cj = clamp(cj, 0, l.nz - 1);
+
+		// and leaving
+		float s_out = s1;
+		if (d.x > 0)
+			s_out = min(s_out, ((float)(ci + 1) * size_x - p.x) / d.x);
+		else if (d.x < 0)
+			s_out = min(s_out, ((float)ci * size_x - p.x) / d.x);
+		if (d.z > 0)
+			s_out = min(s_out, ((float)(cj + 1) * size_z - p.z) / d.z);
+		else if (d.z < 0)
+			s_out = min(s_out, ((float)cj * size_z - p.z) / d.z);
+		if (s_out <= s)
+			s_out = nextafterf(s, s1);
+
+		// completely above this cell?
+		float y_min = min(p.y + d.y * s, p.y + d.y * s_out);
+		if (y_min > l.max[ci * l.nz + cj]) {
+			s = s_out;
+			level = min(level + 1, top);
+			continue;
+		}
+		if (level > 0) {
+			level --;
+			continue;
+		}
+
+		if (trace_square(p, d, ci, cj, s, s_out, s_hit)) {
+			i = ci;
+			j = cj;
+			return true;
+		}
+		s = s_out;
+	}
+	return false;
+}
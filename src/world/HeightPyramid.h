@@ -0,0 +1,44 @@
+/*
+ * HeightPyramid.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include <lib/base/base.h>
+#include <lib/math/vec3.h>
+
+// (c d)
+// (a b)  triangles (acd), (adb)
+//   height: (num_x+1) x (num_z+1) values, index x*(num_z+1)+z (like Terrain::height)
+//   u,v in [0,1], sx,sz: height difference per square
+float height_grid_square(const float *height, int num_z, int i, int j, float u, float v, float &sx, float &sz);
+
+// min/max heights of 2^l x 2^l squares per level l, down to a single square
+//   lets rays skip whole blocks they pass above
+//   everything in terrain space
+class HeightPyramid {
+public:
+	struct Level {
+		int nx, nz;
+		Array<float> min, max;
+	};
+	Array<Level> levels;
+
+	// heights of the vertices in [x1,x2] x [z1,z2] changed
+	//   (re)creates all levels if the grid size changed
+	void update(const Array<float> &height, int num_x, int num_z, const vec3 &pattern, int x1, int x2, int z1, int z2);
+
+	// 2d dda, first crossing of p + d * s (s in [0,1]) with the surface
+	//   (i,j): square that got hit
+	bool trace(const vec3 &p, const vec3 &d, float &s_hit, int &i, int &j) const;
+
+private:
+	bool trace_square(const vec3 &p, const vec3 &d, int i, int j, float s0, float s1, float &s_hit) const;
+
+	const float *height = nullptr;
+	int num_x = 0, num_z = 0;
+	vec3 pattern;
+};
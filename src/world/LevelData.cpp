@@ -200,6 +200,217 @@ bool LevelData::load(const Path &filename) {
 }
 
 
+// cooked format: all fields in declaration order, no text parsing needed
+static const int COOKED_MAGIC = 0x646c7763; // "cwld"
+static const int COOKED_VERSION = 1;
+
+static void write_color(Stream *f, const color &c) {
+	f->write_float(c.r);
+	f->write_float(c.g);
+	f->write_float(c.b);
+	f->write_float(c.a);
+}
+
+static color read_color(Stream *f) {
+	color c;
+	c.r = f->read_float();
+	c.g = f->read_float();
+	c.b = f->read_float();
+	c.a = f->read_float();
+	return c;
+}
+
+static void write_scripts(Stream *f, const Array<LevelData::ScriptData> &scripts) {
+	f->write_int(scripts.num);
+	for (auto &s: scripts) {
+		f->write_str(s.filename.str());
+		f->write_str(s.class_name);
+		f->write_str(s.var);
+		f->write_int(s.variables.num);
+		for (auto &v: s.variables) {
+			f->write_str(v.name);
+			f->write_str(v.value);
+		}
+	}
+}
+
+static Array<LevelData::ScriptData> read_scripts(Stream *f) {
+	Array<LevelData::ScriptData> scripts;
+	scripts.resize(f->read_int());
+	for (auto &s: scripts) {
+		s.filename = f->read_str();
+		s.class_name = f->read_str();
+		s.var = f->read_str();
+		s.variables.resize(f->read_int());
+		for (auto &v: s.variables) {
+			v.name = f->read_str();
+			v.value = f->read_str();
+		}
+	}
+	return scripts;
+}
+
+bool LevelData::load_cooked(const Path &filename) {
+	owned<os::fs::FileStream> file(os::fs::open(filename, "rbc"));
+	auto f = file.get();
+	if (f->read_int() != COOKED_MAGIC or f->read_int() != COOKED_VERSION)
+		return false;
+	world_filename = f->read_str();
+
+	skybox_filename.resize(f->read_int());
+	skybox_ang.resize(skybox_filename.num);
+	for (int i=0; i<skybox_filename.num; i++) {
+		skybox_filename[i] = f->read_str();
+		f->read_vector(&skybox_ang[i]);
+	}
+	background_color = read_color(f);
+	ego_index = f->read_int();
+
+	physics_enabled = f->read_bool();
+	physics_mode = (PhysicsMode)f->read_int();
+	f->read_vector(&gravity);
+
+	fog.enabled = f->read_bool();
+	fog.mode = f->read_int();
+	fog.start = f->read_float();
+	fog.end = f->read_float();
+	fog.distance = f->read_float();
+	fog._color = read_color(f);
+
+	scripts = read_scripts(f);
+
+	objects.resize(f->read_int());
+	for (auto &o: objects) {
+		o.filename = f->read_str();
+		o.name = f->read_str();
+		f->read_vector(&o.pos);
+		f->read_vector(&o.ang);
+		o.components = read_scripts(f);
+	}
+
+	terrains.resize(f->read_int());
+	for (auto &t: terrains) {
+		t.filename = f->read_str();
+		f->read_vector(&t.pos);
+		t.components = read_scripts(f);
+	}
+
+	lights.resize(f->read_int());
+	for (auto &l: lights) {
+		l.enabled = f->read_bool();
+		f->read_vector(&l.pos);
+		f->read_vector(&l.ang);
+		l._color = read_color(f);
+		l.radius = f->read_float();
+		l.theta = f->read_float();
+		l.harshness = f->read_float();
+		l.components = read_scripts(f);
+	}
+
+	cameras.resize(f->read_int());
+	for (auto &c: cameras) {
+		f->read_vector(&c.pos);
+		f->read_vector(&c.ang);
+		c.fov = f->read_float();
+		c.min_depth = f->read_float();
+		c.max_depth = f->read_float();
+		c.exposure = f->read_float();
+		c.bloom_factor = f->read_float();
+		c.components = read_scripts(f);
+	}
+
+	links.resize(f->read_int());
+	for (auto &l: links) {
+		l.object[0] = f->read_int();
+		l.object[1] = f->read_int();
+		l.type = (LinkType)f->read_int();
+		f->read_vector(&l.pos);
+		f->read_vector(&l.ang);
+		l.components = read_scripts(f);
+	}
+	return true;
+}
+
+void LevelData::save_cooked(const Path &filename) {
+	owned<os::fs::FileStream> file(os::fs::open(filename, "wbc"));
+	auto f = file.get();
+	f->write_int(COOKED_MAGIC);
+	f->write_int(COOKED_VERSION);
+	f->write_str(world_filename.str());
+
+	f->write_int(skybox_filename.num);
+	for (int i=0; i<skybox_filename.num; i++) {
+		f->write_str(skybox_filename[i].str());
+		f->write_vector(&skybox_ang[i]);
+	}
+	write_color(f, background_color);
+	f->write_int(ego_index);
+
+	f->write_bool(physics_enabled);
+	f->write_int((int)physics_mode);
+	f->write_vector(&gravity);
+
+	f->write_bool(fog.enabled);
+	f->write_int(fog.mode);
+	f->write_float(fog.start);
+	f->write_float(fog.end);
+	f->write_float(fog.distance);
+	write_color(f, fog._color);
+
+	write_scripts(f, scripts);
+
+	f->write_int(objects.num);
+	for (auto &o: objects) {
+		f->write_str(o.filename.str());
+		f->write_str(o.name);
+		f->write_vector(&o.pos);
+		f->write_vector(&o.ang);
+		write_scripts(f, o.components);
+	}
+
+	f->write_int(terrains.num);
+	for (auto &t: terrains) {
+		f->write_str(t.filename.str());
+		f->write_vector(&t.pos);
+		write_scripts(f, t.components);
+	}
+
+	f->write_int(lights.num);
+	for (auto &l: lights) {
+		f->write_bool(l.enabled);
+		f->write_vector(&l.pos);
+		f->write_vector(&l.ang);
+		write_color(f, l._color);
+		f->write_float(l.radius);
+		f->write_float(l.theta);
+		f->write_float(l.harshness);
+		write_scripts(f, l.components);
+	}
+
+	f->write_int(cameras.num);
+	for (auto &c: cameras) {
+		f->write_vector(&c.pos);
+		f->write_vector(&c.ang);
+		f->write_float(c.fov);
+		f->write_float(c.min_depth);
+		f->write_float(c.max_depth);
+		f->write_float(c.exposure);
+		f->write_float(c.bloom_factor);
+		write_scripts(f, c.components);
+	}
+
+	f->write_int(links.num);
+	for (auto &l: links) {
+		f->write_int(l.object[0]);
+		f->write_int(l.object[1]);
+		f->write_int((int)l.type);
+		f->write_vector(&l.pos);
+		f->write_vector(&l.ang);
+		write_scripts(f, l.components);
+	}
+}
+
+
 #if 0
 static string v2s(const vec3 &v) {
 	return format("%.3f %.3f %.3f", v.x, v.y, v.z);
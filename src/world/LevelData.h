@@ -46,6 +46,10 @@ public:
 	bool load(const Path &filename);
 	void save(const Path &filename);
 
+	// binary cache of a parsed .world file
+	bool load_cooked(const Path &filename);
+	void save_cooked(const Path &filename);
+
 
 	class ScriptData {
 	public:
@@ -65,6 +65,23 @@ Material::Material(ResourceManager *rm) {
 	friction.rolling = 0.90f;
 }
 
+Material::~Material() = default;
+
+UniformBuffer* Material::update_ubo() const {
+	UBOData d = {albedo, emission, roughness, metal, {0, 0}};
+	if (!ubo)
+		ubo = new UniformBuffer(sizeof(UBOData));
+	else if (memcmp(&d, &ubo_data, sizeof(d)) == 0)
+		return ubo.get();
+	ubo_data = d;
+#ifdef USING_VULKAN
+	ubo->update_part(&d, 0, sizeof(d));
+#else
+	ubo->update(&d, sizeof(d));
+#endif
+	return ubo.get();
+}
+
 void Material::add_uniform(const string &name, float *p, int size) {
 	uniforms.add({name, p, size});
 }
@@ -64,6 +64,17 @@ public:
 	color albedo, emission;
 	float roughness, metal;
 
+	// gpu copy of albedo...metal (gl: uniform block "MaterialData")
+	struct UBOData {
+		color albedo, emission;
+		float roughness, metal;
+		int dummy[2];
+	};
+	mutable UBOData ubo_data;
+	mutable owned<UniformBuffer> ubo;
+	// only uploads, when the parameters changed
+	UniformBuffer* update_ubo() const;
+
 	bool cast_shadow;
 
 	struct RenderPassData {
@@ -96,6 +107,7 @@ public:
 	} friction;
 
 	explicit Material(ResourceManager *resource_manager);
+	~Material();
 	xfer<Material> copy();
 
 	bool is_transparent() const;
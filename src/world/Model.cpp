@@ -26,10 +26,12 @@
 #include "Material.h"
 #include "World.h"
 #include "../y/Entity.h"
+#include "../y/EngineData.h"
 #include <lib/math/complex.h>
 #include "../meta.h"
 #include "../graphics-impl.h"
 #include <lib/os/msg.h>
+#include <atomic>
 #include "components/Animator.h"
 
 
@@ -191,6 +193,8 @@ void SubMesh::update_vb(Mesh *mesh, bool animated) {
 }
 
 void Mesh::update_vb(bool animated) {
+	static std::atomic<int> next_generation = 1;
+	generation = next_generation ++;
 	for (auto &s: sub)
 		s.update_vb(this, animated);
 }
@@ -544,8 +548,24 @@ Path Model::filename() {
 }
 
 void Model::update_matrix() {
-	if (owner)
-		_matrix = owner->get_matrix();
+	if (!owner)
+		return;
+	_matrix = owner->get_matrix_cached();
+
+	// fixed ticks: between the previous and the current tick
+	if (engine.fixed_dt > 0 and matrix_old_tick == engine.tick and engine.tick_alpha < 1) {
+		float t = engine.tick_alpha;
+		vec3 p = matrix_old * vec3::ZERO * (1 - t) + _matrix * vec3::ZERO * t;
+		auto q = quaternion::interpolate(quaternion::rotation(matrix_old), quaternion::rotation(_matrix), t);
+		_matrix = mat4::translation(p) * mat4::rotation(q);
+	}
+}
+
+void Model::reset_previous_matrix() {
+	if (!owner)
+		return;
+	matrix_old = owner->get_matrix();
+	matrix_old_tick = engine.tick;
 }
 
 #if 0
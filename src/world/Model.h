@@ -92,6 +92,9 @@ public:
 
 	Model *owner;
 
+	// new (globally unique) value whenever the geometry changes (update_vb), for caches (ray tracing)
+	int generation = 0;
+
 	xfer<Mesh> copy(Model *new_owner);
 };
 
@@ -159,7 +162,11 @@ public:
 	bool visible;
 
 	mat4 _matrix, matrix_old;
+	// matrix_old is the transform before this engine tick
+	int matrix_old_tick = -1;
 	void update_matrix();
+	// no blending from the previous tick (teleports)
+	void reset_previous_matrix();
 
 	// template
 	shared<ModelTemplate> _template;
@@ -45,7 +45,7 @@ ResourceManager *chunked_file_parser_get_resource_manager(ChunkedFileParser *p);
 
 Stream *load_file_x(const Path &filename, int &version) {
 
-	auto f = os::fs::open(filename, "rb");
+	auto f = os::fs::open(filename, "rbc");
 	char c = f->read_char();
 	if (c == 'b') {
 		version = f->read_word();
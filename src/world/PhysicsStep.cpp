@@ -0,0 +1,26 @@
+/*
+ * PhysicsStep.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: michi
+ */
+
+#include "PhysicsStep.h"
+
+void PhysicsStep::start(std::function<void()> f) {
+	wait();
+	collecting = true;
+	task = ThreadPool::get()->submit(f);
+}
+
+void PhysicsStep::wait() {
+	if (!task)
+		return;
+	ThreadPool::get()->wait(task);
+	task = nullptr;
+	collecting = false;
+}
+
+bool PhysicsStep::is_running() const {
+	return (bool)task;
+}
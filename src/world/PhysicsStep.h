@@ -0,0 +1,28 @@
+/*
+ * PhysicsStep.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include <lib/threads/ThreadPool.h>
+#include <functional>
+
+// one simulation step running on the ThreadPool (engine.pipelined)
+//   the step owns bullet's state until it got joined,
+//   so everything touching a btRigidBody has to wait() first
+class PhysicsStep {
+public:
+	void start(std::function<void()> f);
+	// joins the running step, cheap if there is none
+	void wait();
+	bool is_running() const;
+
+	// set while running: callbacks from the step must not run scripts
+	bool collecting = false;
+
+private:
+	TaskRef task;
+};
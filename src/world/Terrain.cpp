@@ -8,6 +8,7 @@
 \*----------------------------------------------------------------------------*/
 
 #include "Terrain.h"
+#include "TerrainHeightfield.h"
 #include "Material.h"
 #include "World.h"
 #include "../y/EngineData.h"
@@ -15,9 +16,11 @@
 #include "../graphics-impl.h"
 #include <lib/math/vec3.h>
 #include <lib/math/plane.h>
+#include <lib/math/Box.h>
 #include <lib/os/file.h>
 #include <lib/os/msg.h>
 #include <lib/os/time.h>
+#include "../Config.h"
 
 const kaba::Class *Terrain::_class = nullptr;
 
@@ -28,10 +31,19 @@ const kaba::Class *Terrain::_class = nullptr;
 //#define min(a,b)		(((a)<(b))?(a):(b))
 
 void Terrain::reset() {
+	if (updater)
+		updater->wait();
+	for (auto &c: chunks)
+		delete c.vertex_buffer;
+	heightfield.clear();
 	filename = "";
 	error = false;
 	num_x = num_z = 0;
+	render_mode = TerrainRenderMode::CHUNKS;
+	num_chunks_x = num_chunks_z = 0;
+	chunks.clear();
 	changed = false;
+	version = 0;
 	vertex_shader_module = "default";
 }
 
@@ -51,7 +63,7 @@ bool Terrain::load(ResourceManager *resource_manager, const Path &_filename_, bo
 	reset();
 
 	filename = _filename_;
-	auto f = os::fs::open(engine.map_dir | filename.with(".map"), "rb");
+	auto f = os::fs::open(engine.map_dir | filename.with(".map"), "rbc");
 	if (f) {
 		//int ffv = f->read_ReadFileFormatVersion();
 
@@ -94,15 +106,19 @@ bool Terrain::load(ResourceManager *resource_manager, const Path &_filename_, bo
 				for (int x=0;x<num_x+1;x++)
 					for (int z=0;z<num_z+1;z++)
 						height[Index(x,z)] = f->read_float();
-				for (int x=0;x<num_x/TERRAIN_CHUNK_SIZE+1;x++)
-					for (int z=0;z<num_z/TERRAIN_CHUNK_SIZE+1;z++)
-						chunk_lod[x][z] = -1;
-
-//#ifdef USING_VULKAN
-				vertex_buffer = new VertexBuffer("3f,3f,2f");
-//#else
-//				vertex_buffer = new VertexBuffer("3f,3f" + string(",2f").repeat(material->textures.num));
-//#endif
+				// (including the partially filled ones)
+				num_chunks_x = (num_x - 1) / TERRAIN_CHUNK_SIZE + 1;
+				num_chunks_z = (num_z - 1) / TERRAIN_CHUNK_SIZE + 1;
+				chunks.resize(num_chunks_x * num_chunks_z);
+
+				if (config.get_str("terrain.mode", "chunks") == "heightfield")
+					render_mode = TerrainRenderMode::HEIGHTFIELD;
+				if (render_mode == TerrainRenderMode::HEIGHTFIELD) {
+					heightfield = new TerrainHeightfield(this);
+					vertex_shader_module = "heightfield";
+				} else if (!updater) {
+					updater = new XTerrainVBUpdater(this);
+				}
 			}
 		} else {
 			msg_error(format("wrong file format: %d (4 expected)",ffv));
@@ -130,10 +146,20 @@ bool Terrain::load(ResourceManager *resource_manager, const Path &_filename_, bo
 }
 
 Terrain::~Terrain() {
+	if (updater)
+		updater->wait();
+	for (auto &c: chunks)
+		delete c.vertex_buffer;
 }
 
 // die Normalen-Vektoren in einem bestimmten Abschnitt der Karte neu berechnen
 void Terrain::update(int x1,int x2,int z1,int z2,int mode) {
+	// the chunk build reads vertex/normal on the workers
+	if (updater and updater->task) {
+		updater->wait();
+		updater->upload();
+	}
+
 	if (x1<0)		x1=0;
 	if (x2<0)		x2=num_x;
 	if (x2>=num_x)	x2=num_x;
@@ -189,43 +215,122 @@ void Terrain::update(int x1,int x2,int z1,int z2,int mode) {
 				pl[nt+1] = plane::from_points(vertex[Index(i  ,j  )],vertex[Index(i+1,j+1)],vertex[Index(i+1,j  )]);
 			}
 
-	force_redraw = true;
+	update_chunks(x1, x2, z1, z2);
+	update_height_levels(x1, x2, z1, z2);
+	if (heightfield)
+		heightfield->dirty = true;
+	version ++;
 }
 
-float Terrain::gimme_height(const vec3 &p) // liefert die interpolierte Hoehe zu einer Position
-{
-	auto o = owner;
-	float x = p.x - o->pos.x;
-	float z = p.z - o->pos.z;
+void Terrain::update_chunks(int x1, int x2, int z1, int z2) {
+	if (chunks.num == 0)
+		return;
+	// border vertices are shared with the previous chunk
+	int cx1 = ::max(x1 - 1, 0) / TERRAIN_CHUNK_SIZE;
+	int cx2 = ::min(x2 / TERRAIN_CHUNK_SIZE, num_chunks_x - 1);
+	int cz1 = ::max(z1 - 1, 0) / TERRAIN_CHUNK_SIZE;
+	int cz2 = ::min(z2 / TERRAIN_CHUNK_SIZE, num_chunks_z - 1);
+	for (int cx=cx1; cx<=cx2; cx++)
+		for (int cz=cz1; cz<=cz2; cz++) {
+			int x0 = cx * TERRAIN_CHUNK_SIZE;
+			int z0 = cz * TERRAIN_CHUNK_SIZE;
+			int xe = ::min(x0 + TERRAIN_CHUNK_SIZE, num_x);
+			int ze = ::min(z0 + TERRAIN_CHUNK_SIZE, num_z);
+			float h0 = height[Index(x0, z0)], h1 = h0;
+			for (int x=x0; x<=xe; x++)
+				for (int z=z0; z<=ze; z++) {
+					float h = height[Index(x, z)];
+					h0 = ::min(h0, h);
+					h1 = ::max(h1, h);
+				}
+			auto &c = chunk(cx, cz);
+			c.dirty = true;
+			c.version ++;
+			c.min = vec3(pattern.x * (float)x0, h0, pattern.z * (float)z0);
+			c.max = vec3(pattern.x * (float)xe, h1, pattern.z * (float)ze);
+		}
+}
+
+bool Terrain::chunk_visible(const TerrainChunk &c, const mat4 &m) const {
+	return Box{c.min, c.max}.in_frustum(m);
+}
+
+float Terrain::square_height(int i, int j, float u, float v, float &sx, float &sz) const {
+	return height_grid_square(&height[0], num_z, i, j, u, v, sx, sz);
+}
+
+bool Terrain::local_height(float x, float z, float &h, float &sx, float &sz) const {
 	if ((x<=min.x)||(z<=min.z)||(x>=max.x)||(z>=max.z))
+		return false;
+	float fx = x / pattern.x;
+	float fz = z / pattern.z;
+	int i = ::min((int)fx, num_x - 1);
+	int j = ::min((int)fz, num_z - 1);
+	h = square_height(i, j, fx - (float)i, fz - (float)j, sx, sz);
+	return true;
+}
+
+static vec3 square_normal(const vec3 &pattern, float sx, float sz) {
+	return vec3(-pattern.z * sx, pattern.x * pattern.z, -pattern.x * sz).normalized();
+}
+
+// liefert die interpolierte Hoehe zu einer Position
+float Terrain::gimme_height(const vec3 &p) const {
+	vec3 o = owner ? owner->pos : v_0;
+	float h, sx, sz;
+	if (!local_height(p.x - o.x, p.z - o.z, h, sx, sz))
+		return p.y;
+	return h + o.y;
+}
+
+float Terrain::gimme_height_n(const vec3 &p, vec3 &n) const {
+	vec3 o = owner ? owner->pos : v_0;
+	float h, sx, sz;
+	if (!local_height(p.x - o.x, p.z - o.z, h, sx, sz)) {
+		n = vec3::EY;
 		return p.y;
-	bool SPI_OB=false;
-	float he=0;
-	int dr_z=(int)(z/pattern.z); // welches Dreieck?
-	int dr_x=(int)(x/pattern.x);
-	if (x-dr_x*pattern.x<z-dr_z*pattern.z)
-		SPI_OB=true;
-	int j=dr_z;
-	int i=dr_x;
-	if (SPI_OB){ // genaue Position auf dem Dreieck
-		dhx=height[Index(i+1,j+1)]-height[Index(i,j+1)];
-		dhz=height[Index(i,j)]-height[Index(i,j+1)];
-		he=height[Index(dr_x,dr_z+1)] + dhx/pattern.x*(x-dr_x*pattern.x) + dhz/pattern.z*(dr_z*pattern.z+pattern.z-z);
-	}else{
-		dhx=height[Index(i+1,j  )]-height[Index(i  ,j  )];
-		dhz=height[Index(i+1,j  )]-height[Index(i+1,j+1)];
-		he=height[Index(dr_x+1,dr_z)]-dhx/pattern.x*(dr_x*pattern.x+pattern.x-x)-dhz/pattern.z*(z-dr_z*pattern.z);
 	}
+	n = square_normal(pattern, sx, sz);
+	return h + o.y;
+}
 
-	return he+o->pos.y;
+static const int BATCH_GRAIN = 4096;
+
+void Terrain::gimme_heights(const Array<vec3> &p, Array<float> &h) const {
+	h.resize(p.num);
+	vec3 o = owner ? owner->pos : v_0;
+	auto f = [this, &p, &h, o] (int first, int end) {
+		for (int i=first; i<end; i++) {
+			float hh, sx, sz;
+			h[i] = local_height(p[i].x - o.x, p[i].z - o.z, hh, sx, sz) ? (hh + o.y) : p[i].y;
+		}
+	};
+	if (p.num > BATCH_GRAIN)
+		ThreadPool::get()->parallel_for(p.num, f, BATCH_GRAIN);
+	else
+		f(0, p.num);
 }
 
-float Terrain::gimme_height_n(const vec3 &p, vec3 &n) {
-	float he = gimme_height(p);
-	vec3 vdx = vec3(pattern.x, dhx,0        );
-	vec3 vdz = vec3(0        ,-dhz,pattern.z);
-	n = vec3::cross(vdz, vdx).normalized();
-	return he;
+void Terrain::gimme_heights_n(const Array<vec3> &p, Array<float> &h, Array<vec3> &n) const {
+	h.resize(p.num);
+	n.resize(p.num);
+	vec3 o = owner ? owner->pos : v_0;
+	auto f = [this, &p, &h, &n, o] (int first, int end) {
+		for (int i=first; i<end; i++) {
+			float hh, sx, sz;
+			if (local_height(p[i].x - o.x, p[i].z - o.z, hh, sx, sz)) {
+				h[i] = hh + o.y;
+				n[i] = square_normal(pattern, sx, sz);
+			} else {
+				h[i] = p[i].y;
+				n[i] = vec3::EY;
+			}
+		}
+	};
+	if (p.num > BATCH_GRAIN)
+		ThreadPool::get()->parallel_for(p.num, f, BATCH_GRAIN);
+	else
+		f(0, p.num);
 }
 
 // Daten fuer das Darstellen des Bodens
@@ -250,7 +355,7 @@ void Terrain::calc_detail(const vec3 &cam_pos) {
 			if (depth<70)	e=2;
 			if (depth<40)	e=1;*/
 			//msg_write(format("%.1f   %f", depth, log(depth / 40)));
-			chunk_lod[x1][z1] = clamp((int)log(depth / 20), 0, TERRAIN_LOG_CHUNK_SIZE);
+			chunk(x1, z1).lod = clamp((int)log(depth / 20), 0, TERRAIN_LOG_CHUNK_SIZE);
 		}
 }
 
@@ -335,149 +440,56 @@ void Terrain::get_triangle_hull(TriangleHull *h, vec3 &_pos_, float _radius_)
 		}
 }
 
-inline bool TracePattern(Terrain *t, const vec3 &pos, const vec3 &p1,const vec3 &p2, CollisionData &data, int x, int z, float y_min, int dir, float range)
-{
-	// trace beam too high above this pattern?
-	if ( (t->height[Index2(t,x,z)]<y_min) and (t->height[Index2(t,x,z+1)]<y_min) and (t->height[Index2(t,x+1,z)]<y_min) and (t->height[Index2(t,x+1,z+1)]<y_min) )
-		return false;
+void Terrain::update_height_levels(int x1, int x2, int z1, int z2) {
+	height_levels.update(height, num_x, num_z, pattern, x1, x2, z1, z2);
+}
 
-	// 4 vertices for 2 triangles
-	vec3 a = pos + t->vertex[Index2(t,x  ,z  )];
-	vec3 b = pos + t->vertex[Index2(t,x+1,z  )];
-	vec3 c = pos + t->vertex[Index2(t,x  ,z+1)];
-	vec3 d = pos + t->vertex[Index2(t,x+1,z+1)];
-
-	float dmin1 = range, dmin2 = range;
-	vec3 ttp;
-	vec3 v;
-
-	// scan both triangles
-	vec3 tp;
-	if (line_intersects_triangle(a,b,d,p1,p2,tp))
-		dmin1=(tp-p1).length();
-	if (line_intersects_triangle(a,c,d,p1,p2,ttp)){
-		dmin2=(tp-p1).length();
-		if (dmin2<dmin1){ // better than the first one?
-			dmin1=dmin2;
-			tp=ttp;
-		}
-	}
-	if (dmin1 >= range)
+bool Terrain::trace(const vec3 &p1, const vec3 &p2, const vec3 &dir, float range, CollisionData &data, bool simple_test) const {
+	vec3 o = owner ? owner->pos : v_0;
+	vec3 p = p1 - o;
+	vec3 d = p2 - p1;
+	float s;
+	int i, j;
+	if (!height_levels.trace(p, d, s, i, j))
 		return false;
 
-	// don't scan backwards...
-	if ((dir==0) and (tp.x<p1.x))	return false;
-	if ((dir==1) and (tp.z<p1.z))	return false;
-	if ((dir==2) and (tp.x>p1.x))	return false;
-	if ((dir==3) and (tp.z>p1.z))	return false;
+	vec3 hit = p + d * s;
+	vec3 r = (dir.length_sqr() > 0) ? dir.normalized() : d.normalized();
+	float dist = vec3::dot(hit - p, r);
+	if (dist < 0 or dist >= range)
+		return false;
 
-	data.pos= tp;
-	data.entity = t->owner;
+	data.entity = owner;
+	data.body = nullptr;
+	if (simple_test)
+		return true;
+	float sx, sz;
+	square_height(i, j, hit.x / pattern.x - (float)i, hit.z / pattern.z - (float)j, sx, sz);
+	data.pos = hit + o;
+	data.n = square_normal(pattern, sx, sz);
 	return true;
 }
 
-bool Terrain::trace(const vec3 &p1, const vec3 &p2, const vec3 &dir, float range, CollisionData &data, bool simple_test) {
-	vec3 pr1 = p1;
-	vec3 pr2 = p2;
-	vec3 pos = v_0;
-	if (owner) {
-		auto o = owner;
-		pr1 -= o->pos;
-		pr2 -= o->pos;
-		pos = o->pos;
-	}
-	[[maybe_unused]] float dmin = range + 1;
-	vec3 c;
-
-	if ((p2.x==p1.x) and (p2.z==p1.z) and (p2.y<p1.y)){
-		float h=gimme_height(p1);
-		if (p2.y < h){
-			data.pos = vec3(p1.x,h,p1.z);
-			data.entity = owner;
-			return true;
-		}
-	}
-
-	float w=(float)atan2(p2.z-p1.z,p2.x-p1.x);
-	int x,z;
-	float y_rel;
-
-// scanning directions
-
-	// positive x (to the right)
-	if ((w>=-pi/4) and (w<pi/4)){
-		int x0 = ::max( int(pr1.x/pattern.x), 0 );
-		int x1 = ::min( int(pr2.x/pattern.x), num_x );
-		for (x=x0;x<x1;x++){
-			z = int( ( ( pattern.x*((float)x+0.5f) - pr1.x ) * (pr2.z-pr1.z) / (pr2.x-pr1.x) + pr1.z ) / pattern.z - 0.5f );
-			if ( ( z > num_z - 2) || ( z < 0 ) )
-				break;
-			if ( p1.y > p2.y )	y_rel = pr1.y + ( ( x + 1 ) * pattern.x - pr1.x ) * ( pr2.y - pr1.y ) / ( pr2.x - pr1.x );
-			else				y_rel = pr1.y + (   x       * pattern.x - pr1.x ) * ( pr2.y - pr1.y ) / ( pr2.x - pr1.x );
-			if (TracePattern(this,pos,p1,p2,data,x,z  ,y_rel,0,range))	return true;
-			if (TracePattern(this,pos,p1,p2,data,x,z+1,y_rel,0,range))	return true;
-		}
-	}
-
-	// positive z (forward)
-	if ((w>=pi/4) and (w<pi*3/4)){
-		int z0 = ::max( int(pr1.z/pattern.z), 0 );
-		int z1 = ::min( int(pr2.z/pattern.z), num_z );
-		for (z=z0;z<z1;z++){
-			x = int( ( ( pattern.z*((float)z+0.5f) - pr1.z ) * (pr2.x-pr1.x) / (pr2.z-pr1.z) + pr1.x ) / pattern.x - 0.5f );
-			if ( ( x > num_x - 2) || ( x < 0 ) )
-				break;
-			if ( p1.y > p2.y )	y_rel = pr1.y + ( ( z + 1 ) * pattern.z - pr1.z ) * ( pr2.y - pr1.y ) / ( pr2.z - pr1.z );
-			else				y_rel = pr1.y + (   z       * pattern.z - pr1.z ) * ( pr2.y - pr1.y ) / ( pr2.z - pr1.z );
-			if (TracePattern(this,pos,p1,p2,data,x  ,z,y_rel,1,range))	return true;
-			if (TracePattern(this,pos,p1,p2,data,x+1,z,y_rel,1,range))	return true;
-		}
-	}
-
-	// negative x (to the left)
-	if ((w>=pi*3/4)||(w<-pi*3/4)){
-		int x0 = ::min( int(pr1.x/pattern.x), num_x );
-		int x1 = ::max( int(pr2.x/pattern.x), 0 );
-		for (x=x0;x>x1;x--){
-			z = int( ( ( pattern.x*((float)x+0.5f) - pr1.x ) * (pr2.z-pr1.z) / (pr2.x-pr1.x) + pr1.z ) / pattern.z - 0.5f );
-			if ( ( z > num_z - 2) || ( z < 0 ) )
-				break;
-			if ( p1.y < p2.y )	y_rel = pr1.y + ( ( x + 1 ) * pattern.x - pr1.x ) * ( pr2.y - pr1.y ) / ( pr2.x - pr1.x );
-			else				y_rel = pr1.y + (   x       * pattern.x - pr1.x ) * ( pr2.y - pr1.y ) / ( pr2.x - pr1.x );
-			if (TracePattern(this,pos,p1,p2,data,x,z  ,y_rel,2,range))	return true;
-			if (TracePattern(this,pos,p1,p2,data,x,z+1,y_rel,2,range))	return true;
-		}
-	}
+XTerrainVBUpdater::XTerrainVBUpdater(Terrain *t) {
+	terrain = t;
+}
 
-	// negative z (backward)
-	if ((w>=-pi*3/4) and (w<-pi/4)){
-		int z0 = ::min( int(pr1.z/pattern.z), num_z );
-		int z1 = ::max( int(pr2.z/pattern.z), 0 );
-		for (z=z0;z>z1;z--){
-			x = int( ( ( pattern.z*((float)z+0.5f) - pr1.z ) * (pr2.x-pr1.x) / (pr2.z-pr1.z) + pr1.x ) / pattern.x - 0.5f );
-			if ( ( x > num_x - 2) || ( x < 0 ) )
-				break;
-			if ( p1.y < p2.y )	y_rel = pr1.y + ( ( z + 1 ) * pattern.z - pr1.z ) * ( pr2.y - pr1.y ) / ( pr2.z - pr1.z );
-			else				y_rel = pr1.y + (   z       * pattern.z - pr1.z ) * ( pr2.y - pr1.y ) / ( pr2.z - pr1.z );
-			if (TracePattern(this,pos,p1,p2,data,x  ,z,y_rel,3,range))	return true;
-			if (TracePattern(this,pos,p1,p2,data,x+1,z,y_rel,3,range))	return true;
-		}
-	}
-	return false;
+XTerrainVBUpdater::~XTerrainVBUpdater() {
+	wait();
 }
 
-bool XTerrainVBUpdater::build_chunk(int chunk_no) {
+// runs on a worker
+//   Terrain::update() waits for the build, so vertex/normal/lod stay constant
+void XTerrainVBUpdater::build_chunk(int chunk_no, Array<Vertex> &vertices) const {
 	int num_x = terrain->num_x;
 	int num_z = terrain->num_z;
-	auto& chunk_lod = terrain->chunk_lod;
+	auto t = terrain;
 	auto& vertex = terrain->vertex;
 	auto& normal = terrain->normal;
 
 	// number of blocks (including the partially filled ones)
-	int nx = (num_x - 1) / TERRAIN_CHUNK_SIZE + 1;
-	int nz = (num_z - 1) / TERRAIN_CHUNK_SIZE + 1;
-	/*nx=num_x/32;
-	nz=num_z/32;*/
+	int nx = terrain->num_chunks_x;
+	int nz = terrain->num_chunks_z;
 
 	int x1 = chunk_no / nz;
 	int z1 = chunk_no % nz;
@@ -494,7 +506,7 @@ bool XTerrainVBUpdater::build_chunk(int chunk_no) {
 			// start
 			int x0 = x1 * TERRAIN_CHUNK_SIZE;
 			int z0 = z1 * TERRAIN_CHUNK_SIZE;
-			int l = chunk_lod[x1][z1];
+			int l = t->chunk(x1, z1).lod;
 			if (l < 0)
 				continue;
 			int e = 1<<l;
@@ -518,7 +530,7 @@ bool XTerrainVBUpdater::build_chunk(int chunk_no) {
 
 					// left border correction
 					if (x==x0 and x1>0) {
-						int ll = chunk_lod[x1-1][z1];
+						int ll = t->chunk(x1-1, z1).lod;
 						int p = 1 << ll;
 						if (p>0 and e<p) {
 							int a0=p*int(z/p);
@@ -535,11 +547,11 @@ bool XTerrainVBUpdater::build_chunk(int chunk_no) {
 
 					// right border correction
 					if (x==x0+TERRAIN_CHUNK_SIZE-e and x1<nx-1) {
-						[[maybe_unused]] int ll = chunk_lod[x1+1][z1];
-						int p = 1 << l;
+						int ll = t->chunk(x1+1, z1).lod;
+						int p = 1 << ll;
 						if (p>0 and e<p) {
 							int a0=p*int(z/p);
-							if (a0+p<num_x) {
+							if (a0+p<=num_z) {
 								float t0=float(z%p)/(float)p;
 								float t1=t0+float(e)/float(p);
 								vb=vertex[Index(x+e,a0)]*(1-t0)+vertex[Index(x+e,a0+p)]*t0;
@@ -552,7 +564,7 @@ bool XTerrainVBUpdater::build_chunk(int chunk_no) {
 
 					// bottom border correction
 					if (z==z0 and z1>0) {
-						int l = chunk_lod[x1][z1-1];
+						int l = t->chunk(x1, z1-1).lod;
 						int p = 1 << l;
 						if (p>0 and e<p) {
 							int a0=p*int(x/p);
@@ -569,11 +581,11 @@ bool XTerrainVBUpdater::build_chunk(int chunk_no) {
 
 					// top border correction
 					if (z==z0+TERRAIN_CHUNK_SIZE-e and z1<nz-1) {
-						int l = chunk_lod[x1][z1+1];
+						int l = t->chunk(x1, z1+1).lod;
 						int p = 1 << l;
 						if (p>0 and e<p) {
 							int a0=p*int(x/p);
-							if (a0+p<num_z) {
+							if (a0+p<=num_x) {
 								float t0=float(x%p)/(float)p;
 								float t1=t0+float(e)/float(p);
 								vc=vertex[Index(a0,z+e)]*(1-t0)+vertex[Index(a0+p,z+e)]*t0;
@@ -589,81 +601,96 @@ bool XTerrainVBUpdater::build_chunk(int chunk_no) {
 					float v1 = (float) z    / (float)num_z;//*texture_scale[i].z;
 					float v2 = (float)(z+e) / (float)num_z;//*texture_scale[i].z;
 
-					uv.add(u1);	uv.add(v1);
-					uv.add(u1);	uv.add(v2);
-					uv.add(u2);	uv.add(v2);
-					uv.add(u1);	uv.add(v1);
-					uv.add(u2);	uv.add(v2);
-					uv.add(u2);	uv.add(v1);
-
-					/*vertices.add({va,na,ta[0],ta[1]});
-					vertices.add({vc,nc,tc[0],tc[1]});
-					vertices.add({vd,nd,td[0],td[1]});
-					vertices.add({va,na,ta[0],ta[1]});
-					vertices.add({vd,nd,td[0],td[1]});
-					vertices.add({vb,nb,tb[0],tb[1]});*/
-					p.add(va);	n.add(na);
-					p.add(vc);	n.add(nc);
-					p.add(vd);	n.add(nd);
-					p.add(va);	n.add(na);
-					p.add(vd);	n.add(nd);
-					p.add(vb);	n.add(nb);
+					vertices.add({va, na, u1, v1});
+					vertices.add({vc, nc, u1, v2});
+					vertices.add({vd, nd, u2, v2});
+					vertices.add({va, na, u1, v1});
+					vertices.add({vd, nd, u2, v2});
+					vertices.add({vb, nb, u2, v1});
 
 				}
 		}
-	return chunk_no >= nx*nz-1;
 }
 
-void XTerrainVBUpdater::condense() {
-	for (int i=0; i<p.num; i++) {
-		vertices.add({p[i], n[i], uv[i*2], uv[i*2+1]});
+bool XTerrainVBUpdater::find_dirty_chunks(const vec3 &cam_pos) {
+	terrain->calc_detail(cam_pos);
+
+	int nx = terrain->num_chunks_x;
+	int nz = terrain->num_chunks_z;
+	bool all = terrain->force_redraw or !complete;
+	terrain->force_redraw = false;
+
+	// a changed level of detail also changes the neighbours' borders
+	for (int x=0; x<nx; x++)
+		for (int z=0; z<nz; z++) {
+			auto &c = terrain->chunk(x, z);
+			if (!all and c.lod == c.lod_old)
+				continue;
+			c.dirty = true;
+			if (x > 0)
+				terrain->chunk(x-1, z).dirty = true;
+			if (x < nx-1)
+				terrain->chunk(x+1, z).dirty = true;
+			if (z > 0)
+				terrain->chunk(x, z-1).dirty = true;
+			if (z < nz-1)
+				terrain->chunk(x, z+1).dirty = true;
+		}
+
+	jobs.clear();
+	foreachi (auto &c, terrain->chunks, i) {
+		c.lod_old = c.lod;
+		if (c.dirty)
+			jobs.add({i, {}});
+		c.dirty = false;
 	}
-	p.clear();
-	n.clear();
-	uv.clear();
+	return jobs.num > 0;
 }
 
 void XTerrainVBUpdater::upload() {
-	vb->update(vertices);
-	vertices.clear();
+	for (auto &j: jobs) {
+		auto &c = terrain->chunks[j.chunk_no];
+		if (!c.vertex_buffer)
+			c.vertex_buffer = new VertexBuffer("3f,3f,2f");
+		c.vertex_buffer->update(j.vertices);
+	}
+	jobs.clear();
+	complete = true;
+}
+
+void XTerrainVBUpdater::wait() {
+	if (task)
+		ThreadPool::get()->wait(task);
+	task = nullptr;
 }
 
 int XTerrainVBUpdater::iterate(const vec3 &cam_pos) {
-	if (mode == 0) {
-		terrain->calc_detail(cam_pos);
+	if (task) {
+		if (!ThreadPool::get()->is_done(task))
+			return 1;
+		task = nullptr;
+		upload();
+		return 2;
+	}
 
-		// do we have to recreate the terrain?
-		bool redraw = false;
-		if (terrain->force_redraw) {
-			redraw = true;
-		} else {
-			for (int x=0; x<terrain->num_x/TERRAIN_CHUNK_SIZE; x++)
-				for (int z=0; z<terrain->num_z/TERRAIN_CHUNK_SIZE; z++)
-					if (terrain->chunk_lod_old[x][z] != terrain->chunk_lod[x][z])
-						redraw = true;
-		}
-		if (!redraw)
-			return 0; // no update needed
-
-		terrain->force_redraw = false;
-		for (int x=0; x<terrain->num_x/TERRAIN_CHUNK_SIZE; x++)
-			for (int z=0; z<terrain->num_z/TERRAIN_CHUNK_SIZE; z++)
-				terrain->chunk_lod_old[x][z] = terrain->chunk_lod[x][z];
-		mode = 10;
-	} else if (mode == 10) {
-		if (build_chunk(counter ++)) {
-			mode = 11;
-			counter = 0;
-		}
-	} else if (mode == 11) {
-		condense();
-		mode = 12;
-	} else if (mode == 12) {
+	if (!find_dirty_chunks(cam_pos))
+		return 0; // no update needed
+
+	auto pool = ThreadPool::get();
+	task = pool->submit([this, pool] {
+		pool->parallel_for(jobs.num, [this] (int first, int end) {
+			for (int i=first; i<end; i++)
+				build_chunk(jobs[i].chunk_no, jobs[i].vertices);
+		}, 1);
+	});
+
+	// first time: complete update!
+	if (!complete) {
+		wait();
 		upload();
-		mode = 0;
-		return 2; // swap vb and restart!
+		return 2;
 	}
-	return 1; // keep iterating!
+	return 1;
 }
 
 void Terrain::prepare_draw(const vec3 &cam_pos) {
@@ -671,9 +698,13 @@ void Terrain::prepare_draw(const vec3 &cam_pos) {
 	// a b
 	// (acd),(adb)
 
-	XTerrainVBUpdater u;
-	u.terrain = this;
-	u.vb = vertex_buffer.get();
-	while (int r = u.iterate(cam_pos) == 1) {}
+	if (!updater)
+		return;
+	updater->wait();
+	force_redraw = true;
+	updater->iterate(cam_pos);
+	updater->wait();
+	if (updater->jobs.num > 0)
+		updater->upload();
 }
 
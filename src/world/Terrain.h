@@ -11,12 +11,17 @@
 #include <lib/base/base.h>
 #include <lib/os/path.h>
 #include <lib/math/vec3.h>
+#include <lib/math/mat4.h>
 #include "../y/Component.h"
 #include "Material.h"
 #include "../graphics-fwd.h"
 #include "../y/BaseClass.h"
+#include "HeightPyramid.h"
+#include <lib/threads/ThreadPool.h>
 class Material;
 class CollisionData;
+struct XTerrainVBUpdater;
+class TerrainHeightfield;
 //class DescriptorSet;
 
 enum class TerrainType {
@@ -24,6 +29,14 @@ enum class TerrainType {
 	PATTERN
 };
 
+// config "terrain.mode"
+enum class TerrainRenderMode {
+	// cpu built vertex buffers per chunk ("chunks")
+	CHUNKS,
+	// height texture, displaced in the vertex shader ("heightfield")
+	HEIGHTFIELD
+};
+
 #define TerrainUpdateNormals	1
 #define TerrainUpdateVertices	2
 #define TerrainUpdatePlanes		4
@@ -32,7 +45,6 @@ enum class TerrainType {
 #define TERRAIN_MAX_SIZE	65536
 #define TERRAIN_LOG_CHUNK_SIZE	6
 #define TERRAIN_CHUNK_SIZE	(1 << TERRAIN_LOG_CHUNK_SIZE)
-#define TERRAIN_MAX_CHUNKS (TERRAIN_MAX_SIZE / TERRAIN_CHUNK_SIZE)
 
 
 // a list of triangles for collision detection
@@ -52,6 +64,21 @@ public:
 	int *edge_index;
 };
 
+// TERRAIN_CHUNK_SIZE x TERRAIN_CHUNK_SIZE squares (less at the far borders)
+struct TerrainChunk {
+	// level of detail: steps of 2^lod squares, -1 = not built yet
+	int lod = -1;
+	int lod_old = -1;
+	// height edited, needs rebuilding
+	bool dirty = false;
+	// incremented on height edits, for caches (ray tracing)
+	int version = 0;
+	// owned by the terrain
+	VertexBuffer *vertex_buffer = nullptr;
+	// bounding box (relative to the owner)
+	vec3 min, max;
+};
+
 class Terrain : public Component {
 public:
 	Terrain();
@@ -60,27 +87,44 @@ public:
 	~Terrain() override;
 	void reset();
 	void _cdecl update(int x1,int x2,int z1,int z2,int mode);
-	float _cdecl gimme_height(const vec3 &p);
-	float _cdecl gimme_height_n(const vec3 &p, vec3 &n);
+	// queries are const and thread-safe
+	float _cdecl gimme_height(const vec3 &p) const;
+	float _cdecl gimme_height_n(const vec3 &p, vec3 &n) const;
+	// large batches get split over the thread pool
+	void _cdecl gimme_heights(const Array<vec3> &p, Array<float> &h) const;
+	void gimme_heights_n(const Array<vec3> &p, Array<float> &h, Array<vec3> &n) const;
 
 	void get_triangle_hull(TriangleHull *hull, vec3 &pos, float radius);
 
-	bool _cdecl trace(const vec3 &p1, const vec3 &p2, const vec3 &dir, float range, CollisionData &data, bool simple_test);
+	// 2d dda through height_levels, first hit from p1 towards p2
+	//   range: measured along dir (or p2-p1 if dir is zero), hits behind p1 don't count
+	//   simple_test: only data.entity/body get set, no hit position or normal
+	bool _cdecl trace(const vec3 &p1, const vec3 &p2, const vec3 &dir, float range, CollisionData &data, bool simple_test) const;
 
 	void calc_detail(const vec3 &cam_pos);
 	void prepare_draw(const vec3 &cam_pos);
 
+	// m: clip space from terrain space (projection * view * model)
+	bool chunk_visible(const TerrainChunk &c, const mat4 &m) const;
+
 	Path filename;
 	TerrainType terrain_type;
+	TerrainRenderMode render_mode;
 	bool error;
 
 	int num_x, num_z;
 	Array<float> height;
 	Array<vec3> vertex, normal;
 	Array<plane> pl; // for collision detection
-	owned<VertexBuffer> vertex_buffer;
-	int chunk_lod[TERRAIN_MAX_CHUNKS][TERRAIN_MAX_CHUNKS];
-	int chunk_lod_old[TERRAIN_MAX_CHUNKS][TERRAIN_MAX_CHUNKS];
+
+	// sized to the actual terrain
+	int num_chunks_x, num_chunks_z;
+	Array<TerrainChunk> chunks;
+	TerrainChunk &chunk(int x, int z) { return chunks[x * num_chunks_z + z]; }
+	// bounding boxes, marks them for rebuilding
+	void update_chunks(int x1, int x2, int z1, int z2);
+	owned<XTerrainVBUpdater> updater;
+	owned<TerrainHeightfield> heightfield;
 	vec3 pattern, min, max;
 	string vertex_shader_module;
 	owned<Material> material;
@@ -89,33 +133,52 @@ public:
 	Path texture_file[MATERIAL_MAX_TEXTURES];
 	vec3 texture_scale[MATERIAL_MAX_TEXTURES];
 
-	float dhx, dhz;
+	HeightPyramid height_levels;
+	void update_height_levels(int x1, int x2, int z1, int z2);
+
+	// square (i,j), u,v in [0,1], sx,sz: height difference per square
+	float square_height(int i, int j, float u, float v, float &sx, float &sz) const;
+	// terrain space, false if outside
+	bool local_height(float x, float z, float &h, float &sx, float &sz) const;
 
 
 	bool changed;
 	bool force_redraw;
+	// incremented by update(), lets caches (ray tracing) notice edits
+	int version;
 
 
 	static const kaba::Class *_class;
 };
 
+// chunk vertex buffers, rebuilt by pool workers
+//   only chunks with a changed level of detail (and their neighbours for the border stitching) or edited heights
 struct XTerrainVBUpdater {
 	struct Vertex {
 		vec3 pos, n;
 		float u, v;
 	};
-	Array<vec3> p,n;
-	Array<float> uv;
-	Array<Vertex> vertices;
-	int mode = 0;
-	int counter = 0;
-	Terrain* terrain = nullptr;
-	VertexBuffer* vb = nullptr;
-
-	bool build_chunk(int chunk_no);
-	void condense();
+	struct Job {
+		int chunk_no;
+		Array<Vertex> vertices;
+	};
+	explicit XTerrainVBUpdater(Terrain *t);
+	~XTerrainVBUpdater();
+
+	Terrain* terrain;
+	// chunks being built, owned by the workers until task is done
+	//   (the terrain's vertex/normal/lod are read-only meanwhile)
+	Array<Job> jobs;
+	TaskRef task;
+	// all chunks uploaded at least once
+	bool complete = false;
+
+	void build_chunk(int chunk_no, Array<Vertex> &vertices) const;
+	bool find_dirty_chunks(const vec3 &cam_pos);
 	void upload();
+	void wait();
 
+	// 0: no update needed, 1: building, 2: uploaded
 	int iterate(const vec3 &cam_pos);
 };
 
@@ -0,0 +1,113 @@
+/*
+ * TerrainHeightfield.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: michi
+ */
+
+#include "TerrainHeightfield.h"
+#include "Terrain.h"
+#include "../graphics-impl.h"
+#include "../y/Entity.h"
+#include <lib/math/math.h>
+
+// layout of the uniform buffer (vec4s)
+static const int DATA_TERRAIN = 0;  // pattern.x, pattern.z, num_x, num_z
+static const int DATA_CAMERA = 1;   // camera x, y, z (terrain space)
+static const int DATA_MORPH = 2;    // per lod: morph start, end
+static const int DATA_NODES = DATA_MORPH + TerrainHeightfield::MAX_LODS; // x, z, cell size (in squares), lod
+static_assert((DATA_NODES + TerrainHeightfield::MAX_NODES) * sizeof(vec4) <= 16384, "TerrainNodes exceeds 16 KB");
+
+// lod l is used up to RANGE_SCALE * 2^l node sizes
+//   large enough that neighbouring nodes never differ by more than one lod
+static const float RANGE_SCALE = 4.0f;
+// vertices morph in the outer part of their range
+static const float MORPH_START = 0.75f;
+
+TerrainHeightfield::TerrainHeightfield(Terrain *t) {
+	terrain = t;
+	num_nodes = 0;
+	dirty = true;
+
+	// x, z in grid units
+	Array<vec3> p;
+	for (int i=0; i<GRID_SIZE; i++)
+		for (int j=0; j<GRID_SIZE; j++) {
+			vec3 a = vec3((float)i, 0, (float)j);
+			vec3 b = vec3((float)(i+1), 0, (float)j);
+			vec3 c = vec3((float)i, 0, (float)(j+1));
+			vec3 d = vec3((float)(i+1), 0, (float)(j+1));
+			p.add(a);	p.add(c);	p.add(d);
+			p.add(a);	p.add(d);	p.add(b);
+		}
+	Array<XTerrainVBUpdater::Vertex> vertices;
+	for (auto &v: p)
+		vertices.add({v, vec3::EY, v.x / (float)GRID_SIZE, v.z / (float)GRID_SIZE});
+	grid = new VertexBuffer("3f,3f,2f");
+	grid->update(vertices);
+
+	// (x, z) -> texel (z, x), like Terrain::height
+	height_texture = new Texture(terrain->num_z + 1, terrain->num_x + 1, "r:f32");
+
+	// smallest lod that covers the whole terrain with one node
+	num_lods = 1;
+	while ((GRID_SIZE << (num_lods - 1)) < ::max(terrain->num_x, terrain->num_z) and num_lods < MAX_LODS)
+		num_lods ++;
+
+	float node_size = (float)GRID_SIZE * ::max(terrain->pattern.x, terrain->pattern.z);
+	data.resize(DATA_NODES + MAX_NODES);
+	data[DATA_TERRAIN] = vec4(terrain->pattern.x, terrain->pattern.z, (float)terrain->num_x, (float)terrain->num_z);
+	for (int l=0; l<MAX_LODS; l++) {
+		range[l] = RANGE_SCALE * node_size * (float)(1 << ::min(l, 30));
+		float r0 = (l > 0) ? range[l - 1] : 0.0f;
+		data[DATA_MORPH + l] = vec4(r0 + (range[l] - r0) * MORPH_START, range[l], 0, 0);
+	}
+	ubo = new UniformBuffer(data.num * sizeof(vec4));
+}
+
+TerrainHeightfield::~TerrainHeightfield() = default;
+
+void TerrainHeightfield::upload_heights() {
+	height_texture->write_float(terrain->height);
+	dirty = false;
+}
+
+// (x, z) in squares
+void TerrainHeightfield::select_node(int x, int z, int lod, const vec3 &cam) {
+	int size = GRID_SIZE << lod;
+	if (x >= terrain->num_x or z >= terrain->num_z)
+		return;
+
+	// nearest (horizontal) distance to the node
+	float px = terrain->pattern.x, pz = terrain->pattern.z;
+	float dx = ::max(::max((float)x * px - cam.x, cam.x - (float)(x + size) * px), 0.0f);
+	float dz = ::max(::max((float)z * pz - cam.z, cam.z - (float)(z + size) * pz), 0.0f);
+	float d = sqrt(dx*dx + dz*dz);
+
+	if (lod == 0 or d > range[lod - 1]) {
+		if (num_nodes < MAX_NODES)
+			data[DATA_NODES + num_nodes ++] = vec4((float)x, (float)z, (float)(1 << lod), (float)lod);
+		return;
+	}
+
+	int h = size / 2;
+	select_node(x, z, lod - 1, cam);
+	select_node(x + h, z, lod - 1, cam);
+	select_node(x, z + h, lod - 1, cam);
+	select_node(x + h, z + h, lod - 1, cam);
+}
+
+void TerrainHeightfield::update(const vec3 &cam_pos) {
+	if (dirty)
+		upload_heights();
+
+	vec3 cam = cam_pos;
+	if (terrain->owner)
+		cam -= terrain->owner->pos;
+
+	num_nodes = 0;
+	select_node(0, 0, num_lods - 1, cam);
+
+	data[DATA_CAMERA] = vec4(cam, 0);
+	ubo->update_array(data);
+}
@@ -0,0 +1,55 @@
+/*
+ * TerrainHeightfield.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: michi
+ */
+
+#pragma once
+
+#include <lib/base/base.h>
+#include <lib/base/pointer.h>
+#include <lib/math/vec3.h>
+#include <lib/math/vec4.h>
+#include "../graphics-fwd.h"
+
+class Terrain;
+
+// gpu rendering mode for terrains:
+//   Terrain::height lives in a texture, one small grid gets instanced per quadtree node
+//   and displaced in the vertex shader ("vertex-heightfield")
+//   nodes get chosen by camera distance, vertices morph into the next coarser level (no cracks)
+//   the cpu data (vertex, pl) is still kept for collisions
+class TerrainHeightfield {
+public:
+	// squares per node edge
+	static const int GRID_SIZE = 16;
+	static const int MAX_LODS = 16;
+	// the whole TerrainNodes block has to fit into 16 KB (the minimum GL_MAX_UNIFORM_BLOCK_SIZE)
+	static const int MAX_NODES = 1000;
+
+	explicit TerrainHeightfield(Terrain *t);
+	~TerrainHeightfield();
+
+	// render thread, once per frame
+	void update(const vec3 &cam_pos);
+
+	Terrain *terrain;
+	owned<Texture> height_texture;
+	// GRID_SIZE x GRID_SIZE squares, x,z in grid units
+	owned<VertexBuffer> grid;
+	// see TerrainNodes in module-vertex-heightfield.shader
+	owned<UniformBuffer> ubo;
+	int num_nodes;
+	// heights changed, upload before the next draw
+	bool dirty;
+
+private:
+	void upload_heights();
+	void select_node(int x, int z, int lod, const vec3 &cam);
+
+	int num_lods;
+	// distance (world units) up to which a lod is used
+	float range[MAX_LODS];
+	Array<vec4> data;
+};
@@ -11,9 +11,12 @@
 #include <algorithm>
 #include <lib/config.h>
 #include <lib/os/msg.h>
+#include <lib/os/filesystem.h>
+#include <lib/os/date.h>
 #include <lib/nix/nix.h>
 #include <lib/kaba/kaba.h>
 #include "../y/EngineData.h"
+#include "../Config.h"
 #include "../y/Component.h"
 #include "../y/ComponentManager.h"
 #include "../y/Entity.h"
@@ -37,6 +40,8 @@
 #include "../fx/ParticleManager.h"
 #include "../plugins/PluginManager.h"
 #include "../helper/PerformanceMonitor.h"
+#include <lib/threads/ThreadPool.h>
+#include "PhysicsStep.h"
 #endif
 
 #if HAS_LIB_BULLET
@@ -138,6 +143,7 @@ void GodInit(int ch_iter) {
 #ifdef _X_ALLOW_X_
 	world.ch_iterate = PerformanceMonitor::create_channel("world", ch_iter);
 	world.ch_animation = PerformanceMonitor::create_channel("animation", ch_iter);
+	world.ch_physics = PerformanceMonitor::create_channel("physics", ch_iter);
 #endif
 }
 
@@ -149,6 +155,22 @@ void send_collision(SolidBody *a, const CollisionData &col) {
 		c->on_collide(col);
 }
 
+// pipelined physics: stepping on a worker, results applied on the main thread
+static PhysicsStep physics_step;
+struct QueuedCollision {
+	SolidBody *body;
+	CollisionData col;
+};
+static Array<QueuedCollision> queued_collisions;
+
+static void send_or_queue_collision(SolidBody *a, const CollisionData &col) {
+	// scripts must not run on the worker
+	if (physics_step.collecting)
+		queued_collisions.add({a, col});
+	else
+		send_collision(a, col);
+}
+
 #if HAS_LIB_BULLET
 void myTickCallback(btDynamicsWorld *world, btScalar timeStep) {
 	auto dispatcher = world->getDispatcher();
@@ -165,9 +187,9 @@ void myTickCallback(btDynamicsWorld *world, btScalar timeStep) {
 			auto &pt = contactManifold->getContactPoint(j);
 			if (pt.getDistance() <= 0) {
 				if (a->active)
-					send_collision(a, {b->owner, b, bt_get_v(pt.m_positionWorldOnB), bt_get_v(pt.m_normalWorldOnB)});
+					send_or_queue_collision(a, {b->owner, b, bt_get_v(pt.m_positionWorldOnB), bt_get_v(pt.m_normalWorldOnB)});
 				if (b->active)
-					send_collision(b, {a->owner, a, bt_get_v(pt.m_positionWorldOnA), -bt_get_v(pt.m_normalWorldOnB)});
+					send_or_queue_collision(b, {a->owner, a, bt_get_v(pt.m_positionWorldOnA), -bt_get_v(pt.m_normalWorldOnB)});
 			}
 		}
 	}
@@ -206,6 +228,10 @@ World::~World() {
 }
 
 void World::reset() {
+	// the entities are about to be deleted
+	wait_physics_step();
+	queued_collisions.clear();
+
 	net_msg_enabled = false;
 	net_messages.clear();
 
@@ -216,6 +242,9 @@ void World::reset() {
 	for (auto *o: entities)
 		delete o;
 	entities.clear();
+#ifdef _X_ALLOW_X_
+	particle_manager->clear();
+#endif
 
 
 
@@ -362,6 +391,7 @@ bool World::load(const LevelData &ld) {
 void World::add_link(Link *l) {
 	links.add(l);
 #if HAS_LIB_BULLET
+	wait_physics_step();
 	dynamicsWorld->addConstraint(l->con, true);
 #endif
 }
@@ -392,7 +422,32 @@ Terrain *World::create_terrain(const Path &filename, const vec3 &pos) {
 
 bool GodLoadWorld(const Path &filename) {
 	LevelData level_data;
-	bool ok = level_data.load(engine.map_dir | filename.with(".world"));
+	Path source = engine.map_dir | filename.with(".world");
+	// the map dir might be read-only, several games might share the cache
+	Path cooked = engine.cache_dir | "levels" | (str(source).md5() + ".cworld");
+	bool use_cache = config.get_bool("world.cooked-cache", true) and !engine.cache_dir.is_empty();
+	bool ok = false;
+	if (use_cache and os::fs::exists(cooked) and os::fs::mtime(cooked).time >= os::fs::mtime(source).time) {
+		try {
+			ok = level_data.load_cooked(cooked);
+		} catch (Exception &e) {
+			msg_error(e.message());
+		}
+		if (!ok)
+			level_data = LevelData();
+	}
+	if (!ok) {
+		ok = level_data.load(source);
+		if (ok and use_cache) {
+			try {
+				os::fs::create_directory(engine.cache_dir);
+				os::fs::create_directory(cooked.parent());
+				level_data.save_cooked(cooked);
+			} catch (Exception &e) {
+				msg_error(e.message());
+			}
+		}
+	}
 	ok &= world.load(level_data);
 	return ok;
 }
@@ -407,6 +462,7 @@ void World::register_entity(Entity *e) {
 	e->on_init_rec();
 
 #if HAS_LIB_BULLET
+	wait_physics_step();
 	if (auto sb = e->get_component<SolidBody>())
 		dynamicsWorld->addRigidBody(sb->body);
 #endif
@@ -468,6 +524,7 @@ Model& World::attach_model(Entity &e, const Path &filename) {
 	e.on_init_rec(); // FIXME might re-initialize too much...
 
 #if HAS_LIB_BULLET
+	wait_physics_step();
 	if (auto sb = e.get_component<SolidBody>())
 		dynamicsWorld->addRigidBody(sb->body);
 #endif
@@ -477,6 +534,7 @@ Model& World::attach_model(Entity &e, const Path &filename) {
 
 void World::unattach_model(Model& m) {
 #if HAS_LIB_BULLET
+	wait_physics_step();
 	if (auto sb = m.owner->get_component<SolidBody>())
 		dynamicsWorld->removeRigidBody(sb->body);
 #endif
@@ -502,6 +560,7 @@ void World::set_active_physics(Entity *o, bool active, bool passive) { //, bool
 	auto c = o->get_component<Collider>();
 
 #if HAS_LIB_BULLET
+	wait_physics_step();
 	btScalar mass(active ? sb->mass : 0);
 	btVector3 local_inertia(0, 0, 0);
 	if (c->col_shape) {
@@ -549,6 +608,7 @@ void World::unregister_entity(Entity *e) {
 
 
 #if HAS_LIB_BULLET
+	wait_physics_step();
 	if (auto sb = e->get_component<SolidBody>())
 		dynamicsWorld->removeRigidBody(sb->body);
 #endif
@@ -595,21 +655,109 @@ void World::iterate_physics(float dt) {
 
 	if (physics_mode == PhysicsMode::FULL_EXTERNAL) {
 #if HAS_LIB_BULLET
-		dynamicsWorld->setGravity(bt_set_v(gravity));
-		dynamicsWorld->stepSimulation(dt, 10);
+		if (engine.pipelined) {
+			// the step was started after the previous frame's simulation
+			finish_physics_step();
+		} else {
+			dynamicsWorld->setGravity(bt_set_v(gravity));
+			dynamicsWorld->stepSimulation(dt, 10);
+		}
 
-		for (auto *o: list)
-			o->get_state_from_bullet();
+		sync_physics_state();
 #endif
 	} else if (physics_mode == PhysicsMode::SIMPLE) {
 		for (auto *o: list)
 			o->do_simple_physics(dt);
+
+		for (auto *sb: list) {
+			if (auto m = sb->owner->get_component<Model>())
+				m->update_matrix();
+		}
 	}
+}
 
-	for (auto *sb: list) {
-		if (auto m = sb->owner->get_component<Model>())
-			m->update_matrix();
+// only bodies bullet moved (not sleeping), each one writes its own entity
+void World::sync_physics_state() {
+#if HAS_LIB_BULLET
+	static Array<SolidBody*> moving;
+	moving.clear();
+	auto& bodies = dynamicsWorld->getNonStaticRigidBodies();
+	for (int i=0; i<bodies.size(); i++)
+		if (bodies[i]->isActive())
+			if (auto sb = static_cast<SolidBody*>(bodies[i]->getUserPointer()))
+				moving.add(sb);
+
+	ThreadPool::get()->parallel_for(moving.num, [] (int first, int end) {
+		for (int i=first; i<end; i++) {
+			moving[i]->get_state_from_bullet();
+			if (auto m = moving[i]->owner->get_component<Model>())
+				m->update_matrix();
+		}
+	}, 256);
+#endif
+}
+
+// only bullet's internal state is touched while the step runs,
+// the entities (read by the renderer) keep the results of the last sync
+void World::start_physics_step(float dt) {
+#if HAS_LIB_BULLET
+	if (!engine.physics_enabled or physics_mode != PhysicsMode::FULL_EXTERNAL or dt == 0)
+		return;
+	wait_physics_step();
+	dynamicsWorld->setGravity(bt_set_v(gravity));
+	physics_step.start([this, dt] {
+		auto t0 = std::chrono::high_resolution_clock::now();
+		dynamicsWorld->stepSimulation(dt, 10);
+		PerformanceMonitor::add_async(ch_physics, t0, std::chrono::high_resolution_clock::now());
+	});
+#endif
+}
+
+void World::wait_physics_step() {
+	physics_step.wait();
+}
+
+void World::finish_physics_step() {
+	wait_physics_step();
+	auto collisions = std::move(queued_collisions);
+	for (auto &c: collisions)
+		send_collision(c.body, c.col);
+}
+
+void World::update_transforms() {
+	int pass = ++ Entity::transform_pass;
+
+	// parents before children, entities within one level are independent
+	static Array<Array<Entity*>> levels;
+	for (auto &l: levels)
+		l.clear();
+	for (auto *e: entities) {
+		int depth = 0;
+		for (auto p = e->parent; p; p = p->parent)
+			depth ++;
+		if (depth >= levels.num)
+			levels.resize(depth + 1);
+		levels[depth].add(e);
 	}
+
+	for (auto &l: levels)
+		ThreadPool::get()->parallel_for(l.num, [&l, pass] (int first, int end) {
+			for (int i=first; i<end; i++)
+				l[i]->_update_world_matrix(pass);
+		}, 512);
+}
+
+void World::invalidate_transforms() {
+	Entity::transform_pass ++;
+}
+
+// only physics moves in ticks, anything else moved by scripts per frame is drawn as is
+void World::store_previous_transforms() {
+	auto& list = ComponentManager::get_list_family<SolidBody>();
+	for (auto *sb: list)
+		if (sb->active)
+			if (auto m = sb->owner->get_component<Model>())
+				m->reset_previous_matrix();
 }
 
 void World::iterate_animations(float dt) {
@@ -735,6 +883,7 @@ enum TraceMode {
 base::optional<CollisionData> World::trace(const vec3 &p1, const vec3 &p2, int mode, Entity *o_ignore) {
 	if (mode & TraceMode::PHYSICAL) {
 #if HAS_LIB_BULLET
+		wait_physics_step();
 		btCollisionWorld::ClosestRayResultCallback ray_callback(bt_set_v(p1), bt_set_v(p2));
 		//ray_callback.m_collisionFilterMask = FILTER_CAMERA;
 
@@ -118,7 +118,18 @@ public:
 
 	void iterate(float dt);
 	void iterate_physics(float dt);
+	// engine.pipelined: the bullet step overlaps with rendering the previous frame
+	void start_physics_step(float dt);
+	void finish_physics_step();
+	void wait_physics_step();
+	void sync_physics_state();
 	void iterate_animations(float dt);
+	// before each fixed tick, for render interpolation
+	void store_previous_transforms();
+	// cache all entities' world matrices, once per frame before rendering
+	void update_transforms();
+	// after rendering, simulation may move anything again
+	void invalidate_transforms();
 
 	void shift_all(const vec3 &dpos);
 	vec3 get_g(const vec3 &pos) const;
@@ -168,7 +179,7 @@ public:
 		vec3 v;
 	} msg_data;
 
-	int ch_iterate = -1, ch_animation = -1;
+	int ch_iterate = -1, ch_animation = -1, ch_physics = -1;
 };
 extern World world;
 
@@ -152,6 +152,7 @@ SolidBody::~SolidBody() {
 
 
 void SolidBody::add_force(const vec3 &f, const vec3 &rho) {
+	world.wait_physics_step();
 	if (engine.elapsed<=0)
 		return;
 	if (!active)
@@ -172,6 +173,7 @@ void SolidBody::add_force(const vec3 &f, const vec3 &rho) {
 }
 
 void SolidBody::add_impulse(const vec3 &p, const vec3 &rho) {
+	world.wait_physics_step();
 	if (engine.elapsed<=0)
 		return;
 	if (!active)
@@ -189,6 +191,7 @@ void SolidBody::add_impulse(const vec3 &p, const vec3 &rho) {
 }
 
 void SolidBody::add_torque(const vec3 &t) {
+	world.wait_physics_step();
 	if (engine.elapsed <= 0)
 		return;
 	if (!active)
@@ -206,6 +209,7 @@ void SolidBody::add_torque(const vec3 &t) {
 }
 
 void SolidBody::add_torque_impulse(const vec3 &l) {
+	world.wait_physics_step();
 	if (engine.elapsed <= 0)
 		return;
 	if (!active)
@@ -343,7 +347,12 @@ void SolidBody::update_data() {
 
 
 void SolidBody::update_motion(int mask) {
+	// explicitly placed, don't interpolate from the old position
+	if (mask & 3)
+		if (auto m = owner->get_component<Model>())
+			m->reset_previous_matrix();
 #if HAS_LIB_BULLET
+	world.wait_physics_step();
 	auto o = owner;
 	btTransform trans;
 	if (mask & 1)
@@ -359,6 +368,7 @@ void SolidBody::update_motion(int mask) {
 
 void SolidBody::update_mass() {
 #if HAS_LIB_BULLET
+	world.wait_physics_step();
 	if (active) {
 		btScalar _mass(mass);
 		btVector3 local_inertia(theta_0._00, theta_0._11, theta_0._22);
@@ -389,7 +399,10 @@ void SolidBody::get_state_from_bullet() {
 }
 
 void SolidBody::state_to_bullet() {
+	if (auto m = owner->get_component<Model>())
+		m->reset_previous_matrix();
 #if HAS_LIB_BULLET
+	world.wait_physics_step();
 	if (active) {
 		btTransform trans;
 		trans.setOrigin(bt_set_v(owner->pos));
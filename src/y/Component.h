@@ -24,6 +24,8 @@ public:
 	virtual void on_iterate(float dt) {}
 
 	virtual void on_collide(const CollisionData &col) {}
+	// engine.fixed_dt > 0: called once per simulation tick
+	virtual void on_iterate_fixed(float dt) {}
 
 	void set_variables(const string &var);
 
@@ -26,6 +26,7 @@ class ComponentListX {
 public:
 	ComponentManager::List list;
 	bool needs_update = false;
+	bool needs_fixed_update = false;
 	const kaba::Class *type_family = nullptr;
 	int ch_iterate = -1;
 
@@ -61,6 +62,7 @@ ComponentListX &_get_list_x(const kaba::Class *type) {
 		ComponentListX list;
 		list.type_family = type;
 		list.needs_update = class_func_did_override(type, "on_iterate");
+		list.needs_fixed_update = class_func_did_override(type, "on_iterate_fixed");
 #ifdef _X_ALLOW_X_
 		if (list.needs_update)
 			list.ch_iterate = PerformanceMonitor::create_channel(type->long_name(), ch_component);
@@ -77,6 +79,7 @@ ComponentListX &_get_list_x_family(const kaba::Class *type_family) {
 		ComponentListX list;
 		list.type_family = type_family;
 		list.needs_update = class_func_did_override(type_family, "on_iterate");
+		list.needs_fixed_update = class_func_did_override(type_family, "on_iterate_fixed");
 #ifdef _X_ALLOW_X_
 		if (list.needs_update)
 			list.ch_iterate = PerformanceMonitor::create_channel(type_family->long_name(), ch_component);
@@ -177,6 +180,13 @@ void ComponentManager::iterate(float dt) {
 #endif
 }
 
+void ComponentManager::iterate_fixed(float dt) {
+	for (auto&& [type, list]: component_lists_by_type)
+		if (list.needs_fixed_update)
+			for (auto *c: list.list)
+				c->on_iterate_fixed(dt);
+}
+
 
 ComponentManager::PairList& ComponentManager::_get_list2(const kaba::Class *type_a, const kaba::Class *type_b) {
 	static PairList _list;
@@ -50,5 +50,6 @@ public:
 	static const kaba::Class *get_component_type_family(const kaba::Class *type);
 
 	static void iterate(float dt);
+	static void iterate_fixed(float dt);
 };
 
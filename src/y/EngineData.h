@@ -54,6 +54,8 @@ public:
 	gui::Font *default_font;
 	Path initial_world_file, second_world_file;
 	bool physics_enabled, collisions_enabled;
+	// simulation of the next frame overlaps with rendering the current one
+	bool pipelined = false;
 	int mirror_level_max;
 
 	int num_real_col_tests;
@@ -61,6 +63,15 @@ public:
 	float fps_max, fps_min;
 	float time_scale, elapsed, elapsed_rt;
 
+	// fixed simulation ticks (physics, on_iterate_fixed()), 0: once per frame with elapsed
+	float fixed_dt = 0;
+	int max_ticks_per_frame = 5;
+	int tick = 0;
+	// progress between the last two ticks, for interpolating transforms
+	float tick_alpha = 1;
+	// counts main loop iterations
+	int frame = 0;
+
 	// output rendering/frame buffer resolution (might be smaller than the physical screen resolution)
 	int width, height;
 
@@ -84,6 +95,8 @@ public:
 	void set_dirs(const Path &texture_dir, const Path &map_dir, const Path &object_dir, const Path &sound_dir, const Path &script_dir, const Path &material_dir, const Path &font_dir);
 
 	Path map_dir, sound_dir, script_dir, object_dir, texture_dir, shader_dir, material_dir, font_dir;
+	// writable, for generated files (cooked levels)
+	Path cache_dir;
 
 	Context *context;
 	ResourceManager *resource_manager;
@@ -92,7 +92,12 @@ Component *Entity::_get_component_untyped_(const kaba::Class *type) const {
 
 
 mat4 Entity::get_local_matrix() const {
-	return mat4::translation(pos) * mat4::rotation(ang);
+	// = translation(pos) * rotation(ang), without the full product
+	auto m = mat4::rotation(ang);
+	m._03 = pos.x;
+	m._13 = pos.y;
+	m._23 = pos.z;
+	return m;
 }
 
 mat4 Entity::get_matrix() const {
@@ -101,6 +106,38 @@ mat4 Entity::get_matrix() const {
 	return get_local_matrix();
 }
 
+int Entity::transform_pass = 0;
+
+// O(1), parents are not checked (see header)
+bool Entity::transform_is_cached() const {
+	if (world_matrix_pass != transform_pass or parent != _world_matrix_parent)
+		return false;
+	return pos == _world_matrix_pos and ang == _world_matrix_ang;
+}
+
+mat4 Entity::get_matrix_cached() const {
+	if (transform_is_cached())
+		return world_matrix;
+	return get_matrix();
+}
+
+// parents must be updated first within the same pass
+void Entity::_update_world_matrix(int pass) {
+	bool parent_cached = parent and parent->world_matrix_pass == pass;
+	world_matrix_changed = (world_matrix_pass < 0) or (parent != _world_matrix_parent)
+			or (pos != _world_matrix_pos) or (ang != _world_matrix_ang)
+			or (parent and (!parent_cached or parent->world_matrix_changed));
+	if (world_matrix_changed) {
+		world_matrix = get_local_matrix();
+		if (parent)
+			world_matrix = (parent_cached ? parent->world_matrix : parent->get_matrix()) * world_matrix;
+		_world_matrix_pos = pos;
+		_world_matrix_ang = ang;
+		_world_matrix_parent = parent;
+	}
+	world_matrix_pass = pass;
+}
+
 
 Entity *Entity::root() const {
 	Entity *next = const_cast<Entity*>(this);
@@ -9,9 +9,9 @@
 
 #include <lib/math/vec3.h>
 #include <lib/math/quaternion.h>
+#include <lib/math/mat4.h>
 #include "BaseClass.h"
 
-class mat4;
 class Component;
 
 
@@ -48,6 +48,22 @@ public:
 	mat4 get_local_matrix() const;
 	mat4 get_matrix() const;
 
+	// world matrix, cached by World::update_transforms() once per frame
+	//   valid until World::invalidate_transforms() (end of the frame)
+	//   falls back to get_matrix(), if the entity itself moved since
+	//   moving a parent in between requires another update_transforms()
+	mat4 get_matrix_cached() const;
+	bool transform_is_cached() const;
+	void _update_world_matrix(int pass);
+	static int transform_pass;
+
+	mat4 world_matrix;
+	int world_matrix_pass = -1;
+	bool world_matrix_changed = false;
+	vec3 _world_matrix_pos;
+	quaternion _world_matrix_ang;
+	Entity *_world_matrix_parent = nullptr;
+
 	int object_id;
 	Entity *parent;
 	Entity *_cdecl root() const;
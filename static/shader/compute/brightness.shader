@@ -1,6 +1,6 @@
 <Layout>
 	version = 430
-	bindings = [[sampler,storage-buffer,buffer]]
+	bindings = [[sampler,storage-buffer]]
 </Layout>
 <ComputeShader>
 
@@ -10,11 +10,6 @@ layout(std430, binding=1) buffer Histogram {
 	int hist[256];
 };
 
-layout(std140, binding=2) uniform Parameters {
-	int width;
-	int height;
-};
-
 layout (local_size_x=16, local_size_y=16) in;
 
 
@@ -33,7 +28,7 @@ int rgb_to_bin(vec3 c) {
 void main() {
 	float u = rand2d(vec2(gl_GlobalInvocationID.xy));
 	float v = rand2d(vec2(gl_GlobalInvocationID.xy) + vec2(3.252, 9.711));
-	ivec2 i = ivec2(u * width, v * height);
+	ivec2 i = ivec2(vec2(u, v) * vec2(textureSize(tex0, 0)));
 	
 	//vec4 c = vec4(u,v,1,1);
 	vec4 c = texelFetch(tex0, i, 0);
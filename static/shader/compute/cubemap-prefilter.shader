@@ -0,0 +1,81 @@
+<Layout>
+	version = 430
+	bindings = [[sampler,image]]
+</Layout>
+<ComputeShader>
+
+// ggx prefiltered cube map level (OpenGL only), one face per dispatch
+//   source: level 0 of the same cube map, n = v = r (split sum approximation)
+
+layout(binding=0) uniform samplerCube tex_cube;
+layout(binding=1, rgba8) uniform writeonly image2D out_face;
+
+uniform int face;
+uniform int size;
+uniform float roughness;
+
+layout (local_size_x=8, local_size_y=8) in;
+
+const int NUM_SAMPLES = 128;
+const float PI = 3.14159265;
+
+// direction through texel (s,t) in [-1,1], gl cube map face conventions
+vec3 face_dir(int f, float s, float t) {
+	if (f == 0)
+		return vec3(1, -t, -s);
+	if (f == 1)
+		return vec3(-1, -t, s);
+	if (f == 2)
+		return vec3(s, 1, t);
+	if (f == 3)
+		return vec3(s, -1, -t);
+	if (f == 4)
+		return vec3(s, -t, 1);
+	return vec3(-s, -t, -1);
+}
+
+vec2 hammersley(uint i, uint n) {
+	uint b = i;
+	b = (b << 16u) | (b >> 16u);
+	b = ((b & 0x55555555u) << 1u) | ((b & 0xAAAAAAAAu) >> 1u);
+	b = ((b & 0x33333333u) << 2u) | ((b & 0xCCCCCCCCu) >> 2u);
+	b = ((b & 0x0F0F0F0Fu) << 4u) | ((b & 0xF0F0F0F0u) >> 4u);
+	b = ((b & 0x00FF00FFu) << 8u) | ((b & 0xFF00FF00u) >> 8u);
+	return vec2(float(i) / float(n), float(b) * 2.3283064365386963e-10);
+}
+
+// half vector around n, distributed like D_ggx(h) * (n.h)
+vec3 importance_sample_ggx(vec2 xi, vec3 n, float a) {
+	float phi = 2.0 * PI * xi.x;
+	float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (a*a - 1.0) * xi.y));
+	float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+	vec3 h = vec3(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta);
+	vec3 up = abs(n.z) < 0.999 ? vec3(0, 0, 1) : vec3(1, 0, 0);
+	vec3 tx = normalize(cross(up, n));
+	vec3 ty = cross(n, tx);
+	return normalize(tx * h.x + ty * h.y + n * h.z);
+}
+
+void main() {
+	ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+	if (p.x >= size || p.y >= size)
+		return;
+	vec2 st = (vec2(p) + 0.5) / float(size) * 2.0 - 1.0;
+	vec3 n = normalize(face_dir(face, st.x, st.y));
+
+	float a = roughness * roughness;
+	vec3 sum = vec3(0);
+	float weight = 0.0;
+	for (int i=0; i<NUM_SAMPLES; i++) {
+		vec3 h = importance_sample_ggx(hammersley(uint(i), uint(NUM_SAMPLES)), n, a);
+		vec3 l = 2.0 * dot(n, h) * h - n;
+		float nl = dot(n, l);
+		if (nl > 0.0) {
+			sum += textureLod(tex_cube, l, 0.0).rgb * nl;
+			weight += nl;
+		}
+	}
+	imageStore(out_face, p, vec4(sum / max(weight, 0.0001), 1.0));
+}
+
+</ComputeShader>
@@ -0,0 +1,175 @@
+<Layout>
+	version = 430
+	name = bvh
+</Layout>
+<Module>
+
+// two level bvh, see Bvh.h and RayTracingData
+//   the importing shader declares Mesh mesh[] and push.num_meshes first
+//   nodes: top level at 0 (leaves: first = mesh), meshes at mesh[k].bvh_root (children relative to it)
+//   triangles: per mesh at mesh[k].bvh_triangles, in bvh order
+
+struct BvhNode {
+	vec3 min;
+	int first;
+	vec3 max;
+	int count;
+};
+
+struct BvhTriangle {
+	vec3 a;
+	float _a;
+	vec3 b;
+	float _b;
+	vec3 c;
+	float _c;
+	vec3 n;
+	int index;
+};
+
+layout(binding=3, std430) readonly buffer BvhNodeData { BvhNode bvh_node[]; };
+layout(binding=4, std430) readonly buffer BvhTriangleData { BvhTriangle bvh_triangle[]; };
+layout(binding=5, std430) readonly buffer BvhInstanceData { mat4 bvh_inverse[]; };
+
+// >= Bvh::MAX_DEPTH + 1, the trees never get deeper
+const int BVH_STACK_SIZE = 64;
+
+struct TriaHitData {
+	vec3 p, n;
+	float f, g;
+	float t;
+};
+
+struct HitData {
+	int index; // tria
+	int mesh;
+	TriaHitData thd;
+};
+
+// both sides, t in units of dir
+bool trace_tria(vec3 p0, vec3 dir, vec3 a, vec3 b, vec3 c, float t_max, out float t, out float f, out float g) {
+	vec3 e1 = b - a;
+	vec3 e2 = c - a;
+	vec3 q = cross(dir, e2);
+	float det = dot(e1, q);
+	t = f = g = 0;
+	if (det == 0)
+		return false;
+	float inv_det = 1.0 / det;
+	vec3 s = p0 - a;
+	f = dot(s, q) * inv_det;
+	if (f < 0 || f > 1)
+		return false;
+	vec3 r = cross(s, e1);
+	g = dot(dir, r) * inv_det;
+	if (g < 0 || f + g > 1)
+		return false;
+	t = dot(e2, r) * inv_det;
+	return t > 0 && t < t_max;
+}
+
+vec3 bvh_inv_dir(vec3 dir) {
+	return 1.0 / mix(dir, vec3(1e-20), equal(dir, vec3(0)));
+}
+
+// entry distance (slab test), -1 if missed
+float bvh_box_entry(vec3 p0, vec3 inv_dir, vec3 bmin, vec3 bmax, float t_max) {
+	vec3 t0 = (bmin - p0) * inv_dir;
+	vec3 t1 = (bmax - p0) * inv_dir;
+	vec3 tn = min(t0, t1);
+	vec3 tf = max(t0, t1);
+	float a = max(max(tn.x, tn.y), max(tn.z, 0.0));
+	float b = min(min(tf.x, tf.y), min(tf.z, t_max));
+	return (a <= b) ? a : -1.0;
+}
+
+// closest hit in mesh k, ray in object space
+bool bvh_trace_mesh(int k, vec3 p0, vec3 dir, inout HitData hd) {
+	int root = mesh[k].bvh_root;
+	int tria0 = mesh[k].bvh_triangles;
+	vec3 inv_dir = bvh_inv_dir(dir);
+	int stack[BVH_STACK_SIZE];
+	int sp = 0;
+	stack[sp ++] = 0;
+	bool hit = false;
+	while (sp > 0) {
+		BvhNode node = bvh_node[root + stack[-- sp]];
+		if (bvh_box_entry(p0, inv_dir, node.min, node.max, hd.thd.t) < 0)
+			continue;
+		if (node.count > 0) {
+			for (int i=node.first; i<node.first+node.count; i++) {
+				BvhTriangle tr = bvh_triangle[tria0 + i];
+				float t, f, g;
+				if (trace_tria(p0, dir, tr.a, tr.b, tr.c, hd.thd.t, t, f, g)) {
+					hd.thd.t = t;
+					hd.thd.f = f;
+					hd.thd.g = g;
+					hd.thd.n = tr.n; // object space for now
+					hd.index = tr.index;
+					hd.mesh = k;
+					hit = true;
+				}
+			}
+		} else {
+			// nearer child gets popped first
+			BvhNode l = bvh_node[root + node.first];
+			BvhNode r = bvh_node[root + node.first + 1];
+			float t_left = bvh_box_entry(p0, inv_dir, l.min, l.max, hd.thd.t);
+			float t_right = bvh_box_entry(p0, inv_dir, r.min, r.max, hd.thd.t);
+			if (t_left >= 0 && t_right >= 0) {
+				bool left_first = (t_left <= t_right);
+				stack[sp ++] = node.first + (left_first ? 1 : 0);
+				stack[sp ++] = node.first + (left_first ? 0 : 1);
+			} else if (t_left >= 0) {
+				stack[sp ++] = node.first;
+			} else if (t_right >= 0) {
+				stack[sp ++] = node.first + 1;
+			}
+		}
+	}
+	return hit;
+}
+
+// closest hit of all instances, t in units of dir
+bool trace(vec3 p0, vec3 dir, out HitData hd) {
+	hd.thd.t = 1000000;
+	hd.index = -1;
+	hd.mesh = -1;
+	if (push.num_meshes == 0)
+		return false;
+
+	vec3 inv_dir = bvh_inv_dir(dir);
+	int stack[BVH_STACK_SIZE];
+	int sp = 0;
+	stack[sp ++] = 0;
+	bool hit = false;
+	while (sp > 0) {
+		BvhNode node = bvh_node[stack[-- sp]];
+		if (bvh_box_entry(p0, inv_dir, node.min, node.max, hd.thd.t) < 0)
+			continue;
+		if (node.count > 0) {
+			int k = node.first;
+			if (mesh[k].num_triangles == 0)
+				continue;
+			// same t in object space, dir is not normalized there
+			mat4 inv = bvh_inverse[k];
+			if (bvh_trace_mesh(k, (inv * vec4(p0, 1)).xyz, (inv * vec4(dir, 0)).xyz, hd))
+				hit = true;
+		} else {
+			stack[sp ++] = node.first + 1;
+			stack[sp ++] = node.first;
+		}
+	}
+
+	if (hit) {
+		hd.thd.p = p0 + dir * hd.thd.t;
+		// inverse transpose
+		vec3 n = normalize((vec4(hd.thd.n, 0) * bvh_inverse[hd.mesh]).xyz);
+		if (dot(n, dir) > 0)
+			n = -n;
+		hd.thd.n = n;
+	}
+	return hit;
+}
+
+</Module>
@@ -0,0 +1,165 @@
+<Layout>
+	version = 430
+	bindings = [[storage-buffer,storage-buffer,storage-buffer,storage-buffer]]
+	pushsize = 120
+</Layout>
+<ComputeShader>
+
+struct Particle {
+	vec4 pos;   // w: time to live
+	vec4 vel;   // w: radius
+	vec4 color;
+};
+
+layout(std430, binding=0) buffer Particles { Particle particle[]; };
+// two halves of [capacity], read one, write the other
+layout(std430, binding=1) buffer Alive { uint alive[]; };
+layout(std430, binding=2) buffer Dead { uint dead[]; };
+layout(std430, binding=3) buffer Counters {
+	// DrawArraysIndirectCommand
+	uint draw_vertex_count;
+	uint draw_instance_count;
+	uint draw_first_vertex;
+	uint draw_first_instance;
+	int alive_count[2];
+	int dead_count;
+	int _padding;
+};
+
+#ifdef vulkan
+layout(push_constant) uniform Parameters {
+	vec4 emit_pos;     // w: time to live
+	vec4 emit_vel;     // w: velocity variation
+	vec4 emit_color;
+	vec4 acceleration; // w: dt
+	vec4 cam_pos;      // w: radius
+	vec4 cam_dir;      // w: radius variation
+	int stage;
+	int num;
+	int current;
+	int capacity;
+	int seed;
+	int sort_j;
+};
+#else
+uniform vec4 emit_pos;
+uniform vec4 emit_vel;
+uniform vec4 emit_color;
+uniform vec4 acceleration;
+uniform vec4 cam_pos;
+uniform vec4 cam_dir;
+uniform int stage;
+uniform int num;
+uniform int current;
+uniform int capacity;
+uniform int seed;
+uniform int sort_j;
+#endif
+
+layout(local_size_x=256) in;
+
+const int STAGE_EMIT = 0;
+const int STAGE_SIMULATE = 1;
+const int STAGE_FINALIZE = 2;
+const int STAGE_SORT_PAD = 3;
+const int STAGE_SORT = 4;
+
+const uint INVALID = 0xffffffffu;
+
+float rand(uint i, uint k) {
+	uint x = i * 1973u + uint(seed) * 9277u + k * 26699u;
+	x = (x ^ 61u) ^ (x >> 16);
+	x *= 9u;
+	x = x ^ (x >> 4);
+	x *= 0x27d4eb2du;
+	x = x ^ (x >> 15);
+	return float(x & 0xffffffu) / float(0xffffff) * 2.0 - 1.0;
+}
+
+void emit(uint i) {
+	if (i >= uint(num))
+		return;
+	int d = atomicAdd(dead_count, -1) - 1;
+	if (d < 0) {
+		atomicAdd(dead_count, 1);
+		return;
+	}
+	uint index = dead[d];
+	vec3 dv = vec3(rand(i, 0u), rand(i, 1u), rand(i, 2u)) * emit_vel.w;
+	particle[index].pos = emit_pos;
+	particle[index].vel = vec4(emit_vel.xyz + dv, max(cam_pos.w + rand(i, 3u) * cam_dir.w, 0.0));
+	particle[index].color = emit_color;
+	alive[current * capacity + atomicAdd(alive_count[current], 1)] = index;
+}
+
+void simulate(uint i) {
+	if (i >= uint(alive_count[current]))
+		return;
+	float dt = acceleration.w;
+	uint index = alive[current * capacity + i];
+	Particle p = particle[index];
+	p.pos.w -= dt;
+	if (p.pos.w < 0.0) {
+		dead[atomicAdd(dead_count, 1)] = index;
+		return;
+	}
+	p.vel.xyz += acceleration.xyz * dt;
+	p.pos.xyz += p.vel.xyz * dt;
+	particle[index].pos = p.pos;
+	particle[index].vel = p.vel;
+	int next = 1 - current;
+	alive[next * capacity + atomicAdd(alive_count[next], 1)] = index;
+}
+
+void finalize() {
+	int next = 1 - current;
+	draw_vertex_count = 6u;
+	draw_instance_count = uint(alive_count[next]);
+	draw_first_vertex = 0u;
+	draw_first_instance = 0u;
+	alive_count[current] = 0;
+}
+
+float depth(uint index) {
+	if (index == INVALID)
+		return -1e30;
+	return dot(particle[index].pos.xyz - cam_pos.xyz, cam_dir.xyz);
+}
+
+// the (new) current half, [count, capacity) gets sorted to the back
+void sort_pad(uint i) {
+	if (i < uint(capacity) && i >= uint(alive_count[current]))
+		alive[current * capacity + i] = INVALID;
+}
+
+// one step of a bitonic sort (k=num, j=sort_j), far particles first
+void sort_step(uint i) {
+	uint l = i ^ uint(sort_j);
+	if (l <= i || i >= uint(capacity))
+		return;
+	uint a = alive[current * capacity + i];
+	uint b = alive[current * capacity + l];
+	float da = depth(a);
+	float db = depth(b);
+	bool descending = ((i & uint(num)) == 0u);
+	if (descending ? (da < db) : (da > db)) {
+		alive[current * capacity + i] = b;
+		alive[current * capacity + l] = a;
+	}
+}
+
+void main() {
+	uint i = gl_GlobalInvocationID.x;
+	if (stage == STAGE_EMIT)
+		emit(i);
+	else if (stage == STAGE_SIMULATE)
+		simulate(i);
+	else if (stage == STAGE_FINALIZE && i == 0u)
+		finalize();
+	else if (stage == STAGE_SORT_PAD)
+		sort_pad(i);
+	else if (stage == STAGE_SORT)
+		sort_step(i);
+}
+
+</ComputeShader>
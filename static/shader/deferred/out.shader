@@ -1,5 +1,5 @@
 <Layout>
-	bindings = [[sampler,sampler,sampler,sampler,sampler,sampler,sampler,sampler,buffer,buffer,buffer,buffer,buffer,buffer]]
+	bindings = [[sampler,sampler,sampler,sampler,sampler,sampler*4,.,sampler,buffer,buffer,buffer,buffer,buffer,buffer]]
 	pushsize = 76
 	input = [vec3,vec3,vec2]
 	topology = triangles
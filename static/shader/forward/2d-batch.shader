@@ -0,0 +1,45 @@
+<Layout>
+	bindings = [[buffer,sampler]]
+	pushsize = 4
+	input = [vec3,vec4,vec2]
+	topology = triangles
+</Layout>
+<VertexShader>
+#version 420
+#extension GL_ARB_separate_shader_objects : enable
+
+struct Matrix {
+	mat4 model;
+	mat4 view;
+	mat4 project;
+};
+/*layout(binding = 0)*/ uniform Matrix matrix;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec4 in_color;
+layout(location = 2) in vec2 in_tex_coord;
+
+layout(location = 0) out vec2 out_tex_coord;
+layout(location = 1) out vec4 out_color;
+
+void main() {
+	gl_Position = matrix.project * matrix.view * matrix.model * vec4(in_position, 1.0);
+	out_tex_coord = in_tex_coord;
+	out_color = in_color;
+}
+</VertexShader>
+<FragmentShader>
+#version 420
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 1) uniform sampler2D tex0;
+
+layout(location = 0) in vec2 in_tex_coord;
+layout(location = 1) in vec4 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+	out_color = texture(tex0, in_tex_coord) * in_color;
+}
+</FragmentShader>
@@ -0,0 +1,82 @@
+<Layout>
+	bindings = [[storage-buffer,storage-buffer,sampler]]
+	pushsize = 148
+	input = [vec3,vec4,vec2]
+	topology = triangles
+	version = 450
+</Layout>
+<VertexShader>
+#extension GL_ARB_separate_shader_objects : enable
+
+// particles simulated by compute/particles.shader, one instance each
+
+struct Particle {
+	vec4 pos;   // w: time to live
+	vec4 vel;   // w: radius
+	vec4 color;
+};
+
+layout(std430, binding=0) readonly buffer Particles { Particle particle[]; };
+layout(std430, binding=1) readonly buffer Alive { uint alive[]; };
+
+#ifdef vulkan
+layout(push_constant) uniform Parameters {
+	mat4 view;
+	mat4 project;
+	vec4 source; // x1,x2,y1,y2
+	int alive_offset;
+};
+#define INSTANCE gl_InstanceIndex
+#else
+struct Matrix {
+	mat4 model;
+	mat4 view;
+	mat4 project;
+};
+uniform Matrix matrix;
+uniform vec4 source;
+uniform int alive_offset;
+#define INSTANCE gl_InstanceID
+#endif
+
+// quad corner in [-1,1]
+layout(location = 0) in vec3 in_position;
+layout(location = 2) in vec2 in_uv;
+
+layout(location = 0) out vec2 out_uv;
+layout(location = 1) out vec4 out_color;
+
+void main() {
+#ifdef vulkan
+	mat4 v = view;
+	mat4 p = project;
+#else
+	mat4 v = matrix.view;
+	mat4 p = matrix.project;
+#endif
+	Particle pp = particle[alive[alive_offset + INSTANCE]];
+	// billboard in view space
+	vec4 center = v * vec4(pp.pos.xyz, 1);
+	gl_Position = p * (center + vec4(in_position.xy * pp.vel.w, 0, 0));
+	out_uv = vec2(mix(source.x, source.y, in_uv.x), mix(source.z, source.w, in_uv.y));
+	out_color = pp.color;
+}
+</VertexShader>
+<FragmentShader>
+#extension GL_ARB_separate_shader_objects : enable
+
+#ifdef vulkan
+layout(binding = 2) uniform sampler2D tex0;
+#else
+uniform sampler2D tex0;
+#endif
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) in vec4 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+	out_color = texture(tex0, in_uv) * in_color;
+}
+</FragmentShader>
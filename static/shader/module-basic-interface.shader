@@ -30,6 +30,9 @@ struct Surfel {
 	vec4 color;
 };
 
+// innermost first, cascade i covers 1/shadow_cascade_scale[i] of the light projection
+const int MAX_SHADOW_CASCADES = 4;
+
 
 
 #ifdef vulkan
@@ -44,6 +47,9 @@ layout(binding = 8) uniform ParameterData {
 	int num_lights;
 	int shadow_index;
 	int num_surfels;
+	int cube_map_levels;
+	int num_shadow_cascades;
+	vec4 shadow_cascade_scale;
 };
 layout(binding = 9) uniform LightData {
 	Light light[32];
@@ -62,8 +68,7 @@ layout(binding = 0) uniform sampler2D tex0;
 layout(binding = 1) uniform sampler2D tex1;
 layout(binding = 2) uniform sampler2D tex2;
 layout(binding = 3) uniform sampler2D tex3;
-layout(binding = 5) uniform sampler2D tex_shadow0;
-layout(binding = 6) uniform sampler2D tex_shadow1;
+layout(binding = 5) uniform sampler2D tex_shadow[MAX_SHADOW_CASCADES];
 layout(binding = 7) uniform samplerCube tex_cube;
 
 #else
@@ -75,20 +80,23 @@ layout(binding = 7) uniform samplerCube tex_cube;
 layout(binding = 0) uniform sampler2D tex0;
 layout(binding = 1) uniform sampler2D tex1;
 layout(binding = 2) uniform sampler2D tex2;
-layout(binding = 3) uniform sampler2D tex3;//sampler_shadow;
-layout(binding = 4) uniform sampler2D tex4;//sampler_shadow2;
-layout(binding = 5) uniform samplerCube tex_cube;//sampler_shadow2;
-
-#define tex_shadow0 tex3
-#define tex_shadow1 tex4
+layout(binding = 3) uniform sampler2D tex3;
+layout(binding = 4) uniform sampler2D tex4;
+layout(binding = 5) uniform samplerCube tex_cube;
+layout(binding = 8) uniform sampler2D tex_shadow[MAX_SHADOW_CASCADES];
 
 
-uniform Material material;
+layout(std140) uniform MaterialData {
+	Material material;
+};
 uniform Matrices matrix;
 
 uniform int num_lights;
 uniform int shadow_index = -1;
 uniform int num_surfels = 0;
+uniform int cube_map_levels = 1;
+uniform int num_shadow_cascades = 0;
+uniform vec4 shadow_cascade_scale = vec4(1,1,1,1);
 layout(std140) uniform LightData {
 	Light light[32];
 };
@@ -83,11 +83,19 @@ float _surf_brightness(Light l, vec3 p) {
 // amount of shadow
 float _surf_shadow_pcf_step(vec3 p, vec2 dd, ivec2 ts) {
 	vec2 d = dd / ts * 0.8;
-	vec2 tp = p.xy + d;
 	float epsilon = 0.004;
-	float shadow_z = texture(tex_shadow1, p.xy + d).r + epsilon;
-	if (tp.x > 0.38 && tp.y > 0.38 && tp.x < 0.62 && tp.y < 0.62)
-		shadow_z = texture(tex_shadow0, (p.xy - vec2(0.5,0.5))*4 + vec2(0.5,0.5) + d).r + epsilon;
+	float shadow_z = 1.0 + epsilon;
+	bool found = false;
+	// innermost cascade containing the point, the outermost one always does
+	//   (the array index has to stay uniform, so no break)
+	for (int i=0; i<num_shadow_cascades; i++) {
+		vec2 tp = (p.xy - vec2(0.5,0.5)) * shadow_cascade_scale[i] + vec2(0.5,0.5) + d;
+		bool inside = (tp.x > 0.02 && tp.y > 0.02 && tp.x < 0.98 && tp.y < 0.98);
+		if (!found && (inside || i == num_shadow_cascades - 1)) {
+			shadow_z = textureLod(tex_shadow[i], tp, 0).r + epsilon;
+			found = true;
+		}
+	}
 	if (p.z > shadow_z)
 		return 1.0;
 	return 0.0;
@@ -102,7 +110,7 @@ vec2 VogelDiskSample(int sampleIndex, int samplesCount, float phi) {
 }
 
 float _surf_shadow_pcf(vec3 p) {
-	ivec2 ts = textureSize(tex_shadow0, 0);
+	ivec2 ts = textureSize(tex_shadow[0], 0);
 	float value = 0;//shadow_pcf_step(p, vec2(0,0), ts);
 	const float R = 1.8;
 	const int N = 16;
@@ -252,7 +260,9 @@ vec4 perform_lighting(vec3 p, vec3 n, vec4 albedo, vec4 emission, float metal, f
 			vec3 p = in_pos.xyz / in_pos.w;
 			mat3 R = transpose(mat3(matrix.view));
 			vec3 L = reflect(p, n);
-			vec4 cube = texture(tex_cube, R*L);
+			// prefiltered mips (ggx, roughness = level / (levels - 1)), otherwise only level 0
+			float lod = roughness0 * float(cube_map_levels - 1);
+			vec4 cube = textureLod(tex_cube, R*L, lod);
 			color += cube * ((metal-0.8) / 0.2) * ((0.2 - roughness0) / 0.2) * 0.5;
 		}
 	}
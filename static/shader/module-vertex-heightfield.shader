@@ -0,0 +1,88 @@
+<Layout>
+	version = 420
+	name = vertex-heightfield
+</Layout>
+<Module>
+
+// see TerrainHeightfield
+
+struct Matrices {
+	mat4 model;
+	mat4 view;
+	mat4 project;
+};
+
+#ifdef vulkan
+layout(binding = 8) uniform Parameters {
+	Matrices matrix;
+};
+layout(binding = 4) uniform sampler2D tex_height;
+layout(binding = 10) uniform TerrainNodes {
+#else
+uniform Matrices matrix;
+layout(binding = 6) uniform sampler2D tex_height;
+layout(std140, binding = 6) uniform TerrainNodes {
+#endif
+	vec4 terrain; // pattern.x, pattern.z, num_x, num_z
+	vec4 camera; // terrain space
+	vec4 morph[16]; // per lod: start, end
+	vec4 node[1000]; // x, z, cell size (in squares), lod
+};
+
+// x, z in grid units
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_pos; // view space
+layout(location = 1) out vec3 out_normal;
+layout(location = 2) out vec2 out_uv;
+layout(location = 3) out vec4 out_color; // optional
+
+// height[x, z] is stored at texel (z, x)
+float height_at_texel(ivec2 t) {
+	t = clamp(t, ivec2(0), ivec2(terrain.zw));
+	return texelFetch(tex_height, t.yx, 0).r;
+}
+
+// t in squares
+float height_at(vec2 t) {
+	ivec2 i = ivec2(floor(t));
+	vec2 f = t - vec2(i);
+	float h00 = height_at_texel(i);
+	float h10 = height_at_texel(i + ivec2(1, 0));
+	float h01 = height_at_texel(i + ivec2(0, 1));
+	float h11 = height_at_texel(i + ivec2(1, 1));
+	return mix(mix(h00, h10, f.x), mix(h01, h11, f.x), f.y);
+}
+
+void main() {
+#ifdef vulkan
+	vec4 n = node[gl_InstanceIndex];
+#else
+	vec4 n = node[gl_InstanceID];
+#endif
+	vec2 grid = in_position.xz;
+	vec2 t = n.xy + grid * n.z;
+
+	// morph odd vertices into the next coarser lod
+	float d = length(t * terrain.xy - camera.xz);
+	vec2 m = morph[int(n.w)].xy;
+	float k = clamp((d - m.x) / (m.y - m.x), 0.0, 1.0);
+	t -= fract(grid * 0.5) * 2.0 * n.z * k;
+	t = clamp(t, vec2(0), terrain.zw);
+
+	vec3 p = vec3(t.x * terrain.x, height_at(t), t.y * terrain.y);
+	// (soft) normal, like Terrain::update()
+	float hx = height_at(t + vec2(2, 0)) - height_at(t - vec2(2, 0));
+	float hz = height_at(t + vec2(0, 2)) - height_at(t - vec2(0, 2));
+	vec3 normal = normalize(vec3(-hx / terrain.x, 4.0, -hz / terrain.y));
+
+	gl_Position = matrix.project * matrix.view * matrix.model * vec4(p, 1);
+	out_normal = (matrix.view * matrix.model * vec4(normal, 0)).xyz;
+	out_uv = t / terrain.zw;
+	out_pos = matrix.view * matrix.model * vec4(p, 1);
+	out_color = vec4(1);
+}
+
+</Module>
@@ -0,0 +1,43 @@
+<Layout>
+	bindings = [[buffer,sampler]]
+	pushsize = 4
+	input = [vec3,vec4,vec2]
+	topology = triangles
+	version = 420
+</Layout>
+<VertexShader>
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform Matrices {
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} mat;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec4 in_color;
+layout(location = 2) in vec2 in_tex_coord;
+
+layout(location = 0) out vec2 out_tex_coord;
+layout(location = 1) out vec4 out_color;
+
+void main() {
+	gl_Position = mat.proj * mat.view * mat.model * vec4(in_position, 1.0);
+	out_tex_coord = in_tex_coord;
+	out_color = in_color;
+}
+</VertexShader>
+<FragmentShader>
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 1) uniform sampler2D tex0;
+
+layout(location = 0) in vec2 in_tex_coord;
+layout(location = 1) in vec4 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+	out_color = texture(tex0, in_tex_coord) * in_color;
+}
+</FragmentShader>
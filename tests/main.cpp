@@ -0,0 +1,56 @@
+/*
+ * main.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <lib/os/msg.h>
+#include <cstdio>
+
+namespace test {
+
+struct Test {
+	string suite, name;
+	void (*f)();
+};
+
+static Array<Test> &all_tests() {
+	static Array<Test> tests;
+	return tests;
+}
+
+Registrar::Registrar(const char *suite, const char *name, void (*f)()) {
+	all_tests().add({suite, name, f});
+}
+
+void fail(const string &expr, const char *file, int line) {
+	throw Failure(format("%s:%d: expected %s", file, line, expr));
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	Array<string> suites;
+	for (int i=1; i<argc; i++)
+		suites.add(argv[i]);
+
+	int num_run = 0, num_failed = 0;
+	for (auto &t: test::all_tests()) {
+		if (suites.num > 0 and suites.find(t.suite) < 0)
+			continue;
+		num_run ++;
+		try {
+			t.f();
+			printf("ok     %s.%s\n", t.suite.c_str(), t.name.c_str());
+		} catch (Exception &e) {
+			num_failed ++;
+			printf("FAILED %s.%s\n   %s\n", t.suite.c_str(), t.name.c_str(), e.message().c_str());
+		}
+	}
+	printf("%d/%d passed\n", num_run - num_failed, num_run);
+	if (num_run == 0)
+		return 1;
+	return (num_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * test.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#ifndef TESTS_TEST_H_
+#define TESTS_TEST_H_
+
+#include <lib/base/base.h>
+
+// minimal unit test registry
+//   y-tests              runs all suites
+//   y-tests <suite>...   runs only the given suites
+namespace test {
+
+class Failure : public Exception {
+public:
+	explicit Failure(const string &msg) : Exception(msg) {}
+};
+
+struct Registrar {
+	Registrar(const char *suite, const char *name, void (*f)());
+};
+
+void fail(const string &expr, const char *file, int line);
+
+}
+
+#define TEST(SUITE, NAME) \
+	static void test_##SUITE##_##NAME(); \
+	static test::Registrar registrar_##SUITE##_##NAME(#SUITE, #NAME, &test_##SUITE##_##NAME); \
+	static void test_##SUITE##_##NAME()
+
+#define EXPECT(X) \
+	do { if (!(X)) test::fail(#X, __FILE__, __LINE__); } while (false)
+
+#endif /* TESTS_TEST_H_ */
@@ -0,0 +1,364 @@
+/*
+ * test_bvh.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <renderer/helper/Bvh.h>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+static Array<Box> random_boxes(int n, std::mt19937 &rng) {
+	std::uniform_real_distribution<float> pos(-100, 100), size(0, 3);
+	Array<Box> boxes;
+	boxes.resize(n);
+	for (auto &b: boxes) {
+		b.min = vec3(pos(rng), pos(rng), pos(rng));
+		b.max = b.min + vec3(size(rng), size(rng), size(rng));
+	}
+	return boxes;
+}
+
+static bool contains(const BvhNode &n, const vec3 &min, const vec3 &max) {
+	return n.min.x <= min.x and n.min.y <= min.y and n.min.z <= min.z
+		and n.max.x >= max.x and n.max.y >= max.y and n.max.z >= max.z;
+}
+
+// every primitive in exactly one leaf, children after their parents, boxes enclose their content
+static bool valid(const Bvh &bvh, const Array<Box> &boxes) {
+	if (bvh.index.num != boxes.num)
+		return false;
+	Array<int> seen;
+	seen.resize(boxes.num);
+	for (int &s: seen)
+		s = 0;
+	for (int n=0; n<bvh.nodes.num; n++) {
+		auto &node = bvh.nodes[n];
+		if (node.count > 0) {
+			if (node.first < 0 or node.first + node.count > bvh.index.num)
+				return false;
+			for (int i=node.first; i<node.first+node.count; i++) {
+				auto &b = boxes[bvh.index[i]];
+				if (!contains(node, b.min, b.max))
+					return false;
+				seen[bvh.index[i]] ++;
+			}
+		} else {
+			if (node.first <= n or node.first + 1 >= bvh.nodes.num)
+				return false;
+			for (int k=0; k<2; k++)
+				if (!contains(node, bvh.nodes[node.first + k].min, bvh.nodes[node.first + k].max))
+					return false;
+		}
+	}
+	for (int s: seen)
+		if (s != 1)
+			return false;
+	return true;
+}
+
+TEST(bvh, build) {
+	std::mt19937 rng(1);
+	// small ones and large ones (parallel subtrees)
+	for (int n: {1, 2, 7, 100, 20000}) {
+		auto boxes = random_boxes(n, rng);
+		Bvh bvh;
+		bvh.build(boxes, 4);
+		EXPECT(valid(bvh, boxes));
+		for (auto &node: bvh.nodes)
+			EXPECT(node.count <= 4);
+	}
+}
+
+TEST(bvh, refit) {
+	std::mt19937 rng(2);
+	auto boxes = random_boxes(5000, rng);
+	Bvh bvh;
+	bvh.build(boxes, 4);
+	int num_nodes = bvh.nodes.num;
+
+	std::uniform_real_distribution<float> move(-20, 20);
+	for (auto &b: boxes) {
+		vec3 d = vec3(move(rng), move(rng), move(rng));
+		b.min += d;
+		b.max += d;
+	}
+	bvh.refit(boxes);
+	EXPECT(bvh.nodes.num == num_nodes);
+	EXPECT(valid(bvh, boxes));
+
+	// tight root
+	Box r = boxes[0];
+	for (auto &b: boxes) {
+		r.min._min(b.min);
+		r.max._max(b.max);
+	}
+	auto root = bvh.bounds();
+	EXPECT(root.min == r.min and root.max == r.max);
+}
+
+// height grid like the terrain
+static void make_grid(int n, float phase, Array<vec3> &vertex, Array<int> &index) {
+	vertex.clear();
+	index.clear();
+	for (int i=0; i<=n; i++)
+		for (int j=0; j<=n; j++)
+			vertex.add(vec3((float)i, sinf((float)i * 0.3f + phase) * cosf((float)j * 0.2f), (float)j));
+	for (int i=0; i<n; i++)
+		for (int j=0; j<n; j++) {
+			int a = i * (n + 1) + j;
+			index.add(a);	index.add(a + 1);	index.add(a + n + 2);
+			index.add(a);	index.add(a + n + 2);	index.add(a + n + 1);
+		}
+}
+
+TEST(bvh, mesh_refit) {
+	Array<vec3> vertex;
+	Array<int> index;
+	make_grid(40, 0, vertex, index);
+	BvhMesh mesh;
+	mesh.build(vertex, index, {});
+	int num_nodes = mesh.bvh.nodes.num;
+
+	make_grid(40, 1.5f, vertex, index);
+	mesh.refit(vertex, index, {});
+	EXPECT(mesh.bvh.nodes.num == num_nodes);
+	EXPECT(mesh.triangles.num == index.num / 3);
+	for (auto &t: mesh.triangles) {
+		EXPECT(t.a == vertex[index[t.index * 3]]);
+		EXPECT(t.b == vertex[index[t.index * 3 + 1]]);
+		EXPECT(t.c == vertex[index[t.index * 3 + 2]]);
+	}
+	Array<Box> boxes;
+	for (int i=0; i<index.num/3; i++) {
+		Box b = {vertex[index[i*3]], vertex[index[i*3]]};
+		for (int k=1; k<3; k++) {
+			b.min._min(vertex[index[i*3+k]]);
+			b.max._max(vertex[index[i*3+k]]);
+		}
+		boxes.add(b);
+	}
+	EXPECT(valid(mesh.bvh, boxes));
+
+	// different triangle count: full rebuild
+	make_grid(20, 0, vertex, index);
+	mesh.refit(vertex, index, {});
+	EXPECT(mesh.triangles.num == index.num / 3);
+}
+
+TEST(bvh, scene_cache) {
+	Array<vec3> vertex;
+	Array<int> index;
+	make_grid(8, 0, vertex, index);
+	int key_a = 0, key_b = 0;
+	std::atomic<int> builds = 0;
+	auto builder = [&] (BvhMesh &b) {
+		builds ++;
+		b.build(vertex, index, {});
+	};
+
+	BvhScene scene;
+	auto frame = [&] (int version_a, bool with_b) {
+		scene.begin();
+		scene.add_instance(&key_a, 0, version_a, mat4::ID, builder);
+		scene.add_instance(&key_a, 0, version_a, mat4::translation(vec3(20, 0, 0)), builder);
+		if (with_b)
+			scene.add_instance(&key_b, 0, 0, mat4::ID, builder);
+		scene.end();
+	};
+
+	// shared by both instances
+	frame(1, true);
+	EXPECT(builds == 2);
+	EXPECT(scene.meshes.num == 2 and scene.instances.num == 3);
+	EXPECT(scene.meshes_changed);
+	scene.meshes_changed = false;
+
+	// cached
+	frame(1, true);
+	EXPECT(builds == 2);
+	EXPECT(!scene.meshes_changed);
+
+	// new geometry version
+	frame(2, true);
+	EXPECT(builds == 3);
+
+	// unused meshes get dropped
+	frame(2, false);
+	EXPECT(builds == 3);
+	EXPECT(scene.meshes.num == 1);
+	EXPECT(scene.top.index.num == 2);
+}
+
+// like RayTracingData::update_bvh(): meshes keyed by address, versioned by Mesh::generation
+TEST(bvh, mesh_generation) {
+	struct FakeMesh {
+		Array<vec3> vertex;
+		Array<int> index;
+		int generation;
+	};
+	FakeMesh mesh;
+	make_grid(8, 0, mesh.vertex, mesh.index);
+	mesh.generation = 1;
+	int builds = 0;
+	int num_triangles = 0;
+
+	BvhScene scene;
+	auto frame = [&] {
+		scene.begin();
+		scene.add_instance(&mesh, 0, mesh.generation, mat4::ID, [&mesh, &builds, &num_triangles] (BvhMesh &b) {
+			builds ++;
+			b.build(mesh.vertex, mesh.index, {});
+			num_triangles = b.triangles.num;
+		});
+		scene.end();
+	};
+
+	frame();
+	frame();
+	EXPECT(builds == 1);
+
+	// edited via update_vb()
+	make_grid(4, 0, mesh.vertex, mesh.index);
+	mesh.generation = 2;
+	frame();
+	EXPECT(builds == 2);
+	EXPECT(num_triangles == mesh.index.num / 3);
+
+	// a different mesh at the same address
+	make_grid(6, 0, mesh.vertex, mesh.index);
+	mesh.generation = 7;
+	frame();
+	EXPECT(builds == 3);
+	EXPECT(num_triangles == mesh.index.num / 3);
+	frame();
+	EXPECT(builds == 3);
+}
+
+TEST(bvh, depth_limit) {
+	std::mt19937 rng(4);
+	auto boxes = random_boxes(1000, rng);
+	Bvh bvh;
+	bvh.build(boxes, 4);
+	EXPECT(bvh.depth > 9);
+
+	// just enough levels: median splits near the limit, leaves stay small
+	bvh.build(boxes, 4, 9);
+	EXPECT(valid(bvh, boxes));
+	EXPECT(bvh.depth <= 9);
+	for (auto &node: bvh.nodes)
+		EXPECT(node.count <= 4);
+
+	// too few levels: larger leaves
+	bvh.build(boxes, 4, 5);
+	EXPECT(valid(bvh, boxes));
+	EXPECT(bvh.depth <= 5);
+}
+
+static Array<vec3> random_triangles(int n, float size, std::mt19937 &rng) {
+	std::uniform_real_distribution<float> pos(-size, size), offset(-1, 1);
+	Array<vec3> vertex;
+	for (int i=0; i<n; i++) {
+		vec3 c = vec3(pos(rng), pos(rng), pos(rng));
+		for (int k=0; k<3; k++)
+			vertex.add(c + vec3(offset(rng), offset(rng), offset(rng)));
+	}
+	return vertex;
+}
+
+// Moeller-Trumbore, both sides, like the packets
+static bool hit_triangle(const vec3 &p0, const vec3 &dir, const vec3 &a, const vec3 &b, const vec3 &c, float &t) {
+	vec3 e1 = b - a, e2 = c - a;
+	vec3 q = vec3::cross(dir, e2);
+	float det = e1 * q;
+	if (det == 0)
+		return false;
+	vec3 s = p0 - a;
+	float f = (s * q) / det;
+	vec3 w = vec3::cross(s, e1);
+	float g = (dir * w) / det;
+	t = (e2 * w) / det;
+	return f >= 0 and g >= 0 and f + g <= 1 and t > 0;
+}
+
+TEST(bvh, packets) {
+	std::mt19937 rng(3);
+	Array<Array<vec3>> vertex;
+	Array<Array<int>> index;
+	vertex.add(random_triangles(500, 10, rng));
+	vertex.add(random_triangles(50, 3, rng));
+	vertex.add(random_triangles(2000, 10, rng));
+	for (auto &v: vertex) {
+		Array<int> ii;
+		for (int i=0; i<v.num; i++)
+			ii.add(i);
+		index.add(ii);
+	}
+
+	Array<mat4> matrix = {
+		mat4::ID,
+		mat4::translation(vec3(15, 0, 0)) * mat4::rotation(vec3(0.3f, 1.0f, 0.2f)) * mat4::scale(2, 1, 0.5f),
+		mat4::translation(vec3(-5, 8, 2)) * mat4::rotation(vec3(1.1f, 0, 0.7f)),
+		mat4::translation(vec3(0, 0, 25)) * mat4::scale(1, 1, 0.2f)};
+	Array<int> mesh_of = {0, 0, 1, 2};
+
+	BvhScene scene;
+	scene.begin();
+	for (int i=0; i<matrix.num; i++) {
+		int m = mesh_of[i];
+		scene.add_instance(&vertex[m], 0, 0, matrix[i], [&vertex, &index, m] (BvhMesh &b) {
+			b.build(vertex[m], index[m], {});
+		});
+	}
+	scene.end();
+
+	// coherent packets (small cones), incoherent rays, rays along the chain
+	std::uniform_real_distribution<float> u(-1, 1);
+	Array<vec3> p0, dir;
+	for (int k=0; k<64; k++) {
+		vec3 o = vec3(u(rng), u(rng), u(rng)) * 30;
+		vec3 d0 = -o + vec3(u(rng), u(rng), u(rng)) * 5;
+		for (int i=0; i<BvhScene::PACKET_SIZE; i++) {
+			p0.add(o + vec3(u(rng), u(rng), u(rng)) * 0.2f);
+			dir.add(d0 + vec3(u(rng), u(rng), u(rng)) * 0.5f);
+		}
+	}
+	for (int i=0; i<500; i++) {
+		p0.add(vec3(u(rng), u(rng), u(rng)) * 30);
+		dir.add(vec3(u(rng), u(rng), u(rng)));
+	}
+
+	Array<BvhHit> hits;
+	scene.trace(p0, dir, 1e6f, hits);
+	EXPECT(hits.num == p0.num);
+
+	int num_hits = 0, mismatches = 0;
+	for (int r=0; r<p0.num; r++) {
+		float t_ref = 1e6f;
+		int inst_ref = -1;
+		for (int i=0; i<matrix.num; i++) {
+			mat4 inv = matrix[i].inverse();
+			vec3 o = inv * p0[r], d = inv.transform_normal(dir[r]);
+			auto &v = vertex[mesh_of[i]];
+			for (int k=0; k<v.num; k+=3) {
+				float t;
+				if (hit_triangle(o, d, v[k], v[k+1], v[k+2], t) and t < t_ref) {
+					t_ref = t;
+					inst_ref = i;
+				}
+			}
+		}
+		if (inst_ref >= 0)
+			num_hits ++;
+		bool same = (hits[r].instance == inst_ref);
+		if (inst_ref >= 0)
+			same = same and fabsf(hits[r].t - t_ref) <= 1e-4f * ::max(t_ref, 1.0f);
+		if (!same)
+			mismatches ++;
+	}
+	EXPECT(num_hits > p0.num / 4);
+	EXPECT(mismatches == 0);
+}
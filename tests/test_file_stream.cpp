@@ -0,0 +1,111 @@
+/*
+ * test_file_stream.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <lib/os/file.h>
+#include <lib/os/filesystem.h>
+#include <lib/base/pointer.h>
+
+static const Path FILENAME = "test-file-stream";
+
+static void write_ints(const string &mode, int n) {
+	owned<os::fs::FileStream> f(os::fs::open(FILENAME, mode));
+	for (int i=0; i<n; i++)
+		f->write_int(i);
+}
+
+static void check_ints(const string &mode, int n) {
+	owned<os::fs::FileStream> f(os::fs::open(FILENAME, mode));
+	EXPECT(f->size() == n * 4);
+	for (int i=0; i<n; i++) {
+		EXPECT(!f->is_end());
+		EXPECT(f->read_int() == i);
+	}
+	EXPECT(f->is_end());
+}
+
+TEST(file_stream, backends_read_the_same) {
+	// larger than the buffer
+	const int N = 50000;
+	write_ints("wbc", N);
+	check_ints("rb", N);
+	check_ints("rbc", N);
+	check_ints("rbm", N);
+	write_ints("wb", N);
+	check_ints("rbc", N);
+	os::fs::_delete(FILENAME);
+}
+
+TEST(file_stream, seek_inside_buffer) {
+	write_ints("wb", 100);
+	owned<os::fs::FileStream> f(os::fs::open(FILENAME, "rbc"));
+	EXPECT(f->read_int() == 0);
+	EXPECT(f->read_int() == 1);
+	f->seek(-4);
+	EXPECT(f->read_int() == 1);
+	f->set_pos(40);
+	EXPECT(f->read_int() == 10);
+	EXPECT(f->pos() == 44);
+	f.clear();
+	os::fs::_delete(FILENAME);
+}
+
+TEST(file_stream, append_and_size) {
+	write_ints("wb", 10);
+	{
+		owned<os::fs::FileStream> f(os::fs::open(FILENAME, "abc"));
+		f->write_int(10);
+		// pending, but counted
+		EXPECT(f->size() == 44);
+	}
+	check_ints("rb", 11);
+	os::fs::_delete(FILENAME);
+}
+
+TEST(file_stream, automatic_backend) {
+	write_ints("wbc", 100);
+	{
+		owned<os::fs::FileStream> f(os::fs::open(FILENAME, "rb"));
+		EXPECT(f->buffered);
+		EXPECT(!dynamic_cast<os::fs::MmapStream*>(f.get()));
+	}
+
+	// >= 1 mb
+	const int N = 300000;
+	write_ints("wbc", N);
+	{
+		owned<os::fs::FileStream> f(os::fs::open(FILENAME, "rb"));
+#if defined(OS_LINUX) || defined(OS_MAC)
+		EXPECT(dynamic_cast<os::fs::MmapStream*>(f.get()));
+#endif
+		EXPECT(f->read_int() == 0);
+	}
+	check_ints("rb", N);
+	{
+		// explicit backends win
+		owned<os::fs::FileStream> f(os::fs::open(FILENAME, "rbu"));
+		EXPECT(!f->buffered);
+		EXPECT(!dynamic_cast<os::fs::MmapStream*>(f.get()));
+	}
+	os::fs::_delete(FILENAME);
+}
+
+TEST(file_stream, write_binary_atomic) {
+	bytes a = bytes("first version");
+	bytes b;
+	b.resize(100000);
+	for (int i=0; i<b.num; i++)
+		b[i] = (char)i;
+	os::fs::write_binary_atomic(FILENAME, a);
+	EXPECT(os::fs::read_binary(FILENAME) == a);
+	// replaces, no temporary files left behind
+	os::fs::write_binary_atomic(FILENAME, b);
+	EXPECT(os::fs::read_binary(FILENAME) == b);
+	for (auto &p: os::fs::search(".", "*.tmp", "f"))
+		EXPECT(p.str().find(FILENAME.str()) < 0);
+	os::fs::_delete(FILENAME);
+}
@@ -0,0 +1,124 @@
+/*
+ * test_height_pyramid.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <world/HeightPyramid.h>
+#include <cmath>
+#include <random>
+
+static const int NX = 37, NZ = 29;
+static const vec3 PATTERN = vec3(2, 1, 3);
+
+static Array<float> make_heights() {
+	Array<float> h;
+	h.resize((NX + 1) * (NZ + 1));
+	for (int x=0; x<=NX; x++)
+		for (int z=0; z<=NZ; z++)
+			h[x * (NZ + 1) + z] = 5 * sinf((float)x * 0.4f) * cosf((float)z * 0.3f) + (float)x * 0.1f;
+	return h;
+}
+
+// reference: small steps along the segment, first sign change of "above the surface"
+static bool march(const Array<float> &h, const vec3 &p, const vec3 &d, float &s_hit) {
+	auto above = [&h] (const vec3 &q, bool &inside) {
+		float fx = q.x / PATTERN.x, fz = q.z / PATTERN.z;
+		inside = (fx >= 0 and fz >= 0 and fx < NX and fz < NZ);
+		if (!inside)
+			return 1.0f;
+		int i = (int)fx, j = (int)fz;
+		float sx, sz;
+		return q.y - height_grid_square(&h[0], NZ, i, j, fx - (float)i, fz - (float)j, sx, sz);
+	};
+	const int N = 20000;
+	bool inside;
+	float a0 = above(p, inside);
+	bool was_inside = inside;
+	for (int k=1; k<=N; k++) {
+		float s = (float)k / (float)N;
+		float a = above(p + d * s, inside);
+		if (inside and was_inside and (a0 > 0) != (a > 0)) {
+			s_hit = s;
+			return true;
+		}
+		a0 = a;
+		was_inside = inside;
+	}
+	return false;
+}
+
+TEST(height_pyramid, levels) {
+	auto h = make_heights();
+	HeightPyramid pyr;
+	pyr.update(h, NX, NZ, PATTERN, -1, -1, -1, -1);
+	EXPECT(pyr.levels.num > 1);
+	auto &top = pyr.levels.back();
+	EXPECT(top.nx == 1 and top.nz == 1);
+	float h0 = h[0], h1 = h[0];
+	for (float x: h) {
+		h0 = min(h0, x);
+		h1 = max(h1, x);
+	}
+	EXPECT(top.min[0] == h0);
+	EXPECT(top.max[0] == h1);
+}
+
+TEST(height_pyramid, incremental_update) {
+	auto h = make_heights();
+	HeightPyramid pyr;
+	pyr.update(h, NX, NZ, PATTERN, -1, -1, -1, -1);
+	h[10 * (NZ + 1) + 7] = 100;
+	pyr.update(h, NX, NZ, PATTERN, 10, 10, 7, 7);
+	EXPECT(pyr.levels.back().max[0] == 100);
+	// a full rebuild gives the same
+	HeightPyramid ref;
+	ref.update(h, NX, NZ, PATTERN, -1, -1, -1, -1);
+	for (int k=0; k<ref.levels.num; k++)
+		for (int i=0; i<ref.levels[k].max.num; i++) {
+			EXPECT(ref.levels[k].min[i] == pyr.levels[k].min[i]);
+			EXPECT(ref.levels[k].max[i] == pyr.levels[k].max[i]);
+		}
+}
+
+TEST(height_pyramid, vertical_ray) {
+	auto h = make_heights();
+	HeightPyramid pyr;
+	pyr.update(h, NX, NZ, PATTERN, -1, -1, -1, -1);
+	float s;
+	int i, j;
+	EXPECT(pyr.trace(vec3(5.5f, 50, 7.5f), vec3(0, -100, 0), s, i, j));
+	float sx, sz;
+	float y = height_grid_square(&h[0], NZ, 2, 2, 0.75f, 0.5f, sx, sz);
+	EXPECT(i == 2 and j == 2);
+	EXPECT(fabs(50 - 100 * s - y) < 0.001f);
+	// above everything
+	EXPECT(!pyr.trace(vec3(5.5f, 50, 7.5f), vec3(60, 0, 70), s, i, j));
+	// outside
+	EXPECT(!pyr.trace(vec3(-10, 50, -10), vec3(0, -100, 0), s, i, j));
+}
+
+TEST(height_pyramid, matches_marching) {
+	auto h = make_heights();
+	HeightPyramid pyr;
+	pyr.update(h, NX, NZ, PATTERN, -1, -1, -1, -1);
+	std::mt19937 rng(7);
+	auto uniform = [&rng] (float a, float b) { return a + (b - a) * (float)(rng() % 100000) / 100000.0f; };
+	int hits = 0;
+	for (int k=0; k<300; k++) {
+		vec3 p = vec3(uniform(-10, 84), uniform(-2, 12), uniform(-10, 97));
+		vec3 q = vec3(uniform(-10, 84), uniform(-8, 10), uniform(-10, 97));
+		float s_ref, s;
+		int i, j;
+		bool r_ref = march(h, p, q - p, s_ref);
+		bool r = pyr.trace(p, q - p, s, i, j);
+		EXPECT(r == r_ref);
+		if (r and r_ref) {
+			hits ++;
+			EXPECT(fabs(s - s_ref) < 0.002f);
+		}
+	}
+	EXPECT(hits > 20);
+}
@@ -0,0 +1,48 @@
+/*
+ * test_linear_range_allocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <lib/vulkan/LinearRangeAllocator.h>
+
+using vulkan::LinearRangeAllocator;
+
+TEST(linear_range_allocator, bump) {
+	LinearRangeAllocator a(1024, 2);
+	EXPECT(a.allocate(10, 1) == 0);
+	EXPECT(a.allocate(16, 256) == 256);
+	EXPECT(a.allocate(4, 4) == 272);
+	EXPECT(a.used == 276);
+}
+
+TEST(linear_range_allocator, full) {
+	LinearRangeAllocator a(256, 3);
+	EXPECT(a.allocate(200, 1) == 0);
+	EXPECT(a.allocate(100, 1) == -1);
+	// still fits
+	EXPECT(a.allocate(56, 1) == 200);
+	EXPECT(a.allocate(1, 1) == -1);
+	EXPECT(a.peak == 256);
+}
+
+TEST(linear_range_allocator, frames) {
+	LinearRangeAllocator a(1000, 3);
+	EXPECT(a.allocate(600, 1) == 0);
+
+	// regions of later frames don't overlap
+	a.next_frame();
+	EXPECT(a.used == 0);
+	EXPECT(a.allocate(600, 1) == 1000);
+	EXPECT(a.allocate(10, 256) == 1768);
+	a.next_frame();
+	EXPECT(a.allocate(600, 1) == 2000);
+
+	// back to the first region
+	a.next_frame();
+	EXPECT(a.frame == 0);
+	EXPECT(a.allocate(100, 1) == 0);
+	EXPECT(a.peak == 778);
+}
@@ -0,0 +1,122 @@
+/*
+ * test_particle_store.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <fx/ParticleStore.h>
+#include <fx/Particle.h>
+#include <cmath>
+
+static Particle make(float x, float ttl, bool suicidal = true) {
+	Particle p;
+	p.pos = vec3(x, 0, 0);
+	p.vel = vec3(1, 2, 3);
+	p.col = color(1, x, 0, 0);
+	p.radius = x;
+	p.time_to_live = ttl;
+	p.suicidal = suicidal;
+	p.enabled = true;
+	return p;
+}
+
+// all arrays in sync: entry i belongs to the particle with pos.x == radius == col.r
+static bool consistent(const ParticleStore &s) {
+	if (s.vel.num != s.size() or s.col.num != s.size() or s.radius.num != s.size()
+			or s.time_to_live.num != s.size() or s.suicidal.num != s.size())
+		return false;
+	if (s.with_length and s.length.num != s.size())
+		return false;
+	for (int i=0; i<s.size(); i++) {
+		if (s.radius[i] != s.col[i].r or s.pos[i].x != s.radius[i])
+			return false;
+		if (s.with_length and s.length[i].x != s.radius[i])
+			return false;
+	}
+	return true;
+}
+
+TEST(particle_store, add_get) {
+	ParticleStore s;
+	EXPECT(s.add(make(1, 5)) == 0);
+	EXPECT(s.add(make(2, 5)) == 1);
+	EXPECT(s.size() == 2);
+	auto p = s.get(1);
+	EXPECT(p.pos == vec3(2, 0, 0));
+	EXPECT(p.radius == 2);
+	EXPECT(p.enabled);
+	EXPECT(consistent(s));
+}
+
+TEST(particle_store, swap_remove) {
+	ParticleStore s(true);
+	for (int i=0; i<5; i++)
+		s.add(make((float)i, 5), vec3((float)i, 0, 0));
+	// last one moves into the gap
+	s.remove(1);
+	EXPECT(s.size() == 4);
+	EXPECT(s.radius[1] == 4);
+	EXPECT(s.length[1].x == 4);
+	// removing the last one
+	s.remove(3);
+	EXPECT(s.size() == 3);
+	EXPECT(s.radius[0] == 0 and s.radius[1] == 4 and s.radius[2] == 2);
+	EXPECT(consistent(s));
+}
+
+TEST(particle_store, remove_expired) {
+	ParticleStore s(true);
+	// expired: 0, 2, 5 (not 3, it isn't suicidal), including the last one
+	float ttl[] = {-1, 1, -1, -1, 2, -1};
+	bool suicidal[] = {true, true, true, false, true, true};
+	for (int i=0; i<6; i++)
+		s.add(make((float)i + 1, ttl[i], suicidal[i]), vec3((float)i + 1, 0, 0));
+	EXPECT(s.remove_expired() == 3);
+	EXPECT(s.size() == 3);
+	EXPECT(consistent(s));
+	float sum = 0;
+	for (int i=0; i<s.size(); i++)
+		sum += s.radius[i];
+	EXPECT(sum == 2 + 4 + 5);
+	EXPECT(s.remove_expired() == 0);
+
+	// all of them
+	for (int i=0; i<s.size(); i++) {
+		s.time_to_live[i] = -1;
+		s.suicidal[i] = true;
+	}
+	EXPECT(s.remove_expired() == 3);
+	EXPECT(s.size() == 0);
+}
+
+TEST(particle_store, integrate) {
+	// above the grain size: split over the pool
+	for (int n: {10, 40000}) {
+		ParticleStore s;
+		for (int i=0; i<n; i++)
+			s.add(make((float)i, 1));
+		s.integrate(0.5f);
+		bool ok = true;
+		for (int i=0; i<n; i++) {
+			ok = ok and s.pos[i] == vec3((float)i + 0.5f, 1, 1.5f);
+			ok = ok and s.time_to_live[i] == 0.5f;
+		}
+		EXPECT(ok);
+	}
+	ParticleStore empty;
+	empty.integrate(1);
+	EXPECT(empty.size() == 0);
+}
+
+TEST(particle_store, reserve_keeps_content) {
+	ParticleStore s;
+	s.add(make(3, 1));
+	s.reserve(1000);
+	EXPECT(s.size() == 1);
+	EXPECT(s.radius[0] == 3);
+	s.clear();
+	EXPECT(s.size() == 0);
+	EXPECT(s.pos.allocated >= 1000);
+}
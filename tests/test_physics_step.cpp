@@ -0,0 +1,84 @@
+/*
+ * test_physics_step.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <world/PhysicsStep.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+// stands in for a SolidBody: the mutators join the step like SolidBody's do
+struct Body {
+	PhysicsStep *step;
+	float vel = 0;
+	std::atomic<bool> stepping = false;
+	bool mutated_while_stepping = false;
+
+	void add_impulse(float p) {
+		step->wait();
+		if (stepping)
+			mutated_while_stepping = true;
+		vel += p;
+	}
+	void set_velocity(float v) {
+		step->wait();
+		if (stepping)
+			mutated_while_stepping = true;
+		vel = v;
+	}
+};
+
+static void simulate(Body &b) {
+	b.stepping = true;
+	// long enough for the main thread to call mutators in the meantime
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	for (int i=0; i<1000; i++)
+		b.vel = b.vel * 0.5f + 1;
+	b.stepping = false;
+}
+
+TEST(physics_step, mutators_wait_for_running_step) {
+	PhysicsStep step;
+	Body b{&step};
+
+	step.start([&b] { simulate(b); });
+	EXPECT(step.is_running());
+	EXPECT(step.collecting);
+	b.add_impulse(10);
+	EXPECT(!step.is_running());
+	EXPECT(!step.collecting);
+	EXPECT(!b.mutated_while_stepping);
+	// the step converges to 2, the impulse comes strictly after it
+	EXPECT(b.vel == 12);
+
+	step.start([&b] { simulate(b); });
+	b.set_velocity(5);
+	EXPECT(!b.mutated_while_stepping);
+	EXPECT(b.vel == 5);
+}
+
+TEST(physics_step, wait_without_step) {
+	PhysicsStep step;
+	step.wait();
+	EXPECT(!step.is_running());
+	EXPECT(!step.collecting);
+}
+
+TEST(physics_step, start_joins_previous_step) {
+	PhysicsStep step;
+	std::atomic<int> running = 0;
+	bool overlapped = false;
+	for (int i=0; i<4; i++)
+		step.start([&running, &overlapped] {
+			if (running++ > 0)
+				overlapped = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			running--;
+		});
+	step.wait();
+	EXPECT(!overlapped);
+}
@@ -0,0 +1,157 @@
+/*
+ * test_range_allocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <lib/vulkan/RangeAllocator.h>
+#include <random>
+
+using vulkan::RangeAllocator;
+
+struct Used {
+	int64 offset, size;
+};
+
+static bool overlaps(const Array<Used> &used) {
+	for (int i=0; i<used.num; i++)
+		for (int j=i+1; j<used.num; j++)
+			if (used[i].offset < used[j].offset + used[j].size and used[j].offset < used[i].offset + used[i].size)
+				return true;
+	return false;
+}
+
+TEST(range_allocator, alignment) {
+	RangeAllocator a(1024);
+	EXPECT(a.allocate(3, 1) == 0);
+	EXPECT(a.allocate(16, 256) == 256);
+	// the padding stays usable
+	EXPECT(a.allocate(100, 4) == 4);
+	EXPECT(a.num_allocations == 3);
+	EXPECT(a.used == 119);
+}
+
+TEST(range_allocator, full) {
+	RangeAllocator a(256);
+	EXPECT(a.allocate(200, 1) == 0);
+	EXPECT(a.allocate(100, 1) == -1);
+	EXPECT(a.allocate(56, 1) == 200);
+	EXPECT(a.allocate(1, 1) == -1);
+	EXPECT(a.free_ranges.num == 0);
+}
+
+TEST(range_allocator, merge_neighbours) {
+	RangeAllocator a(300);
+	int64 o0 = a.allocate(100, 1);
+	int64 o1 = a.allocate(100, 1);
+	int64 o2 = a.allocate(100, 1);
+	a.free(o0, 100);
+	a.free(o2, 100);
+	EXPECT(a.free_ranges.num == 2);
+	// closes the gap, one range again
+	a.free(o1, 100);
+	EXPECT(a.free_ranges.num == 1);
+	EXPECT(a.largest_free_range() == 300);
+	EXPECT(a.is_empty());
+}
+
+TEST(range_allocator, random) {
+	const int64 SIZE = 1 << 20;
+	RangeAllocator a(SIZE);
+	std::mt19937 rng(1234);
+	auto rand_int = [&rng] (int n) { return (int)(rng() % (unsigned)n); };
+	Array<Used> used;
+	for (int k=0; k<4000; k++) {
+		if (used.num > 0 and rand_int(3) == 0) {
+			int i = rand_int(used.num);
+			a.free(used[i].offset, used[i].size);
+			used.erase(i);
+		} else {
+			int64 size = 1 + rand_int(5000);
+			int64 alignment = (int64)1 << rand_int(9);
+			int64 o = a.allocate(size, alignment);
+			if (o >= 0) {
+				EXPECT(o % alignment == 0);
+				EXPECT(o + size <= SIZE);
+				used.add({o, size});
+			}
+		}
+		if (k % 200 == 0)
+			EXPECT(!overlaps(used));
+	}
+	EXPECT(!overlaps(used));
+
+	int64 total = 0;
+	for (auto &u: used)
+		total += u.size;
+	EXPECT(a.used == total);
+	EXPECT(a.num_allocations == used.num);
+
+	for (auto &u: used)
+		a.free(u.offset, u.size);
+	EXPECT(a.is_empty());
+	EXPECT(a.free_ranges.num == 1);
+	EXPECT(a.largest_free_range() == SIZE);
+}
+
+TEST(range_allocator, sparse) {
+	RangeAllocator a(1000);
+	EXPECT(!a.is_sparse(0.5f));
+	int64 o = a.allocate(100, 1);
+	EXPECT(a.is_sparse(0.5f));
+	a.allocate(500, 1);
+	EXPECT(!a.is_sparse(0.5f));
+	EXPECT(a.is_sparse(0.7f));
+	a.free(o, 100);
+	EXPECT(!a.is_sparse(0.5f));
+}
+
+TEST(range_allocator, stats) {
+	RangeAllocator a(1000), b(4000);
+	a.allocate(100, 1);
+	a.allocate(200, 1);
+	b.allocate(4000, 1);
+
+	vulkan::RangeStats s;
+	s.add(a, false);
+	s.add(b, true);
+	EXPECT(s.num_blocks == 2);
+	EXPECT(s.num_dedicated == 1);
+	EXPECT(s.num_allocations == 3);
+	EXPECT(s.allocated == 5000);
+	EXPECT(s.used == 4300);
+	EXPECT(s.largest_free_range == 700);
+	EXPECT(s.str().find("3 allocations in 2 blocks (1 dedicated)") >= 0);
+}
+
+struct FakeBlock {
+	RangeAllocator ranges;
+	int _kind;
+	int kind() const { return _kind; }
+};
+
+TEST(range_allocator, trim) {
+	Array<FakeBlock*> blocks;
+	for (int i=0; i<5; i++)
+		blocks.add(new FakeBlock{RangeAllocator(1000), i % 2});
+	// 0: used, kind 0
+	blocks[0]->ranges.allocate(10, 1);
+	// 3: used, kind 1
+	blocks[3]->ranges.allocate(10, 1);
+
+	// release everything empty
+	auto r = vulkan::empty_blocks_to_release(blocks, 0);
+	EXPECT(r == Array<int>({1, 2, 4}));
+
+	// one spare per kind: keep 2 (kind 0) and 1 (kind 1)
+	r = vulkan::empty_blocks_to_release(blocks, 1);
+	EXPECT(r == Array<int>({4}));
+
+	r = vulkan::empty_blocks_to_release(blocks, 2);
+	EXPECT(r.num == 0);
+
+	for (auto b: blocks)
+		delete b;
+}
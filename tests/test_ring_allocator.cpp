@@ -0,0 +1,86 @@
+/*
+ * test_ring_allocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <lib/vulkan/RingAllocator.h>
+#include <random>
+
+using vulkan::RingAllocator;
+
+TEST(ring_allocator, fifo) {
+	RingAllocator r(100);
+	int64 b0, b1, b2;
+	EXPECT(r.allocate(40, 1, b0) == 0);
+	EXPECT(r.allocate(40, 1, b1) == 40);
+	// 20 left at the end
+	EXPECT(r.allocate(30, 1, b2) == -1);
+	r.release(b0);
+	// wraps, the last 20 bytes are wasted until released
+	EXPECT(r.allocate(30, 1, b2) == 0);
+	EXPECT(b2 == 50);
+	EXPECT(r.used == 90);
+	r.release(b1);
+	r.release(b2);
+	EXPECT(r.used == 0);
+}
+
+TEST(ring_allocator, alignment) {
+	RingAllocator r(256);
+	int64 b;
+	EXPECT(r.allocate(3, 1, b) == 0);
+	EXPECT(r.allocate(8, 16, b) == 16);
+	EXPECT(b == 21);
+	EXPECT(r.used == 24);
+}
+
+TEST(ring_allocator, full) {
+	RingAllocator r(64);
+	int64 b0, b1, b;
+	EXPECT(r.allocate(32, 1, b0) == 0);
+	EXPECT(r.allocate(32, 1, b1) == 32);
+	EXPECT(r.allocate(1, 1, b) == -1);
+	r.release(b0);
+	EXPECT(r.allocate(33, 1, b) == -1);
+	EXPECT(r.allocate(32, 1, b) == 0);
+}
+
+// live allocations never overlap, everything released in order leaves an empty ring
+TEST(ring_allocator, random) {
+	const int64 SIZE = 4096;
+	RingAllocator r(SIZE);
+	std::mt19937 rng(42);
+	struct Live {
+		int64 offset, size, bytes;
+	};
+	Array<Live> live;
+	for (int k=0; k<20000; k++) {
+		if (live.num > 0 and rng() % 3 == 0) {
+			r.release(live[0].bytes);
+			live.erase(0);
+		} else {
+			int64 size = 1 + rng() % 700;
+			int64 alignment = (int64)1 << (rng() % 6);
+			int64 bytes;
+			int64 o = r.allocate(size, alignment, bytes);
+			if (o >= 0) {
+				EXPECT(o % alignment == 0);
+				EXPECT(o + size <= SIZE);
+				for (auto &l: live)
+					EXPECT(o >= l.offset + l.size or l.offset >= o + size);
+				live.add({o, size, bytes});
+			}
+		}
+		int64 total = 0;
+		for (auto &l: live)
+			total += l.bytes;
+		EXPECT(r.used == total);
+		EXPECT(r.used <= SIZE);
+	}
+	for (auto &l: live)
+		r.release(l.bytes);
+	EXPECT(r.used == 0);
+}
@@ -0,0 +1,64 @@
+/*
+ * test_shader_variant_cache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <helper/ShaderVariantCache.h>
+#include <lib/os/file.h>
+#include <lib/os/filesystem.h>
+
+static const Path FILENAME = "test-shader-variants";
+
+static void reset_file() {
+	if (os::fs::exists(FILENAME))
+		os::fs::_delete(FILENAME);
+}
+
+TEST(shader_variant_cache, encode_decode_windows_path) {
+	ShaderVariant v{Path("C:\\game\\shader\\water.shader"), "forward", "animated", ""};
+	auto d = ShaderVariant::decode(v.encode());
+	EXPECT(d.has_value());
+	EXPECT(*d == v);
+	EXPECT(!ShaderVariant::decode("a:b:c:d").has_value());
+	EXPECT(!ShaderVariant::decode("").has_value());
+}
+
+TEST(shader_variant_cache, appends_and_reloads) {
+	reset_file();
+	ShaderVariant a{Path("a.shader"), "forward", "default", ""};
+	ShaderVariant b{Path("b.shader"), "deferred", "instanced", "points"};
+
+	ShaderVariantCache cache;
+	cache.load(FILENAME);
+	EXPECT(cache.variants.num == 0);
+	EXPECT(cache.add(a));
+	EXPECT(!cache.add(a));
+	EXPECT(cache.add(b));
+
+	// one line per variant, no rewrite
+	auto lines = os::fs::read_text(FILENAME).explode("\n");
+	EXPECT(lines.num == 3);
+	EXPECT(lines[0] == a.encode());
+	EXPECT(lines[1] == b.encode());
+
+	ShaderVariantCache cache2;
+	cache2.load(FILENAME);
+	EXPECT(cache2.variants.num == 2);
+	EXPECT(cache2.variants[0] == a);
+	EXPECT(cache2.variants[1] == b);
+	reset_file();
+}
+
+TEST(shader_variant_cache, skips_broken_and_duplicate_lines) {
+	reset_file();
+	ShaderVariant a{Path("a.shader"), "forward", "default", ""};
+	os::fs::write_text(FILENAME, a.encode() + "\r\nbroken line\n" + a.encode() + "\n");
+	ShaderVariantCache cache;
+	cache.load(FILENAME);
+	EXPECT(cache.variants.num == 1);
+	EXPECT(cache.variants[0] == a);
+	reset_file();
+}
@@ -0,0 +1,126 @@
+/*
+ * test_slot_pool.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <fx/SlotPool.h>
+#include <cstdint>
+
+struct Thing {
+	int id;
+	double x;
+};
+
+struct BigThing : Thing {
+	char extra[100];
+};
+
+struct Tag {
+	int id;
+};
+
+using Pool = SlotPool<Thing, Tag>;
+
+static Thing *add(Pool &pool, int id, int size = sizeof(Thing)) {
+	auto p = pool.allocate(size);
+	new(p) Thing{id, (double)id};
+	pool.header(p)->id = id;
+	return p;
+}
+
+// alive is dense and every slot knows its index
+static bool consistent(const Pool &pool) {
+	for (int i=0; i<pool.alive.num; i++) {
+		auto p = pool.alive[i];
+		if (pool.index(p) != i or pool.header(p)->id != p->id)
+			return false;
+		if (((uintptr_t)p % Pool::ALIGNMENT) != 0 or ((uintptr_t)pool.header(p) % Pool::ALIGNMENT) != 0)
+			return false;
+	}
+	return true;
+}
+
+TEST(slot_pool, allocate_free_reuse) {
+	Pool pool;
+	Array<Thing*> things;
+	for (int i=0; i<Pool::CHUNK_SLOTS; i++)
+		things.add(add(pool, i));
+	EXPECT(pool.alive.num == Pool::CHUNK_SLOTS);
+	EXPECT(pool.num_chunks() == 1);
+	EXPECT(consistent(pool));
+
+	// a freed slot gets reused before a new chunk is allocated
+	auto freed = things[10];
+	pool.remove(pool.index(freed));
+	EXPECT(pool.index(freed) == -1);
+	auto p = add(pool, 1000);
+	EXPECT(p == freed);
+	EXPECT(pool.num_chunks() == 1);
+
+	add(pool, 1001);
+	EXPECT(pool.num_chunks() == 2);
+	EXPECT(consistent(pool));
+
+	// different sizes don't share slots
+	auto big = add(pool, 2000, sizeof(BigThing));
+	EXPECT(pool.num_chunks() == 3);
+	pool.remove(pool.index(big));
+	EXPECT(add(pool, 2001, sizeof(BigThing)) == big);
+	EXPECT(consistent(pool));
+}
+
+TEST(slot_pool, stale_handles) {
+	Pool pool;
+	auto a = add(pool, 1);
+	auto h = pool.handle(a);
+	EXPECT(pool.get(h) == a);
+	EXPECT(pool.get(Pool::Handle()) == nullptr);
+
+	pool.remove(pool.index(a));
+	EXPECT(pool.get(h) == nullptr);
+
+	// same slot, new generation
+	auto b = add(pool, 2);
+	EXPECT(b == a);
+	EXPECT(pool.get(h) == nullptr);
+	EXPECT(pool.get(pool.handle(b)) == b);
+}
+
+TEST(slot_pool, swap_remove) {
+	Pool pool;
+	Array<Thing*> things;
+	Array<Pool::Handle> handles;
+	for (int i=0; i<50; i++) {
+		things.add(add(pool, i));
+		handles.add(pool.handle(things.back()));
+	}
+
+	// the last one moves into the gap, but stays in its slot
+	pool.remove(3);
+	EXPECT(pool.alive.num == 49);
+	EXPECT(pool.alive[3] == things[49]);
+	EXPECT(pool.index(things[49]) == 3);
+	EXPECT(consistent(pool));
+
+	for (int i=0; i<50; i++) {
+		if (i == 3) {
+			EXPECT(pool.get(handles[i]) == nullptr);
+		} else {
+			auto p = pool.get(handles[i]);
+			EXPECT(p == things[i]);
+			EXPECT(p and p->id == i);
+		}
+	}
+
+	// removing the last one
+	pool.remove(pool.alive.num - 1);
+	EXPECT(pool.alive.num == 48);
+	EXPECT(consistent(pool));
+	while (pool.alive.num > 0)
+		pool.remove(0);
+	for (auto &h: handles)
+		EXPECT(pool.get(h) == nullptr);
+}
@@ -0,0 +1,170 @@
+/*
+ * test_thread_pool.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: michi
+ */
+
+#include "test.h"
+#include <lib/threads/ThreadPool.h>
+#include <lib/threads/ThreadedWork.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+static void sleep_ms(int ms) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// blocks a worker until released
+struct Gate {
+	std::atomic<bool> open = false;
+	void wait() {
+		while (!open)
+			sleep_ms(1);
+	}
+};
+
+TEST(thread_pool, dependencies) {
+	ThreadPool pool(3);
+	std::atomic<int> a = 0, b = 0, c = 0;
+	bool c_saw_ab = false, d_saw_c = false;
+	auto ta = pool.submit([&] { sleep_ms(20); a = 1; });
+	auto tb = pool.submit([&] { b = 1; });
+	auto tc = pool.submit([&] { c_saw_ab = (a == 1 and b == 1); c = 1; }, {ta, tb});
+	auto td = pool.submit([&] { d_saw_c = (c == 1); }, {tc});
+	pool.wait(td);
+	EXPECT(c_saw_ab);
+	EXPECT(d_saw_c);
+	EXPECT(pool.is_done(ta) and pool.is_done(tb) and pool.is_done(tc));
+
+	// finished dependencies don't block
+	bool ran = false;
+	pool.wait(pool.submit([&] { ran = true; }, {ta, td}));
+	EXPECT(ran);
+}
+
+TEST(thread_pool, nested_parallel_for) {
+	// a single worker must not deadlock either
+	for (int num_workers: {1, 4}) {
+		ThreadPool pool(num_workers);
+		const int N = 16, M = 1000;
+		// Array needs assignable elements
+		std::vector<std::atomic<int>> count(N * M);
+		pool.parallel_for(N, [&] (int first, int end) {
+			for (int i=first; i<end; i++)
+				pool.parallel_for(M, [&, i] (int f, int e) {
+					for (int j=f; j<e; j++)
+						count[i * M + j] ++;
+				}, 64);
+		}, 1);
+		bool once = true;
+		for (auto &x: count)
+			once = once and (x == 1);
+		EXPECT(once);
+	}
+}
+
+TEST(thread_pool, wait_helps) {
+	ThreadPool pool(1);
+	Gate gate;
+	auto blocker = pool.submit([&] { gate.wait(); });
+	sleep_ms(10);
+
+	// the only worker is busy, so the waiting thread has to run it
+	int worker = -2;
+	auto t = pool.submit([&] { worker = pool.current_worker(); });
+	pool.wait(t);
+	EXPECT(worker == -1);
+	EXPECT(!pool.is_done(blocker));
+
+	gate.open = true;
+	pool.wait(blocker);
+}
+
+TEST(thread_pool, wait_for) {
+	ThreadPool pool(1);
+	Gate gate;
+	auto t = pool.submit([&] { gate.wait(); });
+	auto t0 = std::chrono::steady_clock::now();
+	EXPECT(!pool.wait_for(t, 30));
+	auto dt = std::chrono::steady_clock::now() - t0;
+	EXPECT(dt >= std::chrono::milliseconds(25));
+
+	gate.open = true;
+	EXPECT(pool.wait_for(t, 5000));
+	EXPECT(pool.is_done(t));
+}
+
+TEST(thread_pool, exceptions) {
+	ThreadPool pool(2);
+	auto t1 = pool.submit([] { throw std::runtime_error("std"); });
+	auto t2 = pool.submit([] { throw 13; });
+	auto t3 = pool.submit([] { throw Exception("y"); });
+	bool ran = false;
+	// successors still run
+	auto t4 = pool.submit([&] { ran = true; }, {t1, t2, t3});
+	pool.wait(t4);
+	EXPECT(pool.is_done(t1) and pool.is_done(t2) and pool.is_done(t3));
+	EXPECT(ran);
+}
+
+// no two steps run at the same time with the same worker id
+class IdCheckWork : public ThreadedWork {
+public:
+	std::atomic<bool> busy[MAX_THREADS + 1];
+	std::atomic<bool> overlap = false;
+	std::atomic<int> max_id = -1;
+	std::atomic<int> steps = 0;
+	int abort_after = -1;
+
+	IdCheckWork() {
+		for (auto &b: busy)
+			b = false;
+	}
+	void on_step(int index, int worker_id) override {
+		int m = max_id;
+		while (worker_id > m and !max_id.compare_exchange_weak(m, worker_id)) {}
+		if (worker_id < 0 or worker_id > MAX_THREADS)
+			return;
+		if (busy[worker_id].exchange(true))
+			overlap = true;
+		sleep_ms(1);
+		busy[worker_id] = false;
+		steps ++;
+	}
+	bool on_status() override {
+		return abort_after < 0 or steps < abort_after;
+	}
+};
+
+TEST(thread_pool, threaded_work_ids) {
+	auto pool = ThreadPool::get();
+	IdCheckWork work;
+	Gate done;
+	std::thread runner([&] {
+		work.run(300, 2);
+		done.open = true;
+	});
+
+	// threads outside the pool that wait for something else steal the work's chunks
+	auto blocker = pool->submit([&] { done.wait(); });
+	std::thread other([&] { pool->wait(blocker); });
+	pool->wait(blocker);
+	other.join();
+	runner.join();
+
+	EXPECT(!work.overlap);
+	EXPECT(work.steps == 300);
+	EXPECT(work.max_id <= pool->num_workers());
+}
+
+TEST(thread_pool, threaded_work_abort) {
+	IdCheckWork work;
+	work.abort_after = 10;
+	EXPECT(!work.run(100000, 1));
+	EXPECT(!work.overlap);
+	EXPECT(work.steps < 100000);
+}